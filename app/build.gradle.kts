@@ -44,6 +44,9 @@ android {
         buildConfigField("Boolean", "DEBUG", "true")
         buildConfigField("String", "API_VERSION", "\"v1\"")
         buildConfigField("String", "DEVICE_API_KEY", "\"8f3d2c9a7b1e4f6d5a9c2b3e7f1d4a6c9b8e0f2a1d3c4b5e6f7a8b9c0d1e2f3a\"")
+        // Public half of the server's config signing key (X.509 SubjectPublicKeyInfo, hex). Empty until
+        // the server team publishes its production key: runtime config and rule pushes are rejected.
+        buildConfigField("String", "CONFIG_SIGNING_PUBLIC_KEY", "\"\"")
     }
 
     buildTypes {
@@ -53,6 +56,7 @@ android {
             buildConfigField("Boolean", "DEBUG", "true")
             buildConfigField("String", "API_VERSION", "\"v1\"")
             buildConfigField("String", "DEVICE_API_KEY", "\"8f3d2c9a7b1e4f6d5a9c2b3e7f1d4a6c9b8e0f2a1d3c4b5e6f7a8b9c0d1e2f3a\"")
+            buildConfigField("Boolean", "SLOW_OP_WATCHDOG", "true")
             isDebuggable = true
         }
         
@@ -70,6 +74,15 @@ android {
             buildConfigField("Boolean", "DEBUG", "false")
             buildConfigField("String", "API_VERSION", "\"v1\"")
             buildConfigField("String", "DEVICE_API_KEY", "\"8f3d2c9a7b1e4f6d5a9c2b3e7f1d4a6c9b8e0f2a1d3c4b5e6f7a8b9c0d1e2f3a\"")
+            buildConfigField("Boolean", "SLOW_OP_WATCHDOG", "false")
+        }
+
+        // Release code and signing with the slow-operation watchdog on; same applicationId,
+        // since the device-owner app cannot be installed twice
+        create("staging") {
+            initWith(getByName("release"))
+            buildConfigField("Boolean", "SLOW_OP_WATCHDOG", "true")
+            matchingFallbacks += listOf("release")
         }
     }
     
@@ -90,12 +103,62 @@ android {
     kotlinOptions {
         jvmTarget = "11"
     }
+
+    // Rewrite the baseline/startup profiles through R8 and lay out startup classes in the
+    // primary dex (src/main/baselineProfiles/startup-prof.txt)
+    experimentalProperties["android.experimental.art-profile-r8-rewriting"] = true
+    experimentalProperties["android.experimental.r8.dex-startup-optimization"] = true
+
+    testOptions {
+        // android.util.Log and friends return defaults in JVM tests instead of throwing
+        unitTests.isReturnDefaultValues = true
+    }
+}
+
+// Startup-critical classes of the boot-into-lock and command-lock paths. Each must keep a class rule
+// and a method rule in both checked-in profiles; a rename that drops one fails the build.
+val baselineProfileRequired = listOf(
+    "com/microspace/payo/DeviceOwnerApplication",
+    "com/microspace/payo/receivers/boot/BootReceiver",
+    "com/microspace/payo/ui/activities/lock/base/BaseLockActivity",
+    "com/microspace/payo/ui/activities/lock/payment/PaymentOverdueActivity",
+    "com/microspace/payo/ui/activities/lock/security/SecurityViolationActivity",
+    "com/microspace/payo/ui/activities/lock/system/HardLockGenericActivity",
+    "com/microspace/payo/ui/activities/lock/system/DeactivationActivity",
+    "com/microspace/payo/ui/screens/lock/LockScreensKt",
+    "com/microspace/payo/control/RemoteDeviceControlManager",
+    "com/microspace/payo/data/local/database/DeviceOwnerDatabase",
+    "com/microspace/payo/data/local/database/DeviceOwnerDatabase_Impl",
+    "com/microspace/payo/services/heartbeat/HeartbeatManager",
+    "com/microspace/payo/data/remote/ApiClient"
+)
+
+val verifyBaselineProfile by tasks.registering {
+    val profileDir = layout.projectDirectory.dir("src/main/baselineProfiles")
+    val required = baselineProfileRequired
+    inputs.dir(profileDir)
+    doLast {
+        listOf("baseline-prof.txt", "startup-prof.txt").forEach { name ->
+            val rules = profileDir.file(name).asFile.readLines().map { it.trim() }.toSet()
+            val missing = required.filterNot { "L$it;" in rules && "HSPL$it;->**(**)**" in rules }
+            if (missing.isNotEmpty()) {
+                throw GradleException("$name is missing startup-critical classes: ${missing.joinToString()}")
+            }
+        }
+    }
 }
 
+tasks.named("preBuild") { dependsOn(verifyBaselineProfile) }
+
 tasks.withType<JavaCompile> {
     options.compilerArgs.add("-Xlint:-deprecation")
 }
 
+// Machine-dependent measurements (HotPathBenchmark) report numbers instead of asserting them: run with -Pbenchmark
+tasks.withType<Test>().configureEach {
+    if (!project.hasProperty("benchmark")) exclude("**/*Benchmark.class")
+}
+
 dependencies {
     implementation(libs.androidx.core.ktx)
     implementation(libs.androidx.appcompat)
@@ -141,12 +204,22 @@ dependencies {
     implementation(libs.androidx.security.crypto)
     implementation(libs.sqlcipher)
     implementation(libs.coil.compose)
+    // Installs the shipped baseline profile on sideloaded/provisioned installs that bypass Play
+    implementation(libs.androidx.profileinstaller)
     
     testImplementation(libs.junit)
     testImplementation(libs.mockito.core)
     testImplementation(libs.mockito.inline)
     testImplementation(libs.mockito.kotlin)
     testImplementation(libs.kotlin.test)
+    testImplementation(libs.okhttp.mockwebserver)
+    testImplementation(libs.okhttp.tls)
+    // Host SQLite for the DAO query-plan gate (RoomQueryPlanTest)
+    testImplementation(libs.sqlite.jdbc)
     androidTestImplementation(libs.androidx.junit)
     androidTestImplementation(libs.androidx.espresso.core)
+    // Compose UI tests (lock screen recomposition counts); versions from the BOM
+    androidTestImplementation(platform(libs.compose.bom))
+    androidTestImplementation(libs.compose.ui.test.junit4)
+    debugImplementation(libs.compose.ui.test.manifest)
 }
@@ -0,0 +1,110 @@
+﻿package com.microspace.payo
+
+import androidx.compose.runtime.CompositionLocalProvider
+import androidx.compose.runtime.remember
+import androidx.compose.runtime.rememberCoroutineScope
+import androidx.compose.ui.test.junit4.createComposeRule
+import androidx.compose.ui.test.onNodeWithText
+import androidx.compose.ui.test.performClick
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import com.microspace.payo.ui.activities.lock.payment.HardLockPaymentOverdueScreen
+import com.microspace.payo.ui.screens.lock.LocalRecompositionCounter
+import com.microspace.payo.ui.screens.lock.PinEntryScreen
+import com.microspace.payo.ui.screens.lock.RecompositionCounter
+import com.microspace.payo.ui.screens.lock.UnlockCodeState
+import org.junit.Assert.assertEquals
+import org.junit.Rule
+import org.junit.Test
+import org.junit.runner.RunWith
+
+/**
+ * Counts how much of each lock screen a single keypress recomposes: only the parts that show the
+ * entered code, plus the submit button when it becomes enabled.
+ */
+@RunWith(AndroidJUnit4::class)
+class LockScreenRecompositionTest {
+
+    @get:Rule
+    val compose = createComposeRule()
+
+    private val counter = RecompositionCounter()
+
+    @Test
+    fun pinKeypressRecomposesOnlyThePinDots() {
+        compose.setContent {
+            CompositionLocalProvider(LocalRecompositionCounter provides counter) {
+                PinEntryScreen(onPinSubmit = {}, onCancel = {})
+            }
+        }
+        val initial = compose.runOnIdle { counter.snapshot() }
+        assertEquals(10, initial["NumericKeyButton"])
+
+        // First digit: the dots change and the submit button becomes enabled
+        compose.onNodeWithText("1").performClick()
+        compose.runOnIdle {
+            assertEquals(1, counter["PinDots"] - initial.getValue("PinDots"))
+            assertEquals(1, counter["SubmitButton"] - initial.getValue("SubmitButton"))
+            assertEquals(10, counter["NumericKeyButton"])
+            assertEquals(1, counter["PinEntryScreen"])
+        }
+
+        // Further digits: only the dots
+        compose.onNodeWithText("2").performClick()
+        compose.onNodeWithText("3").performClick()
+        compose.runOnIdle {
+            assertEquals(3, counter["PinDots"] - initial.getValue("PinDots"))
+            assertEquals(1, counter["SubmitButton"] - initial.getValue("SubmitButton"))
+            assertEquals(10, counter["NumericKeyButton"])
+            assertEquals(1, counter["PinEntryScreen"])
+        }
+    }
+
+    @Test
+    fun unlockCodeKeypressRecomposesOnlyTheCodeField() {
+        // The badge and lock icon animate forever; drive frames by hand so the rule can go idle
+        compose.mainClock.autoAdvance = false
+        lateinit var state: UnlockCodeState
+        compose.setContent {
+            val scope = rememberCoroutineScope()
+            state = remember { UnlockCodeState(scope, verifier = { false }) }
+            CompositionLocalProvider(LocalRecompositionCounter provides counter) {
+                HardLockPaymentOverdueScreen(
+                    state = state,
+                    nextPaymentDate = "2026-01-01",
+                    onUnlocked = {},
+                    onContactSupport = {}
+                )
+            }
+        }
+        compose.mainClock.advanceTimeByFrame()
+        val initial = compose.runOnIdle { counter.snapshot() }
+
+        press(state, '4')
+        compose.runOnIdle {
+            assertEquals(1, counter["UnlockCodeField"] - initial.getValue("UnlockCodeField"))
+            assertEquals(1, counter["UnlockButton"] - initial.getValue("UnlockButton"))
+            assertUnchanged(initial, "HardLockPaymentOverdueScreen", "OverdueHeader", "OverdueSinceChip", "VerificationMessage")
+        }
+
+        press(state, '2')
+        press(state, '7')
+        compose.runOnIdle {
+            assertEquals(3, counter["UnlockCodeField"] - initial.getValue("UnlockCodeField"))
+            assertEquals(1, counter["UnlockButton"] - initial.getValue("UnlockButton"))
+            assertUnchanged(initial, "HardLockPaymentOverdueScreen", "OverdueHeader", "OverdueSinceChip", "VerificationMessage")
+        }
+    }
+
+    private fun press(state: UnlockCodeState, digit: Char) {
+        compose.runOnUiThread { state.appendDigit(digit) }
+        compose.waitForIdle()
+        compose.mainClock.advanceTimeByFrame()
+        compose.waitForIdle()
+    }
+
+    private fun assertUnchanged(initial: Map<String, Int>, vararg names: String) {
+        for (name in names) {
+            assertEquals("$name recomposed", initial.getValue(name), counter[name])
+        }
+    }
+}
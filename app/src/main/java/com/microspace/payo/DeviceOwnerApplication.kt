@@ -2,30 +2,37 @@ package com.microspace.payo
 
 import android.app.Activity
 import android.app.Application
-import android.content.Context
-import android.net.ConnectivityManager
-import android.net.Network
-import android.net.NetworkCapabilities
-import android.net.NetworkRequest
 import android.os.Bundle
+import android.os.UserManager
 import android.util.Log
 import androidx.work.ExistingWorkPolicy
 import androidx.work.OneTimeWorkRequestBuilder
 import androidx.work.WorkManager
+import com.microspace.payo.config.RuntimeConfigStore
+import com.microspace.payo.core.MemoryGovernor
+import com.microspace.payo.core.watchdog.SlowOperationWatchdog
+import com.microspace.payo.core.network.ConnectivityMonitor
+import com.microspace.payo.data.remote.api.SharedHttpClient
+import com.microspace.payo.data.remote.uplink.StateReportUplink
+import com.microspace.payo.state.LockInvariantMonitor
 import com.microspace.payo.data.DeviceIdProvider
+import com.microspace.payo.data.repository.PaymentStateRepository
+import com.microspace.payo.deactivation.DeviceOwnerDeactivationManager
 import com.microspace.payo.device.DeviceOwnerManager
 import com.microspace.payo.security.mode.CompleteSilentMode
 import com.microspace.payo.security.crypto.EncryptionInitializer
 import com.microspace.payo.security.crypto.EncryptedPreferencesManager
 
-import com.microspace.payo.services.data.LocalDataServerService
+import com.microspace.payo.services.host.DeviceHostService
 import com.microspace.payo.services.heartbeat.HeartbeatWorker
+import com.microspace.payo.services.payment.PaymentDeadlineEngine
 import com.microspace.payo.services.reporting.ServerBugAndLogReporter
 import com.microspace.payo.services.sync.OfflineSyncWorker
 import com.microspace.payo.update.scheduler.UpdateScheduler
 import net.sqlcipher.database.SQLiteDatabase
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
 import kotlinx.coroutines.launch
 
 class DeviceOwnerApplication : Application() {
@@ -36,22 +43,37 @@ class DeviceOwnerApplication : Application() {
             private set
     }
 
+    private val appScope = CoroutineScope(SupervisorJob() + Dispatchers.Default)
+
     override fun onCreate() {
         super.onCreate()
 
+        // Debug and staging only; first, so the rest of start-up is measured too
+        SlowOperationWatchdog.install(this, BuildConfig.SLOW_OP_WATCHDOG)
+
         setupGlobalExceptionHandler()
 
+        // Low-RAM profile and trim-memory callbacks; before anything sizes a pool or buffer
+        MemoryGovernor.install(this)
+
+        // Server-tunable intervals/timeouts; must be loaded before any scheduler starts
+        RuntimeConfigStore.init(this)
+        // Persistent DNS cache for the shared API client; before anything builds an ApiClient
+        SharedHttpClient.init(this)
+
         // Initialize SQLCipher and the encryption stack synchronously on the main
         // thread so that any Activity launched from the PAYO icon can safely use
         // encrypted preferences and Room/SQLCipher without race conditions.
         try {
-            SQLiteDatabase.loadLibs(this)
-            EncryptionInitializer.initializeEncryption(this)
+            SlowOperationWatchdog.shared.trace(SlowOperationWatchdog.Kind.CRYPTO, "app.securityInit") {
+                SQLiteDatabase.loadLibs(this)
+                EncryptionInitializer.initializeEncryption(this)
+            }
             Log.d(TAG, "✅ Security libraries loaded")
 
             DeviceIdProvider.verifyAndRepairConsistency(this)
 
-            if (DeviceOwnerManager(this).isDeviceOwner()) {
+            if (DeviceOwnerManager.getInstance(this).isDeviceOwner()) {
                 CompleteSilentMode(this).enableCompleteSilentMode()
             }
 
@@ -64,38 +86,61 @@ class DeviceOwnerApplication : Application() {
     }
 
     private fun startServicesAndTasks() {
-        // Start Local JSON Data Server
-        LocalDataServerService.startService(this)
+        // State reports (installation status, deactivation confirmation) an earlier process queued
+        appScope.launch { StateReportUplink.getInstance(this@DeviceOwnerApplication) }
+
+        // A deactivation cut short by a crash or kill finishes first (the boot receiver does it on a
+        // locked boot, once unlocked); only the heartbeat keeps running until it completes or is
+        // abandoned, and an abandoned one restarts the managed services itself
+        val deactivation = DeviceOwnerDeactivationManager(this)
+        if (deactivation.isDeactivationInProgress()) {
+            if (getSystemService(UserManager::class.java).isUserUnlocked) {
+                HeartbeatWorker.enqueue(this)
+                Log.w(TAG, "Deactivation was interrupted, resuming")
+                appScope.launch { deactivation.resumeIfInterrupted() }
+            }
+            return
+        }
+
+        // Device host: heartbeat and monitoring once registered
+        DeviceHostService.start(this)
 
         // Network callback for offline sync
         registerNetworkCallbackForOfflineSync()
 
         // Auto-update scheduler
-        if (DeviceOwnerManager(this).isDeviceOwner()) {
+        if (DeviceOwnerManager.getInstance(this).isDeviceOwner()) {
             UpdateScheduler.schedulePeriodicChecks(this)
         }
 
-        // Initialize Monitoring Service if registered (using Encrypted Preferences)
-        val prefsManager = EncryptedPreferencesManager(this)
+        // Backup heartbeat worker if registered (using Encrypted Preferences)
+        val prefsManager = EncryptedPreferencesManager.getInstance(this)
         val regPrefs = prefsManager.getRegistrationPreferences()
         val serverDeviceId = regPrefs.getString("device_id", null)
 
         if (!serverDeviceId.isNullOrEmpty()) {
-            com.microspace.payo.monitoring.SecurityMonitorService.startService(this)
             // ✅ START PERIODIC HEARTBEAT WORKER
             HeartbeatWorker.enqueue(this)
         }
+
+        // Lock-state invariants are re-checked as their sources change; off main, it loads payment state
+        appScope.launch { LockInvariantMonitor.getInstance(this@DeviceOwnerApplication) }
+
+        // Local payment deadlines follow the payment date and server time held in payment state
+        appScope.launch {
+            val payments = PaymentStateRepository.getInstance(this@DeviceOwnerApplication)
+            PaymentDeadlineEngine.getInstance(this@DeviceOwnerApplication).start(payments.state, payments::awaitLoaded)
+        }
     }
 
     private fun registerNetworkCallbackForOfflineSync() {
-        val cm = getSystemService(Context.CONNECTIVITY_SERVICE) as? ConnectivityManager ?: return
-        val request = NetworkRequest.Builder().addCapability(NetworkCapabilities.NET_CAPABILITY_INTERNET).build()
-        cm.registerDefaultNetworkCallback(object : ConnectivityManager.NetworkCallback() {
-            override fun onAvailable(network: Network) {
+        // Rides on the process-wide default network callback instead of registering another one
+        appScope.launch {
+            ConnectivityMonitor.getInstance(this@DeviceOwnerApplication).onlineTransitions.collect {
                 val work = OneTimeWorkRequestBuilder<OfflineSyncWorker>().build()
                 WorkManager.getInstance(this@DeviceOwnerApplication).enqueueUniqueWork("OfflineSync", ExistingWorkPolicy.REPLACE, work)
             }
-        })
+        }
     }
 
     private fun setupGlobalExceptionHandler() {
@@ -88,11 +88,11 @@ object FrpConfig {
     const val SECURITY_SCAN_INTERVAL_MINUTES = 5L
     const val SECURITY_SCAN_INTERVAL_MILLIS = SECURITY_SCAN_INTERVAL_MINUTES * 60 * 1000
 
-    /** FRP verification interval (after activation) - check every 24 hours */
+    /** FRP verification interval (after activation) - default; live value in [RuntimeConfigStore] */
     const val FRP_VERIFICATION_INTERVAL_HOURS = 24L
     const val FRP_VERIFICATION_INTERVAL_MILLIS = FRP_VERIFICATION_INTERVAL_HOURS * 60 * 60 * 1000
 
-    /** GMS availability check interval */
+    /** GMS availability check interval - default; live value in [RuntimeConfigStore] */
     const val GMS_CHECK_INTERVAL_MINUTES = 30L
     const val GMS_CHECK_INTERVAL_MILLIS = GMS_CHECK_INTERVAL_MINUTES * 60 * 1000
 
@@ -0,0 +1,107 @@
+﻿package com.microspace.payo.config
+
+import com.google.gson.annotations.SerializedName
+import com.microspace.payo.update.config.UpdateConfig
+
+/**
+ * Runtime tuning values.
+ *
+ * Defaults are the former compiled-in constants; the server may override any subset
+ * through a signed [SignedConfigBlob] in the heartbeat response.
+ */
+data class RuntimeConfig(
+    val version: Int = 0,
+    val heartbeatIntervalMs: Long = 10_000L,
+    val updateCheckIntervalSeconds: Long = UpdateConfig.UPDATE_CHECK_INTERVAL_SECONDS,
+    val frpVerificationIntervalHours: Long = FrpConfig.FRP_VERIFICATION_INTERVAL_HOURS,
+    val gmsCheckIntervalMinutes: Long = FrpConfig.GMS_CHECK_INTERVAL_MINUTES,
+    val offlineSyncBatchSize: Int = 10,
+    val apiConnectTimeoutSeconds: Long = 120L,
+    val apiReadTimeoutSeconds: Long = 120L,
+    val apiWriteTimeoutSeconds: Long = 120L,
+    val apiCallTimeoutSeconds: Long = 240L,
+    val kioskCheckIntervalMs: Long = 2_000L,
+    val accessibilityCheckIntervalMs: Long = 3_000L,
+    val removalCheckIntervalMs: Long = 5_000L,
+    val paymentGraceHours: Long = 24L
+) {
+
+    /**
+     * Returns the list of out-of-range fields; empty means the config is safe to apply.
+     */
+    fun validate(): List<String> {
+        val errors = mutableListOf<String>()
+        fun check(name: String, value: Long, range: LongRange) {
+            if (value !in range) errors.add("$name=$value not in $range")
+        }
+        check("heartbeat_interval_ms", heartbeatIntervalMs, 5_000L..15 * 60_000L)
+        check("update_check_interval_seconds", updateCheckIntervalSeconds, 30L..7 * 24 * 3600L)
+        check("frp_verification_interval_hours", frpVerificationIntervalHours, 1L..7 * 24L)
+        // WorkManager rejects periodic work below 15 minutes
+        check("gms_check_interval_minutes", gmsCheckIntervalMinutes, 15L..24 * 60L)
+        check("offline_sync_batch_size", offlineSyncBatchSize.toLong(), 1L..200L)
+        check("api_connect_timeout_seconds", apiConnectTimeoutSeconds, 5L..300L)
+        check("api_read_timeout_seconds", apiReadTimeoutSeconds, 5L..300L)
+        check("api_write_timeout_seconds", apiWriteTimeoutSeconds, 5L..300L)
+        check("api_call_timeout_seconds", apiCallTimeoutSeconds, 10L..600L)
+        check("kiosk_check_interval_ms", kioskCheckIntervalMs, 500L..60_000L)
+        check("accessibility_check_interval_ms", accessibilityCheckIntervalMs, 500L..60_000L)
+        check("removal_check_interval_ms", removalCheckIntervalMs, 1_000L..60_000L)
+        check("payment_grace_hours", paymentGraceHours, 0L..7 * 24L)
+        if (apiCallTimeoutSeconds < apiConnectTimeoutSeconds) {
+            errors.add("api_call_timeout_seconds must be >= api_connect_timeout_seconds")
+        }
+        return errors
+    }
+
+    fun withOverrides(o: RuntimeConfigOverrides): RuntimeConfig = copy(
+        version = o.version ?: version,
+        heartbeatIntervalMs = o.heartbeatIntervalMs ?: heartbeatIntervalMs,
+        updateCheckIntervalSeconds = o.updateCheckIntervalSeconds ?: updateCheckIntervalSeconds,
+        frpVerificationIntervalHours = o.frpVerificationIntervalHours ?: frpVerificationIntervalHours,
+        gmsCheckIntervalMinutes = o.gmsCheckIntervalMinutes ?: gmsCheckIntervalMinutes,
+        offlineSyncBatchSize = o.offlineSyncBatchSize ?: offlineSyncBatchSize,
+        apiConnectTimeoutSeconds = o.apiConnectTimeoutSeconds ?: apiConnectTimeoutSeconds,
+        apiReadTimeoutSeconds = o.apiReadTimeoutSeconds ?: apiReadTimeoutSeconds,
+        apiWriteTimeoutSeconds = o.apiWriteTimeoutSeconds ?: apiWriteTimeoutSeconds,
+        apiCallTimeoutSeconds = o.apiCallTimeoutSeconds ?: apiCallTimeoutSeconds,
+        kioskCheckIntervalMs = o.kioskCheckIntervalMs ?: kioskCheckIntervalMs,
+        accessibilityCheckIntervalMs = o.accessibilityCheckIntervalMs ?: accessibilityCheckIntervalMs,
+        removalCheckIntervalMs = o.removalCheckIntervalMs ?: removalCheckIntervalMs,
+        paymentGraceHours = o.paymentGraceHours ?: paymentGraceHours
+    )
+
+    companion object {
+        val DEFAULTS = RuntimeConfig()
+    }
+}
+
+/**
+ * Server-side payload: every field is optional and falls back to the compiled-in default.
+ */
+data class RuntimeConfigOverrides(
+    @SerializedName("version") val version: Int? = null,
+    @SerializedName("heartbeat_interval_ms") val heartbeatIntervalMs: Long? = null,
+    @SerializedName("update_check_interval_seconds") val updateCheckIntervalSeconds: Long? = null,
+    @SerializedName("frp_verification_interval_hours") val frpVerificationIntervalHours: Long? = null,
+    @SerializedName("gms_check_interval_minutes") val gmsCheckIntervalMinutes: Long? = null,
+    @SerializedName("offline_sync_batch_size") val offlineSyncBatchSize: Int? = null,
+    @SerializedName("api_connect_timeout_seconds") val apiConnectTimeoutSeconds: Long? = null,
+    @SerializedName("api_read_timeout_seconds") val apiReadTimeoutSeconds: Long? = null,
+    @SerializedName("api_write_timeout_seconds") val apiWriteTimeoutSeconds: Long? = null,
+    @SerializedName("api_call_timeout_seconds") val apiCallTimeoutSeconds: Long? = null,
+    @SerializedName("kiosk_check_interval_ms") val kioskCheckIntervalMs: Long? = null,
+    @SerializedName("accessibility_check_interval_ms") val accessibilityCheckIntervalMs: Long? = null,
+    @SerializedName("removal_check_interval_ms") val removalCheckIntervalMs: Long? = null,
+    @SerializedName("payment_grace_hours") val paymentGraceHours: Long? = null
+)
+
+/**
+ * Config as delivered in the heartbeat response: [payload] is the JSON of
+ * [RuntimeConfigOverrides], [signature] its hex DER ECDSA signature by the server's config
+ * signing key (see [com.microspace.payo.security.crypto.SignedPayloadVerifier]).
+ */
+data class SignedConfigBlob(
+    @SerializedName("payload") val payload: String? = null,
+    @SerializedName("signature") val signature: String? = null
+)
@@ -0,0 +1,139 @@
+﻿package com.microspace.payo.config
+
+import android.content.Context
+import android.util.Log
+import com.google.gson.Gson
+import com.microspace.payo.security.crypto.SignedPayloadVerifier
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.StateFlow
+import kotlinx.coroutines.flow.asStateFlow
+import java.io.File
+import java.io.FileOutputStream
+
+/**
+ * RuntimeConfigStore - process-wide [RuntimeConfig] snapshot.
+ *
+ * Loaded once in [com.microspace.payo.DeviceOwnerApplication], replaced by signed blobs from
+ * the heartbeat response. A blob is applied only if its signature verifies against the pinned
+ * server key, its version is newer and every value is in its safe range; otherwise the last good
+ * config stays active. Without a pinned key every blob is ignored and the defaults stay active.
+ * Schedulers read [current] on every tick, so changes take effect without a restart.
+ */
+object RuntimeConfigStore {
+
+    private const val TAG = "RuntimeConfigStore"
+    private const val FILE_NAME = "runtime_config.json"
+
+    private val gson = Gson()
+    private val _config = MutableStateFlow(RuntimeConfig.DEFAULTS)
+    val config: StateFlow<RuntimeConfig> = _config.asStateFlow()
+
+    val current: RuntimeConfig
+        get() = _config.value
+
+    @Volatile
+    private var file: File? = null
+
+    /** Replaced in tests, which sign with their own key pair. */
+    @Volatile
+    internal var verifier: SignedPayloadVerifier? = null
+
+    sealed class Outcome {
+        data class Accepted(val config: RuntimeConfig) : Outcome()
+        data class Rejected(val reason: String) : Outcome()
+    }
+
+    fun init(context: Context) {
+        if (file != null) return
+        synchronized(this) {
+            if (file != null) return
+            val f = File(context.applicationContext.filesDir, FILE_NAME)
+            file = f
+            _config.value = verifier()?.let { restore(f, it) } ?: RuntimeConfig.DEFAULTS
+            Log.i(TAG, "Runtime config v${current.version} active")
+        }
+    }
+
+    /**
+     * Applies a server-delivered blob. Returns true if the active config changed.
+     */
+    fun apply(context: Context, blob: SignedConfigBlob): Boolean {
+        init(context)
+        val verifier = verifier() ?: run {
+            Log.w(TAG, "Runtime config push ignored: no config signing key is pinned")
+            return false
+        }
+        return when (val outcome = resolve(current, blob, verifier)) {
+            is Outcome.Accepted -> {
+                val target = file
+                if (target != null && !persistAtomically(target, gson.toJson(blob))) {
+                    Log.e(TAG, "Failed to persist config v${outcome.config.version}; keeping v${current.version}")
+                    return false
+                }
+                _config.value = outcome.config
+                Log.i(TAG, "✅ Runtime config updated to v${outcome.config.version}")
+                true
+            }
+            is Outcome.Rejected -> {
+                Log.w(TAG, "⚠️ Runtime config rejected, keeping v${current.version}: ${outcome.reason}")
+                false
+            }
+        }
+    }
+
+    internal fun resolve(active: RuntimeConfig, blob: SignedConfigBlob, verifier: SignedPayloadVerifier): Outcome {
+        val payload = blob.payload ?: return Outcome.Rejected("missing payload")
+        val signature = blob.signature ?: return Outcome.Rejected("missing signature")
+        if (!verifier.verify(payload, signature)) return Outcome.Rejected("bad signature")
+
+        val overrides = try {
+            gson.fromJson(payload, RuntimeConfigOverrides::class.java)
+        } catch (e: Exception) {
+            null
+        } ?: return Outcome.Rejected("unparseable payload")
+
+        val version = overrides.version ?: return Outcome.Rejected("missing version")
+        if (version <= active.version) return Outcome.Rejected("stale version $version <= ${active.version}")
+
+        // Overrides always apply on top of the compiled-in defaults, never on top of a previous blob.
+        val candidate = RuntimeConfig.DEFAULTS.withOverrides(overrides)
+        val errors = candidate.validate()
+        if (errors.isNotEmpty()) return Outcome.Rejected(errors.joinToString("; "))
+        return Outcome.Accepted(candidate)
+    }
+
+    /**
+     * Reads the persisted blob; anything unreadable or invalid rolls back to the defaults.
+     */
+    internal fun restore(file: File, verifier: SignedPayloadVerifier): RuntimeConfig {
+        if (!file.exists()) return RuntimeConfig.DEFAULTS
+        val blob = try {
+            gson.fromJson(file.readText(), SignedConfigBlob::class.java)
+        } catch (e: Exception) {
+            null
+        } ?: return RuntimeConfig.DEFAULTS
+        return when (val outcome = resolve(RuntimeConfig.DEFAULTS, blob, verifier)) {
+            is Outcome.Accepted -> outcome.config
+            is Outcome.Rejected -> RuntimeConfig.DEFAULTS
+        }
+    }
+
+    /**
+     * Write-to-temp, fsync, rename: a crash leaves either the old or the new file, never half of one.
+     */
+    internal fun persistAtomically(target: File, text: String): Boolean {
+        val tmp = File(target.parentFile, target.name + ".tmp")
+        return try {
+            FileOutputStream(tmp).use { out ->
+                out.write(text.toByteArray(Charsets.UTF_8))
+                out.fd.sync()
+            }
+            tmp.renameTo(target)
+        } catch (e: Exception) {
+            tmp.delete()
+            false
+        }
+    }
+
+    private fun verifier(): SignedPayloadVerifier? = verifier ?: SignedPayloadVerifier.server
+}
@@ -0,0 +1,66 @@
+﻿package com.microspace.payo.control
+
+import android.app.admin.DevicePolicyManager
+import android.content.ComponentName
+import android.content.Context
+import android.os.Build
+import com.microspace.payo.core.watchdog.SlowOperationWatchdog
+import com.microspace.payo.receivers.admin.AdminReceiver
+
+/**
+ * [LockPolicyTarget] backed by the real DevicePolicyManager; API-level guards live here
+ * so contributors can describe the policy without repeating them.
+ */
+class DpmLockPolicyTarget(private val context: Context) : LockPolicyTarget {
+
+    private val dpm = context.getSystemService(Context.DEVICE_POLICY_SERVICE) as DevicePolicyManager
+    private val admin = ComponentName(context, AdminReceiver::class.java)
+
+    fun isDeviceOwner(): Boolean = try {
+        binder("dpm.isDeviceOwnerApp") { dpm.isDeviceOwnerApp(context.packageName) }
+    } catch (e: Exception) {
+        false
+    }
+
+    override fun setLockTaskPackages(packages: Array<String>) =
+        binder("dpm.setLockTaskPackages") { dpm.setLockTaskPackages(admin, packages) }
+
+    override fun setLockTaskFeatures(flags: Int) {
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.P) binder("dpm.setLockTaskFeatures") { dpm.setLockTaskFeatures(admin, flags) }
+    }
+
+    override fun setStatusBarDisabled(disabled: Boolean) {
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.M) binder("dpm.setStatusBarDisabled") { dpm.setStatusBarDisabled(admin, disabled) }
+    }
+
+    override fun setKeyguardDisabledFeatures(flags: Int) =
+        binder("dpm.setKeyguardDisabledFeatures") { dpm.setKeyguardDisabledFeatures(admin, flags) }
+
+    override fun addUserRestriction(restriction: String) =
+        binder("dpm.addUserRestriction") { dpm.addUserRestriction(admin, restriction) }
+
+    override fun clearUserRestriction(restriction: String) =
+        binder("dpm.clearUserRestriction") { dpm.clearUserRestriction(admin, restriction) }
+
+    override fun setAutoTimeRequired(required: Boolean) =
+        binder("dpm.setAutoTimeRequired") { dpm.setAutoTimeRequired(admin, required) }
+
+    override fun setUninstallBlocked(blocked: Boolean) {
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
+            binder("dpm.setUninstallBlocked") { dpm.setUninstallBlocked(admin, context.packageName, blocked) }
+        }
+    }
+
+    override fun installedPackages(): List<String> =
+        binder("pm.getInstalledPackages") { context.packageManager.getInstalledPackages(0) }.map { it.packageName }
+
+    override fun setPackagesSuspended(packages: Array<String>, suspended: Boolean) {
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.N) {
+            binder("dpm.setPackagesSuspended") { dpm.setPackagesSuspended(admin, packages, suspended) }
+        }
+    }
+
+    // Each call is a binder transaction into system_server; policy is often applied from the lock UI
+    private inline fun <T> binder(name: String, block: () -> T): T =
+        SlowOperationWatchdog.shared.trace(SlowOperationWatchdog.Kind.BINDER, name, block)
+}
@@ -7,6 +7,8 @@ import android.content.Intent
 import android.util.Log
 import com.microspace.payo.receivers.admin.AdminReceiver
 import com.microspace.payo.ui.activities.lock.security.SecurityViolationActivity
+import com.microspace.payo.utils.storage.PrefsWriteCoalescer
+import com.microspace.payo.core.ProcessManagers
 
 /**
  * HardLockManager - Applies system-level hard locks to device
@@ -20,6 +22,10 @@ class HardLockManager(private val context: Context) {
         const val LOCK_REASON_KEY = "lock_reason"
         const val LOCK_TIMESTAMP_KEY = "lock_timestamp"
         const val LOCK_SOURCE_KEY = "lock_source"
+
+        /** The process instance for [context]'s storage area; see [ProcessManagers]. */
+        fun getInstance(context: Context): HardLockManager =
+            ProcessManagers.get(context, HardLockManager::class.java, ::HardLockManager)
     }
     
     private val devicePolicyManager: DevicePolicyManager =
@@ -28,6 +34,8 @@ class HardLockManager(private val context: Context) {
     private val adminComponent: ComponentName =
         ComponentName(context, com.microspace.payo.receivers.admin.AdminReceiver::class.java)
     
+    private val lockPrefs = PrefsWriteCoalescer.getInstance().plain(context, LOCK_PREF_NAME)
+    
     fun applyHardLock(
         reason: String,
         recommendation: String? = null,
@@ -85,44 +93,40 @@ class HardLockManager(private val context: Context) {
     }
     
     fun getLockType(): String? {
-        val sharedPref = context.getSharedPreferences(LOCK_PREF_NAME, Context.MODE_PRIVATE)
-        return sharedPref.getString(LOCK_TYPE_KEY, null)
+        return lockPrefs.getString(LOCK_TYPE_KEY, null)
     }
     
     fun getLockReason(): String? {
-        val sharedPref = context.getSharedPreferences(LOCK_PREF_NAME, Context.MODE_PRIVATE)
-        return sharedPref.getString(LOCK_REASON_KEY, null)
+        return lockPrefs.getString(LOCK_REASON_KEY, null)
     }
     
     fun getLockTimestamp(): Long {
-        val sharedPref = context.getSharedPreferences(LOCK_PREF_NAME, Context.MODE_PRIVATE)
-        return sharedPref.getLong(LOCK_TIMESTAMP_KEY, 0L)
+        return lockPrefs.getLong(LOCK_TIMESTAMP_KEY, 0L)
     }
     
     fun getLockSource(): String? {
-        val sharedPref = context.getSharedPreferences(LOCK_PREF_NAME, Context.MODE_PRIVATE)
-        return sharedPref.getString(LOCK_SOURCE_KEY, null)
+        return lockPrefs.getString(LOCK_SOURCE_KEY, null)
     }
     
     private fun saveLockState(lockType: String, reason: String, source: String) {
-        val sharedPref = context.getSharedPreferences(LOCK_PREF_NAME, Context.MODE_PRIVATE)
-        sharedPref.edit().apply {
+        // Lock state must survive a kill right after it is set: written before returning
+        lockPrefs.edit().apply {
             putString(LOCK_TYPE_KEY, lockType)
             putString(LOCK_REASON_KEY, reason)
             putLong(LOCK_TIMESTAMP_KEY, System.currentTimeMillis())
             putString(LOCK_SOURCE_KEY, source)
-            apply()
+            commit()
         }
     }
     
     fun clearLockState() {
-        val sharedPref = context.getSharedPreferences(LOCK_PREF_NAME, Context.MODE_PRIVATE)
-        sharedPref.edit().apply {
+        // Lock state must survive a kill right after it is set: written before returning
+        lockPrefs.edit().apply {
             remove(LOCK_TYPE_KEY)
             remove(LOCK_REASON_KEY)
             remove(LOCK_TIMESTAMP_KEY)
             remove(LOCK_SOURCE_KEY)
-            apply()
+            commit()
         }
     }
     
@@ -0,0 +1,162 @@
+﻿package com.microspace.payo.control
+
+import android.util.Log
+
+/**
+ * Device policy calls a [LockPolicyTransaction] is allowed to make.
+ * Production goes through [DpmLockPolicyTarget]; tests record the calls.
+ */
+interface LockPolicyTarget {
+    fun setLockTaskPackages(packages: Array<String>)
+    fun setLockTaskFeatures(flags: Int)
+    fun setStatusBarDisabled(disabled: Boolean)
+    fun setKeyguardDisabledFeatures(flags: Int)
+    fun addUserRestriction(restriction: String)
+    fun clearUserRestriction(restriction: String)
+    fun setAutoTimeRequired(required: Boolean)
+    fun setUninstallBlocked(blocked: Boolean)
+    fun installedPackages(): List<String>
+    fun setPackagesSuspended(packages: Array<String>, suspended: Boolean)
+}
+
+/**
+ * Collects the complete kiosk / hard-lock policy from every contributor, then applies it
+ * in one pass: each setting is written once, user-visible blocking steps first.
+ *
+ * Later writes to the same setting replace earlier ones; lock-task packages and
+ * suspension exemptions are merged. A user restriction any contributor [restrict]s stays
+ * restricted no matter who [allow]s it or in which order, so an allowance can never reopen a lock.
+ */
+class LockPolicyTransaction {
+
+    /** Apply order. Everything up to [KEYGUARD] is what the user can see or escape through. */
+    enum class Step(val blocking: Boolean) {
+        LOCK_TASK_PACKAGES(true),
+        LOCK_TASK_FEATURES(true),
+        STATUS_BAR(true),
+        KEYGUARD(true),
+        USER_RESTRICTIONS(false),
+        AUTO_TIME(false),
+        UNINSTALL_BLOCKED(false),
+        PACKAGE_SUSPENSION(false)
+    }
+
+    data class StepTiming(val step: Step, val durationNanos: Long, val calls: Int, val error: String?)
+
+    data class Report(val steps: List<StepTiming>) {
+        val totalNanos: Long get() = steps.sumOf { it.durationNanos }
+        val blockingNanos: Long get() = steps.filter { it.step.blocking }.sumOf { it.durationNanos }
+        val failed: List<Step> get() = steps.filter { it.error != null }.map { it.step }
+
+        override fun toString(): String = steps.joinToString(
+            prefix = "total=${totalNanos / 1_000}us blocking=${blockingNanos / 1_000}us [",
+            postfix = "]"
+        ) { "${it.step.name.lowercase()}=${it.durationNanos / 1_000}us/${it.calls}" + (it.error?.let { e -> " ($e)" } ?: "") }
+    }
+
+    private val lockTaskPackages = LinkedHashSet<String>()
+    private var lockTaskFeatures: Int? = null
+    private var statusBarDisabled: Boolean? = null
+    private var keyguardDisabledFeatures: Int? = null
+    private val restrictions = LinkedHashMap<String, Boolean>()
+    private var autoTimeRequired: Boolean? = null
+    private var uninstallBlocked: Boolean? = null
+    private var suspendOthers = false
+    private val suspensionExempt = HashSet<String>()
+
+    fun lockTaskPackages(vararg packages: String) = apply { lockTaskPackages.addAll(packages) }
+
+    fun lockTaskFeatures(flags: Int) = apply { lockTaskFeatures = flags }
+
+    fun statusBarDisabled(disabled: Boolean) = apply { statusBarDisabled = disabled }
+
+    fun keyguardDisabledFeatures(flags: Int) = apply { keyguardDisabledFeatures = flags }
+
+    fun restrict(vararg names: String) = apply { names.forEach { restrictions[it] = true } }
+
+    /** Clears [names] unless some contributor restricts them. */
+    fun allow(vararg names: String) = apply { names.forEach { restrictions.putIfAbsent(it, false) } }
+
+    fun autoTimeRequired(required: Boolean) = apply { autoTimeRequired = required }
+
+    fun uninstallBlocked(blocked: Boolean) = apply { uninstallBlocked = blocked }
+
+    /** Suspends every installed package except [exempt] (and anything exempted by other contributors). */
+    fun suspendAllExcept(vararg exempt: String) = apply {
+        suspendOthers = true
+        suspensionExempt.addAll(exempt)
+    }
+
+    val isEmpty: Boolean
+        get() = lockTaskPackages.isEmpty() && lockTaskFeatures == null && statusBarDisabled == null &&
+            keyguardDisabledFeatures == null && restrictions.isEmpty() && autoTimeRequired == null &&
+            uninstallBlocked == null && !suspendOthers
+
+    /**
+     * Applies the collected policy to [target]. A failing step is logged and recorded in the
+     * report but does not stop the remaining steps. [onBlockingApplied] runs exactly once, as
+     * soon as the blocking steps are in place (e.g. to show the lock screen), even if they failed.
+     */
+    fun commit(target: LockPolicyTarget, onBlockingApplied: (() -> Unit)? = null): Report {
+        val timings = ArrayList<StepTiming>(Step.values().size)
+        var blockingSignalled = false
+
+        for (step in Step.values()) {
+            if (!step.blocking && !blockingSignalled) {
+                blockingSignalled = true
+                onBlockingApplied?.invoke()
+            }
+            val start = System.nanoTime()
+            var calls = 0
+            val error = try {
+                calls = applyStep(step, target)
+                null
+            } catch (e: Exception) {
+                Log.e(TAG, "Step $step failed: ${e.message}")
+                e.message ?: e.javaClass.simpleName
+            }
+            if (calls > 0 || error != null) {
+                timings.add(StepTiming(step, System.nanoTime() - start, calls, error))
+            }
+        }
+        if (!blockingSignalled) onBlockingApplied?.invoke()
+
+        return Report(timings).also { Log.i(TAG, "Lock policy applied: $it") }
+    }
+
+    /** Returns the number of policy calls made. */
+    private fun applyStep(step: Step, target: LockPolicyTarget): Int = when (step) {
+        Step.LOCK_TASK_PACKAGES -> if (lockTaskPackages.isEmpty()) 0 else {
+            target.setLockTaskPackages(lockTaskPackages.toTypedArray()); 1
+        }
+        Step.LOCK_TASK_FEATURES -> lockTaskFeatures?.let { target.setLockTaskFeatures(it); 1 } ?: 0
+        Step.STATUS_BAR -> statusBarDisabled?.let { target.setStatusBarDisabled(it); 1 } ?: 0
+        Step.KEYGUARD -> keyguardDisabledFeatures?.let { target.setKeyguardDisabledFeatures(it); 1 } ?: 0
+        Step.USER_RESTRICTIONS -> {
+            var failures = 0
+            for ((restriction, add) in restrictions) {
+                try {
+                    if (add) target.addUserRestriction(restriction) else target.clearUserRestriction(restriction)
+                } catch (e: Exception) {
+                    failures++
+                    Log.e(TAG, "Failed to ${if (add) "add" else "clear"} $restriction: ${e.message}")
+                }
+            }
+            if (failures > 0 && failures == restrictions.size) throw IllegalStateException("all $failures restrictions failed")
+            restrictions.size
+        }
+        Step.AUTO_TIME -> autoTimeRequired?.let { target.setAutoTimeRequired(it); 1 } ?: 0
+        Step.UNINSTALL_BLOCKED -> uninstallBlocked?.let { target.setUninstallBlocked(it); 1 } ?: 0
+        Step.PACKAGE_SUSPENSION -> if (!suspendOthers) 0 else {
+            val exempt = suspensionExempt + lockTaskPackages
+            val packages = target.installedPackages().filter { it !in exempt }
+            if (packages.isEmpty()) 1 else {
+                target.setPackagesSuspended(packages.toTypedArray(), true); 2
+            }
+        }
+    }
+
+    companion object {
+        private const val TAG = "LockPolicyTransaction"
+    }
+}
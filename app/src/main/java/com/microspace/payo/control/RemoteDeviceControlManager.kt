@@ -24,6 +24,7 @@ import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.SupervisorJob
 import kotlinx.coroutines.launch
 import kotlinx.coroutines.withContext
+import com.microspace.payo.core.ProcessManagers
 
 /**
  * Remote lock control: manages specialized lock activities and enforcement.
@@ -35,7 +36,12 @@ class RemoteDeviceControlManager(private val context: Context) {
 
     companion object {
         private const val TAG = "RemoteControl"
-        private const val PREFS = "control_prefs"
+
+        /** The process instance for [context]'s storage area; see [ProcessManagers]. */
+        fun getInstance(context: Context): RemoteDeviceControlManager =
+            ProcessManagers.get(context, RemoteDeviceControlManager::class.java, ::RemoteDeviceControlManager)
+
+        internal const val PREFS = "control_prefs"
         const val LOCK_UNLOCKED = "unlocked"
         const val LOCK_SOFT = "soft_lock"
         const val LOCK_HARD = "hard_lock"
@@ -101,10 +107,10 @@ class RemoteDeviceControlManager(private val context: Context) {
         return getLockType()
     }
 
-    fun checkAndEnforceLockStateFromBoot() {
+    fun checkAndEnforceLockStateFromBoot(extraPolicy: (LockPolicyTransaction.() -> Unit)? = null) {
         val state = getLockStateForBoot()
         if (state == LOCK_HARD) {
-            applyHardLock(reason = getLockReasonForBoot(), lockType = getLockTypeForBoot())
+            applyHardLock(reason = getLockReasonForBoot(), lockType = getLockTypeForBoot(), extraPolicy = extraPolicy)
         }
     }
 
@@ -116,7 +122,8 @@ class RemoteDeviceControlManager(private val context: Context) {
         forceRestart: Boolean = false,
         forceFromServerOrMismatch: Boolean = false,
         tamperType: String? = null,
-        nextPaymentDate: String? = null
+        nextPaymentDate: String? = null,
+        extraPolicy: (LockPolicyTransaction.() -> Unit)? = null
     ) {
         Log.e(TAG, "ðŸ”’ APPLYING HARD LOCK ($lockType): $reason")
         
@@ -124,32 +131,41 @@ class RemoteDeviceControlManager(private val context: Context) {
         saveHardLockStateToDeviceProtected(reason, lockType)
         saveLockStateToDatabase(LOCK_HARD, reason, tamperType ?: if (lockType == TYPE_TAMPER) "SYSTEM_MODIFIED" else null)
 
-        showLockActivity(reason, lockType, nextPaymentDate)
-
         if (lockType == TYPE_DEACTIVATION) {
+            showLockActivity(reason, lockType, nextPaymentDate)
             Log.w(TAG, "ðŸ”“ Master Override: Skipping restrictions for Deactivation Flow")
             return 
         }
 
+        val target = DpmLockPolicyTarget(context)
+        if (!target.isDeviceOwner()) {
+            showLockActivity(reason, lockType, nextPaymentDate)
+            return
+        }
+
+        val transaction = hardLockPolicy()
+        extraPolicy?.invoke(transaction)
         ioScope.launch {
-            if (dpm.isDeviceOwnerApp(context.packageName)) {
-                try {
-                    val lockTaskPackages = arrayOf(context.packageName) + ALLOWED_PACKAGES
-                    dpm.setLockTaskPackages(admin, lockTaskPackages)
-                    suspendAllOtherPackages(true)
-                    
-                    if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.M) {
-                        dpm.setStatusBarDisabled(admin, true)
-                        dpm.setKeyguardDisabledFeatures(admin, DevicePolicyManager.KEYGUARD_DISABLE_FEATURES_ALL)
-                    }
-                    applyRestrictions(reason)
-                } catch (e: Exception) {
-                    Log.e(TAG, "DPM apply error: ${e.message}")
-                }
-            }
+            // The lock screen goes up once lock-task packages, status bar and keyguard are in place,
+            // so its startLockTask() no longer races the whitelist.
+            transaction.commit(target) { showLockActivity(reason, lockType, nextPaymentDate) }
         }
     }
 
+    /**
+     * Policy every hard lock applies; callers add to it via applyHardLock(extraPolicy).
+     */
+    fun hardLockPolicy(): LockPolicyTransaction = LockPolicyTransaction()
+        .lockTaskPackages(context.packageName, *ALLOWED_PACKAGES)
+        .statusBarDisabled(true)
+        .keyguardDisabledFeatures(DevicePolicyManager.KEYGUARD_DISABLE_FEATURES_ALL)
+        .restrict(
+            UserManager.DISALLOW_SAFE_BOOT,
+            UserManager.DISALLOW_USB_FILE_TRANSFER,
+            UserManager.DISALLOW_MOUNT_PHYSICAL_MEDIA
+        )
+        .suspendAllExcept()
+
     fun unlockDevice() {
         Log.i(TAG, "ðŸ”“ UNLOCKING DEVICE")
         saveState(LOCK_UNLOCKED, "", "")
@@ -199,17 +215,6 @@ class RemoteDeviceControlManager(private val context: Context) {
         }
     }
 
-    private fun applyRestrictions(reason: String) {
-        val restrictions = mutableListOf(
-            UserManager.DISALLOW_SAFE_BOOT,
-            UserManager.DISALLOW_USB_FILE_TRANSFER,
-            UserManager.DISALLOW_MOUNT_PHYSICAL_MEDIA
-        )
-        for (restriction in restrictions) {
-            try { dpm.addUserRestriction(admin, restriction) } catch (_: Exception) {}
-        }
-    }
-
     fun showLockActivity(reason: String, lockType: String, nextPaymentDate: String?) {
         Handler(Looper.getMainLooper()).post {
             val activityClass = when (lockType) {
@@ -0,0 +1,179 @@
+﻿package com.microspace.payo.core
+
+import android.app.ActivityManager
+import android.content.ComponentCallbacks2
+import android.content.Context
+import android.content.res.Configuration
+import android.util.Log
+import kotlinx.coroutines.CoroutineDispatcher
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.launch
+import java.util.concurrent.CopyOnWriteArrayList
+
+/**
+ * MemoryGovernor - one memory budget for the app's caches and buffers.
+ *
+ * On 1-2 GB devices the app competes with the lock screen's own rendering, and nothing used to
+ * give memory back. Caches and buffers register as [Consumer]s; trim-memory callbacks release
+ * them in [Priority] order (disposable first, buffered data last) on the governor's dispatcher,
+ * since releasing may close sockets or write to disk. Above [Profile.budgetBytes] the same order
+ * applies until the total is back under budget.
+ *
+ * On a low-RAM device [install] selects [Profile.LOW_RAM]: smaller pools and commit windows, no
+ * verbose logging.
+ */
+class MemoryGovernor internal constructor(dispatcher: CoroutineDispatcher) : ComponentCallbacks2 {
+
+    /** Trim order: the cheaper a cache is to rebuild, the earlier it goes. */
+    enum class Priority {
+        /** Re-created on demand at no cost beyond latency (idle connections). */
+        DISPOSABLE,
+        /** Rebuilt by the next use (pooled buffers, encoded field caches). */
+        REBUILDABLE,
+        /** Data not yet persisted; trimming writes it out (telemetry rows). */
+        BUFFERED
+    }
+
+    /** How far trimming goes; a level trims every [Priority] up to its own ordinal. */
+    enum class Pressure { BACKGROUND, LOW, CRITICAL }
+
+    interface Consumer {
+        val name: String
+        val priority: Priority
+        /** Approximate bytes currently held. */
+        fun retainedBytes(): Long
+        /** Releases what it holds; called off the main thread. */
+        fun trim()
+        /** Applies the sizes of [profile]; called on registration and when the profile changes. */
+        fun applyProfile(profile: Profile) {}
+    }
+
+    data class Profile(
+        val name: String,
+        val budgetBytes: Long,
+        val encoderPoolSize: Int,
+        val httpIdleConnections: Int,
+        val telemetryBeatsPerCommit: Int,
+        val verboseLogging: Boolean
+    ) {
+        companion object {
+            val STANDARD = Profile(
+                name = "standard",
+                budgetBytes = 4L shl 20,
+                encoderPoolSize = 2,
+                httpIdleConnections = 5,
+                telemetryBeatsPerCommit = 30,
+                verboseLogging = true
+            )
+            val LOW_RAM = Profile(
+                name = "low_ram",
+                budgetBytes = 1L shl 20,
+                encoderPoolSize = 1,
+                httpIdleConnections = 2,
+                telemetryBeatsPerCommit = 10,
+                verboseLogging = false
+            )
+        }
+    }
+
+    companion object {
+        private const val TAG = "MemoryGovernor"
+
+        /** Process instance; consumers register before [install] and pick up its profile then. */
+        val shared = MemoryGovernor(Dispatchers.IO)
+
+        /** Chooses the profile for this device and starts listening for trim-memory callbacks. */
+        fun install(context: Context) {
+            val app = context.applicationContext
+            val lowRam = app.getSystemService(ActivityManager::class.java)?.isLowRamDevice == true
+            shared.setProfile(if (lowRam) Profile.LOW_RAM else Profile.STANDARD)
+            app.registerComponentCallbacks(shared)
+        }
+
+        /** Null for levels that ask for nothing. */
+        @Suppress("DEPRECATION")
+        fun pressureFor(level: Int): Pressure? = when {
+            level >= ComponentCallbacks2.TRIM_MEMORY_MODERATE -> Pressure.CRITICAL
+            level >= ComponentCallbacks2.TRIM_MEMORY_BACKGROUND -> Pressure.LOW
+            level >= ComponentCallbacks2.TRIM_MEMORY_UI_HIDDEN -> Pressure.BACKGROUND
+            level >= ComponentCallbacks2.TRIM_MEMORY_RUNNING_CRITICAL -> Pressure.CRITICAL
+            level >= ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW -> Pressure.LOW
+            level >= ComponentCallbacks2.TRIM_MEMORY_RUNNING_MODERATE -> Pressure.BACKGROUND
+            else -> null
+        }
+    }
+
+    private val scope = CoroutineScope(dispatcher + SupervisorJob())
+    private val consumers = CopyOnWriteArrayList<Consumer>()
+
+    @Volatile
+    var profile: Profile = Profile.STANDARD
+        private set
+
+    fun register(consumer: Consumer) {
+        consumer.applyProfile(profile)
+        consumers.addIfAbsent(consumer)
+    }
+
+    fun setProfile(profile: Profile) {
+        if (this.profile == profile) return
+        this.profile = profile
+        Log.i(TAG, "Memory profile: ${profile.name}")
+        consumers.forEach { it.applyProfile(profile) }
+    }
+
+    /** Bytes held per consumer. */
+    fun retainedBytes(): Map<String, Long> = consumers.associate { it.name to it.retainedBytes() }
+
+    /** Trims every consumer [pressure] reaches, then enforces the budget. Runs on the caller's thread. */
+    fun trim(pressure: Pressure) {
+        for (consumer in ordered()) {
+            if (consumer.priority.ordinal > pressure.ordinal) break
+            trim(consumer)
+        }
+        enforceBudget()
+    }
+
+    /** Trims in priority order until the total is within the profile's budget. */
+    fun enforceBudget() {
+        var total = consumers.sumOf { it.retainedBytes() }
+        if (total <= profile.budgetBytes) return
+        for (consumer in ordered()) {
+            if (total <= profile.budgetBytes) break
+            val held = consumer.retainedBytes()
+            if (held == 0L) continue
+            trim(consumer)
+            total -= held - consumer.retainedBytes()
+        }
+        Log.i(TAG, "Over budget, trimmed to $total of ${profile.budgetBytes} bytes")
+    }
+
+    /** [enforceBudget] on the governor's dispatcher, for callers that just grew a cache. */
+    fun checkBudgetAsync() {
+        scope.launch { enforceBudget() }
+    }
+
+    private fun ordered() = consumers.sortedBy { it.priority.ordinal }
+
+    private fun trim(consumer: Consumer) {
+        try {
+            consumer.trim()
+        } catch (e: Exception) {
+            Log.e(TAG, "Trimming ${consumer.name} failed: ${e.message}")
+        }
+    }
+
+    override fun onTrimMemory(level: Int) {
+        val pressure = pressureFor(level) ?: return
+        Log.d(TAG, "onTrimMemory($level): trimming at $pressure")
+        scope.launch { trim(pressure) }
+    }
+
+    override fun onLowMemory() {
+        scope.launch { trim(Pressure.CRITICAL) }
+    }
+
+    override fun onConfigurationChanged(newConfig: Configuration) {}
+}
@@ -0,0 +1,40 @@
+﻿package com.microspace.payo.core
+
+import android.content.Context
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.atomic.AtomicInteger
+
+/**
+ * ProcessManagers - one instance per process of each Context-bound manager.
+ *
+ * Building a manager resolves system services and opens (often encrypted) preferences, and call
+ * sites used to build their own on every heartbeat, lock transition and broadcast. The managers'
+ * getInstance() come here instead. Device-protected callers (Direct Boot, the boot receiver) and
+ * credential-protected callers open different files, so each storage area gets its own instance,
+ * bound to that area's application context so no Activity or Service is retained.
+ */
+object ProcessManagers {
+
+    private val instances = ConcurrentHashMap<String, Any>()
+    private val built = ConcurrentHashMap<String, AtomicInteger>()
+
+    /** The process instance of [type] for [context]'s storage area, built by [factory] on first use. */
+    fun <T : Any> get(context: Context, type: Class<T>, factory: (Context) -> T): T {
+        val deviceProtected = context.isDeviceProtectedStorage
+        val key = (if (deviceProtected) "de/" else "ce/") + type.name
+        instances[key]?.let { return type.cast(it) }
+        // Reentrant: a manager's constructor may ask for the managers it uses
+        return synchronized(instances) {
+            instances[key]?.let { type.cast(it) } ?: run {
+                val app = context.applicationContext ?: context
+                factory(if (deviceProtected) app.createDeviceProtectedStorageContext() else app).also {
+                    instances[key] = it
+                    built.getOrPut(type.simpleName) { AtomicInteger() }.incrementAndGet()
+                }
+            }
+        }
+    }
+
+    /** Managers built so far in this process, by class name; at most one per storage area. */
+    fun constructions(): Map<String, Int> = built.mapValues { it.value.get() }
+}
@@ -29,6 +29,10 @@ class SilentDeviceOwnerManager(private val context: Context) {
     companion object {
         private const val TAG = "SilentDeviceOwner"
 
+        /** The process instance for [context]'s storage area; see [ProcessManagers]. */
+        fun getInstance(context: Context): SilentDeviceOwnerManager =
+            ProcessManagers.get(context, SilentDeviceOwnerManager::class.java, ::SilentDeviceOwnerManager)
+
         /**
          * All critical restrictions â€“ applied silently, no user messages.
          * Excludes DISALLOW_CONFIG_WIFI/DISALLOW_CONFIG_MOBILE_NETWORKS so user can manage data.
@@ -13,6 +13,7 @@ import androidx.work.WorkManager
 import androidx.work.Worker
 import androidx.work.WorkerParameters
 import com.microspace.payo.config.FrpConfig
+import com.microspace.payo.config.RuntimeConfigStore
 import com.microspace.payo.core.frp.verification.FrpVerificationService
 import java.util.concurrent.TimeUnit
 
@@ -47,8 +48,9 @@ class FrpHealthCheckService : Service() {
                 .setRequiresBatteryNotLow(false)
                 .build()
 
+            val intervalHours = RuntimeConfigStore.current.frpVerificationIntervalHours
             val healthCheckRequest = PeriodicWorkRequestBuilder<FrpHealthCheckWorker>(
-                FrpConfig.FRP_VERIFICATION_INTERVAL_HOURS,
+                intervalHours,
                 TimeUnit.HOURS
             )
                 .setConstraints(constraints)
@@ -62,11 +64,11 @@ class FrpHealthCheckService : Service() {
 
             WorkManager.getInstance(this).enqueueUniquePeriodicWork(
                 WORK_TAG,
-                androidx.work.ExistingPeriodicWorkPolicy.KEEP,
+                androidx.work.ExistingPeriodicWorkPolicy.UPDATE,
                 healthCheckRequest
             )
 
-            Log.i(TAG, "FRP health check scheduled every ${FrpConfig.FRP_VERIFICATION_INTERVAL_HOURS} hours")
+            Log.i(TAG, "FRP health check scheduled every $intervalHours hours")
         } catch (e: Exception) {
             Log.e(TAG, "Failed to schedule FRP health check", e)
         }
@@ -124,8 +126,9 @@ class GmsAvailabilityMonitor(private val context: android.content.Context) {
                 .setRequiredNetworkType(NetworkType.CONNECTED)
                 .build()
 
+            val intervalMinutes = RuntimeConfigStore.current.gmsCheckIntervalMinutes
             val gmsCheckRequest = PeriodicWorkRequestBuilder<GmsAvailabilityWorker>(
-                FrpConfig.GMS_CHECK_INTERVAL_MINUTES,
+                intervalMinutes,
                 TimeUnit.MINUTES
             )
                 .setConstraints(constraints)
@@ -139,11 +142,11 @@ class GmsAvailabilityMonitor(private val context: android.content.Context) {
 
             WorkManager.getInstance(context).enqueueUniquePeriodicWork(
                 "gms_availability_check",
-                androidx.work.ExistingPeriodicWorkPolicy.KEEP,
+                androidx.work.ExistingPeriodicWorkPolicy.UPDATE,
                 gmsCheckRequest
             )
 
-            Log.i(TAG, "GMS availability monitoring scheduled every ${FrpConfig.GMS_CHECK_INTERVAL_MINUTES} minutes")
+            Log.i(TAG, "GMS availability monitoring scheduled every $intervalMinutes minutes")
         } catch (e: Exception) {
             Log.e(TAG, "Failed to schedule GMS monitoring", e)
         }
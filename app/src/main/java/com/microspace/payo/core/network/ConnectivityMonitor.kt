@@ -0,0 +1,157 @@
+﻿package com.microspace.payo.core.network
+
+import android.content.Context
+import android.net.ConnectivityManager
+import android.net.Network
+import android.net.NetworkCapabilities
+import android.os.Build
+import android.util.Log
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.StateFlow
+import kotlinx.coroutines.flow.asStateFlow
+import kotlinx.coroutines.flow.distinctUntilChanged
+import kotlinx.coroutines.flow.filter
+import kotlinx.coroutines.flow.map
+
+/**
+ * ConnectivityMonitor - process-wide default network state.
+ *
+ * Registers one default-network callback for the whole app and keeps the result in [state].
+ * Reading [current] is a field read, no binder call; components that need to react collect
+ * [state] (or [onlineTransitions]) instead of registering their own NetworkCallback.
+ */
+class ConnectivityMonitor internal constructor(private val platform: Platform) {
+
+    /** The two ConnectivityManager touch points, so the state machine runs on the JVM in tests. */
+    internal interface Platform {
+        /** One-off query of the current default network (activeNetwork + capabilities). */
+        fun query(): NetworkState
+        fun registerDefaultNetworkCallback(listener: Listener)
+    }
+
+    /** [network] is an opaque handle, only compared for identity. */
+    internal interface Listener {
+        fun onAvailable(network: Any)
+        fun onCapabilitiesChanged(network: Any, state: NetworkState)
+        fun onLost(network: Any)
+    }
+
+    companion object {
+        private const val TAG = "ConnectivityMonitor"
+
+        @Volatile
+        private var INSTANCE: ConnectivityMonitor? = null
+
+        fun getInstance(context: Context): ConnectivityMonitor {
+            return INSTANCE ?: synchronized(this) {
+                INSTANCE ?: ConnectivityMonitor(AndroidPlatform(context.applicationContext)).also {
+                    it.start()
+                    INSTANCE = it
+                }
+            }
+        }
+
+        internal fun stateOf(capabilities: NetworkCapabilities): NetworkState {
+            val transport = when {
+                capabilities.hasTransport(NetworkCapabilities.TRANSPORT_WIFI) -> NetworkState.Transport.WIFI
+                capabilities.hasTransport(NetworkCapabilities.TRANSPORT_CELLULAR) -> NetworkState.Transport.CELLULAR
+                capabilities.hasTransport(NetworkCapabilities.TRANSPORT_ETHERNET) -> NetworkState.Transport.ETHERNET
+                else -> NetworkState.Transport.OTHER
+            }
+            val roaming = if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.P) {
+                !capabilities.hasCapability(NetworkCapabilities.NET_CAPABILITY_NOT_ROAMING)
+            } else {
+                false
+            }
+            return NetworkState(
+                transport = transport,
+                isValidated = capabilities.hasCapability(NetworkCapabilities.NET_CAPABILITY_INTERNET) &&
+                    capabilities.hasCapability(NetworkCapabilities.NET_CAPABILITY_VALIDATED),
+                isMetered = !capabilities.hasCapability(NetworkCapabilities.NET_CAPABILITY_NOT_METERED),
+                isRoaming = roaming,
+                downstreamKbps = capabilities.linkDownstreamBandwidthKbps,
+                upstreamKbps = capabilities.linkUpstreamBandwidthKbps
+            )
+        }
+    }
+
+    private val _state = MutableStateFlow(NetworkState.DISCONNECTED)
+    val state: StateFlow<NetworkState> = _state.asStateFlow()
+
+    val current: NetworkState
+        get() = _state.value
+
+    /**
+     * Emits each time the device goes from not online to online (validated internet), and once
+     * on collection if it is already online, so work waiting for the network also runs at startup.
+     */
+    val onlineTransitions: Flow<NetworkState>
+        get() = state.map { it.isOnline to it }
+            .distinctUntilChanged { old, new -> old.first == new.first }
+            .filter { it.first }
+            .map { it.second }
+
+    private val lock = Any()
+    private var defaultNetwork: Any? = null
+    private var started = false
+
+    internal fun start() {
+        synchronized(lock) {
+            if (started) return
+            started = true
+        }
+        try {
+            // Seed before the first callback arrives so early readers don't see "offline"
+            _state.value = platform.query()
+            platform.registerDefaultNetworkCallback(object : Listener {
+                override fun onAvailable(network: Any) {
+                    synchronized(lock) {
+                        if (defaultNetwork == network) return
+                        defaultNetwork = network
+                        // Capabilities follow immediately; until then keep the last known transport
+                        if (!_state.value.isConnected) _state.value = NetworkState(transport = NetworkState.Transport.OTHER)
+                    }
+                }
+
+                override fun onCapabilitiesChanged(network: Any, state: NetworkState) {
+                    synchronized(lock) {
+                        defaultNetwork = network
+                        _state.value = state
+                    }
+                }
+
+                override fun onLost(network: Any) {
+                    synchronized(lock) {
+                        // A late onLost for a network we already switched away from is not an outage
+                        if (defaultNetwork != network) return
+                        defaultNetwork = null
+                        _state.value = NetworkState.DISCONNECTED
+                    }
+                }
+            })
+            Log.i(TAG, "Default network callback registered: ${_state.value}")
+        } catch (e: Exception) {
+            Log.e(TAG, "Failed to register default network callback: ${e.message}", e)
+        }
+    }
+
+    private class AndroidPlatform(context: Context) : Platform {
+        private val connectivityManager = context.getSystemService(Context.CONNECTIVITY_SERVICE) as ConnectivityManager
+
+        override fun query(): NetworkState {
+            val network = connectivityManager.activeNetwork ?: return NetworkState.DISCONNECTED
+            val capabilities = connectivityManager.getNetworkCapabilities(network) ?: return NetworkState.DISCONNECTED
+            return stateOf(capabilities)
+        }
+
+        override fun registerDefaultNetworkCallback(listener: Listener) {
+            connectivityManager.registerDefaultNetworkCallback(object : ConnectivityManager.NetworkCallback() {
+                override fun onAvailable(network: Network) = listener.onAvailable(network)
+                override fun onCapabilitiesChanged(network: Network, capabilities: NetworkCapabilities) =
+                    listener.onCapabilitiesChanged(network, stateOf(capabilities))
+                override fun onLost(network: Network) = listener.onLost(network)
+            })
+        }
+    }
+}
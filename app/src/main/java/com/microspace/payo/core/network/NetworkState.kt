@@ -0,0 +1,35 @@
+﻿package com.microspace.payo.core.network
+
+/**
+ * Snapshot of the default network as seen by [ConnectivityMonitor].
+ *
+ * Bandwidths are the platform's estimates in kbps (0 when unknown); they move with signal
+ * quality, so compare [transport]/[isValidated] for transitions, not the whole object.
+ */
+data class NetworkState(
+    val transport: Transport = Transport.NONE,
+    val isValidated: Boolean = false,
+    val isMetered: Boolean = false,
+    val isRoaming: Boolean = false,
+    val downstreamKbps: Int = 0,
+    val upstreamKbps: Int = 0
+) {
+    enum class Transport(val label: String) {
+        NONE("No Connection"),
+        WIFI("WiFi"),
+        CELLULAR("Mobile Data"),
+        ETHERNET("Ethernet"),
+        OTHER("Unknown")
+    }
+
+    val isConnected: Boolean
+        get() = transport != Transport.NONE
+
+    /** Connected through a transport that can carry app traffic and validated by the platform. */
+    val isOnline: Boolean
+        get() = isConnected && isValidated
+
+    companion object {
+        val DISCONNECTED = NetworkState()
+    }
+}
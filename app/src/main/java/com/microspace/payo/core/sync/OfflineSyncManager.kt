@@ -1,9 +1,8 @@
 ﻿package com.microspace.payo.core.sync
 
 import android.content.Context
-import android.net.ConnectivityManager
-import android.net.NetworkCapabilities
 import android.util.Log
+import com.microspace.payo.core.network.ConnectivityMonitor
 import com.microspace.payo.data.remote.ApiClient
 import com.microspace.payo.data.remote.ApiService
 import com.microspace.payo.data.local.database.DeviceOwnerDatabase
@@ -29,7 +28,7 @@ class OfflineSyncManager(private val context: Context) {
     }
     
     private val database = DeviceOwnerDatabase.getDatabase(context)
-    private val apiClient = ApiClient()
+    private val apiClient = ApiClient.getInstance()
     
     init {
         // ApiClient handles Retrofit setup internally
@@ -39,12 +38,7 @@ class OfflineSyncManager(private val context: Context) {
      * Check if device is online
      */
     fun isOnline(): Boolean {
-        val connectivityManager = context.getSystemService(Context.CONNECTIVITY_SERVICE) as ConnectivityManager
-        val network = connectivityManager.activeNetwork ?: return false
-        val capabilities = connectivityManager.getNetworkCapabilities(network) ?: return false
-        
-        return capabilities.hasCapability(NetworkCapabilities.NET_CAPABILITY_INTERNET) &&
-               capabilities.hasCapability(NetworkCapabilities.NET_CAPABILITY_VALIDATED)
+        return ConnectivityMonitor.getInstance(context).current.isOnline
     }
     
     // Additional sync methods will be implemented here
@@ -0,0 +1,85 @@
+﻿package com.microspace.payo.core.watchdog
+
+/**
+ * SlowOperationReport - slow main-thread operations aggregated per kind, name and call site.
+ *
+ * Each site keeps a count, total and maximum duration and the threads it was seen on, so a
+ * regression shows up as a site whose count or maximum grows between builds rather than as one
+ * more line in logcat. At most [maxSites] sites are kept; operations at sites beyond that are only
+ * counted in [dropped].
+ */
+class SlowOperationReport(private val maxSites: Int = DEFAULT_MAX_SITES) {
+
+    data class Entry(
+        val kind: SlowOperationWatchdog.Kind,
+        val name: String,
+        val callSite: String,
+        val count: Int,
+        val totalMs: Long,
+        val maxMs: Long,
+        val threads: Set<String>
+    )
+
+    private data class Key(val kind: SlowOperationWatchdog.Kind, val name: String, val callSite: String)
+
+    private class Site {
+        var count = 0
+        var totalMs = 0L
+        var maxMs = 0L
+        val threads = LinkedHashSet<String>()
+    }
+
+    private val sites = LinkedHashMap<Key, Site>()
+
+    var dropped = 0
+        private set
+
+    @Synchronized
+    fun add(kind: SlowOperationWatchdog.Kind, name: String, callSite: String, durationMs: Long, thread: String) {
+        val key = Key(kind, name, callSite)
+        val site = sites[key] ?: if (sites.size < maxSites) Site().also { sites[key] = it } else null
+        if (site == null) {
+            dropped++
+            return
+        }
+        site.count++
+        site.totalMs += durationMs
+        site.maxMs = maxOf(site.maxMs, durationMs)
+        site.threads += thread
+    }
+
+    /** Sites by total time, worst first. */
+    @Synchronized
+    fun entries(): List<Entry> = sites.map { (key, site) ->
+        Entry(key.kind, key.name, key.callSite, site.count, site.totalMs, site.maxMs, site.threads.toSet())
+    }.sortedWith(compareByDescending<Entry> { it.totalMs }.thenByDescending { it.count })
+
+    /** Tab-separated, one site per line under a header; [title] goes in the first comment line. */
+    fun render(title: String): String {
+        val entries = entries()
+        return buildString {
+            append("# ").append(title).append('\n')
+            append("# kind\tcount\ttotal_ms\tmax_ms\tname\tcall_site\tthreads\n")
+            for (e in entries) {
+                append(e.kind).append('\t')
+                    .append(e.count).append('\t')
+                    .append(e.totalMs).append('\t')
+                    .append(e.maxMs).append('\t')
+                    .append(e.name).append('\t')
+                    .append(e.callSite).append('\t')
+                    .append(e.threads.joinToString(",")).append('\n')
+            }
+            if (dropped > 0) append("# ").append(dropped).append(" operations at further sites not listed\n")
+        }
+    }
+
+    @Synchronized
+    fun clear() {
+        sites.clear()
+        dropped = 0
+    }
+
+    companion object {
+        const val DEFAULT_MAX_SITES = 200
+    }
+}
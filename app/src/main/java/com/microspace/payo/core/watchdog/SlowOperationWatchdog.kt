@@ -0,0 +1,203 @@
+﻿package com.microspace.payo.core.watchdog
+
+import android.content.Context
+import android.os.Build
+import android.os.Looper
+import android.os.StrictMode
+import android.util.Log
+import kotlinx.coroutines.CoroutineDispatcher
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.asExecutor
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.launch
+import java.io.File
+import java.util.concurrent.atomic.AtomicBoolean
+
+/**
+ * SlowOperationWatchdog - debug and staging signal for blocking work on the main thread.
+ *
+ * Lock activities, receivers and application start make binder, disk and Keystore calls on the
+ * main thread, and nothing reported it when one of them got slower. When [install]ed with
+ * `enabled` (BuildConfig.SLOW_OP_WATCHDOG: debug and staging builds) the watchdog combines:
+ * - StrictMode thread and VM policies whose penalty listener records each violation (API 28+;
+ *   older releases only log);
+ * - a main-looper printer that times every dispatched message;
+ * - [trace] around the DPM, prefs and Keystore facades, recording the call site, duration and
+ *   thread of any main-thread call over its [Kind] threshold.
+ * Everything goes into one [SlowOperationReport], rewritten to `files/slow_operations.txt` a few
+ * seconds after it changes. Disabled, [trace] costs one volatile read.
+ */
+class SlowOperationWatchdog internal constructor(
+    dispatcher: CoroutineDispatcher,
+    private val clockNs: () -> Long = System::nanoTime,
+    private val isMainThread: () -> Boolean = { Looper.myLooper() == Looper.getMainLooper() }
+) {
+
+    /** What blocked; the threshold is how long it may take on the main thread. */
+    enum class Kind(val thresholdMs: Long) {
+        BINDER(FRAME_MS),
+        DISK(FRAME_MS),
+        CRYPTO(FRAME_MS),
+        /** A whole main-looper message; long ones are what the user sees as jank or an ANR. */
+        MESSAGE(100),
+        /** Reported by StrictMode; the violation itself is the signal. */
+        STRICT_MODE(0)
+    }
+
+    companion object {
+        private const val TAG = "SlowOpWatchdog"
+        private const val FRAME_MS = 16L
+        private const val REPORT_FILE = "slow_operations.txt"
+        private const val WRITE_DELAY_MS = 5_000L
+        private const val APP_PACKAGE = "com.microspace.payo."
+        private val INSTANCE_HASH = Regex("""\{[0-9a-f]+\}|@[0-9a-f]+""")
+
+        val shared = SlowOperationWatchdog(Dispatchers.IO)
+
+        /** Turns the watchdog on for this process if [enabled]; call first in Application.onCreate. */
+        fun install(context: Context, enabled: Boolean) {
+            if (!enabled) return
+            shared.start(File(context.applicationContext.filesDir, REPORT_FILE))
+        }
+
+        /** "Handler (x.Y) z.Callback: 0" from a looper dispatch or finish line, without instance hashes. */
+        internal fun messageTarget(line: String): String =
+            line.substringAfter(" to ").replace(INSTANCE_HASH, "").replace(Regex(" +"), " ").trim()
+    }
+
+    private val scope = CoroutineScope(dispatcher + SupervisorJob())
+    private val executor = dispatcher.asExecutor()
+    private val writeScheduled = AtomicBoolean(false)
+
+    val report = SlowOperationReport()
+
+    @Volatile
+    var enabled = false
+        private set
+
+    @Volatile
+    private var reportFile: File? = null
+
+    // Main looper only, so no synchronization
+    private var messageStartNs = -1L
+
+    internal fun start(file: File) {
+        if (enabled) return
+        enable(file)
+        try {
+            installStrictMode()
+            Looper.getMainLooper().setMessageLogging { line -> onLooperMessage(line) }
+        } catch (e: Exception) {
+            Log.e(TAG, "Watchdog hooks not installed: ${e.message}")
+        }
+        Log.i(TAG, "Slow-operation watchdog on, report at ${file.path}")
+    }
+
+    /** Starts recording [trace]d calls without the StrictMode and looper hooks. */
+    internal fun enable(file: File?) {
+        reportFile = file
+        enabled = true
+    }
+
+    /**
+     * Runs [block]; on the main thread, records it when it takes longer than [kind]'s threshold.
+     * [name] identifies the facade call (for example `dpm.isDeviceOwnerApp`).
+     */
+    inline fun <T> trace(kind: Kind, name: String, block: () -> T): T {
+        if (!enabled) return block()
+        val start = begin()
+        try {
+            return block()
+        } finally {
+            end(kind, name, start)
+        }
+    }
+
+    @PublishedApi
+    internal fun begin(): Long = if (isMainThread()) clockNs() else -1L
+
+    @PublishedApi
+    internal fun end(kind: Kind, name: String, startNs: Long) {
+        if (startNs < 0) return
+        val ms = (clockNs() - startNs) / 1_000_000
+        if (ms >= kind.thresholdMs) {
+            record(kind, name, ms, callSite(Throwable().stackTrace))
+        }
+    }
+
+    /** Adds one slow operation to the report and schedules a rewrite of the report file. */
+    fun record(kind: Kind, name: String, durationMs: Long, callSite: String, thread: String = Thread.currentThread().name) {
+        report.add(kind, name, callSite, durationMs, thread)
+        Log.w(TAG, "$kind $name took ${durationMs}ms on $thread at $callSite")
+        scheduleWrite()
+    }
+
+    /** Looper printer: ">>>>> Dispatching to ..." before each message, "<<<<< Finished to ..." after. */
+    internal fun onLooperMessage(line: String) {
+        if (line.startsWith(">>>>>")) {
+            messageStartNs = clockNs()
+        } else if (line.startsWith("<<<<<") && messageStartNs >= 0) {
+            val ms = (clockNs() - messageStartNs) / 1_000_000
+            messageStartNs = -1L
+            if (ms >= Kind.MESSAGE.thresholdMs) {
+                record(Kind.MESSAGE, "looper.message", ms, messageTarget(line), "main")
+            }
+        }
+    }
+
+    /** The first app frame that is not the watchdog's own, else the first frame outside it. */
+    internal fun callSite(frames: Array<StackTraceElement>): String {
+        val own = SlowOperationWatchdog::class.java.name
+        val outside = frames.filter { !it.className.startsWith(own) }
+        return (outside.firstOrNull { it.className.startsWith(APP_PACKAGE) } ?: outside.firstOrNull())?.toString() ?: "unknown"
+    }
+
+    private fun installStrictMode() {
+        val threadPolicy = StrictMode.ThreadPolicy.Builder()
+            .detectDiskReads()
+            .detectDiskWrites()
+            .detectNetwork()
+            .detectCustomSlowCalls()
+        val vmPolicy = StrictMode.VmPolicy.Builder()
+            .detectLeakedClosableObjects()
+            .detectLeakedSqlLiteObjects()
+            .detectLeakedRegistrationObjects()
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.P) {
+            threadPolicy.penaltyListener(executor) { v ->
+                record(Kind.STRICT_MODE, v.javaClass.simpleName, 0, callSite(v.stackTrace), "main")
+            }
+            vmPolicy.penaltyListener(executor) { v ->
+                record(Kind.STRICT_MODE, v.javaClass.simpleName, 0, callSite(v.stackTrace), "vm")
+            }
+        } else {
+            threadPolicy.penaltyLog()
+            vmPolicy.penaltyLog()
+        }
+        StrictMode.setThreadPolicy(threadPolicy.build())
+        StrictMode.setVmPolicy(vmPolicy.build())
+    }
+
+    private fun scheduleWrite() {
+        if (reportFile == null || !writeScheduled.compareAndSet(false, true)) return
+        scope.launch {
+            delay(WRITE_DELAY_MS)
+            writeScheduled.set(false)
+            writeReport()
+        }
+    }
+
+    /** Rewrites the report file (temp file, then rename); runs on the watchdog's dispatcher. */
+    internal fun writeReport(): Boolean {
+        val target = reportFile ?: return false
+        val tmp = File(target.parentFile, target.name + ".tmp")
+        return try {
+            tmp.writeText(report.render("Slow main-thread operations, pid ${android.os.Process.myPid()}"))
+            tmp.renameTo(target)
+        } catch (e: Exception) {
+            Log.e(TAG, "Report not written: ${e.message}")
+            false
+        }
+    }
+}
@@ -3,7 +3,7 @@
 import android.content.Context
 import android.os.Build
 import android.util.Log
-import com.microspace.payo.security.crypto.EncryptionManager
+import com.microspace.payo.utils.storage.PrefsWriteCoalescer
 import java.util.concurrent.locks.ReentrantReadWriteLock
 
 /**
@@ -21,8 +21,10 @@ object DeviceIdProvider {
     
     private val lock = ReentrantReadWriteLock()
 
-    private fun getPrefs(context: Context, name: String) = 
-        EncryptionManager(context).getEncryptedSharedPreferences(name)
+    // Coalesced: the three writes of saveDeviceId share each file's next commit with the
+    // registration flags written alongside them
+    private fun getPrefs(context: Context, name: String) =
+        PrefsWriteCoalescer.getInstance().encrypted(context, name)
 
     /**
      * Get device ID from storage.
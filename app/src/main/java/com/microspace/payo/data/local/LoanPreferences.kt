@@ -15,7 +15,7 @@ class LoanPreferences(private val context: Context) {
         private const val KEY_DEVICE_TOKEN = "device_token"
     }
 
-    private val prefsManager = EncryptedPreferencesManager(context)
+    private val prefsManager = EncryptedPreferencesManager.getInstance(context)
     private val encryption = SecureDataEncryption(context)
 
     fun getStoredLoanId(): String? {
@@ -5,6 +5,8 @@ import androidx.room.Database
 import androidx.room.Room
 import androidx.room.RoomDatabase
 import androidx.room.TypeConverters
+import androidx.room.migration.Migration
+import androidx.sqlite.db.SupportSQLiteDatabase
 import com.microspace.payo.data.local.database.dao.device.DeviceDataDao
 import com.microspace.payo.data.local.database.dao.heartbeat.HeartbeatHistoryDao
 import com.microspace.payo.data.local.database.entities.device.DeviceDataEntity
@@ -26,7 +28,7 @@ import net.sqlcipher.database.SQLiteDatabase
         DeviceDataEntity::class,
         HeartbeatHistoryEntity::class
     ],
-    version = 1,
+    version = 2,
     exportSchema = false
 )
 @TypeConverters(JsonConverters::class)
@@ -40,6 +42,22 @@ abstract class AppDatabase : RoomDatabase() {
         
         @Volatile
         private var instance: AppDatabase? = null
+
+        // v2 only adds indices, so the history is kept rather than dropped
+        internal val V2_INDICES = listOf(
+            "CREATE INDEX IF NOT EXISTS `index_device_data_server_device_id` ON `device_data` (`server_device_id`)",
+            "CREATE INDEX IF NOT EXISTS `index_device_data_loan_number` ON `device_data` (`loan_number`)",
+            "CREATE INDEX IF NOT EXISTS `index_device_data_registered_at` ON `device_data` (`registered_at`)",
+            "CREATE INDEX IF NOT EXISTS `index_device_data_sync_status` ON `device_data` (`sync_status`)",
+            "CREATE INDEX IF NOT EXISTS `index_heartbeat_history_sent_at` ON `heartbeat_history` (`sent_at`)",
+            "CREATE INDEX IF NOT EXISTS `index_heartbeat_history_sync_status` ON `heartbeat_history` (`sync_status`)"
+        )
+
+        internal val MIGRATION_1_2 = object : Migration(1, 2) {
+            override fun migrate(db: SupportSQLiteDatabase) {
+                V2_INDICES.forEach(db::execSQL)
+            }
+        }
         
         fun getInstance(context: Context): AppDatabase {
             return instance ?: synchronized(this) {
@@ -58,6 +76,7 @@ abstract class AppDatabase : RoomDatabase() {
                 DATABASE_NAME
             )
                 .openHelperFactory(factory)
+                .addMigrations(MIGRATION_1_2)
                 .fallbackToDestructiveMigration()
                 .build()
         }
@@ -3,6 +3,8 @@ package com.microspace.payo.data.local.database
 import androidx.room.Database
 import androidx.room.Room
 import androidx.room.RoomDatabase
+import androidx.room.migration.Migration
+import androidx.sqlite.db.SupportSQLiteDatabase
 import android.content.Context
 import com.microspace.payo.data.local.database.dao.device.CompleteDeviceRegistrationDao
 import com.microspace.payo.data.local.database.dao.device.DeviceBaselineDao
@@ -15,6 +17,9 @@ import com.microspace.payo.data.local.database.dao.heartbeat.HeartbeatResponseDa
 import com.microspace.payo.data.local.database.dao.sim.SimChangeHistoryDao
 import com.microspace.payo.data.local.database.dao.tamper.TamperDetectionDao
 import com.microspace.payo.data.local.database.dao.audit.SyncAuditDao
+import com.microspace.payo.data.local.database.dao.command.RemoteCommandDao
+import com.microspace.payo.data.local.database.dao.payment.PaymentStateDao
+import com.microspace.payo.data.local.database.dao.uplink.PendingReportDao
 import com.microspace.payo.data.local.database.entities.device.CompleteDeviceRegistrationEntity
 import com.microspace.payo.data.local.database.entities.device.DeviceBaselineEntity
 import com.microspace.payo.data.local.database.entities.device.DeviceDataEntity
@@ -26,7 +31,11 @@ import com.microspace.payo.data.local.database.entities.heartbeat.HeartbeatRespo
 import com.microspace.payo.data.local.database.entities.sim.SimChangeHistoryEntity
 import com.microspace.payo.data.local.database.entities.tamper.TamperDetectionEntity
 import com.microspace.payo.data.local.database.entities.payment.InstallmentEntity
+import com.microspace.payo.data.local.database.entities.payment.PaymentHistoryEntity
+import com.microspace.payo.data.local.database.entities.payment.PaymentStateEntity
 import com.microspace.payo.data.local.database.entities.audit.SyncAuditEntity
+import com.microspace.payo.data.local.database.entities.command.RemoteCommandEntity
+import com.microspace.payo.data.local.database.entities.uplink.PendingReportEntity
 import com.microspace.payo.security.crypto.DatabasePassphraseManager
 import net.sqlcipher.database.SupportFactory
 import net.sqlcipher.database.SQLiteDatabase
@@ -50,9 +59,13 @@ import net.sqlcipher.database.SQLiteDatabase
         SimChangeHistoryEntity::class,
         LockStateRecordEntity::class,
         InstallmentEntity::class,
-        SyncAuditEntity::class
+        SyncAuditEntity::class,
+        RemoteCommandEntity::class,
+        PaymentStateEntity::class,
+        PaymentHistoryEntity::class,
+        PendingReportEntity::class
     ],
-    version = 15,
+    version = 19,
     exportSchema = false
 )
 abstract class DeviceOwnerDatabase : RoomDatabase() {
@@ -69,10 +82,95 @@ abstract class DeviceOwnerDatabase : RoomDatabase() {
     abstract fun lockStateRecordDao(): LockStateRecordDao
     abstract fun installmentDao(): com.microspace.payo.data.local.database.dao.InstallmentDao
     abstract fun syncAuditDao(): SyncAuditDao
+    abstract fun remoteCommandDao(): RemoteCommandDao
+    abstract fun paymentStateDao(): PaymentStateDao
+    abstract fun pendingReportDao(): PendingReportDao
 
     companion object {
         @Volatile
         private var INSTANCE: DeviceOwnerDatabase? = null
+
+        // v16 adds the remote command inbox
+        internal val V16_INDICES = listOf(
+            "CREATE INDEX IF NOT EXISTS `index_remote_commands_status` ON `remote_commands` (`status`)"
+        )
+
+        internal val MIGRATION_15_16 = object : Migration(15, 16) {
+            override fun migrate(db: SupportSQLiteDatabase) {
+                db.execSQL(
+                    "CREATE TABLE IF NOT EXISTS `remote_commands` (`commandId` TEXT NOT NULL, `action` TEXT NOT NULL, " +
+                        "`reason` TEXT NOT NULL, `status` TEXT NOT NULL, `receivedAt` INTEGER NOT NULL, " +
+                        "`executedAt` INTEGER, `success` INTEGER, `result` TEXT, `ackedAt` INTEGER, " +
+                        "PRIMARY KEY(`commandId`))"
+                )
+                V16_INDICES.forEach(db::execSQL)
+            }
+        }
+
+        // v17 adds the materialized payment state and its capped history
+        internal val MIGRATION_16_17 = object : Migration(16, 17) {
+            override fun migrate(db: SupportSQLiteDatabase) {
+                db.execSQL(
+                    "CREATE TABLE IF NOT EXISTS `payment_state` (`id` INTEGER NOT NULL, `nextPaymentDate` TEXT, " +
+                        "`unlockPassword` TEXT, `paymentAmount` TEXT, `paymentCurrency` TEXT, " +
+                        "`daysUntilPayment` INTEGER NOT NULL, `isLocked` INTEGER NOT NULL, `lockReason` TEXT, " +
+                        "`lockTimestamp` INTEGER NOT NULL, `serverTime` TEXT, `lastSyncTime` INTEGER NOT NULL, " +
+                        "`paymentComplete` INTEGER NOT NULL, `loanComplete` INTEGER NOT NULL, `loanStatus` TEXT, " +
+                        "`installmentsPaid` INTEGER NOT NULL, `installmentsTotal` INTEGER NOT NULL, " +
+                        "`overdueInstallments` INTEGER NOT NULL, `totalAmountDue` REAL NOT NULL, " +
+                        "`totalAmountPaid` REAL NOT NULL, `nextInstallmentDueDate` TEXT, `nextInstallmentAmount` REAL, " +
+                        "`installmentsSyncedAt` INTEGER NOT NULL, PRIMARY KEY(`id`))"
+                )
+                db.execSQL(
+                    "CREATE TABLE IF NOT EXISTS `payment_history` (`id` INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, " +
+                        "`date` INTEGER NOT NULL, `amount` TEXT, `currency` TEXT, `status` TEXT NOT NULL, " +
+                        "`daysUntilDue` INTEGER NOT NULL)"
+                )
+            }
+        }
+
+        // v18 only adds the indices the query-plan gate (RoomQueryPlanTest) asks for; creating them
+        // in place keeps the offline queue and lock records that a destructive upgrade would drop.
+        internal val V18_INDICES = listOf(
+            "CREATE INDEX IF NOT EXISTS `index_device_data_server_device_id` ON `device_data` (`server_device_id`)",
+            "CREATE INDEX IF NOT EXISTS `index_device_data_loan_number` ON `device_data` (`loan_number`)",
+            "CREATE INDEX IF NOT EXISTS `index_device_data_registered_at` ON `device_data` (`registered_at`)",
+            "CREATE INDEX IF NOT EXISTS `index_device_data_sync_status` ON `device_data` (`sync_status`)",
+            "CREATE INDEX IF NOT EXISTS `index_tamper_detections_syncStatus_detectedAt` ON `tamper_detections` (`syncStatus`, `detectedAt`)",
+            "CREATE INDEX IF NOT EXISTS `index_tamper_detections_deviceId_detectedAt` ON `tamper_detections` (`deviceId`, `detectedAt`)",
+            "CREATE INDEX IF NOT EXISTS `index_tamper_detections_detectedAt` ON `tamper_detections` (`detectedAt`)",
+            "CREATE INDEX IF NOT EXISTS `index_heartbeat_responses_timestamp` ON `heartbeat_responses` (`timestamp`)",
+            "CREATE INDEX IF NOT EXISTS `index_heartbeat_responses_heartbeatNumber` ON `heartbeat_responses` (`heartbeatNumber`)",
+            "CREATE INDEX IF NOT EXISTS `index_heartbeat_responses_processed_timestamp` ON `heartbeat_responses` (`processed`, `timestamp`)",
+            "CREATE INDEX IF NOT EXISTS `index_sync_audit_log_timestamp` ON `sync_audit_log` (`timestamp`)",
+            "CREATE INDEX IF NOT EXISTS `index_sim_change_history_changed_at` ON `sim_change_history` (`changed_at`)",
+            "CREATE INDEX IF NOT EXISTS `index_lock_state_records_lockState_resolvedAt_createdAt` ON `lock_state_records` (`lockState`, `resolvedAt`, `createdAt`)",
+            "CREATE INDEX IF NOT EXISTS `index_lock_state_records_createdAt` ON `lock_state_records` (`createdAt`)",
+            "CREATE INDEX IF NOT EXISTS `index_offline_events_timestamp` ON `offline_events` (`timestamp`)"
+        )
+
+        internal val MIGRATION_17_18 = object : Migration(17, 18) {
+            override fun migrate(db: SupportSQLiteDatabase) {
+                V18_INDICES.forEach(db::execSQL)
+            }
+        }
+
+        // v19 adds the state report uplink's queue
+        internal val V19_INDICES = listOf(
+            "CREATE INDEX IF NOT EXISTS `index_pending_reports_next_attempt_at` ON `pending_reports` (`next_attempt_at`)"
+        )
+
+        internal val MIGRATION_18_19 = object : Migration(18, 19) {
+            override fun migrate(db: SupportSQLiteDatabase) {
+                db.execSQL(
+                    "CREATE TABLE IF NOT EXISTS `pending_reports` (`report_key` TEXT NOT NULL, `kind` TEXT NOT NULL, " +
+                        "`device_id` TEXT NOT NULL, `payload` TEXT NOT NULL, `revision` INTEGER NOT NULL, " +
+                        "`created_at` INTEGER NOT NULL, `attempts` INTEGER NOT NULL, `next_attempt_at` INTEGER NOT NULL, " +
+                        "PRIMARY KEY(`report_key`))"
+                )
+                V19_INDICES.forEach(db::execSQL)
+            }
+        }
         
         fun getDatabase(context: Context): DeviceOwnerDatabase {
             return INSTANCE ?: synchronized(this) {
@@ -92,6 +190,7 @@ abstract class DeviceOwnerDatabase : RoomDatabase() {
                     "device_owner_database"
                 )
                 .openHelperFactory(factory)
+                .addMigrations(MIGRATION_15_16, MIGRATION_16_17, MIGRATION_17_18, MIGRATION_18_19)
                 .fallbackToDestructiveMigration()
                 .build()
                 INSTANCE = instance
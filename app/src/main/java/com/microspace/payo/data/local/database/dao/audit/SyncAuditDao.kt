@@ -10,6 +10,13 @@ interface SyncAuditDao {
     @Insert
     suspend fun insert(audit: SyncAuditEntity)
 
+    /** Blocking variants for TelemetryAppender's group commit, run inside its transaction. */
+    @Insert
+    fun insertAll(audits: List<SyncAuditEntity>)
+
+    @Query("DELETE FROM sync_audit_log WHERE timestamp < :beforeTimestamp")
+    fun deleteOlderThan(beforeTimestamp: Long)
+
     @Query("SELECT * FROM sync_audit_log ORDER BY timestamp DESC LIMIT 100")
     suspend fun getRecentAudits(): List<SyncAuditEntity>
 
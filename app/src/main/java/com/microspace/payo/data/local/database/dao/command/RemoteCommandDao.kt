@@ -0,0 +1,33 @@
+﻿package com.microspace.payo.data.local.database.dao.command
+
+import androidx.room.Dao
+import androidx.room.Insert
+import androidx.room.OnConflictStrategy
+import androidx.room.Query
+import com.microspace.payo.data.local.database.entities.command.RemoteCommandEntity
+
+@Dao
+interface RemoteCommandDao {
+
+    /** Returns -1 if a command with the same ID was already received. */
+    @Insert(onConflict = OnConflictStrategy.IGNORE)
+    suspend fun insert(command: RemoteCommandEntity): Long
+
+    /** Commands persisted but not yet executed (oldest first). */
+    @Query("SELECT * FROM remote_commands WHERE status = 'RECEIVED' ORDER BY receivedAt ASC")
+    suspend fun getReceived(): List<RemoteCommandEntity>
+
+    @Query("UPDATE remote_commands SET status = 'EXECUTED', executedAt = :executedAt, success = :success, result = :result WHERE commandId = :commandId AND status = 'RECEIVED'")
+    suspend fun markExecuted(commandId: String, success: Boolean, result: String, executedAt: Long)
+
+    /** Executed commands whose acknowledgement has not reached the server yet. */
+    @Query("SELECT * FROM remote_commands WHERE status = 'EXECUTED' ORDER BY executedAt ASC LIMIT :limit")
+    suspend fun getUnacknowledged(limit: Int): List<RemoteCommandEntity>
+
+    @Query("UPDATE remote_commands SET status = 'ACKED', ackedAt = :ackedAt WHERE commandId IN (:commandIds) AND status = 'EXECUTED'")
+    suspend fun markAcknowledged(commandIds: List<String>, ackedAt: Long)
+
+    /** Acknowledged rows are kept for a while so late duplicates are still recognised. */
+    @Query("DELETE FROM remote_commands WHERE status = 'ACKED' AND ackedAt < :beforeMillis")
+    suspend fun deleteAcknowledgedOlderThan(beforeMillis: Long)
+}
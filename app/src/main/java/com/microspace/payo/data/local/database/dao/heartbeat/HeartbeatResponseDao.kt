@@ -19,6 +19,12 @@ interface HeartbeatResponseDao {
     @Insert
     suspend fun insert(response: HeartbeatResponseEntity): Long
     
+    /**
+     * Insert a batch inside TelemetryAppender's group-commit transaction
+     */
+    @Insert
+    fun insertAll(responses: List<HeartbeatResponseEntity>)
+    
     /**
      * Update an existing heartbeat response
      */
@@ -0,0 +1,59 @@
+﻿package com.microspace.payo.data.local.database.dao.payment
+
+import androidx.room.Dao
+import androidx.room.Insert
+import androidx.room.OnConflictStrategy
+import androidx.room.Query
+import androidx.room.Transaction
+import com.microspace.payo.data.local.database.entities.payment.PaymentHistoryEntity
+import com.microspace.payo.data.local.database.entities.payment.PaymentStateEntity
+import kotlinx.coroutines.flow.Flow
+
+@Dao
+interface PaymentStateDao {
+
+    @Query("SELECT * FROM payment_state WHERE id = 1")
+    suspend fun get(): PaymentStateEntity?
+
+    @Query("SELECT * FROM payment_state WHERE id = 1")
+    fun observe(): Flow<PaymentStateEntity?>
+
+    @Insert(onConflict = OnConflictStrategy.REPLACE)
+    suspend fun upsert(state: PaymentStateEntity)
+
+    @Insert
+    suspend fun insertHistory(record: PaymentHistoryEntity): Long
+
+    @Insert
+    suspend fun insertHistory(records: List<PaymentHistoryEntity>)
+
+    /** Deletes everything older than the newest [keep] rows. */
+    @Query("DELETE FROM payment_history WHERE id <= (SELECT id FROM payment_history ORDER BY id DESC LIMIT 1 OFFSET :keep)")
+    suspend fun trimHistory(keep: Int)
+
+    /** Newest first. */
+    @Query("SELECT * FROM payment_history ORDER BY id DESC LIMIT :limit")
+    suspend fun getHistory(limit: Int): List<PaymentHistoryEntity>
+
+    @Query("DELETE FROM payment_history")
+    suspend fun clearHistory()
+
+    @Query("DELETE FROM payment_state")
+    suspend fun clearState()
+
+    @Transaction
+    suspend fun appendHistory(record: PaymentHistoryEntity, keep: Int) {
+        insertHistory(record)
+        trimHistory(keep)
+    }
+
+    /** One-shot import of the legacy prefs format; state and history land together or not at all. */
+    @Transaction
+    suspend fun importLegacy(state: PaymentStateEntity, history: List<PaymentHistoryEntity>, keep: Int) {
+        upsert(state)
+        if (history.isNotEmpty()) {
+            insertHistory(history)
+            trimHistory(keep)
+        }
+    }
+}
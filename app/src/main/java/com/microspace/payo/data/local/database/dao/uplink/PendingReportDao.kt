@@ -0,0 +1,34 @@
+﻿package com.microspace.payo.data.local.database.dao.uplink
+
+import androidx.room.Dao
+import androidx.room.Insert
+import androidx.room.OnConflictStrategy
+import androidx.room.Query
+import com.microspace.payo.data.local.database.entities.uplink.PendingReportEntity
+
+@Dao
+interface PendingReportDao {
+
+    /** Replaces any unsent report under the same key. */
+    @Insert(onConflict = OnConflictStrategy.REPLACE)
+    suspend fun upsert(report: PendingReportEntity)
+
+    /** Reports whose next attempt is due, earliest first. */
+    @Query("SELECT * FROM pending_reports WHERE next_attempt_at <= :now ORDER BY next_attempt_at ASC LIMIT :limit")
+    suspend fun getDue(now: Long, limit: Int): List<PendingReportEntity>
+
+    /** Earliest scheduled attempt, or null when nothing is pending. */
+    @Query("SELECT MIN(next_attempt_at) FROM pending_reports")
+    suspend fun nextAttemptAt(): Long?
+
+    /** Returns 0 if a newer revision replaced the report meanwhile. */
+    @Query("DELETE FROM pending_reports WHERE report_key = :reportKey AND revision = :revision")
+    suspend fun delete(reportKey: String, revision: Long): Int
+
+    @Query("UPDATE pending_reports SET attempts = :attempts, next_attempt_at = :nextAttemptAt WHERE report_key = :reportKey AND revision = :revision")
+    suspend fun reschedule(reportKey: String, revision: Long, attempts: Int, nextAttemptAt: Long)
+
+    /** Brings every waiting report forward to [now], keeping the attempt counts. */
+    @Query("UPDATE pending_reports SET next_attempt_at = :now WHERE next_attempt_at > :now")
+    suspend fun makeDue(now: Long)
+}
@@ -1,13 +1,19 @@
 ﻿package com.microspace.payo.data.local.database.entities.audit
 
 import androidx.room.Entity
+import androidx.room.Index
 import androidx.room.PrimaryKey
 
 /**
  * Records every heartbeat sync action taken by HeartbeatResponseHandler_v2.
  * This creates a detailed audit trail for debugging device state issues.
  */
-@Entity(tableName = "sync_audit_log")
+@Entity(
+    tableName = "sync_audit_log",
+    indices = [
+        Index(value = ["timestamp"])
+    ]
+)
 data class SyncAuditEntity(
     @PrimaryKey(autoGenerate = true)
     val id: Long = 0,
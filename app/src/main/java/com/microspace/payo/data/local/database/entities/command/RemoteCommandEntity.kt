@@ -0,0 +1,39 @@
+﻿package com.microspace.payo.data.local.database.entities.command
+
+import androidx.room.Entity
+import androidx.room.Index
+import androidx.room.PrimaryKey
+
+/**
+ * Remote management command as persisted by the command inbox.
+ *
+ * The server-assigned [commandId] is the primary key, so a retried or duplicated command
+ * is dropped at insert time. Lifecycle: RECEIVED -> EXECUTED -> ACKED; a row left in
+ * RECEIVED by a crash is executed on the next start, one left in EXECUTED is acknowledged
+ * with the next heartbeat.
+ */
+@Entity(
+    tableName = "remote_commands",
+    indices = [Index(value = ["status"])]
+)
+data class RemoteCommandEntity(
+    @PrimaryKey
+    val commandId: String,
+    /** soft_lock, hard_lock, unlock, status */
+    val action: String,
+    val reason: String,
+    val status: String = STATUS_RECEIVED,
+    val receivedAt: Long,
+    val executedAt: Long? = null,
+    /** true if the command was applied; false if it failed or was not understood */
+    val success: Boolean? = null,
+    /** Result or error message reported back in the acknowledgement */
+    val result: String? = null,
+    val ackedAt: Long? = null
+) {
+    companion object {
+        const val STATUS_RECEIVED = "RECEIVED"
+        const val STATUS_EXECUTED = "EXECUTED"
+        const val STATUS_ACKED = "ACKED"
+    }
+}
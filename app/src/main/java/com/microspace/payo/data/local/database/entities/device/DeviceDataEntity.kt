@@ -2,6 +2,7 @@
 
 import androidx.room.ColumnInfo
 import androidx.room.Entity
+import androidx.room.Index
 import androidx.room.PrimaryKey
 import com.google.gson.annotations.SerializedName
 
@@ -11,7 +12,15 @@ import com.google.gson.annotations.SerializedName
  * Stores all device information collected during registration
  * for offline access and comparison with heartbeat data
  */
-@Entity(tableName = "device_data")
+@Entity(
+    tableName = "device_data",
+    indices = [
+        Index(value = ["server_device_id"]),
+        Index(value = ["loan_number"]),
+        Index(value = ["registered_at"]),
+        Index(value = ["sync_status"])
+    ]
+)
 data class DeviceDataEntity(
     @PrimaryKey(autoGenerate = true)
     @ColumnInfo(name = "id")
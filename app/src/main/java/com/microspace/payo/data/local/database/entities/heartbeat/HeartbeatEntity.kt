@@ -1,9 +1,17 @@
 ﻿package com.microspace.payo.data.local.database.entities.heartbeat
 
 import androidx.room.Entity
+import androidx.room.Index
 import androidx.room.PrimaryKey
 
-@Entity(tableName = "heartbeats")
+@Entity(
+    tableName = "heartbeats",
+    indices = [
+        Index(value = ["deviceId", "timestamp"]),
+        Index(value = ["syncStatus", "timestamp"]),
+        Index(value = ["timestamp"])
+    ]
+)
 data class HeartbeatEntity(
     @PrimaryKey(autoGenerate = true)
     val id: Long = 0,
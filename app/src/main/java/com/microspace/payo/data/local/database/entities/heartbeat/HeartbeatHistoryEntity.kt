@@ -24,7 +24,9 @@ import com.microspace.payo.data.local.database.entities.device.DeviceDataEntity
         )
     ],
     indices = [
-        Index(value = ["device_data_id"])
+        Index(value = ["device_data_id"]),
+        Index(value = ["sent_at"]),
+        Index(value = ["sync_status"])
     ]
 )
 data class HeartbeatHistoryEntity(
@@ -1,6 +1,7 @@
 ﻿package com.microspace.payo.data.local.database.entities.heartbeat
 
 import androidx.room.Entity
+import androidx.room.Index
 import androidx.room.PrimaryKey
 import com.google.gson.annotations.SerializedName
 
@@ -13,7 +14,14 @@ import com.google.gson.annotations.SerializedName
  * - Debugging
  * - Analytics
  */
-@Entity(tableName = "heartbeat_responses")
+@Entity(
+    tableName = "heartbeat_responses",
+    indices = [
+        Index(value = ["timestamp"]),
+        Index(value = ["heartbeatNumber"]),
+        Index(value = ["processed", "timestamp"])
+    ]
+)
 data class HeartbeatResponseEntity(
     @PrimaryKey(autoGenerate = true)
     val id: Long = 0,
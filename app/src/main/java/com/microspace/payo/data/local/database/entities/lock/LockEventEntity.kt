@@ -2,10 +2,17 @@
 
 import androidx.room.ColumnInfo
 import androidx.room.Entity
+import androidx.room.Index
 import androidx.room.PrimaryKey
 import com.microspace.payo.data.local.database.entities.common.SyncStatus
 
-@Entity(tableName = "lock_events")
+@Entity(
+    tableName = "lock_events",
+    indices = [
+        Index(value = ["syncStatus", "occurredAt"]),
+        Index(value = ["deviceId", "occurredAt"])
+    ]
+)
 data class LockEventEntity(
     @PrimaryKey
     val id: String = java.util.UUID.randomUUID().toString(),
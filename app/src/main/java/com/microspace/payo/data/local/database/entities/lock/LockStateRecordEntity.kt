@@ -1,6 +1,7 @@
 ﻿package com.microspace.payo.data.local.database.entities.lock
 
 import androidx.room.Entity
+import androidx.room.Index
 import androidx.room.PrimaryKey
 
 /**
@@ -12,7 +13,13 @@ import androidx.room.PrimaryKey
  * - unlockDevice: mark latest unresolved HARD_LOCK with resolvedAt=now()
  * - Boot: get latest unresolved HARD_LOCK; if present, tatizo haijatatuliwa â†’ keep hard lock
  */
-@Entity(tableName = "lock_state_records")
+@Entity(
+    tableName = "lock_state_records",
+    indices = [
+        Index(value = ["lockState", "resolvedAt", "createdAt"]),
+        Index(value = ["createdAt"])
+    ]
+)
 data class LockStateRecordEntity(
     @PrimaryKey(autoGenerate = true)
     val id: Long = 0,
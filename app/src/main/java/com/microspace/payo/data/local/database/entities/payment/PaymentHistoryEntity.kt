@@ -0,0 +1,19 @@
+﻿package com.microspace.payo.data.local.database.entities.payment
+
+import androidx.room.Entity
+import androidx.room.PrimaryKey
+
+/**
+ * One payment history record. Append-only; the repository keeps only the newest
+ * [com.microspace.payo.data.repository.PaymentStateRepository.HISTORY_WINDOW] rows.
+ */
+@Entity(tableName = "payment_history")
+data class PaymentHistoryEntity(
+    @PrimaryKey(autoGenerate = true)
+    val id: Long = 0,
+    val date: Long,
+    val amount: String?,
+    val currency: String?,
+    val status: String,
+    val daysUntilDue: Int
+)
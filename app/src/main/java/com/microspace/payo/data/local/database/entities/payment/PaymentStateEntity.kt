@@ -0,0 +1,55 @@
+﻿package com.microspace.payo.data.local.database.entities.payment
+
+import androidx.room.Entity
+import androidx.room.PrimaryKey
+
+/**
+ * Materialized payment state: the one row lock screens, countdown and reminders read.
+ *
+ * Folded incrementally from heartbeat responses (next payment, lock flags, loan status) and
+ * installment syncs (totals and next due installment) by
+ * [com.microspace.payo.data.repository.PaymentStateRepository]; never assembled on read.
+ */
+@Entity(tableName = "payment_state")
+data class PaymentStateEntity(
+    @PrimaryKey
+    val id: Int = SINGLETON_ID,
+
+    // Next payment (heartbeat)
+    val nextPaymentDate: String? = null,
+    val unlockPassword: String? = null,
+    val paymentAmount: String? = null,
+    val paymentCurrency: String? = null,
+    val daysUntilPayment: Int = -1,
+
+    // Lock state
+    val isLocked: Boolean = false,
+    val lockReason: String? = null,
+    val lockTimestamp: Long = 0L,
+
+    // Server sync
+    val serverTime: String? = null,
+    val lastSyncTime: Long = 0L,
+
+    // Loan status (heartbeat)
+    val paymentComplete: Boolean = false,
+    val loanComplete: Boolean = false,
+    val loanStatus: String? = null,
+
+    // Installment aggregates (installment sync)
+    val installmentsPaid: Int = 0,
+    val installmentsTotal: Int = 0,
+    val overdueInstallments: Int = 0,
+    val totalAmountDue: Double = 0.0,
+    val totalAmountPaid: Double = 0.0,
+    val nextInstallmentDueDate: String? = null,
+    val nextInstallmentAmount: Double? = null,
+    val installmentsSyncedAt: Long = 0L
+) {
+    fun getRemainingAmount(): Double = totalAmountDue - totalAmountPaid
+
+    companion object {
+        const val SINGLETON_ID = 1
+        val EMPTY = PaymentStateEntity()
+    }
+}
@@ -2,6 +2,7 @@
 
 import androidx.room.ColumnInfo
 import androidx.room.Entity
+import androidx.room.Index
 import androidx.room.PrimaryKey
 
 /**
@@ -10,7 +11,12 @@ import androidx.room.PrimaryKey
  * Records each time the phone number, operator, or SIM serial changes.
  * Used to detect unauthorized SIM swaps and display history to the user.
  */
-@Entity(tableName = "sim_change_history")
+@Entity(
+    tableName = "sim_change_history",
+    indices = [
+        Index(value = ["changed_at"])
+    ]
+)
 data class SimChangeHistoryEntity(
     @PrimaryKey(autoGenerate = true)
     @ColumnInfo(name = "id")
@@ -1,9 +1,17 @@
 ﻿package com.microspace.payo.data.local.database.entities.tamper
 
 import androidx.room.Entity
+import androidx.room.Index
 import androidx.room.PrimaryKey
 
-@Entity(tableName = "tamper_detections")
+@Entity(
+    tableName = "tamper_detections",
+    indices = [
+        Index(value = ["syncStatus", "detectedAt"]),
+        Index(value = ["deviceId", "detectedAt"]),
+        Index(value = ["detectedAt"])
+    ]
+)
 data class TamperDetectionEntity(
     @PrimaryKey(autoGenerate = true)
     val id: Long = 0,
@@ -0,0 +1,35 @@
+﻿package com.microspace.payo.data.local.database.entities.uplink
+
+import androidx.room.ColumnInfo
+import androidx.room.Entity
+import androidx.room.Index
+import androidx.room.PrimaryKey
+
+/**
+ * One-shot state report waiting for the state report uplink to deliver it.
+ *
+ * [reportKey] is the report kind and device, so writing a newer state replaces an older one that
+ * was never sent. [revision] identifies the state a delivery attempt carried: a delivery deletes
+ * or reschedules the row only if no newer state replaced it meanwhile.
+ */
+@Entity(
+    tableName = "pending_reports",
+    indices = [Index(value = ["next_attempt_at"])]
+)
+data class PendingReportEntity(
+    @PrimaryKey
+    @ColumnInfo(name = "report_key")
+    val reportKey: String,
+    /** StateReportUplink.Kind name */
+    val kind: String,
+    @ColumnInfo(name = "device_id")
+    val deviceId: String,
+    /** JSON object sent as the request body */
+    val payload: String,
+    val revision: Long,
+    @ColumnInfo(name = "created_at")
+    val createdAt: Long,
+    val attempts: Int = 0,
+    @ColumnInfo(name = "next_attempt_at")
+    val nextAttemptAt: Long
+)
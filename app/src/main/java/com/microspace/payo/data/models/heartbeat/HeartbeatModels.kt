@@ -1,6 +1,8 @@
 ﻿package com.microspace.payo.data.models.heartbeat
 
 import com.google.gson.annotations.SerializedName
+import com.microspace.payo.config.SignedConfigBlob
+import com.microspace.payo.security.monitoring.violation.SignedViolationRuleSet
 
 /**
  * Heartbeat Request model based on HEARTBEAT_API_FLOW_DOCUMENTATION.md
@@ -30,7 +32,29 @@ data class HeartbeatRequest(
     @SerializedName("latitude") val latitude: Double?,
     @SerializedName("longitude") val longitude: Double?,
     @SerializedName("battery_level") val batteryLevel: Int,
-    @SerializedName("language") val language: String? = null
+    @SerializedName("language") val language: String? = null,
+    /** Results of remote commands executed since the last accepted heartbeat */
+    @SerializedName("command_acks") val commandAcks: List<CommandAck>? = null
+)
+
+/**
+ * Acknowledgement of a remote command executed by the command inbox.
+ */
+data class CommandAck(
+    @SerializedName("command_id") val commandId: String,
+    @SerializedName("success") val success: Boolean,
+    @SerializedName("message") val message: String?,
+    @SerializedName("executed_at") val executedAt: Long
+)
+
+/**
+ * Remote command delivered in a heartbeat response; run by the command inbox and acknowledged
+ * through [HeartbeatRequest.commandAcks] of a later heartbeat.
+ */
+data class RemoteCommand(
+    @SerializedName("command_id") val commandId: String? = null,
+    @SerializedName("action") val action: String? = null,
+    @SerializedName("reason") val reason: String? = null
 )
 
 /**
@@ -52,7 +76,10 @@ data class HeartbeatResponse(
     @SerializedName("management_status") val managementStatus: String? = null,
     @SerializedName("changes_detected") val changesDetected: Boolean? = null,
     @SerializedName("changed_fields") val changedFields: List<String>? = null,
-    @SerializedName("deactivate_requested") val deactivateRequested: Boolean? = null
+    @SerializedName("deactivate_requested") val deactivateRequested: Boolean? = null,
+    @SerializedName("violation_rules") val violationRules: SignedViolationRuleSet? = null,
+    @SerializedName("config") val config: SignedConfigBlob? = null,
+    @SerializedName("commands") val commands: List<RemoteCommand>? = null
 ) {
     fun isDeviceLocked(): Boolean {
         if (managementStatus?.lowercase() == "locked") return true
@@ -3,8 +3,13 @@
 // Force rebuild - timestamp: 2026-02-14
 import android.util.Log
 import com.microspace.payo.AppConfig
+import com.microspace.payo.config.RuntimeConfigStore
 import com.microspace.payo.data.remote.api.ApiHeadersInterceptor
+import com.microspace.payo.core.MemoryGovernor
+import com.microspace.payo.data.remote.api.HeartbeatRequestEncoder
+import com.microspace.payo.data.remote.api.HeartbeatSchemaCodec
 import com.microspace.payo.data.remote.api.HtmlResponseInterceptor
+import com.microspace.payo.data.remote.api.SharedHttpClient
 import com.microspace.payo.data.models.heartbeat.HeartbeatRequest
 import com.microspace.payo.data.models.heartbeat.HeartbeatResponse
 import com.microspace.payo.data.models.installation.InstallationStatusRequest
@@ -18,9 +23,6 @@ import com.microspace.payo.data.models.tech.BugReportResponse
 import com.microspace.payo.data.models.tech.DeviceLogRequest
 import com.microspace.payo.data.models.tech.DeviceLogResponse
 import com.google.gson.GsonBuilder
-import okhttp3.CertificatePinner
-import okhttp3.ConnectionSpec
-import okhttp3.OkHttpClient
 import okhttp3.logging.HttpLoggingInterceptor
 import retrofit2.Response
 import retrofit2.Retrofit
@@ -28,75 +30,52 @@ import retrofit2.converter.gson.GsonConverterFactory
 import java.util.concurrent.TimeUnit
 
 class ApiClient {
+
+    companion object {
+        // Shared by all ApiClient instances so pooled buffers and field caches survive between beats
+        private val heartbeatEncoder = HeartbeatRequestEncoder().also { MemoryGovernor.shared.register(it) }
+
+        // Negotiated schema and the fields the server already holds, likewise kept between beats
+        private val heartbeatCodec = HeartbeatSchemaCodec(heartbeatEncoder)
+
+        @Volatile
+        private var INSTANCE: ApiClient? = null
+
+        /** The process client, rebuilt when the runtime config (and with it the timeouts) changes. */
+        fun getInstance(): ApiClient {
+            val config = RuntimeConfigStore.current
+            INSTANCE?.takeIf { it.timeouts === config }?.let { return it }
+            return synchronized(this) {
+                INSTANCE?.takeIf { it.timeouts === config } ?: ApiClient().also { INSTANCE = it }
+            }
+        }
+    }
     
     private val gson = GsonBuilder()
         .setLenient()
         .serializeNulls()  // Include null values in JSON serialization
         .create()
     
-    private val okHttpClient = OkHttpClient.Builder()
-        .connectTimeout(120, TimeUnit.SECONDS)  // 2 minutes for SSL handshake
-        .readTimeout(120, TimeUnit.SECONDS)     // 2 minutes for slow networks
-        .writeTimeout(120, TimeUnit.SECONDS)    // 2 minutes for slow networks
-        .callTimeout(240, TimeUnit.SECONDS)     // 4 minutes overall request timeout
-        .addInterceptor(ApiHeadersInterceptor())
-        .addInterceptor(HtmlResponseInterceptor())
-        .apply {
-            // Use HEADERS only - BODY consumes the response stream, leaving errorBody() empty for 400/404/500
-            if (true) { // FORCED LOGGING ENABLED
-                val loggingInterceptor = HttpLoggingInterceptor().apply {
-                    level = HttpLoggingInterceptor.Level.HEADERS
-                }
-                addInterceptor(loggingInterceptor)
-            }
-            
-            // PERFECT SSL SECURITY FOR DEVICE OWNER
-            try {
-                // 1. Force modern TLS versions only (TLS 1.2+)
-                val connectionSpecs = listOf(
-                    ConnectionSpec.MODERN_TLS,
-                    ConnectionSpec.COMPATIBLE_TLS
-                )
-                connectionSpecs(connectionSpecs)
-                
-                // 2. Enhanced hostname verification
-                hostnameVerifier { hostname, session ->
-                    val validHostnames = listOf("payoplan.com", "api.payoplan.com")
-                    val isValidHostname = validHostnames.any { validHost ->
-                        hostname.equals(validHost, ignoreCase = true) || 
-                        hostname.endsWith(".$validHost", ignoreCase = true)
-                    }
-                    
-                    if (isValidHostname) {
-                        Log.d("ApiClient", "âœ… SSL hostname verified: $hostname")
-                        true
-                    } else {
-                        Log.e("ApiClient", "âŒ SSL hostname verification failed: $hostname")
-                        false
-                    }
-                }
-                
-                // 3. Certificate pinner for maximum security (programmatic pinning)
-                val certificatePinner = CertificatePinner.Builder()
-                    .add("payoplan.com", "sha256/y8S/sGw+VDqpDXnu4dKxrnI6nj1tdn0od2WAFM7zvog=") // REAL PAYOPLAN.COM PIN
-                    .add("api.payoplan.com", "sha256/y8S/sGw+VDqpDXnu4dKxrnI6nj1tdn0od2WAFM7zvog=") // REAL PAYOPLAN.COM PIN
-                    .build()
-                
-                // ENABLED: Certificate pinning is now active with real certificate pin
-                certificatePinner(certificatePinner)
-                
-                Log.d("ApiClient", "âœ… Perfect SSL security configured for Device Owner")
-                Log.d("ApiClient", "   - TLS 1.2+ enforced")
-                Log.d("ApiClient", "   - Hostname verification active")
-                Log.d("ApiClient", "   - Certificate pinning ACTIVE with real payoplan.com pin")
-                Log.d("ApiClient", "   - Pin: y8S/sGw+VDqpDXnu4dKxrnI6nj1tdn0od2WAFM7zvog=")
-                Log.d("ApiClient", "   - Device Owner ClassCastException should be FIXED!")
-                
-            } catch (e: Exception) {
-                Log.w("ApiClient", "Could not configure enhanced SSL: ${e.message}")
+    // Timeouts are taken from the runtime config when the client is built (defaults: 2/2/2/4 minutes)
+    private val timeouts = RuntimeConfigStore.current
+
+    // Derived from the shared client: pool, TLS session cache, cached DNS and the TLS policy
+    // (TLS 1.2+, hostname allow-list, certificate pinning) live in SharedHttpClient
+    private val okHttpClient = SharedHttpClient.newClient {
+        connectTimeout(timeouts.apiConnectTimeoutSeconds, TimeUnit.SECONDS)  // SSL handshake
+        readTimeout(timeouts.apiReadTimeoutSeconds, TimeUnit.SECONDS)        // slow networks
+        writeTimeout(timeouts.apiWriteTimeoutSeconds, TimeUnit.SECONDS)      // slow networks
+        callTimeout(timeouts.apiCallTimeoutSeconds, TimeUnit.SECONDS)        // overall request timeout
+        addInterceptor(ApiHeadersInterceptor())
+        addInterceptor(HtmlResponseInterceptor())
+        // Use HEADERS only - BODY consumes the response stream, leaving errorBody() empty for 400/404/500
+        if (true) { // FORCED LOGGING ENABLED
+            val loggingInterceptor = HttpLoggingInterceptor().apply {
+                level = HttpLoggingInterceptor.Level.HEADERS
             }
+            addInterceptor(loggingInterceptor)
         }
-        .build()
+    }
     
     private val retrofit = Retrofit.Builder()
         .baseUrl(AppConfig.BASE_URL)
@@ -111,6 +90,9 @@ class ApiClient {
             throw RuntimeException("Failed to create API service: ${e.message}", e)
         }
     }
+
+    /** The raw endpoints, for callers that map responses themselves (StateReportUplink). */
+    internal val service: ApiService get() = apiService
     
     suspend fun registerDevice(deviceData: DeviceRegistrationRequest): Response<DeviceRegistrationResponse> {
         Log.d("ApiClient", "ðŸ” Device Owner Registration Attempt")
@@ -208,8 +190,10 @@ class ApiClient {
         Log.d("ApiClient", "   Fingerprint: ${heartbeatData.deviceFingerprint}")
         Log.d("ApiClient", "   Bootloader: ${heartbeatData.bootloader}")
         
+        // Streamed into a pooled buffer instead of Gson -> String -> Buffer; see HeartbeatRequestEncoder.
+        // On schema 2 only the fields the server does not hold yet are sent; see HeartbeatSchemaCodec
         return try {
-            val response = apiService.sendHeartbeat(deviceId, heartbeatData)
+            val response = heartbeatCodec.send(heartbeatData) { body -> apiService.sendHeartbeat(deviceId, body) }
             if (response.isSuccessful) {
                 Log.d("ApiClient", "âœ… Heartbeat SUCCESS: HTTP ${response.code()}")
             } else {
@@ -17,6 +17,7 @@ import com.microspace.payo.data.models.tech.DeviceLogResponse
 import com.microspace.payo.data.models.payment.InstallmentResponse
 import com.microspace.payo.data.models.payment.PaymentRequest
 import com.microspace.payo.data.models.payment.PaymentResponse
+import okhttp3.RequestBody
 import retrofit2.Response
 import retrofit2.http.Body
 import retrofit2.http.GET
@@ -29,10 +30,11 @@ interface ApiService {
     @POST("api/devices/mobile/register/")
     suspend fun registerDevice(@Body deviceData: DeviceRegistrationRequest): Response<DeviceRegistrationResponse>
 
+    /** Body is a [HeartbeatRequest] pre-encoded by HeartbeatRequestEncoder, in the schema HeartbeatSchemaCodec negotiated. */
     @POST("api/devices/{device_id}/data/")
     suspend fun sendHeartbeat(
         @Path("device_id") deviceId: String,
-        @Body heartbeatData: HeartbeatRequest
+        @Body heartbeatData: RequestBody
     ): Response<HeartbeatResponse>
 
     /**
@@ -0,0 +1,124 @@
+﻿package com.microspace.payo.data.remote.api
+
+import android.util.Log
+import okhttp3.Dns
+import java.io.File
+import java.net.InetAddress
+import java.net.UnknownHostException
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.Executor
+
+/**
+ * DNS cache in front of the system resolver for the handful of API hosts.
+ *
+ * Fresh entries (younger than [ttlMillis]) are served directly. Expired entries are still served
+ * for up to [maxStaleMillis] while one background lookup refreshes them (stale-while-revalidate),
+ * so a beat never waits on DNS for a host it has seen before. If a blocking lookup fails, the
+ * last known addresses are used rather than failing the call.
+ *
+ * Entries are written to [store] so the first request after a process restart skips the cold
+ * lookup too. The platform resolver does not expose record TTLs, so [ttlMillis] is a fixed cap.
+ */
+class CachingDns internal constructor(
+    private val delegate: Dns,
+    private val ttlMillis: Long,
+    private val maxStaleMillis: Long,
+    private val refresher: Executor,
+    private val store: File?,
+    private val clock: () -> Long = System::currentTimeMillis
+) : Dns {
+
+    private class Entry(val addresses: List<InetAddress>, val resolvedAt: Long)
+
+    private val entries = ConcurrentHashMap<String, Entry>()
+    private val refreshing: MutableSet<String> = ConcurrentHashMap.newKeySet()
+
+    init {
+        load()
+    }
+
+    override fun lookup(hostname: String): List<InetAddress> {
+        val host = hostname.lowercase()
+        val entry = entries[host]
+        if (entry != null) {
+            val age = clock() - entry.resolvedAt
+            if (age in 0 until ttlMillis) return entry.addresses
+            if (age in 0 until ttlMillis + maxStaleMillis) {
+                refreshAsync(host)
+                return entry.addresses
+            }
+        }
+        return try {
+            resolve(host)
+        } catch (e: UnknownHostException) {
+            if (entry == null) throw e
+            Log.w(TAG, "Lookup of $host failed, using addresses from ${clock() - entry.resolvedAt}ms ago")
+            entry.addresses
+        }
+    }
+
+    /** Drops [hostname] after a connect failure so the next call resolves again instead of retrying dead addresses. */
+    fun invalidate(hostname: String) {
+        if (entries.remove(hostname.lowercase()) != null) refresher.execute { save() }
+    }
+
+    private fun resolve(host: String): List<InetAddress> {
+        val addresses = delegate.lookup(host)
+        entries[host] = Entry(addresses, clock())
+        refresher.execute { save() }
+        return addresses
+    }
+
+    private fun refreshAsync(host: String) {
+        if (!refreshing.add(host)) return
+        refresher.execute {
+            try {
+                resolve(host)
+            } catch (e: Exception) {
+                Log.w(TAG, "Background refresh of $host failed: ${e.message}")
+            } finally {
+                refreshing.remove(host)
+            }
+        }
+    }
+
+    /** One line per host: `host<TAB>resolvedAt<TAB>ip,ip,...`. */
+    @Synchronized
+    private fun save() {
+        val target = store ?: return
+        try {
+            val text = entries.entries.joinToString("\n") { (host, entry) ->
+                host + "\t" + entry.resolvedAt + "\t" + entry.addresses.joinToString(",") { it.hostAddress.orEmpty() }
+            }
+            val tmp = File(target.parentFile, target.name + ".tmp")
+            tmp.writeText(text)
+            if (!tmp.renameTo(target)) Log.w(TAG, "Could not replace ${target.name}")
+        } catch (e: Exception) {
+            Log.w(TAG, "Could not persist DNS cache: ${e.message}")
+        }
+    }
+
+    private fun load() {
+        val source = store?.takeIf { it.exists() } ?: return
+        try {
+            source.forEachLine { line ->
+                val parts = line.split('\t')
+                if (parts.size != 3) return@forEachLine
+                val resolvedAt = parts[1].toLongOrNull() ?: return@forEachLine
+                val addresses = parts[2].split(',').filter { it.isNotEmpty() }.map { literal ->
+                    // Literals never hit the resolver; re-attach the host name for SNI and logging
+                    InetAddress.getByAddress(parts[0], InetAddress.getByName(literal).address)
+                }
+                if (addresses.isNotEmpty()) entries[parts[0]] = Entry(addresses, resolvedAt)
+            }
+            Log.d(TAG, "Loaded ${entries.size} cached host(s)")
+        } catch (e: Exception) {
+            Log.w(TAG, "Ignoring unreadable DNS cache: ${e.message}")
+            entries.clear()
+        }
+    }
+
+    companion object {
+        private const val TAG = "CachingDns"
+    }
+}
@@ -0,0 +1,92 @@
+﻿package com.microspace.payo.data.remote.api
+
+import android.util.Log
+import okhttp3.Call
+import okhttp3.Connection
+import okhttp3.EventListener
+import okhttp3.Handshake
+import okhttp3.Protocol
+import java.io.IOException
+import java.net.InetAddress
+import java.net.InetSocketAddress
+import java.net.Proxy
+import java.util.concurrent.atomic.AtomicLong
+
+/**
+ * Per-call DNS / TCP / TLS timings, so the effect of pooling, the DNS cache and pre-warming is
+ * visible in logcat and in [Stats]. A connect failure evicts the host from [dns].
+ */
+class ConnectionTimingListener private constructor(
+    private val stats: Stats,
+    private val dns: CachingDns?
+) : EventListener() {
+
+    /** Process-wide counters, read by diagnostics and tests. */
+    class Stats {
+        val newConnections = AtomicLong()
+        val reusedConnections = AtomicLong()
+        val lastDnsMs = AtomicLong(-1)
+        val lastConnectMs = AtomicLong(-1)
+        val lastTlsHandshakeMs = AtomicLong(-1)
+
+        override fun toString() =
+            "new=${newConnections.get()} reused=${reusedConnections.get()} " +
+                "dns=${lastDnsMs.get()}ms connect=${lastConnectMs.get()}ms tls=${lastTlsHandshakeMs.get()}ms"
+    }
+
+    class Factory(private val stats: Stats, private val dns: CachingDns?) : EventListener.Factory {
+        override fun create(call: Call): EventListener = ConnectionTimingListener(stats, dns)
+    }
+
+    private var dnsStart = 0L
+    private var connectStart = 0L
+    private var tlsStart = 0L
+    private var connected = false
+
+    override fun dnsStart(call: Call, domainName: String) {
+        dnsStart = System.nanoTime()
+    }
+
+    override fun dnsEnd(call: Call, domainName: String, inetAddressList: List<InetAddress>) {
+        stats.lastDnsMs.set(elapsedMs(dnsStart))
+    }
+
+    override fun connectStart(call: Call, inetSocketAddress: InetSocketAddress, proxy: Proxy) {
+        connectStart = System.nanoTime()
+    }
+
+    override fun secureConnectStart(call: Call) {
+        tlsStart = System.nanoTime()
+    }
+
+    override fun secureConnectEnd(call: Call, handshake: Handshake?) {
+        stats.lastTlsHandshakeMs.set(elapsedMs(tlsStart))
+    }
+
+    override fun connectEnd(call: Call, inetSocketAddress: InetSocketAddress, proxy: Proxy, protocol: Protocol?) {
+        connected = true
+        stats.lastConnectMs.set(elapsedMs(connectStart))
+        stats.newConnections.incrementAndGet()
+        Log.d(TAG, "New connection to ${call.request().url.host}: $stats")
+    }
+
+    override fun connectFailed(
+        call: Call,
+        inetSocketAddress: InetSocketAddress,
+        proxy: Proxy,
+        protocol: Protocol?,
+        ioe: IOException
+    ) {
+        dns?.invalidate(call.request().url.host)
+    }
+
+    override fun connectionAcquired(call: Call, connection: Connection) {
+        if (!connected) stats.reusedConnections.incrementAndGet()
+    }
+
+    private fun elapsedMs(start: Long) = (System.nanoTime() - start) / 1_000_000
+
+    companion object {
+        private const val TAG = "ConnectionTiming"
+    }
+}
@@ -0,0 +1,92 @@
+﻿package com.microspace.payo.data.remote.api
+
+import com.microspace.payo.data.models.heartbeat.HeartbeatRequest
+
+/**
+ * HeartbeatField - the registered field dictionary of the heartbeat schema.
+ *
+ * A field's id is its ordinal: it is the field's bit in a schema-2 presence bitmap and its
+ * position in both encodings, so entries are only ever appended (a retired field keeps its slot).
+ * [kind] decides when a schema-2 beat carries the field; see [HeartbeatSchemaCodec].
+ */
+enum class HeartbeatField(val key: String, val kind: Kind) {
+    DEVICE_IMEIS("device_imeis", Kind.STATIC),
+    SERIAL_NUMBER("serial_number", Kind.STATIC),
+    INSTALLED_RAM("installed_ram", Kind.STATIC),
+    TOTAL_STORAGE("total_storage", Kind.STATIC),
+    IS_DEVICE_ROOTED("is_device_rooted", Kind.STATE),
+    IS_USB_DEBUGGING_ENABLED("is_usb_debugging_enabled", Kind.STATE),
+    IS_DEVELOPER_MODE_ENABLED("is_developer_mode_enabled", Kind.STATE),
+    IS_BOOTLOADER_UNLOCKED("is_bootloader_unlocked", Kind.STATE),
+    IS_CUSTOM_ROM("is_custom_rom", Kind.STATE),
+    ANDROID_ID("android_id", Kind.STATE),
+    MODEL("model", Kind.STATIC),
+    MANUFACTURER("manufacturer", Kind.STATIC),
+    DEVICE_FINGERPRINT("device_fingerprint", Kind.STATIC),
+    BOOTLOADER("bootloader", Kind.STATIC),
+    OS_VERSION("os_version", Kind.STATE),
+    OS_EDITION("os_edition", Kind.STATIC),
+    SDK_VERSION("sdk_version", Kind.STATE),
+    SECURITY_PATCH_LEVEL("security_patch_level", Kind.STATE),
+    SYSTEM_UPTIME("system_uptime", Kind.STATE),
+    INSTALLED_APPS_HASH("installed_apps_hash", Kind.STATE),
+    SYSTEM_PROPERTIES_HASH("system_properties_hash", Kind.STATE),
+    LATITUDE("latitude", Kind.STATE),
+    LONGITUDE("longitude", Kind.STATE),
+    BATTERY_LEVEL("battery_level", Kind.STATE),
+    LANGUAGE("language", Kind.STATE),
+    COMMAND_ACKS("command_acks", Kind.EVENT);
+
+    enum class Kind {
+        /** Fixed for the device; covered by the static digest and sent as a block when it changes. */
+        STATIC,
+        /** Current device state; sent when it differs from what the server last accepted. */
+        STATE,
+        /** Belongs to this beat only; sent whenever it is non-null. */
+        EVENT
+    }
+
+    val bit: Long get() = 1L shl ordinal
+
+    fun valueOf(request: HeartbeatRequest): Any? = when (this) {
+        DEVICE_IMEIS -> request.deviceImeis
+        SERIAL_NUMBER -> request.serialNumber
+        INSTALLED_RAM -> request.installedRam
+        TOTAL_STORAGE -> request.totalStorage
+        IS_DEVICE_ROOTED -> request.isDeviceRooted
+        IS_USB_DEBUGGING_ENABLED -> request.isUsbDebuggingEnabled
+        IS_DEVELOPER_MODE_ENABLED -> request.isDeveloperModeEnabled
+        IS_BOOTLOADER_UNLOCKED -> request.isBootloaderUnlocked
+        IS_CUSTOM_ROM -> request.isCustomRom
+        ANDROID_ID -> request.androidId
+        MODEL -> request.model
+        MANUFACTURER -> request.manufacturer
+        DEVICE_FINGERPRINT -> request.deviceFingerprint
+        BOOTLOADER -> request.bootloader
+        OS_VERSION -> request.osVersion
+        OS_EDITION -> request.osEdition
+        SDK_VERSION -> request.sdkVersion
+        SECURITY_PATCH_LEVEL -> request.securityPatchLevel
+        SYSTEM_UPTIME -> request.systemUptime
+        INSTALLED_APPS_HASH -> request.installedAppsHash
+        SYSTEM_PROPERTIES_HASH -> request.systemPropertiesHash
+        LATITUDE -> request.latitude
+        LONGITUDE -> request.longitude
+        BATTERY_LEVEL -> request.batteryLevel
+        LANGUAGE -> request.language
+        COMMAND_ACKS -> request.commandAcks
+    }
+
+    companion object {
+        /** All fields in id order, without the copy values() makes. */
+        val ALL: Array<HeartbeatField> = values()
+
+        val STATIC_FIELDS: List<HeartbeatField> = ALL.filter { it.kind == Kind.STATIC }
+
+        /** Presence bitmap with every field set. */
+        val ALL_PRESENT: Long = ALL.fold(0L) { mask, field -> mask or field.bit }
+
+        /** Presence bits of everything but events: a beat carrying all of them is a full snapshot. */
+        val SNAPSHOT: Long = ALL.filter { it.kind != Kind.EVENT }.fold(0L) { mask, field -> mask or field.bit }
+    }
+}
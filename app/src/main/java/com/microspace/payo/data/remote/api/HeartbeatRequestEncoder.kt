@@ -0,0 +1,338 @@
+﻿package com.microspace.payo.data.remote.api
+
+import com.microspace.payo.core.MemoryGovernor
+import com.microspace.payo.data.models.heartbeat.CommandAck
+import com.microspace.payo.data.models.heartbeat.HeartbeatRequest
+import okhttp3.MediaType
+import okhttp3.MediaType.Companion.toMediaType
+import okhttp3.RequestBody
+import okio.BufferedSink
+
+/**
+ * Streams a [HeartbeatRequest] as JSON straight into a pooled byte array.
+ *
+ * Output is byte-identical to the app's Gson (serializeNulls, HTML-safe escaping), but no
+ * intermediate String, JsonWriter or Okio Buffer is created: field names are pre-encoded once,
+ * and each field's last value is kept with its encoded bytes, so fields that do not change
+ * between beats (model, fingerprint, IMEIs, ...) are a plain array copy. After warm-up a beat
+ * allocates nothing.
+ *
+ * [encode] writes the schema-1 JSON object; [encodeCompact] writes the same field values as a
+ * schema-2 presence-bitmap payload for [HeartbeatSchemaCodec]. Field positions in both come from
+ * the [HeartbeatField] dictionary.
+ *
+ * A body stays leased until [release]; the pool holds [POOL_SIZE] bodies (one on a low-RAM
+ * profile) so a SIM-triggered beat can overlap the periodic one, beyond that a fresh body is
+ * allocated. Under memory pressure [trim] drops the pool and the field caches; the next beat
+ * rebuilds them.
+ */
+class HeartbeatRequestEncoder : MemoryGovernor.Consumer {
+
+    /** Reusable request body; bytes stay valid (and retries replay them) until released. */
+    class PooledBody internal constructor() : RequestBody() {
+        internal var bytes = ByteArray(INITIAL_CAPACITY)
+        internal var length = 0
+        internal var mediaType = JSON
+
+        override fun contentType(): MediaType = mediaType
+        override fun contentLength(): Long = length.toLong()
+        override fun writeTo(sink: BufferedSink) {
+            sink.write(bytes, 0, length)
+        }
+
+        internal fun ensure(extra: Int) {
+            if (length + extra > bytes.size) bytes = bytes.copyOf(maxOf(bytes.size * 2, length + extra))
+        }
+
+        internal fun put(b: Int) {
+            ensure(1)
+            bytes[length++] = b.toByte()
+        }
+
+        internal fun put(src: ByteArray, len: Int = src.size) {
+            ensure(len)
+            System.arraycopy(src, 0, bytes, length, len)
+            length += len
+        }
+
+        /** Bytes written so far, for tests and logging. */
+        fun toUtf8(): String = String(bytes, 0, length, Charsets.UTF_8)
+    }
+
+    /** Last value of one field and its encoded JSON bytes. */
+    private class FieldCache {
+        var string: String? = null
+        var bits = 0L
+        var valid = false
+        var encoded = ByteArray(32)
+        var length = 0
+    }
+
+    private val pool = ArrayDeque<PooledBody>(POOL_SIZE)
+    private var poolLimit = POOL_SIZE
+    private val caches = Array(FIELD_NAMES.size) { FieldCache() }
+    private val scratch = PooledBody()
+
+    @Synchronized
+    fun encode(request: HeartbeatRequest): PooledBody {
+        val body = lease(JSON)
+        for (field in HeartbeatField.ALL) {
+            body.put(FIELD_NAMES[field.ordinal])
+            value(body, field, request)
+        }
+        body.put('}'.code)
+        return body
+    }
+
+    /**
+     * Schema-2 payload: `{"schema":N,"static_digest":"..","present":bitmap,"values":[..]}` where
+     * values holds the fields whose [HeartbeatField.bit] is set in [present], in id order.
+     */
+    @Synchronized
+    fun encodeCompact(request: HeartbeatRequest, schema: Int, staticDigest: String, present: Long, mediaType: MediaType): PooledBody {
+        val body = lease(mediaType)
+        body.put(COMPACT_SCHEMA); long(body, schema.toLong())
+        body.put(COMPACT_DIGEST); writeString(body, staticDigest)
+        body.put(COMPACT_PRESENT); long(body, present)
+        body.put(COMPACT_VALUES)
+        var first = true
+        for (field in HeartbeatField.ALL) {
+            if ((present and field.bit) == 0L) continue
+            if (!first) body.put(','.code)
+            first = false
+            value(body, field, request)
+        }
+        body.put(']'.code)
+        body.put('}'.code)
+        return body
+    }
+
+    @Synchronized
+    fun release(body: PooledBody) {
+        if (pool.size < poolLimit && body !in pool) pool.addLast(body)
+    }
+
+    override val name = "heartbeat_encoder"
+
+    override val priority = MemoryGovernor.Priority.REBUILDABLE
+
+    @Synchronized
+    override fun retainedBytes(): Long =
+        pool.sumOf { it.bytes.size.toLong() } + caches.sumOf { it.encoded.size.toLong() }
+
+    @Synchronized
+    override fun trim() {
+        pool.clear()
+        for (cache in caches) {
+            cache.string = null
+            cache.valid = false
+            cache.encoded = ByteArray(32)
+            cache.length = 0
+        }
+        // Otherwise it keeps the last re-encoded field's old array alive
+        scratch.bytes = EMPTY
+    }
+
+    @Synchronized
+    override fun applyProfile(profile: MemoryGovernor.Profile) {
+        poolLimit = profile.encoderPoolSize
+        while (pool.size > poolLimit) pool.removeLast()
+    }
+
+    private fun lease(mediaType: MediaType): PooledBody {
+        val body = pool.removeFirstOrNull() ?: PooledBody()
+        body.length = 0
+        body.mediaType = mediaType
+        return body
+    }
+
+    /** The JSON value of [field]; its ordinal is also its slot in [caches]. */
+    private fun value(body: PooledBody, field: HeartbeatField, request: HeartbeatRequest) = when (field) {
+        HeartbeatField.DEVICE_IMEIS -> stringList(body, request.deviceImeis)
+        HeartbeatField.SERIAL_NUMBER -> string(body, field, request.serialNumber)
+        HeartbeatField.INSTALLED_RAM -> string(body, field, request.installedRam)
+        HeartbeatField.TOTAL_STORAGE -> string(body, field, request.totalStorage)
+        HeartbeatField.IS_DEVICE_ROOTED -> bool(body, request.isDeviceRooted)
+        HeartbeatField.IS_USB_DEBUGGING_ENABLED -> bool(body, request.isUsbDebuggingEnabled)
+        HeartbeatField.IS_DEVELOPER_MODE_ENABLED -> bool(body, request.isDeveloperModeEnabled)
+        HeartbeatField.IS_BOOTLOADER_UNLOCKED -> bool(body, request.isBootloaderUnlocked)
+        HeartbeatField.IS_CUSTOM_ROM -> bool(body, request.isCustomRom)
+        HeartbeatField.ANDROID_ID -> string(body, field, request.androidId)
+        HeartbeatField.MODEL -> string(body, field, request.model)
+        HeartbeatField.MANUFACTURER -> string(body, field, request.manufacturer)
+        HeartbeatField.DEVICE_FINGERPRINT -> string(body, field, request.deviceFingerprint)
+        HeartbeatField.BOOTLOADER -> string(body, field, request.bootloader)
+        HeartbeatField.OS_VERSION -> string(body, field, request.osVersion)
+        HeartbeatField.OS_EDITION -> string(body, field, request.osEdition)
+        HeartbeatField.SDK_VERSION -> long(body, request.sdkVersion.toLong())
+        HeartbeatField.SECURITY_PATCH_LEVEL -> string(body, field, request.securityPatchLevel)
+        HeartbeatField.SYSTEM_UPTIME -> long(body, request.systemUptime)
+        HeartbeatField.INSTALLED_APPS_HASH -> string(body, field, request.installedAppsHash)
+        HeartbeatField.SYSTEM_PROPERTIES_HASH -> string(body, field, request.systemPropertiesHash)
+        HeartbeatField.LATITUDE -> double(body, field, request.latitude)
+        HeartbeatField.LONGITUDE -> double(body, field, request.longitude)
+        HeartbeatField.BATTERY_LEVEL -> long(body, request.batteryLevel.toLong())
+        HeartbeatField.LANGUAGE -> string(body, field, request.language)
+        HeartbeatField.COMMAND_ACKS -> commandAcks(body, request.commandAcks)
+    }
+
+    private fun bool(body: PooledBody, value: Boolean) = body.put(if (value) TRUE else FALSE)
+
+    private fun string(body: PooledBody, field: HeartbeatField, value: String?) {
+        if (value == null) return body.put(NULL)
+        val cache = caches[field.ordinal]
+        if (!cache.valid || cache.string != value) {
+            scratch.bytes = cache.encoded
+            scratch.length = 0
+            writeString(scratch, value)
+            cache.encoded = scratch.bytes
+            cache.length = scratch.length
+            cache.string = value
+            cache.valid = true
+        }
+        body.put(cache.encoded, cache.length)
+    }
+
+    private fun double(body: PooledBody, field: HeartbeatField, value: Double?) {
+        if (value == null) return body.put(NULL)
+        val cache = caches[field.ordinal]
+        val bits = value.toRawBits()
+        if (!cache.valid || cache.bits != bits) {
+            // Same text as Gson's JsonWriter.value(double); only re-rendered when the value moves
+            val text = value.toString()
+            scratch.bytes = cache.encoded
+            scratch.length = 0
+            for (c in text) scratch.put(c.code)
+            cache.encoded = scratch.bytes
+            cache.length = scratch.length
+            cache.bits = bits
+            cache.valid = true
+        }
+        body.put(cache.encoded, cache.length)
+    }
+
+    private fun stringList(body: PooledBody, values: List<String>?) {
+        if (values == null) return body.put(NULL)
+        body.put('['.code)
+        for (i in values.indices) {
+            if (i > 0) body.put(','.code)
+            writeString(body, values[i])
+        }
+        body.put(']'.code)
+    }
+
+    private fun commandAcks(body: PooledBody, acks: List<CommandAck>?) {
+        if (acks == null) return body.put(NULL)
+        body.put('['.code)
+        for (i in acks.indices) {
+            val ack = acks[i]
+            body.put(if (i > 0) ACK_ID_NEXT else ACK_ID_FIRST)
+            writeString(body, ack.commandId)
+            body.put(ACK_SUCCESS); bool(body, ack.success)
+            body.put(ACK_MESSAGE); if (ack.message != null) writeString(body, ack.message) else body.put(NULL)
+            body.put(ACK_EXECUTED_AT); long(body, ack.executedAt)
+            body.put('}'.code)
+        }
+        body.put(']'.code)
+    }
+
+    private fun long(body: PooledBody, value: Long) {
+        if (value == Long.MIN_VALUE) {
+            for (c in value.toString()) body.put(c.code)
+            return
+        }
+        var v = value
+        if (v < 0) {
+            body.put('-'.code)
+            v = -v
+        }
+        var digits = 1
+        var probe = v
+        while (probe >= 10) {
+            probe /= 10
+            digits++
+        }
+        body.ensure(digits)
+        var pos = body.length + digits - 1
+        do {
+            body.bytes[pos--] = ('0'.code + (v % 10).toInt()).toByte()
+            v /= 10
+        } while (v > 0)
+        body.length += digits
+    }
+
+    /** Quoted, Gson-escaped, UTF-8 encoded, char by char. */
+    private fun writeString(body: PooledBody, s: String) {
+        body.put('"'.code)
+        var i = 0
+        val n = s.length
+        while (i < n) {
+            val c = s[i].code
+            when {
+                c == '"'.code || c == '\\'.code -> { body.put('\\'.code); body.put(c) }
+                c == '\n'.code -> { body.put('\\'.code); body.put('n'.code) }
+                c == '\r'.code -> { body.put('\\'.code); body.put('r'.code) }
+                c == '\t'.code -> { body.put('\\'.code); body.put('t'.code) }
+                c == '\b'.code -> { body.put('\\'.code); body.put('b'.code) }
+                c == 0x0c -> { body.put('\\'.code); body.put('f'.code) }
+                c < 0x20 || c == '<'.code || c == '>'.code || c == '&'.code || c == '='.code ||
+                    c == '\''.code || c == 0x2028 || c == 0x2029 -> unicodeEscape(body, c)
+                c < 0x80 -> body.put(c)
+                c < 0x800 -> {
+                    body.put(0xc0 or (c shr 6))
+                    body.put(0x80 or (c and 0x3f))
+                }
+                Character.isHighSurrogate(s[i]) && i + 1 < n && Character.isLowSurrogate(s[i + 1]) -> {
+                    val cp = Character.toCodePoint(s[i], s[i + 1])
+                    body.put(0xf0 or (cp shr 18))
+                    body.put(0x80 or ((cp shr 12) and 0x3f))
+                    body.put(0x80 or ((cp shr 6) and 0x3f))
+                    body.put(0x80 or (cp and 0x3f))
+                    i++
+                }
+                // Lone surrogate: String.getBytes(UTF_8) writes '?'
+                Character.isSurrogate(s[i]) -> body.put('?'.code)
+                else -> {
+                    body.put(0xe0 or (c shr 12))
+                    body.put(0x80 or ((c shr 6) and 0x3f))
+                    body.put(0x80 or (c and 0x3f))
+                }
+            }
+            i++
+        }
+        body.put('"'.code)
+    }
+
+    private fun unicodeEscape(body: PooledBody, c: Int) {
+        body.put('\\'.code)
+        body.put('u'.code)
+        body.put(HEX[(c shr 12) and 0xf].code)
+        body.put(HEX[(c shr 8) and 0xf].code)
+        body.put(HEX[(c shr 4) and 0xf].code)
+        body.put(HEX[c and 0xf].code)
+    }
+
+    companion object {
+        const val POOL_SIZE = 2
+        private const val INITIAL_CAPACITY = 2048
+        private const val HEX = "0123456789abcdef"
+        private val EMPTY = ByteArray(0)
+        private val JSON = "application/json; charset=UTF-8".toMediaType()
+        private val TRUE = "true".toByteArray()
+        private val FALSE = "false".toByteArray()
+        private val NULL = "null".toByteArray()
+        private val ACK_ID_FIRST = "{\"command_id\":".toByteArray()
+        private val ACK_ID_NEXT = ",{\"command_id\":".toByteArray()
+        private val ACK_SUCCESS = ",\"success\":".toByteArray()
+        private val ACK_MESSAGE = ",\"message\":".toByteArray()
+        private val ACK_EXECUTED_AT = ",\"executed_at\":".toByteArray()
+        private val COMPACT_SCHEMA = "{\"schema\":".toByteArray()
+        private val COMPACT_DIGEST = ",\"static_digest\":".toByteArray()
+        private val COMPACT_PRESENT = ",\"present\":".toByteArray()
+        private val COMPACT_VALUES = ",\"values\":[".toByteArray()
+
+        /** `{"name":` / `,"name":` in [HeartbeatField] id order, which is [HeartbeatRequest] declaration (Gson's) order. */
+        private val FIELD_NAMES: Array<ByteArray> = HeartbeatField.ALL
+            .mapIndexed { i, field -> ((if (i == 0) "{" else ",") + "\"" + field.key + "\":").toByteArray() }.toTypedArray()
+    }
+}
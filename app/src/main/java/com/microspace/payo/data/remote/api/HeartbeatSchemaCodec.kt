@@ -0,0 +1,186 @@
+﻿package com.microspace.payo.data.remote.api
+
+import android.util.Log
+import com.microspace.payo.data.models.heartbeat.HeartbeatRequest
+import okhttp3.MediaType.Companion.toMediaType
+import retrofit2.Response
+import java.security.MessageDigest
+
+/**
+ * HeartbeatSchemaCodec - picks the heartbeat schema and, on schema 2, which fields a beat carries.
+ *
+ * Schema 1 is the full [HeartbeatRequest] JSON, sent until the server advertises schema 2 with
+ * the [SCHEMA_HEADER] response header. A schema-2 beat ([MEDIA_TYPE_V2]) carries a digest of
+ * the [HeartbeatField.Kind.STATIC] fields, a presence bitmap and only the fields the server does
+ * not already hold: the static block when its digest changed, state fields that differ from the
+ * last accepted beat, and non-null events. A server whose stored digest does not match answers
+ * 409 and the beat is re-sent with every field; a 415 drops back to schema 1.
+ *
+ * When a beat's fate is unknown (the call threw, or any other non-2xx such as a 5xx from a proxy
+ * that may have forwarded it), the server may hold it or not, so the next beat is a full one.
+ *
+ * The baseline is only advanced by accepted beats, and only when no other beat was accepted
+ * since this one was encoded; otherwise the next beat is a full one.
+ */
+class HeartbeatSchemaCodec(private val encoder: HeartbeatRequestEncoder) {
+
+    /** One encoded beat; report its outcome to [onResponse], then release [body] to the encoder. */
+    class Beat internal constructor(
+        val body: HeartbeatRequestEncoder.PooledBody,
+        val schema: Int,
+        val present: Long,
+        internal val request: HeartbeatRequest,
+        internal val staticDigest: String,
+        internal val generation: Long
+    )
+
+    companion object {
+        private const val TAG = "HeartbeatSchemaCodec"
+
+        const val SCHEMA_V1 = 1
+        const val SCHEMA_V2 = 2
+
+        /** Response header with the highest schema the server accepts. */
+        const val SCHEMA_HEADER = "X-Heartbeat-Schema"
+
+        val MEDIA_TYPE_V2 = "application/vnd.payo.heartbeat+json; v=2".toMediaType()
+
+        /**
+         * Hex of the first 8 bytes of SHA-256 over `key=value\n` for each static field in id order,
+         * IMEIs joined with commas. The server computes the same over what it stored.
+         */
+        fun staticDigest(request: HeartbeatRequest): String {
+            val text = StringBuilder()
+            for (field in HeartbeatField.STATIC_FIELDS) {
+                val value = field.valueOf(request)
+                text.append(field.key).append('=')
+                    .append(if (value is List<*>) value.joinToString(",") else value ?: "")
+                    .append('\n')
+            }
+            val hash = MessageDigest.getInstance("SHA-256").digest(text.toString().toByteArray(Charsets.UTF_8))
+            return hash.take(8).joinToString("") { "%02x".format(it) }
+        }
+    }
+
+    private var serverSchema = SCHEMA_V1
+    private var baseline: HeartbeatRequest? = null
+    private var baselineDigest: String? = null
+    private var generation = 0L
+    private var digestSource: HeartbeatRequest? = null
+    private var digest = ""
+
+    val schema: Int
+        @Synchronized get() = serverSchema
+
+    /**
+     * Encodes [request], hands the body to [post] and records the answer, posting once more in
+     * full when the server asks for it. Bodies go back to the encoder before this returns.
+     */
+    suspend fun <T> send(
+        request: HeartbeatRequest,
+        post: suspend (HeartbeatRequestEncoder.PooledBody) -> Response<T>
+    ): Response<T> {
+        var beat = encode(request)
+        try {
+            var response = postOrResync(beat, post)
+            if (onResponse(beat, response.code(), response.headers()[SCHEMA_HEADER])) {
+                Log.d(TAG, "Heartbeat schema ${beat.schema} answered HTTP ${response.code()}, resending in full")
+                encoder.release(beat.body)
+                beat = encode(request)
+                response = postOrResync(beat, post)
+                onResponse(beat, response.code(), response.headers()[SCHEMA_HEADER])
+            }
+            return response
+        } finally {
+            encoder.release(beat.body)
+        }
+    }
+
+    /** The request may have reached the server before the call failed, e.g. a lost response. */
+    private suspend fun <T> postOrResync(
+        beat: Beat,
+        post: suspend (HeartbeatRequestEncoder.PooledBody) -> Response<T>
+    ): Response<T> = try {
+        post(beat.body)
+    } catch (e: Exception) {
+        resync()
+        throw e
+    }
+
+    @Synchronized
+    fun encode(request: HeartbeatRequest): Beat {
+        val digest = digestOf(request)
+        if (serverSchema < SCHEMA_V2) {
+            return Beat(encoder.encode(request), SCHEMA_V1, HeartbeatField.ALL_PRESENT, request, digest, generation)
+        }
+        val base = baseline
+        var present = 0L
+        for (field in HeartbeatField.ALL) {
+            val carried = when {
+                field.kind == HeartbeatField.Kind.EVENT -> field.valueOf(request) != null
+                base == null -> true
+                field.kind == HeartbeatField.Kind.STATIC -> digest != baselineDigest
+                else -> field.valueOf(request) != field.valueOf(base)
+            }
+            if (carried) present = present or field.bit
+        }
+        val body = encoder.encodeCompact(request, SCHEMA_V2, digest, present, MEDIA_TYPE_V2)
+        return Beat(body, SCHEMA_V2, present, request, digest, generation)
+    }
+
+    /**
+     * Records the server's answer to [beat]: [code] is the HTTP status and [advertisedSchema] the
+     * [SCHEMA_HEADER] value. Returns true when the beat must be encoded and sent again.
+     */
+    @Synchronized
+    fun onResponse(beat: Beat, code: Int, advertisedSchema: String?): Boolean {
+        advertisedSchema?.trim()?.toIntOrNull()?.let { serverSchema = it.coerceIn(SCHEMA_V1, SCHEMA_V2) }
+        val full = (beat.present and HeartbeatField.SNAPSHOT) == HeartbeatField.SNAPSHOT
+        return when {
+            code in 200..299 -> {
+                // A full beat replaces everything; a partial one only applies to the baseline it was diffed against
+                if (full || beat.generation == generation) {
+                    // Events belong to the beat that carried them
+                    baseline = beat.request.copy(commandAcks = null)
+                    baselineDigest = beat.staticDigest
+                } else {
+                    resync()
+                }
+                generation++
+                false
+            }
+            // Digest mismatch: the server lost or never had the static block
+            beat.schema >= SCHEMA_V2 && code == 409 && !full -> {
+                resync()
+                true
+            }
+            beat.schema >= SCHEMA_V2 && code == 415 -> {
+                serverSchema = SCHEMA_V1
+                resync()
+                true
+            }
+            // Applied or not is unknown: diff against nothing until a beat is accepted
+            else -> {
+                resync()
+                false
+            }
+        }
+    }
+
+    /** Forgets what the server holds; the next schema-2 beat carries every field. */
+    @Synchronized
+    fun resync() {
+        baseline = null
+        baselineDigest = null
+        generation++
+    }
+
+    private fun digestOf(request: HeartbeatRequest): String {
+        val source = digestSource
+        if (source == null || HeartbeatField.STATIC_FIELDS.any { it.valueOf(source) != it.valueOf(request) }) {
+            digest = staticDigest(request)
+            digestSource = request
+        }
+        return digest
+    }
+}
@@ -0,0 +1,158 @@
+﻿package com.microspace.payo.data.remote.api
+
+import android.content.Context
+import android.util.Log
+import com.microspace.payo.AppConfig
+import com.microspace.payo.core.MemoryGovernor
+import okhttp3.Call
+import okhttp3.Callback
+import okhttp3.CertificatePinner
+import okhttp3.ConnectionPool
+import okhttp3.ConnectionSpec
+import okhttp3.Dns
+import okhttp3.OkHttpClient
+import okhttp3.Request
+import okhttp3.Response
+import java.io.File
+import java.io.IOException
+import java.security.KeyStore
+import java.util.concurrent.Executors
+import java.util.concurrent.TimeUnit
+import javax.net.ssl.HostnameVerifier
+import javax.net.ssl.SSLContext
+import javax.net.ssl.TrustManagerFactory
+import javax.net.ssl.X509TrustManager
+
+/**
+ * One connection layer for every call to payoplan.com.
+ *
+ * Each [com.microspace.payo.data.remote.ApiClient] used to build its own OkHttpClient, so
+ * every heartbeat, tamper report and log POST from a fresh instance paid DNS + TCP + a full
+ * pinned TLS handshake. Clients now derive from [base] via [newClient], sharing:
+ *  - the connection pool, so a warm keep-alive connection is reused across instances;
+ *  - one SSLContext, so a new connection resumes the previous TLS session;
+ *  - [CachingDns], persisted in no-backup storage so a restart skips the cold lookup;
+ *  - the TLS policy (specs, hostname allow-list, pins), which is also what makes pooled
+ *    connections interchangeable between clients.
+ *
+ * [prewarm] opens a connection ahead of a scheduled beat; [stats] records the timings. Idle
+ * connections are the first thing the [MemoryGovernor] releases.
+ */
+object SharedHttpClient {
+    private const val TAG = "SharedHttpClient"
+    private const val DNS_CACHE_FILE = "api_dns_cache.tsv"
+    private const val DNS_TTL_MS = 10 * 60_000L
+    private const val DNS_MAX_STALE_MS = 24 * 60 * 60_000L
+    private const val TLS_SESSION_TIMEOUT_SECONDS = 12 * 60 * 60
+    // Socket, TLS record and Okio segment buffers of one idle keep-alive connection, roughly
+    private const val IDLE_CONNECTION_BYTES = 64L * 1024
+
+    private val allowedHosts = listOf("payoplan.com", "api.payoplan.com")
+    private val refresher = Executors.newSingleThreadExecutor { r -> Thread(r, "api-dns").apply { isDaemon = true } }
+
+    val stats = ConnectionTimingListener.Stats()
+
+    @Volatile
+    private var dnsStore: File? = null
+
+    /** Shared instance so pooled connections match on Address equality across clients. */
+    val hostnameVerifier = HostnameVerifier { hostname, _ ->
+        val isValidHostname = allowedHosts.any { validHost ->
+            hostname.equals(validHost, ignoreCase = true) ||
+                hostname.endsWith(".$validHost", ignoreCase = true)
+        }
+        if (isValidHostname) {
+            Log.d(TAG, "✅ SSL hostname verified: $hostname")
+        } else {
+            Log.e(TAG, "❌ SSL hostname verification failed: $hostname")
+        }
+        isValidHostname
+    }
+
+    val certificatePinner = CertificatePinner.Builder()
+        .add("payoplan.com", "sha256/y8S/sGw+VDqpDXnu4dKxrnI6nj1tdn0od2WAFM7zvog=") // REAL PAYOPLAN.COM PIN
+        .add("api.payoplan.com", "sha256/y8S/sGw+VDqpDXnu4dKxrnI6nj1tdn0od2WAFM7zvog=") // REAL PAYOPLAN.COM PIN
+        .build()
+
+    /** Points the DNS cache at persistent storage; call before the first API call. */
+    fun init(context: Context) {
+        if (dnsStore == null) dnsStore = File(context.applicationContext.noBackupFilesDir, DNS_CACHE_FILE)
+        MemoryGovernor.shared.register(idleConnections)
+    }
+
+    private val lazyBase = lazy {
+        val dns = CachingDns(Dns.SYSTEM, DNS_TTL_MS, DNS_MAX_STALE_MS, refresher, dnsStore)
+        val maxIdle = MemoryGovernor.shared.profile.httpIdleConnections
+        buildBase(platformTrustManager(), hostnameVerifier, certificatePinner, dns, maxIdle).also {
+            Log.d(TAG, "✅ Shared client: TLS 1.2+, hostname allow-list, pinning, cached DNS (store=${dnsStore != null})")
+        }
+    }
+
+    val base: OkHttpClient by lazyBase
+
+    /** Idle pooled connections; evicting them closes sockets, so it runs off the main thread. */
+    private val idleConnections = object : MemoryGovernor.Consumer {
+        override val name = "http_idle_connections"
+        override val priority = MemoryGovernor.Priority.DISPOSABLE
+
+        override fun retainedBytes(): Long =
+            if (lazyBase.isInitialized()) base.connectionPool.idleConnectionCount() * IDLE_CONNECTION_BYTES else 0L
+
+        override fun trim() {
+            if (lazyBase.isInitialized()) base.connectionPool.evictAll()
+        }
+    }
+
+    /** A client with per-caller timeouts and interceptors on top of the shared pool and TLS state. */
+    fun newClient(configure: OkHttpClient.Builder.() -> Unit): OkHttpClient =
+        base.newBuilder().apply(configure).build()
+
+    /**
+     * Opens a connection to the API host if none is idle, so the next beat goes out on a warm
+     * socket. Fire-and-forget; a failure is only logged and the beat connects as before.
+     */
+    fun prewarm() = prewarm(base, AppConfig.BASE_URL)
+
+    internal fun prewarm(client: OkHttpClient, url: String) {
+        if (client.connectionPool.idleConnectionCount() > 0) return
+        val request = Request.Builder().url(url).head().build()
+        client.newCall(request).enqueue(object : Callback {
+            override fun onResponse(call: Call, response: Response) {
+                response.close()
+            }
+
+            override fun onFailure(call: Call, e: IOException) {
+                Log.w(TAG, "Pre-warm failed: ${e.message}")
+            }
+        })
+    }
+
+    internal fun buildBase(
+        trustManager: X509TrustManager,
+        hostnameVerifier: HostnameVerifier,
+        certificatePinner: CertificatePinner,
+        dns: CachingDns,
+        maxIdleConnections: Int = 5
+    ): OkHttpClient {
+        // One SSLContext for the process: its client session cache is what lets new connections resume
+        val sslContext = SSLContext.getInstance("TLS").apply {
+            init(null, arrayOf(trustManager), null)
+            clientSessionContext.sessionTimeout = TLS_SESSION_TIMEOUT_SECONDS
+        }
+        return OkHttpClient.Builder()
+            .connectionPool(ConnectionPool(maxIdleConnections, 5, TimeUnit.MINUTES))
+            .dns(dns)
+            .sslSocketFactory(sslContext.socketFactory, trustManager)
+            .connectionSpecs(listOf(ConnectionSpec.MODERN_TLS, ConnectionSpec.COMPATIBLE_TLS))
+            .hostnameVerifier(hostnameVerifier)
+            .certificatePinner(certificatePinner)
+            .eventListenerFactory(ConnectionTimingListener.Factory(stats, dns))
+            .build()
+    }
+
+    private fun platformTrustManager(): X509TrustManager {
+        val factory = TrustManagerFactory.getInstance(TrustManagerFactory.getDefaultAlgorithm())
+        factory.init(null as KeyStore?)
+        return factory.trustManagers.filterIsInstance<X509TrustManager>().first()
+    }
+}
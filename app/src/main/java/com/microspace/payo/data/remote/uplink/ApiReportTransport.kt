@@ -0,0 +1,42 @@
+﻿package com.microspace.payo.data.remote.uplink
+
+import com.google.gson.Gson
+import com.google.gson.reflect.TypeToken
+import com.microspace.payo.data.models.installation.InstallationStatusRequest
+import com.microspace.payo.data.remote.ApiClient
+import com.microspace.payo.data.remote.ApiService
+import retrofit2.Response
+
+/**
+ * [StateReportUplink.Transport] over the device API. The service is resolved per delivery, since
+ * the process ApiClient is rebuilt when the runtime config changes its timeouts.
+ */
+internal class ApiReportTransport(
+    private val service: () -> ApiService = { ApiClient.getInstance().service }
+) : StateReportUplink.Transport {
+
+    private val gson = Gson()
+    private val mapType = object : TypeToken<Map<String, Any>>() {}.type
+
+    override suspend fun deliver(kind: StateReportUplink.Kind, deviceId: String, payload: String): StateReportUplink.Outcome {
+        val response = when (kind) {
+            StateReportUplink.Kind.INSTALLATION_STATUS ->
+                service().sendInstallationStatus(deviceId, gson.fromJson(payload, InstallationStatusRequest::class.java))
+            StateReportUplink.Kind.DEACTIVATION_CONFIRMATION ->
+                service().confirmDeactivation(deviceId, gson.fromJson<Map<String, Any>>(payload, mapType))
+        }
+        return outcomeOf(response)
+    }
+
+    private fun outcomeOf(response: Response<*>): StateReportUplink.Outcome {
+        val code = response.code()
+        if (!response.isSuccessful) response.errorBody()?.close()
+        return when {
+            response.isSuccessful -> StateReportUplink.Outcome.DELIVERED
+            // Timeouts and throttling are worth retrying; other client errors are not
+            code == 408 || code == 429 -> StateReportUplink.Outcome.RETRY
+            code in 400..499 -> StateReportUplink.Outcome.REJECTED
+            else -> StateReportUplink.Outcome.RETRY
+        }
+    }
+}
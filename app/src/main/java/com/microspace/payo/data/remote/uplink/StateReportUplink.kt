@@ -0,0 +1,261 @@
+﻿package com.microspace.payo.data.remote.uplink
+
+import android.content.Context
+import android.util.Log
+import com.google.gson.Gson
+import com.microspace.payo.data.local.database.DeviceOwnerDatabase
+import com.microspace.payo.data.local.database.dao.uplink.PendingReportDao
+import com.microspace.payo.data.local.database.entities.uplink.PendingReportEntity
+import com.microspace.payo.registration.DeviceRegistrationManager
+import kotlinx.coroutines.CoroutineDispatcher
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.launch
+import java.util.concurrent.CopyOnWriteArrayList
+import java.util.concurrent.TimeUnit
+import java.util.concurrent.atomic.AtomicBoolean
+import kotlin.random.Random
+
+/**
+ * StateReportUplink - durable delivery of one-shot state reports.
+ *
+ * Installation status and deactivation confirmations used to be posted from the caller's
+ * coroutine with fixed sleeps between retries, so leaving the screen or losing the process lost
+ * the report. A report is now written to `pending_reports` before anything is sent, under a key
+ * of its [Kind] and device: a newer state replaces an older one that was never sent, so only the
+ * latest state goes out. A single runner delivers due reports, retries failures with jittered
+ * exponential backoff, resumes whatever an earlier process left, and is woken early by every
+ * successful heartbeat ([onHeartbeatDelivered]), when the network is known to work.
+ */
+class StateReportUplink internal constructor(
+    private val dao: PendingReportDao,
+    private val transport: Transport,
+    dispatcher: CoroutineDispatcher,
+    private val clock: () -> Long = System::currentTimeMillis,
+    private val random: Random = Random.Default
+) {
+
+    enum class Kind {
+        INSTALLATION_STATUS,
+        DEACTIVATION_CONFIRMATION
+    }
+
+    enum class Outcome {
+        DELIVERED,
+        /** Network failure or server error; tried again later. */
+        RETRY,
+        /** The server refused the report (4xx); sending it again would not help. */
+        REJECTED
+    }
+
+    /** Sends one report; throwing counts as [Outcome.RETRY]. */
+    interface Transport {
+        /** [payload] is the JSON the report was submitted with. */
+        suspend fun deliver(kind: Kind, deviceId: String, payload: String): Outcome
+    }
+
+    companion object {
+        private const val TAG = "StateReportUplink"
+        private const val BATCH = 20
+        private val BASE_BACKOFF_MS = TimeUnit.SECONDS.toMillis(5)
+        private val MAX_BACKOFF_MS = TimeUnit.MINUTES.toMillis(30)
+        private val gson = Gson()
+
+        @Volatile
+        private var INSTANCE: StateReportUplink? = null
+
+        fun getInstance(context: Context): StateReportUplink {
+            return INSTANCE ?: synchronized(this) {
+                INSTANCE ?: run {
+                    val app = context.applicationContext
+                    StateReportUplink(
+                        DeviceOwnerDatabase.getDatabase(app).pendingReportDao(),
+                        ApiReportTransport(),
+                        Dispatchers.IO
+                    ).also {
+                        // Registered before start() so a report delivered by the resumed runner is seen
+                        it.onDelivered(Kind.INSTALLATION_STATUS) { DeviceRegistrationManager(app).onInstallationStatusDelivered() }
+                        it.start()
+                        INSTANCE = it
+                    }
+                }
+            }
+        }
+
+        // Opening the database reads the Keystore-backed passphrase; never on the caller's thread
+        private val submitScope = CoroutineScope(Dispatchers.IO + SupervisorJob())
+
+        /** [submit] for code outside coroutines or on the main thread. */
+        fun submitAsync(context: Context, kind: Kind, deviceId: String, payload: Any) {
+            val app = context.applicationContext
+            submitScope.launch {
+                try {
+                    getInstance(app).submit(kind, deviceId, payload)
+                } catch (e: Exception) {
+                    Log.e(TAG, "Could not store $kind report: ${e.message}")
+                }
+            }
+        }
+
+        /** Backoff before attempt [attempts] + 1: doubling from 5s up to 30 min, jittered over its upper half. */
+        internal fun backoffMs(attempts: Int, random: Random): Long {
+            val ceiling = (BASE_BACKOFF_MS shl (attempts - 1).coerceIn(0, 20)).coerceAtMost(MAX_BACKOFF_MS)
+            return ceiling / 2 + random.nextLong(ceiling / 2 + 1)
+        }
+    }
+
+    private val scope = CoroutineScope(dispatcher + SupervisorJob())
+    private val wakeups = Channel<Unit>(Channel.CONFLATED)
+    private val started = AtomicBoolean(false)
+    private val listeners = CopyOnWriteArrayList<Pair<Kind, () -> Unit>>()
+
+    // Reports submitted in the same millisecond still get distinct, increasing revisions
+    private var lastRevision = 0L
+
+    @Volatile
+    private var timer: Job? = null
+
+    /** Starts the runner, which first sends whatever an earlier process persisted. */
+    fun start() {
+        if (!started.compareAndSet(false, true)) return
+        scope.launch {
+            for (wakeup in wakeups) {
+                try {
+                    drain()
+                } catch (e: Exception) {
+                    Log.e(TAG, "Report drain failed: ${e.message}")
+                }
+            }
+        }
+        wakeups.trySend(Unit)
+    }
+
+    /** Called on the runner after a report of [kind] reached the server. */
+    fun onDelivered(kind: Kind, listener: () -> Unit) {
+        listeners.add(kind to listener)
+    }
+
+    /**
+     * Persists [payload] (serialized with Gson, as the request body) as the latest [kind] state of
+     * [deviceId], replacing an unsent older one, and wakes the runner. Returns once the report is
+     * stored, not once it is delivered.
+     */
+    suspend fun submit(kind: Kind, deviceId: String, payload: Any) {
+        val now = clock()
+        dao.upsert(
+            PendingReportEntity(
+                reportKey = "${kind.name}:$deviceId",
+                kind = kind.name,
+                deviceId = deviceId,
+                payload = gson.toJson(payload),
+                revision = nextRevision(now),
+                createdAt = now,
+                nextAttemptAt = now
+            )
+        )
+        wakeups.trySend(Unit)
+    }
+
+    /**
+     * Queues the [Kind.DEACTIVATION_CONFIRMATION] every deactivation path reports its outcome with;
+     * a later outcome for the same device replaces one not yet sent.
+     */
+    suspend fun confirmDeactivation(deviceId: String, success: Boolean, error: String? = null) {
+        val message = if (success) {
+            "Device Owner successfully removed and all restrictions cleared"
+        } else {
+            "Device Owner removal failed: ${error ?: "Unknown error"}"
+        }
+        submit(
+            Kind.DEACTIVATION_CONFIRMATION,
+            deviceId,
+            mapOf("status" to if (success) "success" else "failed", "message" to message)
+        )
+    }
+
+    /** A heartbeat just went through: send waiting reports now instead of at their backoff time. */
+    fun onHeartbeatDelivered() {
+        scope.launch {
+            try {
+                dao.makeDue(clock())
+                wakeups.trySend(Unit)
+            } catch (e: Exception) {
+                Log.w(TAG, "Could not reschedule reports: ${e.message}")
+            }
+        }
+    }
+
+    @Synchronized
+    private fun nextRevision(now: Long): Long {
+        lastRevision = maxOf(now, lastRevision + 1)
+        return lastRevision
+    }
+
+    private suspend fun drain() {
+        timer?.cancel()
+        while (true) {
+            val due = dao.getDue(clock(), BATCH)
+            if (due.isEmpty()) break
+            for (report in due) {
+                if (!send(report)) {
+                    // The network is likely down: the rest waits for the timer or the next heartbeat
+                    scheduleNext()
+                    return
+                }
+            }
+        }
+        scheduleNext()
+    }
+
+    /** Returns false if the report has to be retried. */
+    private suspend fun send(report: PendingReportEntity): Boolean {
+        val kind = Kind.valueOf(report.kind)
+        val outcome = try {
+            transport.deliver(kind, report.deviceId, report.payload)
+        } catch (e: Exception) {
+            Log.w(TAG, "$kind delivery failed: ${e.message}")
+            Outcome.RETRY
+        }
+        when (outcome) {
+            Outcome.DELIVERED, Outcome.REJECTED -> {
+                val current = dao.delete(report.reportKey, report.revision) > 0
+                if (outcome == Outcome.REJECTED) {
+                    Log.e(TAG, "$kind report for ${report.deviceId} rejected by the server, dropped")
+                } else {
+                    Log.i(TAG, "$kind report delivered after ${report.attempts + 1} attempt(s)")
+                    // Not current: a newer state replaced it in flight and is still to be sent
+                    if (current) listeners.filter { it.first == kind }.forEach { notify(kind, it.second) }
+                }
+                return true
+            }
+            Outcome.RETRY -> {
+                val attempts = report.attempts + 1
+                val wait = backoffMs(attempts, random)
+                dao.reschedule(report.reportKey, report.revision, attempts, clock() + wait)
+                Log.d(TAG, "$kind report attempt $attempts failed, next in ${wait}ms")
+                return false
+            }
+        }
+    }
+
+    private fun notify(kind: Kind, listener: () -> Unit) {
+        try {
+            listener()
+        } catch (e: Exception) {
+            Log.e(TAG, "$kind delivery listener failed: ${e.message}")
+        }
+    }
+
+    private suspend fun scheduleNext() {
+        val next = dao.nextAttemptAt() ?: return
+        val wait = (next - clock()).coerceAtLeast(0)
+        timer = scope.launch {
+            delay(wait)
+            wakeups.trySend(Unit)
+        }
+    }
+}
@@ -29,7 +29,7 @@ class DeviceRegistrationRepository(private val context: Context) {
     private val registrationBackup = com.microspace.payo.data.local.RegistrationDataBackup(context)
     
     // Public API client for logging errors
-    val apiClient = ApiClient()
+    val apiClient = ApiClient.getInstance()
     
     private val apiService: ApiService by lazy {
         val logging = HttpLoggingInterceptor().apply {
@@ -23,10 +23,12 @@ class HeartbeatResponseRepository(context: Context) {
     private val TAG = "HeartbeatResponseRepository"
     private val database = DeviceOwnerDatabase.getDatabase(context)
     private val dao = database.heartbeatResponseDao()
+    private val telemetry = TelemetryAppender.getInstance(context)
     private val gson = Gson()
     
     /**
-     * Save a heartbeat response
+     * Save a heartbeat response through the telemetry appender: responses carrying a lock
+     * or deactivation are written immediately, routine ones with the next group commit
      */
     suspend fun saveResponse(
         response: HeartbeatResponse,
@@ -85,12 +87,12 @@ class HeartbeatResponseRepository(context: Context) {
                 processed = false
             )
             
-            val id = dao.insert(entity)
-            Log.d(TAG, "âœ… Saved heartbeat response #$heartbeatNumber (id=$id)")
-            id
+            val lockAffecting = entity.isLocked || entity.hardlockRequested ||
+                entity.softlockRequested || entity.deactivationRequested
+            if (lockAffecting) telemetry.writeThrough(entity) else telemetry.append(entity)
+            Log.d(TAG, "âœ… Saved heartbeat response #$heartbeatNumber (buffered=${!lockAffecting})")
         } catch (e: Exception) {
             Log.e(TAG, "âŒ Error saving response: ${e.message}")
-            -1L
         }
     }
     
@@ -13,7 +13,7 @@ class InstallmentRepository(private val context: Context) {
     
     private val db = DeviceOwnerDatabase.getDatabase(context)
     private val installmentDao = db.installmentDao()
-    private val apiClient = ApiClient()
+    private val apiClient = ApiClient.getInstance()
     
     companion object {
         private const val TAG = "InstallmentRepository"
@@ -49,6 +49,7 @@ class InstallmentRepository(private val context: Context) {
                     // Clear old installments and insert new ones
                     installmentDao.deleteByDeviceId(deviceId)
                     installmentDao.insertAll(installments)
+                    PaymentStateRepository.getInstance(context).applyInstallments(installments)
                     
                     Log.d(TAG, "âœ… Synced ${installments.size} installments for device $deviceId")
                     Result.success(installments)
@@ -0,0 +1,340 @@
+﻿package com.microspace.payo.data.repository
+
+import android.content.Context
+import android.util.Log
+import com.google.gson.reflect.TypeToken
+import com.microspace.payo.data.local.database.DeviceOwnerDatabase
+import com.microspace.payo.data.local.database.dao.payment.PaymentStateDao
+import com.microspace.payo.data.local.database.entities.payment.InstallmentEntity
+import com.microspace.payo.data.local.database.entities.payment.PaymentHistoryEntity
+import com.microspace.payo.data.local.database.entities.payment.PaymentStateEntity
+import com.microspace.payo.data.models.heartbeat.HeartbeatResponse
+import com.microspace.payo.security.crypto.EncryptionManager
+import com.microspace.payo.utils.gson.SafeGsonProvider
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.StateFlow
+import kotlinx.coroutines.flow.asStateFlow
+import kotlinx.coroutines.launch
+import java.time.Instant
+import java.time.LocalDate
+import java.time.LocalDateTime
+import java.time.ZoneId
+import java.time.ZoneOffset
+import java.time.ZonedDateTime
+import java.time.temporal.ChronoUnit
+
+/**
+ * PaymentStateRepository - single source of truth for payment facts.
+ *
+ * Holds the materialized [PaymentStateEntity] in memory as a [StateFlow]; reads are a field
+ * access. Heartbeat responses and installment syncs fold into it with [update]. A write only
+ * happens when the row actually changed, and a burst of updates becomes one upsert, done on a
+ * background writer. Payment history is an append-only Room table capped at [HISTORY_WINDOW] rows.
+ *
+ * [getInstance] never blocks: the stored row is loaded in the background (importing the legacy
+ * `payment_data_encrypted` prefs if there is none yet) and published through [state]. Until then
+ * the snapshot is empty; updates made meanwhile are replayed on top of the loaded row, and the
+ * suspend functions wait for the load. Callers that decide on a read can [awaitLoaded] first.
+ */
+class PaymentStateRepository internal constructor(
+    private val dao: PaymentStateDao,
+    scope: CoroutineScope,
+    loadStored: suspend () -> PaymentStateEntity,
+    private val clock: () -> Long = System::currentTimeMillis
+) {
+
+    companion object {
+        private const val TAG = "PaymentStateRepository"
+        const val HISTORY_WINDOW = 12
+        const val DEFAULT_CURRENCY = "TZS"
+
+        // Legacy PaymentDataManager prefs format
+        internal const val LEGACY_PREF_NAME = "payment_data_encrypted"
+        internal const val LEGACY_KEY_NEXT_PAYMENT_DATE = "next_payment_date"
+        internal const val LEGACY_KEY_UNLOCK_PASSWORD = "unlock_password"
+        internal const val LEGACY_KEY_PAYMENT_AMOUNT = "payment_amount"
+        internal const val LEGACY_KEY_PAYMENT_CURRENCY = "payment_currency"
+        internal const val LEGACY_KEY_IS_LOCKED = "is_locked"
+        internal const val LEGACY_KEY_LOCK_REASON = "lock_reason"
+        internal const val LEGACY_KEY_LOCK_TIMESTAMP = "lock_timestamp"
+        internal const val LEGACY_KEY_SERVER_TIME = "server_time"
+        internal const val LEGACY_KEY_LAST_SYNC_TIME = "last_sync_time"
+        internal const val LEGACY_KEY_PAYMENT_HISTORY = "payment_history_json"
+        internal const val LEGACY_KEY_DAYS_UNTIL_PAYMENT = "days_until_payment"
+
+        @Volatile
+        private var INSTANCE: PaymentStateRepository? = null
+
+        fun getInstance(context: Context): PaymentStateRepository {
+            return INSTANCE ?: synchronized(this) {
+                INSTANCE ?: run {
+                    val app = context.applicationContext
+                    val dao = DeviceOwnerDatabase.getDatabase(app).paymentStateDao()
+                    PaymentStateRepository(dao, CoroutineScope(Dispatchers.IO + SupervisorJob()), {
+                        try {
+                            val legacy = EncryptionManager.getInstance(app).getEncryptedSharedPreferences(LEGACY_PREF_NAME)
+                            load(dao, legacy.all) { legacy.edit().clear().apply() }
+                        } catch (e: Exception) {
+                            Log.e(TAG, "❌ Failed to load payment state: ${e.message}", e)
+                            dao.get() ?: PaymentStateEntity.EMPTY
+                        }
+                    }).also { INSTANCE = it }
+                }
+            }
+        }
+
+        /**
+         * Returns the stored row, importing [legacy] prefs values first if there is none.
+         * [clearLegacy] runs only once the row has been read back from the database, so a failed
+         * or lost import (the unlock password included) is retried from the prefs on the next start.
+         */
+        internal suspend fun load(dao: PaymentStateDao, legacy: Map<String, *>, clearLegacy: () -> Unit): PaymentStateEntity {
+            val stored = dao.get()
+            if (stored != null) {
+                if (legacy.isNotEmpty()) clearLegacy()
+                return stored
+            }
+            if (legacy.isEmpty()) return PaymentStateEntity.EMPTY
+
+            val (state, history) = fromLegacyPrefs(legacy)
+            dao.importLegacy(state, history, HISTORY_WINDOW)
+            if (dao.get() != state) {
+                Log.w(TAG, "Imported payment state did not read back; keeping the legacy prefs")
+                return state
+            }
+            clearLegacy()
+            Log.i(TAG, "✅ Migrated payment prefs (${history.size} history records)")
+            return state
+        }
+
+        /** Maps the legacy prefs values; an unreadable history is dropped, not fatal. */
+        internal fun fromLegacyPrefs(values: Map<String, *>): Pair<PaymentStateEntity, List<PaymentHistoryEntity>> {
+            val state = PaymentStateEntity(
+                nextPaymentDate = values[LEGACY_KEY_NEXT_PAYMENT_DATE] as? String,
+                unlockPassword = values[LEGACY_KEY_UNLOCK_PASSWORD] as? String,
+                paymentAmount = values[LEGACY_KEY_PAYMENT_AMOUNT] as? String,
+                paymentCurrency = values[LEGACY_KEY_PAYMENT_CURRENCY] as? String,
+                daysUntilPayment = values[LEGACY_KEY_DAYS_UNTIL_PAYMENT] as? Int ?: -1,
+                isLocked = values[LEGACY_KEY_IS_LOCKED] as? Boolean ?: false,
+                lockReason = values[LEGACY_KEY_LOCK_REASON] as? String,
+                lockTimestamp = values[LEGACY_KEY_LOCK_TIMESTAMP] as? Long ?: 0L,
+                serverTime = values[LEGACY_KEY_SERVER_TIME] as? String,
+                lastSyncTime = values[LEGACY_KEY_LAST_SYNC_TIME] as? Long ?: 0L
+            )
+            // Stored oldest first; insertion order becomes row-id order
+            val history = SafeGsonProvider.fromJson<List<LegacyPaymentRecord>>(values[LEGACY_KEY_PAYMENT_HISTORY] as? String) {
+                object : TypeToken<List<LegacyPaymentRecord>>() {}.type
+            }.orEmpty().takeLast(HISTORY_WINDOW).mapNotNull { record ->
+                val status = record.status ?: return@mapNotNull null
+                PaymentHistoryEntity(
+                    date = record.date,
+                    amount = record.amount,
+                    currency = record.currency,
+                    status = status,
+                    daysUntilDue = record.daysUntilDue
+                )
+            }
+            return state to history
+        }
+
+        /**
+         * Whole days from [today] to the due date's calendar day in [zone]; null if unparseable.
+         * Offset-less timestamps are taken as UTC, as the server sends them.
+         */
+        internal fun daysUntil(dateTime: String, today: LocalDate, zone: ZoneId): Int? {
+            val due = parseServerTime(dateTime) ?: return null
+            return ChronoUnit.DAYS.between(today, due.withZoneSameInstant(zone).toLocalDate()).toInt()
+        }
+
+        /** A server timestamp (payment date, server time); offset-less ones are UTC. Null if unparseable. */
+        fun parseServerTime(dateTime: String): ZonedDateTime? = try {
+            ZonedDateTime.parse(dateTime)
+        } catch (e: Exception) {
+            try {
+                LocalDateTime.parse(dateTime).atZone(ZoneOffset.UTC)
+            } catch (e: Exception) {
+                null
+            }
+        }
+    }
+
+    /** Gson shape of the legacy `payment_history_json` records. */
+    internal data class LegacyPaymentRecord(
+        val date: Long = 0L,
+        val amount: String? = null,
+        val currency: String? = null,
+        val status: String? = null,
+        val daysUntilDue: Int = -1
+    )
+
+    private val _state = MutableStateFlow(PaymentStateEntity.EMPTY)
+    val state: StateFlow<PaymentStateEntity> = _state.asStateFlow()
+
+    val current: PaymentStateEntity
+        get() = _state.value
+
+    private val writes = Channel<Unit>(Channel.CONFLATED)
+    private val loaded = CompletableDeferred<Unit>()
+    private val earlyLock = Any()
+
+    /** Transforms applied before the stored row arrived; null once it has. */
+    @Volatile
+    private var early: MutableList<(PaymentStateEntity) -> PaymentStateEntity>? = ArrayList()
+
+    init {
+        scope.launch {
+            val stored = loadStored()
+            synchronized(earlyLock) {
+                val replayed = early.orEmpty().fold(stored) { state, transform -> transform(state) }
+                _state.value = replayed
+                early = null
+                if (replayed != stored) writes.trySend(Unit)
+            }
+            loaded.complete(Unit)
+
+            for (write in writes) {
+                try {
+                    dao.upsert(_state.value)
+                } catch (e: Exception) {
+                    Log.e(TAG, "❌ Failed to persist payment state: ${e.message}", e)
+                }
+            }
+        }
+    }
+
+    val isLoaded: Boolean
+        get() = loaded.isCompleted
+
+    /** Suspends until the stored row is in [state]. */
+    suspend fun awaitLoaded() = loaded.await()
+
+    /**
+     * Applies [transform] to the snapshot. Returns the new state; unchanged state is not written.
+     */
+    fun update(transform: (PaymentStateEntity) -> PaymentStateEntity): PaymentStateEntity {
+        if (early != null) synchronized(earlyLock) {
+            early?.let { pending ->
+                pending += transform
+                return transform(_state.value).also { _state.value = it }
+            }
+        }
+        while (true) {
+            val previous = _state.value
+            val next = transform(previous)
+            if (next == previous) return previous
+            if (_state.compareAndSet(previous, next)) {
+                writes.trySend(Unit)
+                return next
+            }
+        }
+    }
+
+    fun setNextPayment(dateTime: String?, unlockPassword: String?, amount: String? = null, currency: String? = null) {
+        val now = clock()
+        update {
+            it.copy(
+                nextPaymentDate = dateTime,
+                unlockPassword = unlockPassword,
+                paymentAmount = amount,
+                paymentCurrency = currency,
+                daysUntilPayment = dateTime?.let { d -> daysUntil(d, today(now), ZoneId.systemDefault()) } ?: it.daysUntilPayment,
+                lastSyncTime = now
+            )
+        }
+    }
+
+    fun setLockState(isLocked: Boolean, reason: String?) {
+        val now = clock()
+        update {
+            if (it.isLocked == isLocked && it.lockReason == reason) it
+            else it.copy(isLocked = isLocked, lockReason = reason, lockTimestamp = now)
+        }
+    }
+
+    fun setServerTime(serverTime: String?) {
+        val now = clock()
+        update { it.copy(serverTime = serverTime, lastSyncTime = now) }
+    }
+
+    /**
+     * Folds the payment-relevant parts of a heartbeat response. A response without
+     * `next_payment` keeps the stored one.
+     */
+    fun applyHeartbeat(response: HeartbeatResponse) {
+        val now = clock()
+        update { state ->
+            var next = state.copy(
+                serverTime = response.serverTime ?: state.serverTime,
+                lastSyncTime = now,
+                paymentComplete = response.paymentComplete ?: state.paymentComplete,
+                loanComplete = response.loanComplete ?: state.loanComplete,
+                loanStatus = response.loanStatus ?: state.loanStatus
+            )
+            response.nextPayment?.let { payment ->
+                next = next.copy(
+                    nextPaymentDate = payment.dateTime,
+                    unlockPassword = response.getUnlockPassword() ?: payment.unlockingPassword,
+                    paymentCurrency = state.paymentCurrency ?: DEFAULT_CURRENCY,
+                    daysUntilPayment = payment.dateTime?.let { daysUntil(it, today(now), ZoneId.systemDefault()) }
+                        ?: state.daysUntilPayment
+                )
+            }
+            val locked = response.isDeviceLocked()
+            val reason = response.getLockReason().takeIf { it.isNotBlank() }
+            if (locked != state.isLocked || reason != state.lockReason) {
+                next = next.copy(isLocked = locked, lockReason = reason, lockTimestamp = now)
+            }
+            next
+        }
+    }
+
+    /** Folds a full installment sync into the loan aggregates. */
+    fun applyInstallments(installments: List<InstallmentEntity>) {
+        val now = clock()
+        val nextDue = installments.filter { !it.isPaid() }.minByOrNull { it.installmentNumber }
+        update {
+            it.copy(
+                installmentsPaid = installments.count { i -> i.isPaid() },
+                installmentsTotal = installments.size,
+                overdueInstallments = installments.count { i -> i.isOverdue || i.status == "overdue" },
+                totalAmountDue = installments.sumOf { i -> i.amountDue },
+                totalAmountPaid = installments.sumOf { i -> i.amountPaid },
+                nextInstallmentDueDate = nextDue?.dueDate,
+                nextInstallmentAmount = nextDue?.getRemainingAmount(),
+                installmentsSyncedAt = now
+            )
+        }
+    }
+
+    // History waits for the load, which may still be importing the legacy records
+    suspend fun appendHistory(record: PaymentHistoryEntity) {
+        awaitLoaded()
+        dao.appendHistory(record, HISTORY_WINDOW)
+    }
+
+    /** Newest first, at most [HISTORY_WINDOW] records. */
+    suspend fun getHistory(): List<PaymentHistoryEntity> {
+        awaitLoaded()
+        return dao.getHistory(HISTORY_WINDOW)
+    }
+
+    suspend fun clearHistory() {
+        awaitLoaded()
+        dao.clearHistory()
+    }
+
+    suspend fun clearAll() {
+        awaitLoaded()
+        _state.value = PaymentStateEntity.EMPTY
+        dao.clearState()
+        dao.clearHistory()
+    }
+
+    private fun today(now: Long): LocalDate =
+        Instant.ofEpochMilli(now).atZone(ZoneId.systemDefault()).toLocalDate()
+}
@@ -0,0 +1,203 @@
+﻿package com.microspace.payo.data.repository
+
+import android.content.Context
+import android.util.Log
+import com.microspace.payo.core.MemoryGovernor
+import com.microspace.payo.data.local.database.DeviceOwnerDatabase
+import com.microspace.payo.data.local.database.entities.audit.SyncAuditEntity
+import com.microspace.payo.data.local.database.entities.heartbeat.HeartbeatResponseEntity
+import kotlinx.coroutines.CoroutineDispatcher
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.launch
+import java.util.concurrent.TimeUnit
+import java.util.concurrent.atomic.AtomicLong
+
+/**
+ * TelemetryAppender - group commit for the rows each heartbeat leaves behind.
+ *
+ * Routine rows (sync audit entries, stored heartbeat responses) are buffered in memory and
+ * written in one transaction once [beatsPerCommit] heartbeats completed or the oldest buffered
+ * row is [maxDelayMs] old, instead of one SQLCipher transaction (and fsync) per row. Audit
+ * pruning runs once per commit instead of once per beat.
+ *
+ * A lock-affecting row goes through [writeThrough]: it is committed before the call returns,
+ * together with anything already buffered so table order is kept. A kill therefore loses at
+ * most the routine rows of the current window, never a lock fact. The device host flushes the
+ * buffer when it stops, and the [MemoryGovernor] flushes it under critical memory pressure; a
+ * low-RAM profile commits every [MemoryGovernor.Profile.telemetryBeatsPerCommit] beats.
+ */
+class TelemetryAppender internal constructor(
+    private val store: Store,
+    dispatcher: CoroutineDispatcher,
+    beatsPerCommit: Int = BEATS_PER_COMMIT,
+    private val maxDelayMs: Long = MAX_DELAY_MS,
+    private val clock: () -> Long = System::currentTimeMillis
+) : MemoryGovernor.Consumer {
+
+    /** Writes one batch in a single transaction. */
+    interface Store {
+        fun commit(batch: Batch)
+    }
+
+    data class Batch(
+        val audits: List<SyncAuditEntity>,
+        val responses: List<HeartbeatResponseEntity>,
+        /** Audit rows older than this are pruned in the same transaction. */
+        val pruneAuditsBefore: Long
+    )
+
+    companion object {
+        private const val TAG = "TelemetryAppender"
+
+        /** 30 beats is five minutes at the default 10s interval. */
+        const val BEATS_PER_COMMIT = 30
+        val MAX_DELAY_MS = TimeUnit.MINUTES.toMillis(5)
+        private val AUDIT_RETENTION_MS = TimeUnit.DAYS.toMillis(30)
+        // Entity fields plus the JSON payloads they carry, roughly
+        private const val ROW_BYTES = 1024L
+
+        @Volatile
+        private var INSTANCE: TelemetryAppender? = null
+
+        fun getInstance(context: Context): TelemetryAppender {
+            return INSTANCE ?: synchronized(this) {
+                INSTANCE ?: TelemetryAppender(
+                    RoomStore(DeviceOwnerDatabase.getDatabase(context.applicationContext)),
+                    Dispatchers.IO
+                ).also {
+                    INSTANCE = it
+                    MemoryGovernor.shared.register(it)
+                }
+            }
+        }
+    }
+
+    private class RoomStore(private val db: DeviceOwnerDatabase) : Store {
+        override fun commit(batch: Batch) {
+            db.runInTransaction {
+                if (batch.audits.isNotEmpty()) db.syncAuditDao().insertAll(batch.audits)
+                if (batch.responses.isNotEmpty()) db.heartbeatResponseDao().insertAll(batch.responses)
+                db.syncAuditDao().deleteOlderThan(batch.pruneAuditsBefore)
+            }
+        }
+    }
+
+    private val scope = CoroutineScope(dispatcher + SupervisorJob())
+
+    @Volatile
+    private var beatsPerCommit = beatsPerCommit
+
+    // Buffer state, guarded by itself
+    private val bufferLock = Any()
+    private val audits = ArrayList<SyncAuditEntity>()
+    private val responses = ArrayList<HeartbeatResponseEntity>()
+    private var beats = 0
+    private var oldestAt = 0L
+    private var timer: Job? = null
+
+    // Held across drain + commit so batches reach the store in the order they were taken
+    private val commitLock = Any()
+
+    /** Transactions issued, for the fsync budget. */
+    val commits = AtomicLong()
+
+    val bufferedRows: Int
+        get() = synchronized(bufferLock) { audits.size + responses.size }
+
+    fun append(audit: SyncAuditEntity) = buffer { audits.add(audit) }
+
+    fun append(response: HeartbeatResponseEntity) = buffer { responses.add(response) }
+
+    /** Commits [audit] (and the buffer) before returning; throws if the write failed. */
+    fun writeThrough(audit: SyncAuditEntity) = commit(listOf(audit), emptyList())
+
+    fun writeThrough(response: HeartbeatResponseEntity) = commit(emptyList(), listOf(response))
+
+    /** Counts one finished heartbeat; a full window is committed on the appender's dispatcher. */
+    fun beatCompleted() {
+        val due = synchronized(bufferLock) {
+            beats++
+            beats >= beatsPerCommit || (hasRows() && clock() - oldestAt >= maxDelayMs)
+        }
+        if (due) flushAsync()
+    }
+
+    /** Commits everything buffered on the calling thread. Failures keep the rows buffered. */
+    fun flush() {
+        try {
+            commit(emptyList(), emptyList())
+        } catch (e: Exception) {
+            Log.e(TAG, "Telemetry commit failed, keeping $bufferedRows rows buffered: ${e.message}")
+        }
+    }
+
+    /** Flushes off the caller's thread, e.g. from a service's onDestroy. */
+    fun flushAsync() {
+        scope.launch { flush() }
+    }
+
+    override val name = "telemetry_buffer"
+
+    override val priority = MemoryGovernor.Priority.BUFFERED
+
+    override fun retainedBytes(): Long = bufferedRows * ROW_BYTES
+
+    override fun trim() = flush()
+
+    override fun applyProfile(profile: MemoryGovernor.Profile) {
+        beatsPerCommit = profile.telemetryBeatsPerCommit
+    }
+
+    private fun buffer(add: () -> Unit) {
+        synchronized(bufferLock) {
+            if (!hasRows()) startWindow()
+            add()
+        }
+    }
+
+    /** Called with [bufferLock] held when the first row of a window arrives. */
+    private fun startWindow() {
+        oldestAt = clock()
+        timer?.cancel()
+        // Backstop for when beats stop arriving (service stopped, device offline)
+        timer = scope.launch {
+            delay(maxDelayMs)
+            flush()
+        }
+    }
+
+    private fun hasRows() = audits.isNotEmpty() || responses.isNotEmpty()
+
+    private fun commit(extraAudits: List<SyncAuditEntity>, extraResponses: List<HeartbeatResponseEntity>) {
+        synchronized(commitLock) {
+            val drained = synchronized(bufferLock) {
+                val batch = Batch(audits.toList(), responses.toList(), clock() - AUDIT_RETENTION_MS)
+                audits.clear()
+                responses.clear()
+                beats = 0
+                timer?.cancel()
+                timer = null
+                batch
+            }
+            val batch = drained.copy(audits = drained.audits + extraAudits, responses = drained.responses + extraResponses)
+            if (batch.audits.isEmpty() && batch.responses.isEmpty()) return
+            try {
+                store.commit(batch)
+                commits.incrementAndGet()
+            } catch (e: Exception) {
+                // Put the routine rows back ahead of anything buffered meanwhile; the caller of a
+                // write-through sees the exception
+                synchronized(bufferLock) {
+                    if (!hasRows()) startWindow()
+                    audits.addAll(0, drained.audits)
+                    responses.addAll(0, drained.responses)
+                }
+                throw e
+            }
+        }
+    }
+}
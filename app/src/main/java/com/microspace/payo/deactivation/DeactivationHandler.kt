@@ -2,7 +2,7 @@
 
 import android.content.Context
 import android.util.Log
-import com.microspace.payo.data.remote.ApiClient
+import com.microspace.payo.data.remote.uplink.StateReportUplink
 import kotlinx.coroutines.*
 
 /**
@@ -16,14 +16,11 @@ import kotlinx.coroutines.*
  * - Status reporting
  */
 class DeactivationHandler(
-    private val context: Context,
-    private val apiClient: ApiClient
+    private val context: Context
 ) {
     
     companion object {
         private const val TAG = "DeactivationHandler"
-        private const val MAX_RETRY_ATTEMPTS = 3
-        private const val RETRY_DELAY_MS = 1000L
     }
     
     private val deactivationManager = DeviceOwnerDeactivationManager(context)
@@ -68,48 +65,19 @@ class DeactivationHandler(
     }
     
     /**
-     * Send confirmation to server with retry logic
+     * Queue the confirmation with the state report uplink, which persists it and retries with
+     * backoff; a later confirmation for the same device replaces one not yet sent.
      */
     private suspend fun sendConfirmationToServer(
         deviceId: String,
         success: Boolean,
         error: String? = null
     ) {
-        var lastException: Exception? = null
-        
-        repeat(MAX_RETRY_ATTEMPTS) { attempt ->
-            try {
-                Log.d(TAG, "Sending confirmation (attempt ${attempt + 1}/$MAX_RETRY_ATTEMPTS)...")
-                
-                val status = if (success) "success" else "failed"
-                val message = if (success) {
-                    "Device Owner successfully removed and all restrictions cleared"
-                } else {
-                    "Device Owner removal failed: ${error ?: "Unknown error"}"
-                }
-                
-                // Send to server
-                val response = apiClient.confirmDeactivation(deviceId, status, message)
-                
-                if (response.isSuccessful) {
-                    Log.i(TAG, "âœ… Confirmation sent successfully")
-                    return@repeat
-                } else {
-                    throw Exception("HTTP ${response.code()}: ${response.message()}")
-                }
-                
-            } catch (e: Exception) {
-                Log.w(TAG, "âš  Confirmation failed (attempt ${attempt + 1}): ${e.message}")
-                lastException = e
-                
-                if (attempt < MAX_RETRY_ATTEMPTS - 1) {
-                    delay(RETRY_DELAY_MS)
-                }
-            }
-        }
-        
-        if (lastException != null) {
-            Log.e(TAG, "âŒ Failed to send confirmation after $MAX_RETRY_ATTEMPTS attempts")
+        try {
+            StateReportUplink.getInstance(context).confirmDeactivation(deviceId, success, error)
+            Log.d(TAG, "Confirmation (success=$success) queued for delivery")
+        } catch (e: Exception) {
+            Log.e(TAG, "Could not queue confirmation: ${e.message}")
         }
     }
     
@@ -0,0 +1,176 @@
+﻿package com.microspace.payo.deactivation
+
+import android.util.Log
+
+/**
+ * Device state a [DeactivationJournal] tears down. Every call must be safe to repeat, and the
+ * reads report what is actually applied so only real changes are reverted.
+ * Production goes through [DpmDeactivationTarget]; tests use a fake DPM.
+ */
+interface DeactivationTarget {
+    fun cancelAllWork()
+    fun stopServices()
+    /** User restrictions currently set by this admin. */
+    fun userRestrictions(): Set<String>
+    fun clearUserRestriction(restriction: String)
+    fun resetGlobalPolicies()
+    /** Installed packages currently suspended. */
+    fun suspendedPackages(): List<String>
+    fun setPackagesSuspended(packages: Array<String>, suspended: Boolean)
+    fun forgetWifiNetworks()
+    fun clearLockState()
+    fun removeOwner()
+    fun clearAppData()
+}
+
+/**
+ * Runs deactivation as a checkpointed sequence of idempotent steps.
+ *
+ * The first incomplete step is persisted before it starts and advanced after it succeeds, so a
+ * deactivation interrupted by a crash, a kill or a reboot resumes where it stopped instead of
+ * starting over, and a half-managed device is recognisable by [isInProgress]. A failing step stops
+ * the run and stays pending for the next attempt, up to [maxAttempts] failed runs in a row; then
+ * the journal is closed as [Report.abandoned] so the device is managed normally again instead of
+ * staying half torn down.
+ */
+class DeactivationJournal(private val store: Store, private val maxAttempts: Int = MAX_ATTEMPTS) {
+
+    /** Where the journal is kept; must survive [Step.CLEAR_APP_DATA]. */
+    interface Store {
+        /** Name of the first incomplete step, or null when no deactivation is in progress. */
+        fun load(): String?
+        /** Written before returning; null closes the journal. */
+        fun save(pending: String?)
+        /** Failed runs of the pending step so far. */
+        fun attempts(): Int
+        /** Written before returning. */
+        fun saveAttempts(attempts: Int)
+    }
+
+    /** Teardown order: the owner is removed last of the policy steps, so earlier ones still have rights. */
+    enum class Step {
+        CANCEL_WORK,
+        STOP_SERVICES,
+        CLEAR_RESTRICTIONS,
+        RESET_POLICIES,
+        UNSUSPEND_APPS,
+        FORGET_WIFI,
+        CLEAR_STATE,
+        REMOVE_OWNER,
+        CLEAR_APP_DATA
+    }
+
+    data class StepTiming(val step: Step, val durationNanos: Long, val calls: Int, val error: String?)
+
+    /**
+     * [abandoned]: [failed] has now failed [maxAttempts] runs in a row and the journal was closed
+     * without finishing; the teardown will not be resumed.
+     */
+    data class Report(val resumedAt: Step, val steps: List<StepTiming>, val abandoned: Boolean = false) {
+        val totalNanos: Long get() = steps.sumOf { it.durationNanos }
+        val failed: Step? get() = steps.firstOrNull { it.error != null }?.step
+        val completed: Boolean get() = failed == null
+
+        override fun toString(): String = steps.joinToString(
+            prefix = "total=${totalNanos / 1_000}us from=${resumedAt.name.lowercase()}${if (abandoned) " abandoned" else ""} [",
+            postfix = "]"
+        ) { "${it.step.name.lowercase()}=${it.durationNanos / 1_000}us/${it.calls}" + (it.error?.let { e -> " ($e)" } ?: "") }
+    }
+
+    /** The step an interrupted deactivation resumes at, or null if none is in progress. */
+    val pending: Step?
+        get() = store.load()?.let { name ->
+            // A step renamed by an update: every step is idempotent, so start over
+            Step.values().firstOrNull { it.name == name } ?: Step.values().first()
+        }
+
+    val isInProgress: Boolean get() = store.load() != null
+
+    /** Runs every step from [pending] (or the first) on [target] and closes the journal on success. */
+    fun run(target: DeactivationTarget): Report {
+        val resumedAt = pending ?: Step.values().first().also { store.save(it.name) }
+        val timings = ArrayList<StepTiming>(Step.values().size)
+        // Only the pending step can carry failures from earlier runs
+        var priorFailures = store.attempts()
+        var abandoned = false
+
+        for (step in Step.values().drop(resumedAt.ordinal)) {
+            val start = System.nanoTime()
+            try {
+                val calls = applyStep(step, target)
+                timings.add(StepTiming(step, System.nanoTime() - start, calls, null))
+            } catch (e: Exception) {
+                Log.e(TAG, "Step $step failed: ${e.message}")
+                timings.add(StepTiming(step, System.nanoTime() - start, 0, e.message ?: e.javaClass.simpleName))
+                val attempts = priorFailures + 1
+                if (attempts >= maxAttempts) {
+                    Log.e(TAG, "Step $step failed $attempts times, giving up")
+                    store.saveAttempts(0)
+                    store.save(null)
+                    abandoned = true
+                } else {
+                    store.saveAttempts(attempts)
+                }
+                break
+            }
+            store.save(Step.values().getOrNull(step.ordinal + 1)?.name)
+            if (priorFailures > 0) {
+                store.saveAttempts(0)
+                priorFailures = 0
+            }
+        }
+
+        return Report(resumedAt, timings, abandoned).also { Log.i(TAG, "Deactivation steps: $it") }
+    }
+
+    /** Returns the number of state-changing calls made. */
+    private fun applyStep(step: Step, target: DeactivationTarget): Int = when (step) {
+        Step.CANCEL_WORK -> {
+            target.cancelAllWork(); 1
+        }
+        Step.STOP_SERVICES -> {
+            target.stopServices(); 1
+        }
+        Step.CLEAR_RESTRICTIONS -> {
+            val applied = target.userRestrictions()
+            var failures = 0
+            for (restriction in applied) {
+                try {
+                    target.clearUserRestriction(restriction)
+                } catch (e: Exception) {
+                    failures++
+                    Log.e(TAG, "Failed to clear $restriction: ${e.message}")
+                }
+            }
+            if (failures > 0 && failures == applied.size) throw IllegalStateException("all $failures restrictions failed")
+            applied.size
+        }
+        Step.RESET_POLICIES -> {
+            target.resetGlobalPolicies(); 1
+        }
+        Step.UNSUSPEND_APPS -> {
+            val suspended = target.suspendedPackages()
+            if (suspended.isEmpty()) 0 else {
+                target.setPackagesSuspended(suspended.toTypedArray(), false); 1
+            }
+        }
+        Step.FORGET_WIFI -> {
+            target.forgetWifiNetworks(); 1
+        }
+        Step.CLEAR_STATE -> {
+            target.clearLockState(); 1
+        }
+        Step.REMOVE_OWNER -> {
+            target.removeOwner(); 1
+        }
+        Step.CLEAR_APP_DATA -> {
+            target.clearAppData(); 1
+        }
+    }
+
+    companion object {
+        private const val TAG = "DeactivationJournal"
+        /** Failed runs of one step before the deactivation is abandoned. */
+        const val MAX_ATTEMPTS = 5
+    }
+}
@@ -4,22 +4,17 @@ import android.app.admin.DevicePolicyManager
 import android.content.ComponentName
 import android.content.Context
 import android.content.Intent
-import android.content.pm.PackageManager
+import android.content.SharedPreferences
 import android.net.Uri
 import android.os.Build
-import android.os.UserManager
 import android.util.Log
-import com.microspace.payo.monitoring.SecurityMonitorService
-import com.microspace.payo.receivers.admin.AdminReceiver
-import com.microspace.payo.services.security.FirmwareSecurityMonitorService
-import com.microspace.payo.services.data.LocalDataServerService
-import com.microspace.payo.services.remote.RemoteManagementService
+import com.microspace.payo.data.DeviceIdProvider
+import com.microspace.payo.data.remote.uplink.StateReportUplink
+import com.microspace.payo.services.heartbeat.HeartbeatWorker
+import com.microspace.payo.services.host.DeviceHostService
 import com.microspace.payo.services.lock.SoftLockMonitorService
 import com.microspace.payo.services.lock.SoftLockOverlayService
-import com.microspace.payo.services.heartbeat.HeartbeatWorker
-import com.microspace.payo.device.DeviceOwnerManager
-import com.microspace.payo.update.config.UpdateConfig
-import com.microspace.payo.work.RestrictionEnforcementWorker
+import com.microspace.payo.utils.storage.PrefsWriteCoalescer
 import com.microspace.payo.utils.storage.SharedPreferencesManager
 import kotlinx.coroutines.*
 import java.util.concurrent.atomic.AtomicBoolean
@@ -33,40 +28,64 @@ import java.util.concurrent.atomic.AtomicBoolean
  * - All restrictions, lock state, and "managed" UI are removed so the device displays and behaves like a normal phone.
  * - All app services are stopped (none left running or visible).
  *
- * Deactivation Flow:
- * 1. Stop ALL app services (heartbeat, lock, security, firmware, local server, etc.)
- * 2. Clear all user restrictions
+ * Deactivation Flow (the steps of [DeactivationJournal], run on [DpmDeactivationTarget]):
+ * 1. Cancel all work and stop ALL app services (heartbeat, lock, security, firmware, etc.)
+ * 2. Clear the user restrictions this admin actually set
  * 3. Reset global policies (lock task, status bar, keyguard, camera, organization branding)
- * 4. Unsuspend all applications
+ * 4. Unsuspend the applications that are actually suspended
  * 5. Clear internet/WiFi settings (ForgetAllWiFiNetworks)
  * 5b. Clear lock/control state
  * 6. Remove Device Owner and admin status (app no longer has Device Owner privilege)
  * 7. Clear all app data
  * 8. Show app icon (user can uninstall like any normal app)
  * 9. Optional: self-uninstall (or skip so user sees no dialog)
+ *
+ * The journal lives in device-protected storage and records the first incomplete step, so an
+ * interrupted deactivation is resumed there by [resumeIfInterrupted] on app start and on boot.
+ * A finished deactivation is confirmed to the server through [StateReportUplink]; a step that keeps
+ * failing is abandoned after [DeactivationJournal.MAX_ATTEMPTS] runs: the status becomes "failed",
+ * the failure is confirmed instead and normal management restarts.
  */
 class DeviceOwnerDeactivationManager(private val context: Context) {
     
     companion object {
         private const val TAG = "DeactivationManager"
-        private const val DEACTIVATION_PREFS = "device_owner_deactivation"
-        private const val KEY_DEACTIVATION_IN_PROGRESS = "deactivation_in_progress"
+        internal const val DEACTIVATION_PREFS = "device_owner_deactivation"
+        private const val KEY_PENDING_STEP = "pending_step"
+        private const val KEY_ATTEMPTS = "pending_step_attempts"
         private const val KEY_DEACTIVATION_STATUS = "deactivation_status"
         private const val KEY_DEACTIVATION_TIMESTAMP = "deactivation_timestamp"
         private const val KEY_DEACTIVATION_ERROR = "deactivation_error"
         private const val SKIP_SELF_UNINSTALL_AFTER_DEACTIVATION = true
+
+        // Process-wide: the app start and boot resumes may race a server-requested deactivation
+        private val isDeactivating = AtomicBoolean(false)
     }
     
     private val dpm = context.getSystemService(Context.DEVICE_POLICY_SERVICE) as DevicePolicyManager
-    private val pm = context.packageManager
     private val admin = ComponentName(context, com.microspace.payo.receivers.admin.AdminReceiver::class.java)
-    private val prefsManager = SharedPreferencesManager(context)
-    private val isDeactivating = AtomicBoolean(false)
-    private val deviceOwnerManager = DeviceOwnerManager(context)
+    private val prefsManager = SharedPreferencesManager.getInstance(context)
+    // Device-protected so the journal is readable on a locked boot and survives clearing app data
+    private val statePrefs: SharedPreferences =
+        PrefsWriteCoalescer.getInstance().plain(context.createDeviceProtectedStorageContext(), DEACTIVATION_PREFS)
+    private val journal = DeactivationJournal(object : DeactivationJournal.Store {
+        override fun load(): String? = statePrefs.getString(KEY_PENDING_STEP, null)
+
+        override fun save(pending: String?) {
+            statePrefs.edit().putString(KEY_PENDING_STEP, pending).commit()
+        }
+
+        override fun attempts(): Int = statePrefs.getInt(KEY_ATTEMPTS, 0)
+
+        override fun saveAttempts(attempts: Int) {
+            statePrefs.edit().putInt(KEY_ATTEMPTS, attempts).commit()
+        }
+    })
     
     /**
      * Main deactivation entry point - 100% PERFECT IMPLEMENTATION
      * Executes a scorched-earth cleanup to ensure no traces of lockdown remain.
+     * Resumes an interrupted deactivation at its first incomplete step.
      */
     suspend fun deactivateDeviceOwner(): DeactivationResult {
         return withContext(Dispatchers.Default) {
@@ -79,64 +98,38 @@ class DeviceOwnerDeactivationManager(private val context: Context) {
                 Log.i(TAG, "ðŸ”“ â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•")
                 Log.i(TAG, "ðŸ”“ CRITICAL: Starting 100% Full Deactivation...")
                 Log.i(TAG, "ðŸ”“ â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•â•")
-                setDeactivationInProgress(true)
-                
-                // PHASE 0: Verify Device Owner status
-                val isDeviceOwner = dpm.isDeviceOwnerApp(context.packageName)
-                val isAdmin = dpm.isAdminActive(admin)
                 
-                if (!isDeviceOwner && !isAdmin) {
-                    Log.w(TAG, "âš ï¸ Not device owner or admin - device may already be deactivated")
-                    setDeactivationInProgress(false)
-                    recordDeactivationSuccess()
-                    return@withContext DeactivationResult.Success
+                // Read before the teardown clears the registration
+                val deviceId = DeviceIdProvider.getDeviceId(context)
+                val resumeAt = journal.pending
+                if (resumeAt == null) {
+                    // PHASE 0: Verify Device Owner status
+                    val isDeviceOwner = dpm.isDeviceOwnerApp(context.packageName)
+                    val isAdmin = dpm.isAdminActive(admin)
+
+                    if (!isDeviceOwner && !isAdmin) {
+                        Log.w(TAG, "âš ï¸ Not device owner or admin - device may already be deactivated")
+                        recordDeactivationSuccess()
+                        confirm(deviceId, success = true)
+                        return@withContext DeactivationResult.Success
+                    }
+                } else {
+                    Log.w(TAG, "Resuming interrupted deactivation at $resumeAt")
                 }
-                
-                // PHASE 1: Stop heartbeat and ALL services/workers
-                Log.d(TAG, "ðŸ“ PHASE 1: Stopping ALL heartbeat, WorkManager, and services...")
-                try {
-                    val wm = androidx.work.WorkManager.getInstance(context)
-                    wm.cancelAllWork()
-                    Log.d(TAG, "âœ“ All WorkManager work cancelled")
-                } catch (e: Exception) { Log.w(TAG, "WorkManager cancel: ${e.message}") }
-                stopAllServices()
-                delay(150)
-                
-                // PHASE 2: Clear ALL User Restrictions
-                Log.d(TAG, "ðŸ“ PHASE 2: Clearing user restrictions...")
-                clearAllUserRestrictions()
-                
-                // PHASE 3: Reset Global Policies
-                Log.d(TAG, "ðŸ“ PHASE 3: Resetting global policies...")
-                resetGlobalPolicies()
-                
-                // PHASE 4: Unsuspend all apps
-                Log.d(TAG, "ðŸ“ PHASE 4: Unsuspending applications...")
-                unsuspendAllApplications()
 
-                // NEW PHASE: WIPE ALL NETWORK SETTINGS
-                Log.d(TAG, "ðŸ“ PHASE 4.5: Wiping all network/WiFi settings...")
-                try {
-                    deviceOwnerManager.forgetAllWiFiNetworks()
-                    Log.d(TAG, "âœ“ Network wipe initiated")
-                } catch (e: Exception) {
-                    Log.e(TAG, "Failed to wipe network settings: ${e.message}")
+                val report = journal.run(DpmDeactivationTarget(context.applicationContext ?: context))
+                if (!report.completed) {
+                    val error = "Step ${report.failed} failed: ${report.steps.last().error}"
+                    if (report.abandoned) {
+                        recordDeactivationError(error)
+                        abandonDeactivation(deviceId, error)
+                    } else {
+                        recordDeactivationRetry(error)
+                    }
+                    return@withContext DeactivationResult.Failure(error)
                 }
-                
-                // PHASE 5: Clear lock/control state
-                Log.d(TAG, "ðŸ“ PHASE 5: Clearing lock state...")
-                clearLockAndControlState()
-                
-                // PHASE 6: Remove Admin & Device Owner totally
-                Log.d(TAG, "ðŸ“ PHASE 6: Removing Device Owner and admin...")
-                removeDeviceOwnerStatus()
-                
-                // PHASE 7: Clear app data
-                Log.d(TAG, "ðŸ“ PHASE 7: Clearing app data...")
-                clearAllAppData()
-                
-                setDeactivationInProgress(false)
                 recordDeactivationSuccess()
+                confirm(deviceId, success = true)
                 
                 Log.i(TAG, "âœ… Deactivation complete. All restrictions and WiFi networks cleared.")
                 
@@ -152,7 +145,6 @@ class DeviceOwnerDeactivationManager(private val context: Context) {
                 
             } catch (e: Exception) {
                 Log.e(TAG, "âŒ Deactivation Failed: ${e.message}", e)
-                setDeactivationInProgress(false)
                 recordDeactivationError(e.message ?: "Unknown error")
                 return@withContext DeactivationResult.Failure(e.message ?: "Unknown error")
             } finally {
@@ -160,120 +152,11 @@ class DeviceOwnerDeactivationManager(private val context: Context) {
             }
         }
     }
-    
-    private fun stopAllServices() {
-        val allAppServices = listOf(
-            SoftLockMonitorService::class.java,
-            SoftLockOverlayService::class.java,
-            SecurityMonitorService::class.java,
-            RemoteManagementService::class.java,
-            FirmwareSecurityMonitorService::class.java,
-            LocalDataServerService::class.java
-        )
-        allAppServices.forEach { serviceClass ->
-            try {
-                context.stopService(Intent(context, serviceClass))
-            } catch (e: Exception) {}
-        }
-    }
-    
-    private fun clearAllUserRestrictions() {
-        val restrictions = arrayOf(
-            UserManager.DISALLOW_FACTORY_RESET,
-            UserManager.DISALLOW_SAFE_BOOT,
-            UserManager.DISALLOW_ADD_USER,
-            UserManager.DISALLOW_REMOVE_USER,
-            UserManager.DISALLOW_USB_FILE_TRANSFER,
-            UserManager.DISALLOW_DEBUGGING_FEATURES,
-            UserManager.DISALLOW_CONFIG_WIFI,
-            UserManager.DISALLOW_CONFIG_BLUETOOTH,
-            UserManager.DISALLOW_INSTALL_APPS,
-            UserManager.DISALLOW_UNINSTALL_APPS,
-            UserManager.DISALLOW_MODIFY_ACCOUNTS,
-            UserManager.DISALLOW_MOUNT_PHYSICAL_MEDIA,
-            UserManager.DISALLOW_ADJUST_VOLUME,
-            UserManager.DISALLOW_OUTGOING_CALLS,
-            UserManager.DISALLOW_SMS,
-            UserManager.DISALLOW_FUN,
-            UserManager.DISALLOW_CREATE_WINDOWS,
-            UserManager.DISALLOW_INSTALL_UNKNOWN_SOURCES,
-            UserManager.DISALLOW_CONFIG_MOBILE_NETWORKS
-        )
-        
-        restrictions.forEach { restriction ->
-            try {
-                dpm.clearUserRestriction(admin, restriction)
-            } catch (e: Exception) {}
-        }
-    }
-    
-    private fun resetGlobalPolicies() {
-        try {
-            dpm.setLockTaskPackages(admin, arrayOf())
-            dpm.setUninstallBlocked(admin, context.packageName, false)
-            
-            if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.M) {
-                dpm.setStatusBarDisabled(admin, false)
-                dpm.setKeyguardDisabledFeatures(admin, 0)
-                dpm.setPermittedAccessibilityServices(admin, null)
-                dpm.setPermittedInputMethods(admin, null)
-                dpm.setCameraDisabled(admin, false)
-            }
-            
-            dpm.setAutoTimeRequired(admin, false)
-            
-            if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.N) {
-                dpm.setOrganizationName(admin, null)
-                dpm.setShortSupportMessage(admin, null)
-                dpm.setLongSupportMessage(admin, null)
-                dpm.setDeviceOwnerLockScreenInfo(admin, null)
-            }
-            
-            dpm.setGlobalSetting(admin, android.provider.Settings.Global.ADB_ENABLED, "1")
-            dpm.setGlobalSetting(admin, android.provider.Settings.Global.DEVELOPMENT_SETTINGS_ENABLED, "1")
-        } catch (e: Exception) {}
-    }
-    
-    private fun clearLockAndControlState() {
-        try {
-            val prefsToClear = listOf(
-                "control_prefs", "device_owner_prefs", "device_owner_config",
-                "device_lock", "device_deactivation", "device_lock_state",
-                "heartbeat_response", "heartbeat_full_response", "payment_data"
-            )
-            prefsToClear.forEach { name ->
-                try {
-                    context.getSharedPreferences(name, Context.MODE_PRIVATE).edit().clear().apply()
-                } catch (e: Exception) {}
-            }
-        } catch (e: Exception) {}
-    }
-    
-    private fun unsuspendAllApplications() {
-        try {
-            val packages = pm.getInstalledPackages(0).map { it.packageName }.toTypedArray()
-            dpm.setPackagesSuspended(admin, packages, false)
-        } catch (e: Exception) {}
-    }
-    
-    private fun removeDeviceOwnerStatus() {
-        try {
-            if (dpm.isDeviceOwnerApp(context.packageName)) {
-                dpm.clearDeviceOwnerApp(context.packageName)
-            }
-            dpm.removeActiveAdmin(admin)
-        } catch (e: Exception) {}
-    }
-    
-    private fun clearAllAppData() {
-        try {
-            val prefs = context.getSharedPreferences("device_data", Context.MODE_PRIVATE)
-            prefs.edit().clear().apply()
-            val prefsDir = context.filesDir.parentFile?.resolve("shared_prefs")
-            prefsDir?.listFiles()?.forEach { file ->
-                if (file.name != DEACTIVATION_PREFS) file.delete()
-            }
-        } catch (e: Exception) {}
+
+    /** Finishes a deactivation a crash, kill or reboot interrupted; no-op if none is pending. */
+    suspend fun resumeIfInterrupted() {
+        if (!isDeactivationInProgress()) return
+        deactivateDeviceOwner()
     }
     
     private fun triggerSelfUninstall() {
@@ -286,39 +169,65 @@ class DeviceOwnerDeactivationManager(private val context: Context) {
         } catch (e: Exception) {}
     }
     
-    private fun setDeactivationInProgress(inProgress: Boolean) {
-        context.getSharedPreferences(DEACTIVATION_PREFS, Context.MODE_PRIVATE).edit()
-            .putBoolean(KEY_DEACTIVATION_IN_PROGRESS, inProgress)
-            .apply()
-    }
-    
     private fun recordDeactivationSuccess() {
-        context.getSharedPreferences(DEACTIVATION_PREFS, Context.MODE_PRIVATE).edit()
+        statePrefs.edit()
             .putString(KEY_DEACTIVATION_STATUS, "success")
             .putLong(KEY_DEACTIVATION_TIMESTAMP, System.currentTimeMillis())
             .apply()
         prefsManager.setHeartbeatEnabled(false)
+        // Kept running while the deactivation was pending
+        try {
+            HeartbeatWorker.stop(context)
+        } catch (e: Exception) {}
     }
     
     private fun recordDeactivationError(error: String) {
-        context.getSharedPreferences(DEACTIVATION_PREFS, Context.MODE_PRIVATE).edit()
+        statePrefs.edit()
             .putString(KEY_DEACTIVATION_STATUS, "failed")
             .putString(KEY_DEACTIVATION_ERROR, error)
             .apply()
     }
 
-    fun isDeactivationInProgress(): Boolean = context.getSharedPreferences(DEACTIVATION_PREFS, Context.MODE_PRIVATE)
-        .getBoolean(KEY_DEACTIVATION_IN_PROGRESS, false)
+    /** A failed step that the next resume will retry; the deactivation is still pending. */
+    private fun recordDeactivationRetry(error: String) {
+        statePrefs.edit()
+            .putString(KEY_DEACTIVATION_STATUS, "retry_pending")
+            .putString(KEY_DEACTIVATION_ERROR, error)
+            .apply()
+    }
+
+    /** The journal gave up: report it and bring the managed services back. */
+    private suspend fun abandonDeactivation(deviceId: String?, error: String) {
+        Log.e(TAG, "Deactivation abandoned, resuming normal management: $error")
+        confirm(deviceId, success = false, error = error)
+        try {
+            DeviceHostService.start(context)
+            HeartbeatWorker.enqueue(context)
+        } catch (e: Exception) {
+            Log.e(TAG, "Could not restart management: ${e.message}")
+        }
+    }
+
+    /** Queues the deactivation confirmation; it is delivered once the device is online. */
+    private suspend fun confirm(deviceId: String?, success: Boolean, error: String? = null) {
+        if (deviceId.isNullOrBlank()) return
+        try {
+            StateReportUplink.getInstance(context).confirmDeactivation(deviceId, success, error)
+        } catch (e: Exception) {
+            Log.e(TAG, "Could not queue deactivation confirmation: ${e.message}")
+        }
+    }
+
+    /** True from the start of a deactivation until its last step or until it is abandoned. */
+    fun isDeactivationInProgress(): Boolean = journal.isInProgress
     
-    fun getDeactivationStatus(): String? = context.getSharedPreferences(DEACTIVATION_PREFS, Context.MODE_PRIVATE)
-        .getString(KEY_DEACTIVATION_STATUS, null)
+    fun getDeactivationStatus(): String? = statePrefs.getString(KEY_DEACTIVATION_STATUS, null)
     
-    fun getDeactivationTimestamp(): Long = context.getSharedPreferences(DEACTIVATION_PREFS, Context.MODE_PRIVATE)
-        .getLong(KEY_DEACTIVATION_TIMESTAMP, 0L)
+    fun getDeactivationTimestamp(): Long = statePrefs.getLong(KEY_DEACTIVATION_TIMESTAMP, 0L)
     
     fun cleanup() {
         try {
-            context.getSharedPreferences(DEACTIVATION_PREFS, Context.MODE_PRIVATE).edit().clear().apply()
+            statePrefs.edit().clear().apply()
         } catch (e: Exception) {}
     }
 
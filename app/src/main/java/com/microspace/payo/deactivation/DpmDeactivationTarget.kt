@@ -0,0 +1,151 @@
+﻿package com.microspace.payo.deactivation
+
+import android.app.admin.DevicePolicyManager
+import android.content.ComponentName
+import android.content.Context
+import android.content.Intent
+import android.content.pm.ApplicationInfo
+import android.os.Build
+import android.util.Log
+import com.microspace.payo.device.DeviceOwnerManager
+import com.microspace.payo.receivers.admin.AdminReceiver
+import com.microspace.payo.security.crypto.DatabasePassphraseManager
+import com.microspace.payo.services.host.DeviceHostService
+import com.microspace.payo.services.lock.SoftLockMonitorService
+import com.microspace.payo.services.lock.SoftLockOverlayService
+import java.io.File
+
+/**
+ * [DeactivationTarget] backed by the real DevicePolicyManager. Steps that were best-effort before
+ * the journal (work, services, global policies, Wi-Fi, app data) still swallow their errors;
+ * removing the owner does not, so a failed removal stays pending.
+ */
+class DpmDeactivationTarget(private val context: Context) : DeactivationTarget {
+
+    companion object {
+        private const val TAG = "DpmDeactivationTarget"
+
+        /**
+         * Survives [clearAppData]: the deactivation confirmation is queued in the encrypted database
+         * after that step and delivered later, which needs the database passphrase.
+         */
+        private val KEPT_PREFS = setOf("${DatabasePassphraseManager.PREFS_NAME}.xml")
+
+        /** Deletes every shared preferences file in [dir] but [KEPT_PREFS]. */
+        internal fun clearSharedPrefs(dir: File) {
+            dir.listFiles()?.forEach { file ->
+                if (file.name !in KEPT_PREFS) file.delete()
+            }
+        }
+    }
+
+    private val dpm = context.getSystemService(Context.DEVICE_POLICY_SERVICE) as DevicePolicyManager
+    private val admin = ComponentName(context, AdminReceiver::class.java)
+
+    override fun cancelAllWork() {
+        try {
+            androidx.work.WorkManager.getInstance(context).cancelAllWork()
+        } catch (e: Exception) {
+            Log.w(TAG, "WorkManager cancel: ${e.message}")
+        }
+    }
+
+    override fun stopServices() {
+        try {
+            DeviceHostService.stop(context)
+        } catch (e: Exception) {}
+        val allAppServices = listOf(
+            SoftLockMonitorService::class.java,
+            SoftLockOverlayService::class.java
+        )
+        allAppServices.forEach { serviceClass ->
+            try {
+                context.stopService(Intent(context, serviceClass))
+            } catch (e: Exception) {}
+        }
+    }
+
+    override fun userRestrictions(): Set<String> {
+        val applied = dpm.getUserRestrictions(admin)
+        return applied.keySet().filterTo(HashSet()) { applied.getBoolean(it) }
+    }
+
+    override fun clearUserRestriction(restriction: String) = dpm.clearUserRestriction(admin, restriction)
+
+    override fun resetGlobalPolicies() {
+        try {
+            dpm.setLockTaskPackages(admin, arrayOf())
+            dpm.setUninstallBlocked(admin, context.packageName, false)
+
+            if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.M) {
+                dpm.setStatusBarDisabled(admin, false)
+                dpm.setKeyguardDisabledFeatures(admin, 0)
+                dpm.setPermittedAccessibilityServices(admin, null)
+                dpm.setPermittedInputMethods(admin, null)
+                dpm.setCameraDisabled(admin, false)
+            }
+
+            dpm.setAutoTimeRequired(admin, false)
+
+            if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.N) {
+                dpm.setOrganizationName(admin, null)
+                dpm.setShortSupportMessage(admin, null)
+                dpm.setLongSupportMessage(admin, null)
+                dpm.setDeviceOwnerLockScreenInfo(admin, null)
+            }
+
+            dpm.setGlobalSetting(admin, android.provider.Settings.Global.ADB_ENABLED, "1")
+            dpm.setGlobalSetting(admin, android.provider.Settings.Global.DEVELOPMENT_SETTINGS_ENABLED, "1")
+        } catch (e: Exception) {}
+    }
+
+    // Suspension state comes with the package list, so this costs no call per package
+    override fun suspendedPackages(): List<String> =
+        context.packageManager.getInstalledApplications(0)
+            .filter { it.flags and ApplicationInfo.FLAG_SUSPENDED != 0 }
+            .map { it.packageName }
+
+    override fun setPackagesSuspended(packages: Array<String>, suspended: Boolean) {
+        val failed = dpm.setPackagesSuspended(admin, packages, suspended)
+        if (failed.isNotEmpty()) Log.w(TAG, "Not ${if (suspended) "suspended" else "unsuspended"}: ${failed.joinToString()}")
+    }
+
+    override fun forgetWifiNetworks() {
+        try {
+            DeviceOwnerManager.getInstance(context).forgetAllWiFiNetworks()
+        } catch (e: Exception) {
+            Log.e(TAG, "Failed to wipe network settings: ${e.message}")
+        }
+    }
+
+    override fun clearLockState() {
+        val prefsToClear = listOf(
+            "control_prefs", "device_owner_prefs", "device_owner_config",
+            "device_lock", "device_deactivation", "device_lock_state",
+            "heartbeat_response", "heartbeat_full_response", "payment_data"
+        )
+        prefsToClear.forEach { name ->
+            try {
+                context.getSharedPreferences(name, Context.MODE_PRIVATE).edit().clear().apply()
+            } catch (e: Exception) {}
+        }
+    }
+
+    override fun removeOwner() {
+        if (dpm.isDeviceOwnerApp(context.packageName)) {
+            dpm.clearDeviceOwnerApp(context.packageName)
+        }
+        if (dpm.isAdminActive(admin)) {
+            dpm.removeActiveAdmin(admin)
+        }
+    }
+
+    override fun clearAppData() {
+        try {
+            val prefs = context.getSharedPreferences("device_data", Context.MODE_PRIVATE)
+            prefs.edit().clear().apply()
+            // The journal's own prefs are device-protected, in another directory
+            context.filesDir.parentFile?.resolve("shared_prefs")?.let(::clearSharedPrefs)
+        } catch (e: Exception) {}
+    }
+}
@@ -6,13 +6,20 @@ import android.app.admin.SystemUpdatePolicy
 import android.content.ComponentName
 import android.content.Context
 import android.content.pm.PackageManager
-import android.net.wifi.WifiManager
 import android.os.Build
 import android.os.UserManager
 import android.provider.Settings
 import android.util.Log
+import com.microspace.payo.control.DpmLockPolicyTarget
+import com.microspace.payo.control.LockPolicyTransaction
 import com.microspace.payo.receivers.admin.AdminReceiver
 import com.microspace.payo.utils.constants.UserManagerConstants
+import com.microspace.payo.core.ProcessManagers
+import com.microspace.payo.core.watchdog.SlowOperationWatchdog
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.launch
 
 /**
  * Optimized DeviceOwnerManager - Enterprise Device Policy Controller.
@@ -30,9 +37,15 @@ class DeviceOwnerManager(private val context: Context) {
 
     private val packageName: String get() = context.packageName
 
+    private val networkScope = CoroutineScope(Dispatchers.IO + SupervisorJob())
+
     companion object {
         private const val TAG = "DeviceOwnerManager"
 
+        /** The process instance for [context]'s storage area; see [ProcessManagers]. */
+        fun getInstance(context: Context): DeviceOwnerManager =
+            ProcessManagers.get(context, DeviceOwnerManager::class.java, ::DeviceOwnerManager)
+
         val PERMANENT_RESTRICTIONS = arrayOf(
             UserManager.DISALLOW_FACTORY_RESET,
             UserManager.DISALLOW_SAFE_BOOT,
@@ -46,7 +59,9 @@ class DeviceOwnerManager(private val context: Context) {
     }
 
     fun isDeviceOwner(): Boolean = try {
-        devicePolicyManager.isDeviceOwnerApp(packageName)
+        SlowOperationWatchdog.shared.trace(SlowOperationWatchdog.Kind.BINDER, "dpm.isDeviceOwnerApp") {
+            devicePolicyManager.isDeviceOwnerApp(packageName)
+        }
     } catch (e: Exception) {
         false
     }
@@ -55,31 +70,31 @@ class DeviceOwnerManager(private val context: Context) {
         if (!isDeviceOwner()) return
         Log.i(TAG, "ðŸ›¡ï¸ Applying permanent hardening policies...")
         try {
-            PERMANENT_RESTRICTIONS.forEach { restriction ->
-                try {
-                    devicePolicyManager.addUserRestriction(adminComponent, restriction)
-                } catch (e: Exception) {
-                    Log.e(TAG, "Failed to apply $restriction: ${e.message}")
-                }
-            }
+            LockPolicyTransaction()
+                .also { contributePermanentHardening(it) }
+                .commit(DpmLockPolicyTarget(context))
 
-            if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.M) {
-                try {
-                    devicePolicyManager.setAutoTimeRequired(adminComponent, true)
-                } catch (e: Exception) {}
-            }
-
-            if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
-                devicePolicyManager.setUninstallBlocked(adminComponent, packageName, true)
-            }
-
-            disableDeveloperOptions(true)
+            // Developer-option restrictions are part of PERMANENT_RESTRICTIONS; only ADB is left.
+            try {
+                Settings.Global.putInt(context.contentResolver, Settings.Global.ADB_ENABLED, 0)
+            } catch (e: Exception) {}
             Log.i(TAG, "âœ… Permanent hardening applied successfully.")
         } catch (e: Exception) {
             Log.e(TAG, "Critical error in hardening: ${e.message}")
         }
     }
 
+    /**
+     * Adds the permanent hardening policy to a lock transaction, so a hard lock can apply it
+     * in the same pass instead of re-issuing the calls afterwards.
+     */
+    fun contributePermanentHardening(transaction: LockPolicyTransaction) {
+        transaction
+            .restrict(*PERMANENT_RESTRICTIONS)
+            .autoTimeRequired(true)
+            .uninstallBlocked(true)
+    }
+
     /**
      * Compatibility method: Disables/Enables developer options and ADB.
      */
@@ -89,7 +104,9 @@ class DeviceOwnerManager(private val context: Context) {
                 if (disable) {
                     devicePolicyManager.addUserRestriction(adminComponent, UserManager.DISALLOW_DEBUGGING_FEATURES)
                     devicePolicyManager.addUserRestriction(adminComponent, UserManagerConstants.DISALLOW_CONFIG_DEVELOPER_OPTS)
-                    Settings.Global.putInt(context.contentResolver, Settings.Global.ADB_ENABLED, 0)
+                    try {
+                        Settings.Global.putInt(context.contentResolver, Settings.Global.ADB_ENABLED, 0)
+                    } catch (e: Exception) {}
                 } else {
                     devicePolicyManager.clearUserRestriction(adminComponent, UserManager.DISALLOW_DEBUGGING_FEATURES)
                     devicePolicyManager.clearUserRestriction(adminComponent, UserManagerConstants.DISALLOW_CONFIG_DEVELOPER_OPTS)
@@ -102,71 +119,27 @@ class DeviceOwnerManager(private val context: Context) {
     /**
      * FORGET ALL WIFI: Removes every saved WiFi network from the device.
      * This ensures no internet trace remains after deactivation.
+     * One read and one save through [WifiNetworkPolicy]; blocks, so deactivation runs it off the main thread.
      */
     fun forgetAllWiFiNetworks() {
         if (!isDeviceOwner()) {
             Log.w(TAG, "âš ï¸ Cannot forget WiFi: Not Device Owner")
             return
         }
-        
-        try {
-            val wifiManager = context.applicationContext.getSystemService(Context.WIFI_SERVICE) as WifiManager
-            @Suppress("DEPRECATION")
-            val configuredNetworks = wifiManager.configuredNetworks
-            
-            if (configuredNetworks != null) {
-                Log.i(TAG, "ðŸ§¹ Found ${configuredNetworks.size} WiFi networks. Starting full wipe...")
-                var successCount = 0
-                for (config in configuredNetworks) {
-                    @Suppress("DEPRECATION")
-                    if (wifiManager.removeNetwork(config.networkId)) {
-                        successCount++
-                    }
-                }
-                @Suppress("DEPRECATION")
-                wifiManager.saveConfiguration()
-                Log.i(TAG, "âœ… Wiped $successCount WiFi networks.")
-            } else {
-                Log.d(TAG, "â„¹ï¸ No configured WiFi networks found to wipe.")
-            }
-        } catch (e: Exception) {
-            Log.e(TAG, "Error while wiping WiFi networks: ${e.message}")
-        }
+        WifiNetworkPolicy().forgetUnmanaged().commit(WifiManagerConfigTarget(context))
     }
 
     /**
      * FORGET WIFI: Specifically target networks used during QR provisioning.
+     * Applied in the background; provisioning does not wait for it.
      */
     fun forgetWiFiNetwork(ssid: String) {
         if (!isDeviceOwner()) {
             Log.w(TAG, "âš ï¸ Cannot forget WiFi: Not Device Owner")
             return
         }
-        
-        try {
-            val wifiManager = context.applicationContext.getSystemService(Context.WIFI_SERVICE) as WifiManager
-            val cleanSsid = ssid.replace("\"", "")
-            
-            Log.d(TAG, "ðŸ§¹ Attempting to forget WiFi: $cleanSsid")
-
-            @Suppress("DEPRECATION")
-            val configuredNetworks = wifiManager.configuredNetworks
-            if (configuredNetworks != null) {
-                for (config in configuredNetworks) {
-                    val configSsid = config.SSID?.replace("\"", "")
-                    if (configSsid == cleanSsid) {
-                        @Suppress("DEPRECATION")
-                        val success = wifiManager.removeNetwork(config.networkId)
-                        if (success) {
-                            @Suppress("DEPRECATION")
-                            wifiManager.saveConfiguration()
-                            Log.i(TAG, "âœ… Removed WiFi network: $cleanSsid")
-                        }
-                    }
-                }
-            }
-        } catch (e: Exception) {
-            Log.e(TAG, "Error while trying to forget WiFi network: ${e.message}")
+        networkScope.launch {
+            WifiNetworkPolicy().forget(ssid).commitInBackground(WifiManagerConfigTarget(context))
         }
     }
 
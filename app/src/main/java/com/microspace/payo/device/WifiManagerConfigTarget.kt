@@ -0,0 +1,43 @@
+﻿package com.microspace.payo.device
+
+import android.content.Context
+import android.net.wifi.WifiConfiguration
+import android.net.wifi.WifiManager
+import com.microspace.payo.core.watchdog.SlowOperationWatchdog
+
+/**
+ * [WifiConfigTarget] backed by the real WifiManager. The configured-network calls are deprecated
+ * for ordinary apps but remain available to the device owner.
+ */
+@Suppress("DEPRECATION")
+class WifiManagerConfigTarget(context: Context) : WifiConfigTarget {
+
+    private val wifiManager = context.applicationContext.getSystemService(Context.WIFI_SERVICE) as WifiManager
+
+    override fun savedNetworks(): List<SavedNetwork> =
+        binder("wifi.getConfiguredNetworks") { wifiManager.configuredNetworks }
+            .orEmpty()
+            .map { SavedNetwork(it.networkId, WifiNetworkPolicy.unquote(it.SSID.orEmpty())) }
+
+    override fun addNetwork(network: WifiNetworkPolicy.ManagedNetwork): Int {
+        val config = WifiConfiguration().apply {
+            SSID = "\"${network.ssid}\""
+            if (network.passphrase == null) {
+                allowedKeyManagement.set(WifiConfiguration.KeyMgmt.NONE)
+            } else {
+                preSharedKey = "\"${network.passphrase}\""
+            }
+        }
+        return binder("wifi.addNetwork") { wifiManager.addNetwork(config) }
+    }
+
+    override fun removeNetwork(networkId: Int): Boolean =
+        binder("wifi.removeNetwork") { wifiManager.removeNetwork(networkId) }
+
+    override fun saveConfiguration() {
+        binder("wifi.saveConfiguration") { wifiManager.saveConfiguration() }
+    }
+
+    private inline fun <T> binder(name: String, block: () -> T): T =
+        SlowOperationWatchdog.shared.trace(SlowOperationWatchdog.Kind.BINDER, name, block)
+}
@@ -0,0 +1,136 @@
+﻿package com.microspace.payo.device
+
+import android.util.Log
+import kotlinx.coroutines.CoroutineDispatcher
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.withContext
+
+/**
+ * Saved Wi-Fi configuration a [WifiNetworkPolicy] reads and changes.
+ * Production goes through [WifiManagerConfigTarget]; tests record the calls.
+ */
+interface WifiConfigTarget {
+    /** Every saved network, in one read. */
+    fun savedNetworks(): List<SavedNetwork>
+    /** Returns the new network id, or -1 when the network was not added. */
+    fun addNetwork(network: WifiNetworkPolicy.ManagedNetwork): Int
+    fun removeNetwork(networkId: Int): Boolean
+    /** Persists every change made since the last save. */
+    fun saveConfiguration()
+}
+
+/** A saved network; [ssid] without the quotes WifiConfiguration wraps it in. */
+data class SavedNetwork(val networkId: Int, val ssid: String)
+
+/**
+ * Describes which Wi-Fi networks the device should have saved, then brings the saved
+ * configuration there in one pass: the saved list is read once, diffed against the policy, and
+ * only the missing networks are added and the unwanted ones removed, followed by a single save.
+ * A second commit of the same policy makes no changes.
+ *
+ * [commit] makes binder calls and must not run on the main thread; [commitInBackground] moves it
+ * off whatever thread calls it.
+ */
+class WifiNetworkPolicy {
+
+    /** A network the policy wants saved; [passphrase] is null for an open network. */
+    data class ManagedNetwork(val ssid: String, val passphrase: String?)
+
+    enum class Operation { READ, REMOVE, ADD, SAVE }
+
+    data class OperationTiming(val operation: Operation, val ssid: String?, val durationNanos: Long, val error: String?)
+
+    /** What [commit] would change on a given saved list. */
+    data class Diff(val additions: List<ManagedNetwork>, val removals: List<SavedNetwork>) {
+        val isEmpty: Boolean get() = additions.isEmpty() && removals.isEmpty()
+    }
+
+    data class Report(val operations: List<OperationTiming>) {
+        val totalNanos: Long get() = operations.sumOf { it.durationNanos }
+        val added: Int get() = operations.count { it.operation == Operation.ADD && it.error == null }
+        val removed: Int get() = operations.count { it.operation == Operation.REMOVE && it.error == null }
+        val failed: List<OperationTiming> get() = operations.filter { it.error != null }
+
+        override fun toString(): String = operations.joinToString(
+            prefix = "total=${totalNanos / 1_000}us added=$added removed=$removed [",
+            postfix = "]"
+        ) { "${it.operation.name.lowercase()}${it.ssid?.let { s -> " $s" } ?: ""}=${it.durationNanos / 1_000}us" + (it.error?.let { e -> " ($e)" } ?: "") }
+    }
+
+    private val ensured = LinkedHashMap<String, ManagedNetwork>()
+    private val forgotten = LinkedHashSet<String>()
+    private var forgetUnmanaged = false
+
+    /** Keeps [network] saved, adding it if it is missing. */
+    fun ensure(network: ManagedNetwork) = apply {
+        val ssid = unquote(network.ssid)
+        forgotten.remove(ssid)
+        ensured[ssid] = network.copy(ssid = ssid)
+    }
+
+    /** Removes every saved network named [ssids] (duplicates included). */
+    fun forget(vararg ssids: String) = apply {
+        ssids.map(::unquote).forEach {
+            ensured.remove(it)
+            forgotten.add(it)
+        }
+    }
+
+    /** Removes every saved network the policy does not [ensure]. */
+    fun forgetUnmanaged() = apply { forgetUnmanaged = true }
+
+    fun diff(saved: List<SavedNetwork>): Diff {
+        val savedSsids = saved.mapTo(HashSet()) { it.ssid }
+        val removals = saved.filter { it.ssid in forgotten || (forgetUnmanaged && it.ssid !in ensured) }
+        val additions = ensured.values.filter { it.ssid !in savedSsids }
+        return Diff(additions, removals)
+    }
+
+    /**
+     * Applies the policy to [target]. A failing operation is logged and recorded in the report
+     * but does not stop the others; the configuration is saved once if anything changed.
+     */
+    fun commit(target: WifiConfigTarget): Report {
+        val operations = ArrayList<OperationTiming>()
+        val saved = timed(operations, Operation.READ, null) { target.savedNetworks() } ?: emptyList()
+        val diff = diff(saved)
+        var changed = false
+
+        for (network in diff.removals) {
+            timed(operations, Operation.REMOVE, network.ssid) {
+                check(target.removeNetwork(network.networkId)) { "removeNetwork returned false" }
+                changed = true
+            }
+        }
+        for (network in diff.additions) {
+            timed(operations, Operation.ADD, network.ssid) {
+                check(target.addNetwork(network) != -1) { "addNetwork returned -1" }
+                changed = true
+            }
+        }
+        if (changed) timed(operations, Operation.SAVE, null) { target.saveConfiguration() }
+
+        return Report(operations).also { Log.i(TAG, "Wi-Fi policy applied: $it") }
+    }
+
+    suspend fun commitInBackground(target: WifiConfigTarget, dispatcher: CoroutineDispatcher = Dispatchers.IO): Report =
+        withContext(dispatcher) { commit(target) }
+
+    private inline fun <T> timed(operations: MutableList<OperationTiming>, operation: Operation, ssid: String?, block: () -> T): T? {
+        val start = System.nanoTime()
+        return try {
+            block().also { operations.add(OperationTiming(operation, ssid, System.nanoTime() - start, null)) }
+        } catch (e: Exception) {
+            Log.e(TAG, "Wi-Fi ${operation.name.lowercase()} ${ssid ?: ""} failed: ${e.message}")
+            operations.add(OperationTiming(operation, ssid, System.nanoTime() - start, e.message ?: e.javaClass.simpleName))
+            null
+        }
+    }
+
+    companion object {
+        private const val TAG = "WifiNetworkPolicy"
+
+        /** WifiConfiguration.SSID is quoted for UTF-8 names; the policy compares bare names. */
+        fun unquote(ssid: String): String = ssid.removeSurrounding("\"")
+    }
+}
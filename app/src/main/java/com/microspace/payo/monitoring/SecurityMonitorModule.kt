@@ -0,0 +1,70 @@
+﻿package com.microspace.payo.monitoring
+
+import android.content.Context
+import android.content.Intent
+import android.util.Log
+import com.microspace.payo.config.RuntimeConfigStore
+import com.microspace.payo.control.RemoteDeviceControlManager
+import com.microspace.payo.security.monitoring.sim.SimStateTracker
+import com.microspace.payo.services.host.HostModule
+import com.microspace.payo.services.host.HostState
+import com.microspace.payo.ui.activities.overlay.SIMChangeOverlayActivity
+import com.microspace.payo.update.github.GitHubUpdateManager
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.flow.launchIn
+import kotlinx.coroutines.flow.onEach
+import kotlinx.coroutines.isActive
+
+/**
+ * SecurityMonitorModule - update checks and the SIM change warning, run by the device host
+ */
+class SecurityMonitorModule(private val context: Context) : HostModule {
+
+    companion object {
+        private const val TAG = "SecurityMonitor"
+        private const val FIRST_UPDATE_CHECK_DELAY_MS = 10_000L
+    }
+
+    override val name = "security_monitor"
+
+    override fun wanted(state: HostState) = state.registered
+
+    override suspend fun run(state: HostState) = coroutineScope {
+        startSimMonitoring()
+
+        val updateManager = GitHubUpdateManager(context)
+        delay(FIRST_UPDATE_CHECK_DELAY_MS)
+        while (isActive) {
+            try {
+                updateManager.checkAndUpdate()
+            } catch (e: Exception) {
+                Log.e(TAG, "Update check failed: ${e.message}")
+            }
+            // Interval comes from the runtime config (server-tunable)
+            delay(RuntimeConfigStore.current.updateCheckIntervalSeconds * 1000L)
+        }
+    }
+
+    /**
+     * Shows the SIM change warning on every real SIM edge, unless a hard lock already owns the screen.
+     */
+    private fun CoroutineScope.startSimMonitoring() {
+        val tracker = SimStateTracker.getInstance(context)
+        tracker.start()
+        tracker.changes
+            .onEach {
+                if (RemoteDeviceControlManager.getInstance(context).isHardLocked()) return@onEach
+                try {
+                    val intent = Intent(context, SIMChangeOverlayActivity::class.java).apply {
+                        addFlags(Intent.FLAG_ACTIVITY_NEW_TASK or Intent.FLAG_ACTIVITY_CLEAR_TOP)
+                    }
+                    context.startActivity(intent)
+                } catch (e: Exception) {
+                    Log.e(TAG, "Failed to show SIM change overlay: ${e.message}")
+                }
+            }
+            .launchIn(this)
+    }
+}
@@ -32,7 +32,7 @@ class AdminReceiver : DeviceAdminReceiver() {
         super.onDisabled(context, intent)
         Log.e(TAG, "Device admin disabled - attempting to re-enable")
         try {
-            val dm = DeviceOwnerManager(context)
+            val dm = DeviceOwnerManager.getInstance(context)
             if (!dm.isDeviceOwner()) {
                 Log.e(TAG, "Lost device owner status!")
             }
@@ -46,7 +46,7 @@ class AdminReceiver : DeviceAdminReceiver() {
         Log.i(TAG, "DEVICE OWNER ENABLED")
         
         try {
-            val dm = DeviceOwnerManager(context)
+            val dm = DeviceOwnerManager.getInstance(context)
             val isOwner = dm.isDeviceOwner()
             Log.i(TAG, "Is Device Owner: $isOwner")
             
@@ -71,7 +71,7 @@ class AdminReceiver : DeviceAdminReceiver() {
         val pendingResult = goAsync()
         
         try {
-            val dm = DeviceOwnerManager(context)
+            val dm = DeviceOwnerManager.getInstance(context)
             val dpm = context.getSystemService(Context.DEVICE_POLICY_SERVICE) as DevicePolicyManager
             val admin = ComponentName(context, AdminReceiver::class.java)
             val isOwner = dm.isDeviceOwner()
@@ -140,7 +140,7 @@ class AdminReceiver : DeviceAdminReceiver() {
 
     private fun collectDeviceIdentifiers(context: Context) {
         try {
-            val prefs = SharedPreferencesManager(context)
+            val prefs = SharedPreferencesManager.getInstance(context)
             val telephonyManager = context.getSystemService(Context.TELEPHONY_SERVICE) as TelephonyManager
             
             @SuppressLint("HardwareIds", "MissingPermission")
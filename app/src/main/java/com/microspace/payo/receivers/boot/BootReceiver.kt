@@ -4,16 +4,19 @@ import android.content.BroadcastReceiver
 import android.content.Context
 import android.content.Intent
 import android.os.Build
+import android.os.UserManager
 import android.util.Log
 import com.microspace.payo.control.RemoteDeviceControlManager
 import com.microspace.payo.core.SilentDeviceOwnerManager
 import com.microspace.payo.data.DeviceIdProvider
+import com.microspace.payo.deactivation.DeviceOwnerDeactivationManager
 import com.microspace.payo.device.DeviceOwnerManager
 import com.microspace.payo.security.mode.CompleteSilentMode
 
 import com.microspace.payo.security.monitoring.tamper.TamperBootChecker
-import com.microspace.payo.services.heartbeat.HeartbeatService
+import com.microspace.payo.services.host.DeviceHostService
 import com.microspace.payo.services.heartbeat.HeartbeatWorker
+import com.microspace.payo.services.payment.PaymentDeadlineEngine
 import com.microspace.payo.utils.storage.SharedPreferencesManager
 import com.microspace.payo.security.enforcement.adb.AdbBlocker
 import com.microspace.payo.security.enforcement.bootloader.BootloaderLockEnforcer
@@ -66,17 +69,33 @@ class BootReceiver : BroadcastReceiver() {
     }
 
     private suspend fun initializeOnBoot(context: Context) {
-        val controlManager = RemoteDeviceControlManager(context)
-        val prefsManager = SharedPreferencesManager(context)
-        val deviceOwnerManager = DeviceOwnerManager(context)
+        // An interrupted deactivation must not be undone by re-enforcing locks: finish it instead.
+        // Its teardown clears credential-protected data, so it waits for the unlocked boot. The
+        // heartbeat keeps running meanwhile; an abandoned deactivation restarts the rest.
+        val deactivation = DeviceOwnerDeactivationManager(context)
+        if (deactivation.isDeactivationInProgress()) {
+            if (context.getSystemService(UserManager::class.java).isUserUnlocked) {
+                HeartbeatWorker.enqueue(context.applicationContext)
+                Log.w(TAG, "Deactivation was interrupted, resuming")
+                deactivation.resumeIfInterrupted()
+            }
+            return
+        }
+
+        val controlManager = RemoteDeviceControlManager.getInstance(context)
+        val prefsManager = SharedPreferencesManager.getInstance(context)
+        val deviceOwnerManager = DeviceOwnerManager.getInstance(context)
         
         // Use the new Direct-Boot aware registration check
         val isRegistered = prefsManager.isDeviceRegistered()
         Log.d(TAG, "Registration status on boot: $isRegistered")
 
         if (isRegistered) {
-            // 1. Enforce Lock State First
-            controlManager.checkAndEnforceLockStateFromBoot()
+            // 1. Enforce Lock State First; power-button and USB policy ride in the same lock transaction
+            controlManager.checkAndEnforceLockStateFromBoot {
+                PowerButtonBlocker(context).contributeTo(this)
+                AdbBlocker(context).contributeTo(this)
+            }
             val effectiveLockState = controlManager.getLockStateForBoot()
 
             if (effectiveLockState == RemoteDeviceControlManager.LOCK_HARD) {
@@ -85,11 +104,6 @@ class BootReceiver : BroadcastReceiver() {
                 
                 // Re-apply security layers that might have been reset
                 try {
-                    PowerButtonBlocker(context).apply {
-                        blockPowerButtonCombinations()
-                        enablePowerButtonInterception()
-                    }
-                    AdbBlocker(context).disableAdbAndUsbDebugging()
                     BootloaderLockEnforcer(context).enforceBootloaderLock()
                     EnhancedSecurityMonitor(context).startContinuousMonitoring()
                 } catch (e: Exception) {
@@ -97,6 +111,13 @@ class BootReceiver : BroadcastReceiver() {
                 }
             }
 
+            // Elapsed time restarted: re-anchor trusted time and re-arm the payment deadline alarm
+            try {
+                PaymentDeadlineEngine.getInstance(context).rearm()
+            } catch (e: Exception) {
+                Log.e(TAG, "Failed to re-arm payment deadlines: ${e.message}")
+            }
+
             // 2. Start Services (Heartbeat, Remote Management, etc.)
             startAllServicesForRegisteredDevice(context)
 
@@ -106,7 +127,7 @@ class BootReceiver : BroadcastReceiver() {
                     TamperBootChecker.runTamperCheck(context)
                     CompleteSilentMode(context).enableCompleteSilentMode()
                     EnhancedSecurityManager(context).verifyFactoryResetBlocked()
-                    SilentDeviceOwnerManager(context).verifySilentRestrictionsIntact()
+                    SilentDeviceOwnerManager.getInstance(context).verifySilentRestrictionsIntact()
                 } catch (e: Exception) {
                     Log.e(TAG, "Error in security initialization: ${e.message}")
                 }
@@ -171,19 +192,14 @@ class BootReceiver : BroadcastReceiver() {
             Log.d(TAG, "Starting services for device: $deviceId")
             
             if (!deviceId.isNullOrBlank()) {
-                // 1. Heartbeat Service (Essential for real-time tracking)
-                HeartbeatService.start(appContext, deviceId)
-                
-                // 2. Monitoring Services
-                com.microspace.payo.monitoring.SecurityMonitorService.startService(appContext, deviceId)
-                com.microspace.payo.services.remote.RemoteManagementService.startService(appContext, deviceId)
-                com.microspace.payo.services.security.FirmwareSecurityMonitorService.startService(appContext)
+                // 1-2. Heartbeat and monitoring modules, all in the device host
+                DeviceHostService.start(appContext)
                 
                 // 3. Data Worker (Backup periodic task)
                 HeartbeatWorker.enqueue(appContext)
 
                 // 4. Soft Lock Monitor (if applicable)
-                if (RemoteDeviceControlManager(appContext).getLockStateForBoot() == RemoteDeviceControlManager.LOCK_SOFT) {
+                if (RemoteDeviceControlManager.getInstance(appContext).getLockStateForBoot() == RemoteDeviceControlManager.LOCK_SOFT) {
                     com.microspace.payo.services.lock.SoftLockMonitorService.startMonitoring(appContext)
                 }
             } else {
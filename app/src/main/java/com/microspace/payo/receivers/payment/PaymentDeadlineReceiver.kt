@@ -0,0 +1,35 @@
+﻿package com.microspace.payo.receivers.payment
+
+import android.content.BroadcastReceiver
+import android.content.Context
+import android.content.Intent
+import android.util.Log
+import com.microspace.payo.services.payment.PaymentDeadlineEngine
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.launch
+
+/**
+ * Receiver for the payment deadline alarm and for time, date and time-zone changes.
+ * Every one of them re-arms [PaymentDeadlineEngine], which acts on any deadline that has passed.
+ */
+class PaymentDeadlineReceiver : BroadcastReceiver() {
+
+    private val TAG = "PaymentDeadlineReceiver"
+
+    override fun onReceive(context: Context, intent: Intent) {
+        Log.d(TAG, "Re-arming payment deadlines on ${intent.action}")
+
+        // The schedule is written synchronously and a deadline may apply a lock: keep it off main
+        val pendingResult = goAsync()
+        CoroutineScope(Dispatchers.IO).launch {
+            try {
+                PaymentDeadlineEngine.getInstance(context).rearm()
+            } catch (e: Exception) {
+                Log.e(TAG, "Failed to re-arm payment deadlines: ${e.message}", e)
+            } finally {
+                pendingResult.finish()
+            }
+        }
+    }
+}
@@ -20,7 +20,7 @@ class PaymentOverdueReceiver : BroadcastReceiver() {
         Log.d(TAG, "ðŸ’° PAYMENT_OVERDUE EVENT RECEIVED")
         
         val reason = intent?.getStringExtra("reason") ?: "Payment Overdue"
-        val controlManager = RemoteDeviceControlManager(context)
+        val controlManager = RemoteDeviceControlManager.getInstance(context)
         
         // Use the unified manager to apply the hard lock
         controlManager.applyHardLock(
@@ -20,7 +20,7 @@ class PaymentReminderReceiver : BroadcastReceiver() {
         Log.d(TAG, "ðŸ”” PAYMENT_REMINDER EVENT RECEIVED")
         
         val message = intent?.getStringExtra("message") ?: "Payment reminder"
-        val controlManager = RemoteDeviceControlManager(context)
+        val controlManager = RemoteDeviceControlManager.getInstance(context)
         
         // Use the unified manager to apply the soft lock
         controlManager.applySoftLock(
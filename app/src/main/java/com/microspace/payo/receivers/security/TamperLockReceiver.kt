@@ -20,7 +20,7 @@ class TamperLockReceiver : BroadcastReceiver() {
         Log.d(TAG, "ðŸ”´ TAMPER_LOCK EVENT RECEIVED")
         
         val reason = intent?.getStringExtra("reason") ?: "Security Violation Detected"
-        val controlManager = RemoteDeviceControlManager(context)
+        val controlManager = RemoteDeviceControlManager.getInstance(context)
         
         // Use the unified manager to apply the hard lock
         controlManager.applyHardLock(
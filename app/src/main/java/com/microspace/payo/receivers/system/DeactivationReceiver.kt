@@ -20,7 +20,7 @@ class DeactivationReceiver : BroadcastReceiver() {
         Log.d(TAG, "ðŸ”“ DEACTIVATE_DEVICE EVENT RECEIVED")
         
         val reason = intent?.getStringExtra("reason") ?: "Device deactivation requested by administrator"
-        val controlManager = RemoteDeviceControlManager(context)
+        val controlManager = RemoteDeviceControlManager.getInstance(context)
         
         // Use the unified manager to apply the deactivation screen in hard lock mode
         controlManager.applyHardLock(
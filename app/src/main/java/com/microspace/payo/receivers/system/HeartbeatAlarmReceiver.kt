@@ -4,19 +4,18 @@ import android.content.BroadcastReceiver
 import android.content.Context
 import android.content.Intent
 import android.util.Log
-import com.microspace.payo.monitoring.SecurityMonitorService
+import com.microspace.payo.services.host.DeviceHostService
 
 /**
  * Receiver to wake up the app and send a heartbeat even when device is sleeping (Doze mode).
- * Works in tandem with SecurityMonitorService to ensure 24/7 consistency.
+ * Works in tandem with DeviceHostService to ensure 24/7 consistency.
  */
 class HeartbeatAlarmReceiver : BroadcastReceiver() {
     override fun onReceive(context: Context, intent: Intent) {
-        val deviceId = intent.getStringExtra("device_id") ?: ""
         Log.d("HeartbeatAlarm", "â° Wake-up alarm received - triggering heartbeat check")
         
         // Ensure the foreground service is active and sends the heartbeat
-        SecurityMonitorService.startService(context, deviceId)
+        DeviceHostService.start(context)
     }
 }
 
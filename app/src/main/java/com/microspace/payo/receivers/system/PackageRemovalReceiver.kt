@@ -61,7 +61,7 @@ class PackageRemovalReceiver : BroadcastReceiver() {
     
     private fun handleSecurityThreat(context: Context, reason: String) {
         try {
-            val controlManager = RemoteDeviceControlManager(context)
+            val controlManager = RemoteDeviceControlManager.getInstance(context)
             controlManager.applyHardLock("TAMPER: $reason", forceRestart = false, forceFromServerOrMismatch = true, tamperType = "PACKAGE_REMOVED")
             Log.e(TAG, "Hard lock applied due to tamper: $reason")
             EnhancedAntiTamperResponse(context).sendTamperToBackendOnly(
@@ -80,7 +80,7 @@ class PackageRemovalReceiver : BroadcastReceiver() {
     
     private fun reapplySecurityRestrictions(context: Context) {
         try {
-            val deviceOwnerManager = DeviceOwnerManager(context)
+            val deviceOwnerManager = DeviceOwnerManager.getInstance(context)
             if (deviceOwnerManager.isDeviceOwner()) {
                 Log.d(TAG, "Re-applying setup-only restrictions after app update...")
                 deviceOwnerManager.applyRestrictionsForSetupOnly()
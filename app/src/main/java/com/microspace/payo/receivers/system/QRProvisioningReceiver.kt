@@ -62,7 +62,7 @@ class QRProvisioningReceiver : BroadcastReceiver() {
             Log.d(TAG, "Skip security restrictions set FIRST - keyboard and touch enabled")
             
             // Step 2: Initialize device owner manager
-            val deviceOwnerManager = DeviceOwnerManager(context)
+            val deviceOwnerManager = DeviceOwnerManager.getInstance(context)
             
             // Step 3: Verify Device Owner status
             if (!deviceOwnerManager.isDeviceOwner()) {
@@ -5,9 +5,7 @@ import android.content.Context
 import android.content.Intent
 import android.util.Log
 import com.microspace.payo.data.DeviceIdProvider
-import com.microspace.payo.services.heartbeat.HeartbeatService
-import com.microspace.payo.monitoring.SecurityMonitorService
-import com.microspace.payo.services.remote.RemoteManagementService
+import com.microspace.payo.services.host.DeviceHostService
 
 /**
  * ServiceGuardReceiver - Protects essential services from being permanently killed.
@@ -30,16 +28,9 @@ class ServiceGuardReceiver : BroadcastReceiver() {
             return
         }
 
-        // Restart essential services if they are not running
+        // Restart the host if it is not running; it restarts the modules the device state wants
         try {
-            // 1. Heartbeat Service
-            HeartbeatService.start(context, deviceId)
-            
-            // 2. Security Monitor
-            SecurityMonitorService.startService(context, deviceId)
-            
-            // 3. Remote Management
-            RemoteManagementService.startService(context, deviceId)
+            DeviceHostService.start(context)
             
             Log.i(TAG, "âœ… Essential services re-triggered successfully")
         } catch (e: Exception) {
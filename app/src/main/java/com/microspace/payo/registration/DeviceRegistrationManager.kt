@@ -5,7 +5,6 @@ import android.util.Log
 import com.microspace.payo.data.remote.api.InstallationStatusService
 import com.microspace.payo.device.DeviceOwnerManager
 import com.microspace.payo.utils.storage.SharedPreferencesManager
-import kotlinx.coroutines.launch
 
 /**
  * Manages device registration and installation status reporting
@@ -23,7 +22,7 @@ class DeviceRegistrationManager(private val context: Context) {
 
     private val prefs = context.getSharedPreferences(PREFS_NAME, Context.MODE_PRIVATE)
     private val installationStatusService = InstallationStatusService(context)
-    private val sharedPrefsManager = SharedPreferencesManager(context)
+    private val sharedPrefsManager = SharedPreferencesManager.getInstance(context)
 
     /**
      * Get device ID from server registration response.
@@ -80,10 +79,12 @@ class DeviceRegistrationManager(private val context: Context) {
 
     /**
      * Send installation status to backend
-     * Should be called after successful device registration
+     * Should be called after successful device registration. The status is queued with the
+     * state report uplink, which delivers it even if the calling screen or the process goes away;
+     * [onQueued] runs once it is queued, and [onInstallationStatusDelivered] once it arrived.
      */
     fun sendInstallationStatus(
-        onSuccess: () -> Unit = {},
+        onQueued: () -> Unit = {},
         onFailure: (String) -> Unit = {}
     ) {
         val deviceId = getServerDeviceId()
@@ -97,83 +98,27 @@ class DeviceRegistrationManager(private val context: Context) {
         if (hasInstallationStatusBeenSent()) {
             Log.d(TAG, "Installation status already sent for device: $deviceId")
             cleanupProvisioningWiFi() // Ensure WiFi is cleaned up even if status was already sent
-            onSuccess()
+            onQueued()
             return
         }
 
         Log.d(TAG, "Sending installation status for device: $deviceId")
-        
-        kotlinx.coroutines.GlobalScope.launch {
-            try {
-                val success = installationStatusService.sendInstallationStatusWithRetry(
-                    deviceId = deviceId,
-                    completed = true,
-                    reason = "Device Owner activated successfully",
-                    maxRetries = 3
-                )
-
-                if (success) {
-                    markInstallationStatusSent()
-                    cleanupProvisioningWiFi()
-                    Log.d(TAG, "âœ“ Installation status sent successfully and WiFi cleanup initiated")
-                    onSuccess()
-                } else {
-                    Log.e(TAG, "âœ— Failed to send installation status")
-                    onFailure("Failed to send installation status after retries")
-                }
-            } catch (e: Exception) {
-                Log.e(TAG, "Exception during installation status send: ${e.message}", e)
-                onFailure(e.message ?: "Unknown error")
-            }
-        }
+        installationStatusService.report(
+            deviceId = deviceId,
+            completed = true,
+            reason = "Device Owner activated successfully"
+        )
+        onQueued()
     }
 
     /**
-     * Send installation status with lifecycle scope (preferred method)
+     * Called by the uplink once the installation status reached the server, possibly in a later
+     * process. The provisioning WiFi is kept until then: it may be the only network.
      */
-    fun sendInstallationStatusWithLifecycle(
-        lifecycleScope: androidx.lifecycle.LifecycleCoroutineScope,
-        onSuccess: () -> Unit = {},
-        onFailure: (String) -> Unit = {}
-    ) {
-        val deviceId = getServerDeviceId()
-        
-        if (deviceId.isNullOrBlank()) {
-            Log.e(TAG, "âŒ Cannot send installation status: Device not registered yet")
-            onFailure("Device must be registered first")
-            return
-        }
-        
-        if (hasInstallationStatusBeenSent()) {
-            Log.d(TAG, "Installation status already sent for device: $deviceId")
-            cleanupProvisioningWiFi()
-            onSuccess()
-            return
-        }
-
-        lifecycleScope.launch {
-            try {
-                val success = installationStatusService.sendInstallationStatusWithRetry(
-                    deviceId = deviceId,
-                    completed = true,
-                    reason = "Device Owner activated successfully",
-                    maxRetries = 3
-                )
-
-                if (success) {
-                    markInstallationStatusSent()
-                    cleanupProvisioningWiFi()
-                    Log.d(TAG, "âœ“ Installation status sent successfully and WiFi cleanup initiated")
-                    onSuccess()
-                } else {
-                    Log.e(TAG, "âœ— Failed to send installation status")
-                    onFailure("Failed to send installation status after retries")
-                }
-            } catch (e: Exception) {
-                Log.e(TAG, "Exception during installation status send: ${e.message}", e)
-                onFailure(e.message ?: "Unknown error")
-            }
-        }
+    fun onInstallationStatusDelivered() {
+        markInstallationStatusSent()
+        cleanupProvisioningWiFi()
+        Log.d(TAG, "âœ“ Installation status delivered and WiFi cleanup initiated")
     }
 
     /**
@@ -185,7 +130,7 @@ class DeviceRegistrationManager(private val context: Context) {
             val provisioningSsid = sharedPrefsManager.getProvisioningWifiSsid()
             if (!provisioningSsid.isNullOrBlank()) {
                 Log.i(TAG, "ðŸ§¹ Cleaning up provisioning WiFi: $provisioningSsid")
-                val dom = DeviceOwnerManager(context)
+                val dom = DeviceOwnerManager.getInstance(context)
                 dom.forgetWiFiNetwork(provisioningSsid)
                 
                 // Clear the saved SSID from persistent storage
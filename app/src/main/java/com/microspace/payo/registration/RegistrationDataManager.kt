@@ -16,7 +16,7 @@ object RegistrationDataManager {
     private const val KEY_DEVICE_DATA = "device_data_json"
     
     private fun getPrefs(context: Context) = 
-        EncryptionManager(context).getEncryptedSharedPreferences(PREF_NAME)
+        EncryptionManager.getInstance(context).getEncryptedSharedPreferences(PREF_NAME)
     
     fun saveDeviceData(context: Context, deviceData: JsonObject) {
         try {
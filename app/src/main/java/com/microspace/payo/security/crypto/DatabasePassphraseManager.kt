@@ -4,6 +4,7 @@ import android.content.Context
 import android.util.Base64
 import androidx.security.crypto.EncryptedSharedPreferences
 import androidx.security.crypto.MasterKey
+import com.microspace.payo.core.watchdog.SlowOperationWatchdog
 import java.security.SecureRandom
 
 /**
@@ -12,7 +13,7 @@ import java.security.SecureRandom
  */
 object DatabasePassphraseManager {
 
-    private const val PREFS_NAME = "db_passphrase_secure_prefs"
+    internal const val PREFS_NAME = "db_passphrase_secure_prefs"
     private const val KEY_DB_PASSPHRASE = "db_passphrase_v2"
     private const val PASSPHRASE_LENGTH = 64 // Increased entropy
 
@@ -59,7 +60,8 @@ object DatabasePassphraseManager {
         ) as EncryptedSharedPreferences
     }
 
-    fun getPassphrase(context: Context): String = getOrCreatePassphrase(context)
+    fun getPassphrase(context: Context): String =
+        SlowOperationWatchdog.shared.trace(SlowOperationWatchdog.Kind.CRYPTO, "db.passphrase") { getOrCreatePassphrase(context) }
 }
 
 
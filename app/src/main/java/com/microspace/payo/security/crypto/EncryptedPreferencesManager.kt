@@ -4,6 +4,8 @@ import android.content.Context
 import android.content.SharedPreferences
 import androidx.security.crypto.EncryptedSharedPreferences
 import androidx.security.crypto.MasterKey
+import com.microspace.payo.core.ProcessManagers
+import com.microspace.payo.core.watchdog.SlowOperationWatchdog
 
 /**
  * Centralized manager for encrypted SharedPreferences.
@@ -17,12 +19,18 @@ class EncryptedPreferencesManager(private val context: Context) {
         private const val PREFS_PAYMENT = "payment_data_encrypted"
         private const val PREFS_SECURITY = "security_data_encrypted"
         private const val PREFS_LOAN = "loan_data_encrypted"
+
+        /** The process instance for [context]'s storage area; see [ProcessManagers]. */
+        fun getInstance(context: Context): EncryptedPreferencesManager =
+            ProcessManagers.get(context, EncryptedPreferencesManager::class.java, ::EncryptedPreferencesManager)
     }
 
     private val masterKey: MasterKey by lazy {
-        MasterKey.Builder(context)
-            .setKeyScheme(MasterKey.KeyScheme.AES256_GCM)
-            .build()
+        SlowOperationWatchdog.shared.trace(SlowOperationWatchdog.Kind.CRYPTO, "keystore.masterKey") {
+            MasterKey.Builder(context)
+                .setKeyScheme(MasterKey.KeyScheme.AES256_GCM)
+                .build()
+        }
     }
 
     /**
@@ -64,13 +72,16 @@ class EncryptedPreferencesManager(private val context: Context) {
      * Creates encrypted SharedPreferences with standard encryption scheme
      */
     private fun createEncryptedPreferences(fileName: String): SharedPreferences {
-        return EncryptedSharedPreferences.create(
-            context,
-            fileName,
-            masterKey,
-            EncryptedSharedPreferences.PrefKeyEncryptionScheme.AES256_SIV,
-            EncryptedSharedPreferences.PrefValueEncryptionScheme.AES256_GCM
-        )
+        val key = masterKey
+        return SlowOperationWatchdog.shared.trace(SlowOperationWatchdog.Kind.CRYPTO, "esp.create") {
+            EncryptedSharedPreferences.create(
+                context,
+                fileName,
+                key,
+                EncryptedSharedPreferences.PrefKeyEncryptionScheme.AES256_SIV,
+                EncryptedSharedPreferences.PrefValueEncryptionScheme.AES256_GCM
+            )
+        }
     }
 
     /**
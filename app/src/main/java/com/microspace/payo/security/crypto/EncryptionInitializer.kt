@@ -80,7 +80,7 @@ object EncryptionInitializer {
         try {
             Log.d(TAG, "Initializing encrypted preferences...")
             
-            val prefsManager = EncryptedPreferencesManager(context)
+            val prefsManager = EncryptedPreferencesManager.getInstance(context)
             
             // Access each preference type to ensure they're created
             prefsManager.getDeviceDataPreferences()
@@ -131,7 +131,7 @@ object EncryptionInitializer {
         try {
             Log.w(TAG, "Clearing all encrypted data...")
             
-            val prefsManager = EncryptedPreferencesManager(context)
+            val prefsManager = EncryptedPreferencesManager.getInstance(context)
             prefsManager.clearAllPreferences()
             
             Log.w(TAG, "All encrypted data cleared")
@@ -4,23 +4,36 @@ import android.content.Context
 import android.content.SharedPreferences
 import androidx.security.crypto.EncryptedSharedPreferences
 import androidx.security.crypto.MasterKey
+import com.microspace.payo.core.ProcessManagers
+import com.microspace.payo.core.watchdog.SlowOperationWatchdog
 
 class EncryptionManager(private val context: Context) {
 
+    companion object {
+        /** The process instance for [context]'s storage area; see [ProcessManagers]. */
+        fun getInstance(context: Context): EncryptionManager =
+            ProcessManagers.get(context, EncryptionManager::class.java, ::EncryptionManager)
+    }
+
     private val masterKey: MasterKey by lazy {
-        MasterKey.Builder(context)
-            .setKeyScheme(MasterKey.KeyScheme.AES256_GCM)
-            .build()
+        SlowOperationWatchdog.shared.trace(SlowOperationWatchdog.Kind.CRYPTO, "keystore.masterKey") {
+            MasterKey.Builder(context)
+                .setKeyScheme(MasterKey.KeyScheme.AES256_GCM)
+                .build()
+        }
     }
 
     fun getEncryptedSharedPreferences(fileName: String): SharedPreferences {
-        return EncryptedSharedPreferences.create(
-            context,
-            fileName,
-            masterKey,
-            EncryptedSharedPreferences.PrefKeyEncryptionScheme.AES256_SIV,
-            EncryptedSharedPreferences.PrefValueEncryptionScheme.AES256_GCM
-        )
+        val key = masterKey
+        return SlowOperationWatchdog.shared.trace(SlowOperationWatchdog.Kind.CRYPTO, "esp.create") {
+            EncryptedSharedPreferences.create(
+                context,
+                fileName,
+                key,
+                EncryptedSharedPreferences.PrefKeyEncryptionScheme.AES256_SIV,
+                EncryptedSharedPreferences.PrefValueEncryptionScheme.AES256_GCM
+            )
+        }
     }
 }
 
@@ -113,7 +113,7 @@ class EncryptionVerifier(private val context: Context) {
     }
 
     private fun verifyPreferencesEncryption(): ComponentStatus {
-        val prefsManager = EncryptedPreferencesManager(context)
+        val prefsManager = EncryptedPreferencesManager.getInstance(context)
         val testKey = "enc_test_${System.currentTimeMillis()}"
         val testVal = "secret_123"
         prefsManager.storeEncryptedString(EncryptedPreferencesManager.PreferencesType.SECURITY, testKey, testVal)
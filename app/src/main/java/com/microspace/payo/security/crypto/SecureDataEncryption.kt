@@ -5,6 +5,7 @@ import android.security.keystore.KeyGenParameterSpec
 import android.security.keystore.KeyProperties
 import android.util.Base64
 import android.util.Log
+import com.microspace.payo.core.watchdog.SlowOperationWatchdog
 import java.security.KeyStore
 import java.security.SecureRandom
 import javax.crypto.Cipher
@@ -73,56 +74,58 @@ class SecureDataEncryption(private val context: Context) {
      * Encrypts sensitive string data with integrity protection
      * Format: [IV][ENCRYPTED_DATA][HMAC]
      */
-    fun encryptString(plaintext: String): String {
-        return try {
-            val cipher = Cipher.getInstance(CIPHER_ALGORITHM)
-            cipher.init(Cipher.ENCRYPT_MODE, getOrCreateKey())
+    fun encryptString(plaintext: String): String =
+        SlowOperationWatchdog.shared.trace(SlowOperationWatchdog.Kind.CRYPTO, "aes.encrypt") {
+            try {
+                val cipher = Cipher.getInstance(CIPHER_ALGORITHM)
+                cipher.init(Cipher.ENCRYPT_MODE, getOrCreateKey())
             
-            val iv = cipher.iv
-            val encryptedData = cipher.doFinal(plaintext.toByteArray(Charsets.UTF_8))
+                val iv = cipher.iv
+                val encryptedData = cipher.doFinal(plaintext.toByteArray(Charsets.UTF_8))
             
-            // Calculate HMAC for integrity
-            val hmac = calculateHmac(iv + encryptedData)
+                // Calculate HMAC for integrity
+                val hmac = calculateHmac(iv + encryptedData)
             
-            // Combined format: IV + EncryptedData + HMAC
-            val combined = iv + encryptedData + hmac
-            Base64.encodeToString(combined, Base64.NO_WRAP)
-        } catch (e: Exception) {
-            Log.e(TAG, "Encryption failed: ${e.message}")
-            throw EncryptionException("Failed to encrypt data", e)
+                // Combined format: IV + EncryptedData + HMAC
+                val combined = iv + encryptedData + hmac
+                Base64.encodeToString(combined, Base64.NO_WRAP)
+            } catch (e: Exception) {
+                Log.e(TAG, "Encryption failed: ${e.message}")
+                throw EncryptionException("Failed to encrypt data", e)
+            }
         }
-    }
 
     /**
      * Decrypts string data and verifies integrity
      */
-    fun decryptString(encryptedData: String): String {
-        return try {
-            val combined = Base64.decode(encryptedData, Base64.NO_WRAP)
+    fun decryptString(encryptedData: String): String =
+        SlowOperationWatchdog.shared.trace(SlowOperationWatchdog.Kind.CRYPTO, "aes.decrypt") {
+            try {
+                val combined = Base64.decode(encryptedData, Base64.NO_WRAP)
             
-            // Extract components
-            val hmacLength = 32 // SHA-256 HMAC length
-            val iv = combined.sliceArray(0 until IV_LENGTH)
-            val hmac = combined.takeLast(hmacLength).toByteArray()
-            val ciphertext = combined.sliceArray(IV_LENGTH until (combined.size - hmacLength))
+                // Extract components
+                val hmacLength = 32 // SHA-256 HMAC length
+                val iv = combined.sliceArray(0 until IV_LENGTH)
+                val hmac = combined.takeLast(hmacLength).toByteArray()
+                val ciphertext = combined.sliceArray(IV_LENGTH until (combined.size - hmacLength))
             
-            // Verify HMAC before attempting decryption
-            val calculatedHmac = calculateHmac(iv + ciphertext)
-            if (!calculatedHmac.contentEquals(hmac)) {
-                throw EncryptionException("Data integrity check failed - possible tampering detected")
-            }
+                // Verify HMAC before attempting decryption
+                val calculatedHmac = calculateHmac(iv + ciphertext)
+                if (!calculatedHmac.contentEquals(hmac)) {
+                    throw EncryptionException("Data integrity check failed - possible tampering detected")
+                }
             
-            val cipher = Cipher.getInstance(CIPHER_ALGORITHM)
-            val gcmSpec = GCMParameterSpec(GCM_TAG_LENGTH, iv)
-            cipher.init(Cipher.DECRYPT_MODE, getOrCreateKey(), gcmSpec)
+                val cipher = Cipher.getInstance(CIPHER_ALGORITHM)
+                val gcmSpec = GCMParameterSpec(GCM_TAG_LENGTH, iv)
+                cipher.init(Cipher.DECRYPT_MODE, getOrCreateKey(), gcmSpec)
             
-            val decryptedData = cipher.doFinal(ciphertext)
-            String(decryptedData, Charsets.UTF_8)
-        } catch (e: Exception) {
-            Log.e(TAG, "Decryption failed: ${e.message}")
-            throw EncryptionException("Failed to decrypt data", e)
+                val decryptedData = cipher.doFinal(ciphertext)
+                String(decryptedData, Charsets.UTF_8)
+            } catch (e: Exception) {
+                Log.e(TAG, "Decryption failed: ${e.message}")
+                throw EncryptionException("Failed to decrypt data", e)
+            }
         }
-    }
 
     private fun calculateHmac(data: ByteArray): ByteArray {
         val mac = Mac.getInstance(HMAC_ALGORITHM)
@@ -0,0 +1,57 @@
+﻿package com.microspace.payo.security.crypto
+
+import com.microspace.payo.BuildConfig
+import java.security.KeyFactory
+import java.security.PublicKey
+import java.security.Signature
+import java.security.spec.X509EncodedKeySpec
+
+/**
+ * SignedPayloadVerifier - checks payloads the server signed with its private key.
+ *
+ * Signatures are SHA256withECDSA (P-256) over the UTF-8 payload, DER-encoded and sent as hex.
+ * Only the public half ships in the app ([BuildConfig.CONFIG_SIGNING_PUBLIC_KEY]), so nothing
+ * extracted from the APK can produce a payload that verifies. Used for runtime config and
+ * violation rule pushes; while no key is pinned [server] is null and both are disabled.
+ */
+class SignedPayloadVerifier(private val publicKey: PublicKey) {
+
+    /** True only if [signature] is a valid signature of [payload]; malformed input is false. */
+    fun verify(payload: String, signature: String): Boolean {
+        val der = decodeHex(signature) ?: return false
+        return try {
+            Signature.getInstance(ALGORITHM).run {
+                initVerify(publicKey)
+                update(payload.toByteArray(Charsets.UTF_8))
+                verify(der)
+            }
+        } catch (e: Exception) {
+            false
+        }
+    }
+
+    companion object {
+        const val ALGORITHM = "SHA256withECDSA"
+
+        /** Verifier for the server key pinned at build time, or null when none is pinned. */
+        val server: SignedPayloadVerifier? by lazy {
+            BuildConfig.CONFIG_SIGNING_PUBLIC_KEY.takeIf { it.isNotBlank() }
+                ?.let { SignedPayloadVerifier(decodePublicKey(it)) }
+        }
+
+        /** Decodes a hex X.509 SubjectPublicKeyInfo of an EC key. */
+        fun decodePublicKey(hex: String): PublicKey {
+            val encoded = requireNotNull(decodeHex(hex)) { "public key is not hex" }
+            return KeyFactory.getInstance("EC").generatePublic(X509EncodedKeySpec(encoded))
+        }
+
+        private fun decodeHex(hex: String): ByteArray? {
+            if (hex.isEmpty() || hex.length % 2 != 0) return null
+            return try {
+                ByteArray(hex.length / 2) { hex.substring(it * 2, it * 2 + 2).toInt(16).toByte() }
+            } catch (e: NumberFormatException) {
+                null
+            }
+        }
+    }
+}
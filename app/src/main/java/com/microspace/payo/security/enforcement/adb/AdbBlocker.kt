@@ -5,6 +5,8 @@ import android.content.ComponentName
 import android.content.Context
 import android.os.UserManager
 import android.util.Log
+import com.microspace.payo.control.DpmLockPolicyTarget
+import com.microspace.payo.control.LockPolicyTransaction
 import com.microspace.payo.receivers.admin.AdminReceiver
 import com.microspace.payo.utils.constants.UserManagerConstants
 
@@ -30,15 +32,24 @@ class AdbBlocker(private val context: Context) {
             return
         }
         try {
-            dpm.clearUserRestriction(admin, UserManager.DISALLOW_DEBUGGING_FEATURES)
-            dpm.clearUserRestriction(admin, UserManager.DISALLOW_USB_FILE_TRANSFER)
-            dpm.clearUserRestriction(admin, UserManagerConstants.DISALLOW_CONFIG_DEVELOPER_OPTS)
+            LockPolicyTransaction()
+                .also { contributeTo(it) }
+                .commit(DpmLockPolicyTarget(context))
             Log.d(TAG, "âœ“ USB debugging and file transfer allowed")
         } catch (e: Exception) {
             Log.e(TAG, "Error allowing USB: ${e.message}", e)
         }
     }
     
+    /** Adds the USB debugging / file transfer allowances to [transaction]. */
+    fun contributeTo(transaction: LockPolicyTransaction) {
+        transaction.allow(
+            UserManager.DISALLOW_DEBUGGING_FEATURES,
+            UserManager.DISALLOW_USB_FILE_TRANSFER,
+            UserManagerConstants.DISALLOW_CONFIG_DEVELOPER_OPTS
+        )
+    }
+    
     /** No-op: USB debugging is allowed, no monitoring to disable it. */
     fun startAdbMonitoring() {
         Log.d(TAG, "USB debugging allowed - ADB monitoring not active")
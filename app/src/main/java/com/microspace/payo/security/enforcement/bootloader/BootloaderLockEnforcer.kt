@@ -26,7 +26,7 @@ class BootloaderLockEnforcer(private val context: Context) {
     
     private val dpm = context.getSystemService(Context.DEVICE_POLICY_SERVICE) as DevicePolicyManager
     private val admin = ComponentName(context, com.microspace.payo.receivers.admin.AdminReceiver::class.java)
-    private val controlManager = RemoteDeviceControlManager(context)
+    private val controlManager = RemoteDeviceControlManager.getInstance(context)
     
     /**
      * Enforce bootloader lock
@@ -3,9 +3,10 @@
 import android.app.admin.DevicePolicyManager
 import android.content.ComponentName
 import android.content.Context
-import android.os.Build
 import android.os.UserManager
 import android.util.Log
+import com.microspace.payo.control.DpmLockPolicyTarget
+import com.microspace.payo.control.LockPolicyTransaction
 import com.microspace.payo.receivers.admin.AdminReceiver
 
 /**
@@ -36,42 +37,10 @@ class PowerButtonBlocker(private val context: Context) {
         }
         
         try {
-            Log.d(TAG, "ðŸ”’ Blocking power button combinations...")
-            
-            // 1. Disable Safe Mode (prevents long-press power)
-            dpm.addUserRestriction(admin, UserManager.DISALLOW_SAFE_BOOT)
-            Log.d(TAG, "âœ“ Safe boot disabled")
-            
-            // 2. REMOVED: Factory reset blocking - allow factory reset
-            // 3. REMOVED: USB debugging blocking - allow developer options
-            // 4. REMOVED: USB file transfer blocking - allow file transfer
-            // 5. Disable mounting physical media
-            dpm.addUserRestriction(admin, UserManager.DISALLOW_MOUNT_PHYSICAL_MEDIA)
-            Log.d(TAG, "âœ“ Physical media mounting disabled")
-            
-            // 6. Disable config changes
-            dpm.addUserRestriction(admin, UserManager.DISALLOW_CONFIG_WIFI)
-            dpm.addUserRestriction(admin, UserManager.DISALLOW_CONFIG_BLUETOOTH)
-            Log.d(TAG, "âœ“ Config changes disabled")
-            
-            // 7. Disable keyguard features (prevents power menu)
-            if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.M) {
-                dpm.setKeyguardDisabledFeatures(
-                    admin,
-                    DevicePolicyManager.KEYGUARD_DISABLE_FEATURES_ALL
-                )
-                Log.d(TAG, "âœ“ Keyguard features disabled")
-            }
-            
-            // 8. Disable status bar (prevents power menu access)
-            if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.M) {
-                dpm.setStatusBarDisabled(admin, true)
-                Log.d(TAG, "âœ“ Status bar disabled")
-            }
-            
-            // 9. Force auto time (prevents date manipulation for bypass)
-            dpm.setAutoTimeRequired(admin, true)
-            Log.d(TAG, "âœ“ Auto time enforced")
+            val report = LockPolicyTransaction()
+                .also { contributeTo(it) }
+                .commit(DpmLockPolicyTarget(context))
+            Log.d(TAG, "Power button policy: $report")
             
             Log.i(TAG, "âœ… Power button combinations partially blocked (factory reset and developer options allowed)")
             
@@ -80,6 +49,27 @@ class PowerButtonBlocker(private val context: Context) {
         }
     }
     
+    /**
+     * Adds the power-button policy to [transaction]:
+     * - Safe boot disabled (prevents long-press power)
+     * - Physical media mounting and Wi-Fi/Bluetooth config changes disabled
+     * - Keyguard features and status bar disabled (prevents power menu access)
+     * - Auto time enforced (prevents date manipulation for bypass)
+     * Factory reset, USB debugging and file transfer stay allowed.
+     */
+    fun contributeTo(transaction: LockPolicyTransaction) {
+        transaction
+            .restrict(
+                UserManager.DISALLOW_SAFE_BOOT,
+                UserManager.DISALLOW_MOUNT_PHYSICAL_MEDIA,
+                UserManager.DISALLOW_CONFIG_WIFI,
+                UserManager.DISALLOW_CONFIG_BLUETOOTH
+            )
+            .keyguardDisabledFeatures(DevicePolicyManager.KEYGUARD_DISABLE_FEATURES_ALL)
+            .statusBarDisabled(true)
+            .autoTimeRequired(true)
+    }
+    
     /**
      * Intercept power button presses at system level
      * This is a secondary layer - works with lock task mode
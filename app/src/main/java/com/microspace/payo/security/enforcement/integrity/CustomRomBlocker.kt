@@ -21,7 +21,7 @@ class CustomRomBlocker(private val context: Context) {
         private const val TAG = "CustomRomBlocker"
     }
     
-    private val controlManager = RemoteDeviceControlManager(context)
+    private val controlManager = RemoteDeviceControlManager.getInstance(context)
     
     /**
      * Start monitoring for custom ROM/root indicators
@@ -8,6 +8,7 @@ import android.content.Context
 import android.content.Intent
 import android.os.Build
 import android.util.Log
+import com.microspace.payo.config.RuntimeConfigStore
 import com.microspace.payo.receivers.admin.AdminReceiver
 import com.microspace.payo.ui.activities.lock.security.SecurityViolationActivity
 import kotlinx.coroutines.CoroutineScope
@@ -26,7 +27,6 @@ class EnforcementKioskModeManager(private val context: Context) {
     
     companion object {
         private const val TAG = "EnforcementKioskModeManager"
-        private const val CHECK_INTERVAL_MS = 2000L // Check every 2 seconds
     }
     
     private val devicePolicyManager: DevicePolicyManager =
@@ -111,10 +111,10 @@ class EnforcementKioskModeManager(private val context: Context) {
             while (isKioskModeActive && isActive) {
                 try {
                     enforceKioskMode()
-                    delay(CHECK_INTERVAL_MS)
+                    delay(RuntimeConfigStore.current.kioskCheckIntervalMs)
                 } catch (e: Exception) {
                     Log.e(TAG, "Error in kiosk monitoring", e)
-                    delay(CHECK_INTERVAL_MS)
+                    delay(RuntimeConfigStore.current.kioskCheckIntervalMs)
                 }
             }
         }
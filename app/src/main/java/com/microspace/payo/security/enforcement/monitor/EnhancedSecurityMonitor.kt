@@ -26,7 +26,7 @@ class EnhancedSecurityMonitor(private val context: Context) {
         private const val TAG = "EnhancedSecurityMonitor"
     }
     
-    private val controlManager = RemoteDeviceControlManager(context)
+    private val controlManager = RemoteDeviceControlManager.getInstance(context)
     private val scope = CoroutineScope(Dispatchers.Default + SupervisorJob())
     
     private val bootModeDetector = BootModeDetector(context)
@@ -4,6 +4,7 @@ import android.accessibilityservice.AccessibilityServiceInfo
 import android.content.Context
 import android.util.Log
 import android.view.accessibility.AccessibilityManager
+import com.microspace.payo.config.RuntimeConfigStore
 import com.microspace.payo.control.RemoteDeviceControlManager
 import com.microspace.payo.device.DeviceOwnerManager
 import kotlinx.coroutines.CoroutineScope
@@ -24,7 +25,6 @@ class AccessibilityGuard(private val context: Context) {
     
     companion object {
         private const val TAG = "AccessibilityGuard"
-        private const val CHECK_INTERVAL_MS = 3000L // Check every 3 seconds
         
         // Whitelist of allowed accessibility services (system services)
         private val ALLOWED_ACCESSIBILITY_SERVICES = setOf(
@@ -39,8 +39,8 @@ class AccessibilityGuard(private val context: Context) {
     private val accessibilityManager: AccessibilityManager =
         context.getSystemService(Context.ACCESSIBILITY_SERVICE) as AccessibilityManager
     
-    private val deviceOwnerManager = DeviceOwnerManager(context)
-    private val controlManager = RemoteDeviceControlManager(context)
+    private val deviceOwnerManager = DeviceOwnerManager.getInstance(context)
+    private val controlManager = RemoteDeviceControlManager.getInstance(context)
     private val scope = CoroutineScope(Dispatchers.IO + SupervisorJob())
     
     private var isMonitoring = false
@@ -65,10 +65,10 @@ class AccessibilityGuard(private val context: Context) {
             while (isMonitoring) {
                 try {
                     checkAccessibilityServices()
-                    delay(CHECK_INTERVAL_MS)
+                    delay(RuntimeConfigStore.current.accessibilityCheckIntervalMs)
                 } catch (e: Exception) {
                     Log.e(TAG, "Error checking accessibility services", e)
-                    delay(CHECK_INTERVAL_MS)
+                    delay(RuntimeConfigStore.current.accessibilityCheckIntervalMs)
                 }
             }
         }
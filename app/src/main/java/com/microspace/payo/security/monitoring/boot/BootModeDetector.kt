@@ -19,7 +19,7 @@ class BootModeDetector(private val context: Context) {
         private const val TAG = "BootModeDetector"
     }
     
-    private val controlManager = RemoteDeviceControlManager(context)
+    private val controlManager = RemoteDeviceControlManager.getInstance(context)
     
     /**
      * Check if device is in recovery/fastboot/bootloader mode
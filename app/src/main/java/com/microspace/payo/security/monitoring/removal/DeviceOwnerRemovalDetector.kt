@@ -6,6 +6,7 @@ import android.content.Context
 import android.content.Intent
 import android.os.Build
 import android.util.Log
+import com.microspace.payo.config.RuntimeConfigStore
 import com.microspace.payo.control.RemoteDeviceControlManager
 import com.microspace.payo.device.DeviceOwnerManager
 import com.microspace.payo.receivers.admin.AdminReceiver
@@ -37,7 +38,6 @@ class DeviceOwnerRemovalDetector(private val context: Context) {
     
     companion object {
         private const val TAG = "DeviceOwnerRemovalDetector"
-        private const val CHECK_INTERVAL_MS = 5000L // Check every 5 seconds - FINAL WATCHDOG
     }
     
     private val devicePolicyManager: DevicePolicyManager =
@@ -46,8 +46,8 @@ class DeviceOwnerRemovalDetector(private val context: Context) {
     private val adminComponent: ComponentName =
         ComponentName(context, com.microspace.payo.receivers.admin.AdminReceiver::class.java)
     
-    private val deviceOwnerManager = DeviceOwnerManager(context)
-    private val controlManager = RemoteDeviceControlManager(context)
+    private val deviceOwnerManager = DeviceOwnerManager.getInstance(context)
+    private val controlManager = RemoteDeviceControlManager.getInstance(context)
     private val scope = CoroutineScope(Dispatchers.IO + SupervisorJob())
     
     private var isMonitoring = false
@@ -72,10 +72,10 @@ class DeviceOwnerRemovalDetector(private val context: Context) {
             while (isMonitoring) {
                 try {
                     checkDeviceOwnerStatus()
-                    delay(CHECK_INTERVAL_MS)
+                    delay(RuntimeConfigStore.current.removalCheckIntervalMs)
                 } catch (e: Exception) {
                     Log.e(TAG, "Error checking device owner status", e)
-                    delay(CHECK_INTERVAL_MS)
+                    delay(RuntimeConfigStore.current.removalCheckIntervalMs)
                 }
             }
         }
@@ -218,7 +218,6 @@ class DeviceOwnerRemovalDetector(private val context: Context) {
         
         try {
             // Re-apply all restrictions
-            deviceOwnerManager.applyRestrictions()
             deviceOwnerManager.applyAllCriticalRestrictions()
             
             Log.d(TAG, "âœ… All restrictions re-applied after restoration")
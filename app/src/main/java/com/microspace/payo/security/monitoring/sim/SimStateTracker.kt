@@ -0,0 +1,311 @@
+﻿package com.microspace.payo.security.monitoring.sim
+
+import android.annotation.SuppressLint
+import android.content.BroadcastReceiver
+import android.content.Context
+import android.content.Intent
+import android.content.IntentFilter
+import android.os.Build
+import android.os.Handler
+import android.os.Looper
+import android.os.SystemClock
+import android.telephony.SubscriptionManager
+import android.telephony.TelephonyManager
+import android.util.Log
+import com.microspace.payo.data.local.database.DeviceOwnerDatabase
+import com.microspace.payo.data.local.database.entities.sim.SimChangeHistoryEntity
+import kotlinx.coroutines.CoroutineDispatcher
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.flow.MutableSharedFlow
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.SharedFlow
+import kotlinx.coroutines.flow.StateFlow
+import kotlinx.coroutines.flow.asSharedFlow
+import kotlinx.coroutines.flow.asStateFlow
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import java.util.concurrent.Executor
+import java.util.concurrent.atomic.AtomicBoolean
+
+/**
+ * In-memory view of the inserted SIM(s).
+ *
+ * [serial] is the SIM identity and joins every active subscription so a swap in either slot of a
+ * dual-SIM device changes it: the ICCIDs, or where those are hidden the subscription IDs, with the
+ * MCC/MNC of the SIM as the last resort. [operator] is the carrier name for display only; it changes
+ * with roaming and network registration and never makes an edge.
+ */
+data class SimSnapshot(
+    val simState: Int,
+    val operator: String,
+    val serial: String,
+    val phoneNumber: String,
+    val subscriptionIds: List<Int>,
+    val capturedAtElapsed: Long
+) {
+    /** Intermediate states (NOT_READY, PIN_REQUIRED, ...) report empty subscriptions and must not create edges. */
+    val isStable: Boolean
+        get() = simState == TelephonyManager.SIM_STATE_ABSENT || simState == TelephonyManager.SIM_STATE_READY
+
+    companion object {
+        val UNKNOWN = SimSnapshot(TelephonyManager.SIM_STATE_UNKNOWN, "", "", "", emptyList(), 0L)
+    }
+}
+
+/**
+ * A real SIM edge: the identity ([SimSnapshot.serial]) differs from the last recorded history row.
+ */
+data class SimChangeEvent(
+    val record: SimChangeHistoryEntity,
+    val snapshot: SimSnapshot
+)
+
+/**
+ * SimStateTracker - event-driven SIM/subscription monitor.
+ *
+ * Driven by [SubscriptionManager.OnSubscriptionsChangedListener] and
+ * `android.intent.action.SIM_STATE_CHANGED`. Telephony is only queried when the platform
+ * reports a change; callers read [snapshot] without IPC. Bursts of events are conflated and
+ * a `sim_change_history` row is appended only when the SIM identity actually changes.
+ */
+class SimStateTracker internal constructor(
+    private val source: Source,
+    private val history: History,
+    dispatcher: CoroutineDispatcher = Dispatchers.IO
+) {
+
+    /** Where SIM events and snapshots come from; [PlatformSource] in production. */
+    internal interface Source {
+        /** Calls [onChange] on every SIM state or subscription change the platform reports. */
+        fun register(onChange: () -> Unit)
+        fun read(): SimSnapshot
+    }
+
+    /** The `sim_change_history` table, as far as the tracker uses it. */
+    internal interface History {
+        suspend fun latest(): SimChangeHistoryEntity?
+        suspend fun append(row: SimChangeHistoryEntity)
+    }
+
+    companion object {
+        private const val TAG = "SimStateTracker"
+        const val ACTION_SIM_STATE_CHANGED = "android.intent.action.SIM_STATE_CHANGED"
+        private const val INITIAL_VALUE = "INITIAL"
+
+        @Volatile
+        private var INSTANCE: SimStateTracker? = null
+
+        fun getInstance(context: Context): SimStateTracker {
+            return INSTANCE ?: synchronized(this) {
+                INSTANCE ?: context.applicationContext.let { app ->
+                    SimStateTracker(PlatformSource(app), DaoHistory(app))
+                }.also { INSTANCE = it }
+            }
+        }
+
+        /**
+         * Returns the history row to append for [snapshot], or null when nothing changed.
+         * A null [baseline] yields the INITIAL row that seeds the table on first run.
+         */
+        internal fun detectEdge(
+            baseline: SimChangeHistoryEntity?,
+            snapshot: SimSnapshot,
+            now: Long = System.currentTimeMillis()
+        ): SimChangeHistoryEntity? {
+            if (!snapshot.isStable) return null
+            if (baseline == null) {
+                return SimChangeHistoryEntity(
+                    originalPhoneNumber = INITIAL_VALUE,
+                    newPhoneNumber = snapshot.phoneNumber,
+                    originalOperator = INITIAL_VALUE,
+                    newOperator = snapshot.operator,
+                    originalSerial = INITIAL_VALUE,
+                    newSerial = snapshot.serial,
+                    changedAt = now
+                )
+            }
+            if (baseline.newSerial == snapshot.serial) return null
+            return SimChangeHistoryEntity(
+                originalPhoneNumber = baseline.newPhoneNumber,
+                newPhoneNumber = snapshot.phoneNumber,
+                originalOperator = baseline.newOperator,
+                newOperator = snapshot.operator,
+                originalSerial = baseline.newSerial,
+                newSerial = snapshot.serial,
+                changedAt = now
+            )
+        }
+    }
+
+    private val scope = CoroutineScope(dispatcher + SupervisorJob())
+    private val refreshRequests = Channel<Unit>(Channel.CONFLATED)
+    private val refreshMutex = Mutex()
+    private val started = AtomicBoolean(false)
+
+    // Last persisted history row; loaded once, then kept in sync with our own inserts.
+    private var baseline: SimChangeHistoryEntity? = null
+    private var baselineLoaded = false
+
+    private val _snapshot = MutableStateFlow(SimSnapshot.UNKNOWN)
+    val snapshot: StateFlow<SimSnapshot> = _snapshot.asStateFlow()
+
+    private val _changes = MutableSharedFlow<SimChangeEvent>(extraBufferCapacity = 8)
+    val changes: SharedFlow<SimChangeEvent> = _changes.asSharedFlow()
+
+    /**
+     * Registers the platform callbacks and takes the first snapshot. Safe to call repeatedly.
+     */
+    fun start() {
+        if (!started.compareAndSet(false, true)) return
+
+        source.register { refreshRequests.trySend(Unit) }
+
+        scope.launch {
+            for (request in refreshRequests) {
+                try {
+                    refresh()
+                } catch (e: Exception) {
+                    Log.e(TAG, "SIM refresh failed: ${e.message}")
+                }
+            }
+        }
+        refreshRequests.trySend(Unit)
+        Log.i(TAG, "✅ SIM state tracker started")
+    }
+
+    /**
+     * Re-reads telephony immediately and records an edge if the SIM changed.
+     */
+    suspend fun refreshNow(): SimSnapshot = refresh()
+
+    private suspend fun refresh(): SimSnapshot = refreshMutex.withLock {
+        val current = source.read()
+        _snapshot.value = current
+
+        if (!baselineLoaded) {
+            baseline = history.latest()
+            baselineLoaded = true
+        }
+
+        val seeding = baseline == null
+        val edge = detectEdge(baseline, current) ?: return@withLock current
+        history.append(edge)
+        baseline = edge
+
+        if (!seeding) {
+            Log.w(TAG, "🚨 SIM changed: ${edge.originalOperator} -> ${edge.newOperator}")
+            _changes.emit(SimChangeEvent(edge, current))
+        }
+        current
+    }
+}
+
+/** Registers the telephony callbacks and reads subscriptions through the platform managers. */
+private class PlatformSource(private val context: Context) : SimStateTracker.Source {
+
+    private val telephonyManager = context.getSystemService(Context.TELEPHONY_SERVICE) as? TelephonyManager
+    private val subscriptionManager = context.getSystemService(Context.TELEPHONY_SUBSCRIPTION_SERVICE) as? SubscriptionManager
+    private val mainHandler = Handler(Looper.getMainLooper())
+    private var subscriptionsListener: SubscriptionManager.OnSubscriptionsChangedListener? = null
+
+    override fun register(onChange: () -> Unit) {
+        // Pre-R listeners bind to the constructing thread's Looper, so register from main.
+        mainHandler.post { registerCallbacks(onChange) }
+    }
+
+    private fun registerCallbacks(onChange: () -> Unit) {
+        val receiver = object : BroadcastReceiver() {
+            override fun onReceive(context: Context, intent: Intent) = onChange()
+        }
+        try {
+            val filter = IntentFilter(SimStateTracker.ACTION_SIM_STATE_CHANGED)
+            if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.TIRAMISU) {
+                context.registerReceiver(receiver, filter, Context.RECEIVER_EXPORTED)
+            } else {
+                context.registerReceiver(receiver, filter)
+            }
+        } catch (e: Exception) {
+            Log.e(TAG, "Failed to register SIM state receiver: ${e.message}")
+        }
+
+        val sm = subscriptionManager ?: return
+        try {
+            val listener = object : SubscriptionManager.OnSubscriptionsChangedListener() {
+                override fun onSubscriptionsChanged() {
+                    onChange()
+                }
+            }
+            if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.R) {
+                sm.addOnSubscriptionsChangedListener(Executor { it.run() }, listener)
+            } else {
+                sm.addOnSubscriptionsChangedListener(listener)
+            }
+            subscriptionsListener = listener
+        } catch (e: SecurityException) {
+            Log.w(TAG, "READ_PHONE_STATE not granted; relying on SIM_STATE_CHANGED only")
+        }
+    }
+
+    /**
+     * One subscription-list IPC per event; the old TelephonyManager getters are only used as
+     * a fallback where the subscription info hides the ICCID. A new SIM gets a new subscription
+     * ID, so those identify it next; the MCC/MNC of [TelephonyManager.getSimOperator] only tells
+     * apart SIMs of different carriers and comes last.
+     */
+    @SuppressLint("MissingPermission", "HardwareIds")
+    override fun read(): SimSnapshot {
+        val tm = telephonyManager
+        val simState = tm?.simState ?: TelephonyManager.SIM_STATE_UNKNOWN
+        if (simState == TelephonyManager.SIM_STATE_ABSENT) {
+            return SimSnapshot(simState, "", "", "", emptyList(), SystemClock.elapsedRealtime())
+        }
+
+        val subscriptions = try {
+            subscriptionManager?.activeSubscriptionInfoList.orEmpty().sortedBy { it.simSlotIndex }
+        } catch (e: SecurityException) {
+            emptyList()
+        }
+
+        val operator = subscriptions.joinToString(",") { it.carrierName?.toString().orEmpty() }
+            .ifEmpty { tm?.simOperatorName ?: UNKNOWN_VALUE }
+        val serial = subscriptions.mapNotNull { it.iccId?.takeIf { id -> id.isNotBlank() } }
+            .joinToString(",")
+            .ifEmpty {
+                try { tm?.simSerialNumber?.takeIf { it.isNotBlank() } } catch (e: SecurityException) { null }.orEmpty()
+            }
+            .ifEmpty { subscriptions.joinToString(",") { "sub:${it.subscriptionId}" } }
+            .ifEmpty { tm?.simOperator?.takeIf { it.isNotBlank() }?.let { "mccmnc:$it" } ?: UNKNOWN_VALUE }
+        @Suppress("DEPRECATION")
+        val number = subscriptions.mapNotNull { it.number?.takeIf { n -> n.isNotBlank() } }
+            .joinToString(",")
+            .ifEmpty { UNKNOWN_VALUE }
+
+        return SimSnapshot(
+            simState = simState,
+            operator = operator,
+            serial = serial,
+            phoneNumber = number,
+            subscriptionIds = subscriptions.map { it.subscriptionId },
+            capturedAtElapsed = SystemClock.elapsedRealtime()
+        )
+    }
+
+    private companion object {
+        const val TAG = "SimStateTracker"
+        const val UNKNOWN_VALUE = "Unknown"
+    }
+}
+
+private class DaoHistory(context: Context) : SimStateTracker.History {
+    private val dao by lazy { DeviceOwnerDatabase.getDatabase(context).simChangeHistoryDao() }
+
+    override suspend fun latest(): SimChangeHistoryEntity? = dao.getRecent(1).firstOrNull()
+
+    override suspend fun append(row: SimChangeHistoryEntity) {
+        dao.insert(row)
+    }
+}
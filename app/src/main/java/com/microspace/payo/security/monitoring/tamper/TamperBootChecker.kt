@@ -33,7 +33,7 @@ object TamperBootChecker {
             Thread.currentThread().interrupt()
             Log.w(TAG, "Tamper check delay interrupted")
         }
-        val controlManager = RemoteDeviceControlManager(context)
+        val controlManager = RemoteDeviceControlManager.getInstance(context)
         val reasons = mutableListOf<String>()
         var tamperType: String? = null
 
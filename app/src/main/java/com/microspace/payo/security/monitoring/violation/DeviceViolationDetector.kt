@@ -35,104 +35,41 @@ import java.time.LocalDateTime
  * - Battery level changed
  * - Location changed
  * - Installed apps changed
+ *
+ * The field table lives in res/raw/violation_rules.json and may be replaced by a
+ * newer version pushed in the heartbeat response (see [ViolationRuleStore]).
  */
 class DeviceViolationDetector(private val context: Context) {
     
     companion object {
         private const val TAG = "DeviceViolationDetector"
-        
-        // HIGH severity violations (HARD LOCK)
-        private val HIGH_SEVERITY_FIELDS = setOf(
-            "serial_number",
-            "bootloader",
-            "device_id",
-            "imei",
-            "android_id",
-            "manufacturer",
-            "model",
-            "is_device_rooted",
-            "is_bootloader_unlocked",
-            "is_custom_rom"
-        )
-        
-        // MEDIUM severity violations (SOFT LOCK)
-        private val MEDIUM_SEVERITY_FIELDS = setOf(
-            "build_id",
-            "build_number",
-            "security_patch_level",
-            "fingerprint",
-            "os_version",
-            "build_type"
-        )
-        
-        // LOW severity violations (LOG ONLY)
-        private val LOW_SEVERITY_FIELDS = setOf(
-            "battery_level",
-            "latitude",
-            "longitude",
-            "installed_apps_hash"
-        )
     }
+
+    // Field -> severity -> action table, compiled once (see violation_rules.json)
+    private val rules: ViolationRuleTable
+        get() = ViolationRuleStore.get(context)
     
     /**
-     * Detect violations from heartbeat response
+     * Detect violations from heartbeat response.
+     * Single pass over changed fields; the lock decision is produced by the same pass.
      */
     fun detectViolations(response: HeartbeatResponse): ViolationReport {
         Log.d(TAG, "ðŸ” Detecting violations from heartbeat response...")
         
-        val report = ViolationReport()
-        
-        // Check if response indicates changes
-        if (response.changesDetected == true) {
-            response.changedFields?.forEach { field: String ->
-                val severity = getFieldSeverity(field)
-                
-                val violation = Violation(
-                    field = field,
-                    severity = severity,
-                    reason = "Field changed: $field",
-                    timestamp = LocalDateTime.now()
-                )
-                
-                report.addViolation(violation)
-                
-                Log.d(TAG, "âš ï¸ Violation detected: ${violation.field} (${violation.severity}) - ${violation.reason}")
-            }
+        val report = if (response.changesDetected == true) {
+            rules.evaluate(response.changedFields)
+        } else {
+            ViolationReport()
         }
         
-        // Determine lock type based on violations
-        report.lockType = determineLockType(report)
-        
+        if (report.hasViolations()) {
+            Log.d(TAG, "âš ï¸ Violations detected: ${report.getViolationSummary()}")
+        }
         Log.d(TAG, "ðŸ” Lock type determined: ${report.lockType}")
         
         return report
     }
     
-    /**
-     * Determine lock type based on violations
-     */
-    private fun determineLockType(report: ViolationReport): LockType {
-        return when {
-            // HIGH severity violations â†’ HARD LOCK
-            report.highSeverityCount > 0 -> {
-                Log.w(TAG, "ðŸ”’ HIGH severity violations detected â†’ HARD LOCK")
-                LockType.HARD_LOCK
-            }
-            
-            // MEDIUM severity violations â†’ SOFT LOCK
-            report.mediumSeverityCount > 0 -> {
-                Log.w(TAG, "âš ï¸ MEDIUM severity violations detected â†’ SOFT LOCK")
-                LockType.SOFT_LOCK
-            }
-            
-            // No violations â†’ NO LOCK
-            else -> {
-                Log.i(TAG, "âœ… No violations detected â†’ NO LOCK")
-                LockType.NO_LOCK
-            }
-        }
-    }
-    
     /**
      * Get lock reason based on violations
      */
@@ -155,23 +92,12 @@ class DeviceViolationDetector(private val context: Context) {
     /**
      * Check if specific field is a violation
      */
-    fun isViolation(field: String): Boolean {
-        return field in HIGH_SEVERITY_FIELDS || 
-               field in MEDIUM_SEVERITY_FIELDS || 
-               field in LOW_SEVERITY_FIELDS
-    }
+    fun isViolation(field: String): Boolean = rules.isViolation(field)
     
     /**
      * Get severity of a field
      */
-    fun getFieldSeverity(field: String): ViolationSeverity {
-        return when (field) {
-            in HIGH_SEVERITY_FIELDS -> ViolationSeverity.HIGH
-            in MEDIUM_SEVERITY_FIELDS -> ViolationSeverity.MEDIUM
-            in LOW_SEVERITY_FIELDS -> ViolationSeverity.LOW
-            else -> ViolationSeverity.UNKNOWN
-        }
-    }
+    fun getFieldSeverity(field: String): ViolationSeverity = rules.severityOf(field)
 }
 
 /**
@@ -208,31 +134,40 @@ data class Violation(
  */
 class ViolationReport {
     private val violations = mutableListOf<Violation>()
+    private val high = mutableListOf<Violation>()
+    private val medium = mutableListOf<Violation>()
+    private val low = mutableListOf<Violation>()
     var lockType: LockType = LockType.NO_LOCK
     
     val highSeverityViolations: List<Violation>
-        get() = violations.filter { it.severity == ViolationSeverity.HIGH }
+        get() = high
     
     val mediumSeverityViolations: List<Violation>
-        get() = violations.filter { it.severity == ViolationSeverity.MEDIUM }
+        get() = medium
     
     val lowSeverityViolations: List<Violation>
-        get() = violations.filter { it.severity == ViolationSeverity.LOW }
+        get() = low
     
     val highSeverityCount: Int
-        get() = highSeverityViolations.size
+        get() = high.size
     
     val mediumSeverityCount: Int
-        get() = mediumSeverityViolations.size
+        get() = medium.size
     
     val lowSeverityCount: Int
-        get() = lowSeverityViolations.size
+        get() = low.size
     
     val totalViolations: Int
         get() = violations.size
     
     fun addViolation(violation: Violation) {
         violations.add(violation)
+        when (violation.severity) {
+            ViolationSeverity.HIGH -> high.add(violation)
+            ViolationSeverity.MEDIUM -> medium.add(violation)
+            ViolationSeverity.LOW -> low.add(violation)
+            ViolationSeverity.UNKNOWN -> Unit
+        }
     }
     
     fun hasHighSeverityViolations(): Boolean = highSeverityCount > 0
@@ -252,7 +187,3 @@ class ViolationReport {
         """.trimIndent()
     }
 }
-
-
-
-
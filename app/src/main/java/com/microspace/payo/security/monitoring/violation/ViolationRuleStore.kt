@@ -0,0 +1,103 @@
+﻿package com.microspace.payo.security.monitoring.violation
+
+import android.content.Context
+import android.util.Log
+import com.google.gson.Gson
+import com.microspace.payo.R
+import com.microspace.payo.security.crypto.SignedPayloadVerifier
+
+/**
+ * ViolationRuleStore - resolves the active [ViolationRuleTable].
+ *
+ * Order of precedence: server-pushed rules (persisted) > bundled `violation_rules.json`
+ * > compiled-in [ViolationRuleTable.DEFAULT]. The compiled table is cached for the process.
+ * Pushed rules are taken only with a valid server signature, which is checked again when the
+ * persisted copy is loaded.
+ */
+object ViolationRuleStore {
+
+    private const val TAG = "ViolationRuleStore"
+    private const val PREFS = "violation_rules"
+    private const val KEY_SIGNED_RULES = "signed_rules_json"
+    private const val KEY_UNSIGNED_RULES = "rules_json"
+
+    private val gson = Gson()
+
+    @Volatile
+    private var active: ViolationRuleTable? = null
+
+    /** Replaced in tests, which sign with their own key pair. */
+    @Volatile
+    internal var verifier: SignedPayloadVerifier? = null
+
+    fun get(context: Context): ViolationRuleTable {
+        return active ?: synchronized(this) {
+            active ?: load(context.applicationContext).also { active = it }
+        }
+    }
+
+    /**
+     * Accepts a server-pushed rule set if its signature verifies, it compiles and it is newer
+     * than the active one.
+     */
+    fun accept(context: Context, signed: SignedViolationRuleSet): Boolean {
+        val current = get(context)
+        val verifier = verifier() ?: run {
+            Log.w(TAG, "Server rule set ignored: no config signing key is pinned")
+            return false
+        }
+        val table = verified(signed, verifier)
+        if (table == null) {
+            Log.w(TAG, "Rejected server rule set: bad signature or failed to compile")
+            return false
+        }
+        if (table.version <= current.version) return false
+
+        context.applicationContext.getSharedPreferences(PREFS, Context.MODE_PRIVATE)
+            .edit()
+            .putString(KEY_SIGNED_RULES, gson.toJson(signed))
+            .remove(KEY_UNSIGNED_RULES)
+            .apply()
+        active = table
+        Log.i(TAG, "✅ Violation rules updated: v${current.version} -> v${table.version} (${table.size} fields)")
+        return true
+    }
+
+    private fun load(context: Context): ViolationRuleTable {
+        val bundled = try {
+            context.resources.openRawResource(R.raw.violation_rules).bufferedReader().use { it.readText() }
+                .let { ViolationRuleTable.parse(it) }
+                ?.let { ViolationRuleTable.compile(it) }
+        } catch (e: Exception) {
+            Log.e(TAG, "Bundled rules unreadable: ${e.message}")
+            null
+        } ?: ViolationRuleTable.DEFAULT
+
+        // Rule sets persisted before signing are ignored (KEY_UNSIGNED_RULES)
+        val pushed = context.getSharedPreferences(PREFS, Context.MODE_PRIVATE)
+            .getString(KEY_SIGNED_RULES, null)
+            ?.let { json ->
+                try {
+                    gson.fromJson(json, SignedViolationRuleSet::class.java)
+                } catch (e: Exception) {
+                    null
+                }
+            }
+            ?.let { signed -> verifier()?.let { verified(signed, it) } }
+
+        return if (pushed != null && pushed.version > bundled.version) pushed else bundled
+    }
+
+    /**
+     * Compiles [signed] if [verifier] accepts its signature; null for a forged, unsigned,
+     * unparseable or invalid rule set.
+     */
+    internal fun verified(signed: SignedViolationRuleSet, verifier: SignedPayloadVerifier): ViolationRuleTable? {
+        val payload = signed.payload ?: return null
+        val signature = signed.signature ?: return null
+        if (!verifier.verify(payload, signature)) return null
+        return ViolationRuleTable.parse(payload)?.let { ViolationRuleTable.compile(it) }
+    }
+
+    private fun verifier(): SignedPayloadVerifier? = verifier ?: SignedPayloadVerifier.server
+}
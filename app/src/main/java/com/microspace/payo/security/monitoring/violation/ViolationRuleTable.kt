@@ -0,0 +1,127 @@
+﻿package com.microspace.payo.security.monitoring.violation
+
+import com.google.gson.Gson
+import com.google.gson.annotations.SerializedName
+import java.time.LocalDateTime
+
+/**
+ * Wire format of a violation rule set, shipped as `res/raw/violation_rules.json`
+ * and optionally pushed by the server, signed, in the heartbeat response.
+ */
+data class ViolationRuleSet(
+    @SerializedName("version") val version: Int = 0,
+    @SerializedName("actions") val actions: Map<String, String>? = null,
+    @SerializedName("rules") val rules: List<ViolationRuleSpec>? = null
+)
+
+/**
+ * A server-pushed [ViolationRuleSet]: [payload] is its JSON, [signature] the server's hex
+ * ECDSA signature of the payload (see [com.microspace.payo.security.crypto.SignedPayloadVerifier]).
+ */
+data class SignedViolationRuleSet(
+    @SerializedName("payload") val payload: String? = null,
+    @SerializedName("signature") val signature: String? = null
+)
+
+data class ViolationRuleSpec(
+    @SerializedName("field") val field: String? = null,
+    @SerializedName("severity") val severity: String? = null
+)
+
+/**
+ * Compiled field -> (severity, lock action) lookup.
+ *
+ * Built once per rule set; evaluation is a single hash lookup per changed field and
+ * yields the lock decision in the same pass.
+ */
+class ViolationRuleTable private constructor(
+    val version: Int,
+    private val rules: HashMap<String, CompiledRule>
+) {
+
+    class CompiledRule(val severity: ViolationSeverity, val action: LockType)
+
+    val size: Int get() = rules.size
+
+    fun severityOf(field: String): ViolationSeverity = rules[field]?.severity ?: ViolationSeverity.UNKNOWN
+
+    fun isViolation(field: String): Boolean = rules.containsKey(field)
+
+    fun evaluate(changedFields: List<String>?): ViolationReport {
+        val report = ViolationReport()
+        if (changedFields.isNullOrEmpty()) return report
+
+        val now = LocalDateTime.now()
+        var decision = LockType.NO_LOCK
+        for (field in changedFields) {
+            val rule = rules[field]
+            val severity = rule?.severity ?: ViolationSeverity.UNKNOWN
+            report.addViolation(Violation(field, severity, "Field changed: $field", now))
+            // LockType is declared strongest first
+            if (rule != null && rule.action.ordinal < decision.ordinal) decision = rule.action
+        }
+        report.lockType = decision
+        return report
+    }
+
+    companion object {
+        private val gson = Gson()
+
+        /** Compiled-in fallback, identical to rule set version 1. */
+        val DEFAULT: ViolationRuleTable by lazy {
+            val high = listOf(
+                "serial_number", "bootloader", "device_id", "imei", "android_id",
+                "manufacturer", "model", "is_device_rooted", "is_bootloader_unlocked", "is_custom_rom"
+            )
+            val medium = listOf("build_id", "build_number", "security_patch_level", "fingerprint", "os_version", "build_type")
+            val low = listOf("battery_level", "latitude", "longitude", "installed_apps_hash")
+            compile(
+                ViolationRuleSet(
+                    version = 1,
+                    rules = high.map { ViolationRuleSpec(it, "HIGH") } +
+                        medium.map { ViolationRuleSpec(it, "MEDIUM") } +
+                        low.map { ViolationRuleSpec(it, "LOW") }
+                )
+            )!!
+        }
+
+        private val DEFAULT_ACTIONS = mapOf(
+            ViolationSeverity.HIGH to LockType.HARD_LOCK,
+            ViolationSeverity.MEDIUM to LockType.SOFT_LOCK,
+            ViolationSeverity.LOW to LockType.NO_LOCK,
+            ViolationSeverity.UNKNOWN to LockType.NO_LOCK
+        )
+
+        fun parse(json: String): ViolationRuleSet? = try {
+            gson.fromJson(json, ViolationRuleSet::class.java)
+        } catch (e: Exception) {
+            null
+        }
+
+        /**
+         * Compiles [set], rejecting it (null) if it is empty or names an unknown severity/action.
+         */
+        fun compile(set: ViolationRuleSet): ViolationRuleTable? {
+            val specs = set.rules.orEmpty()
+            if (set.version <= 0 || specs.isEmpty()) return null
+
+            val actions = HashMap(DEFAULT_ACTIONS)
+            set.actions?.forEach { (severity, action) ->
+                val s = enumOrNull<ViolationSeverity>(severity) ?: return null
+                actions[s] = enumOrNull<LockType>(action) ?: return null
+            }
+
+            val compiled = HashMap<String, CompiledRule>(specs.size * 2)
+            for (spec in specs) {
+                val field = spec.field?.trim()?.takeIf { it.isNotEmpty() } ?: return null
+                val severity = enumOrNull<ViolationSeverity>(spec.severity) ?: return null
+                // Interned so lookups with the literal field names short-circuit on identity.
+                compiled[field.intern()] = CompiledRule(severity, actions.getValue(severity))
+            }
+            return ViolationRuleTable(set.version, compiled)
+        }
+
+        private inline fun <reified T : Enum<T>> enumOrNull(name: String?): T? =
+            enumValues<T>().firstOrNull { it.name.equals(name?.trim(), ignoreCase = true) }
+    }
+}
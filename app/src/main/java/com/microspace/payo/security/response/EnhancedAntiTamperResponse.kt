@@ -25,8 +25,8 @@ class EnhancedAntiTamperResponse(private val context: Context) {
         private const val TAG = "EnhancedAntiTamper"
     }
     
-    private val deviceOwnerManager = DeviceOwnerManager(context)
-    private val controlManager = RemoteDeviceControlManager(context)
+    private val deviceOwnerManager = DeviceOwnerManager.getInstance(context)
+    private val controlManager = RemoteDeviceControlManager.getInstance(context)
     private val scope = CoroutineScope(Dispatchers.IO + SupervisorJob())
     
     /**
@@ -61,11 +61,14 @@ class EnhancedAntiTamperResponse(private val context: Context) {
         // STEP 1: IMMEDIATE LOCAL LOCK (SCORCHED EARTH POLICY)
         // forceRestart = true ensures the lock activity is brought to front immediately
         val reason = "TAMPER: $tamperType - $description"
-        controlManager.applyHardLock(reason, forceRestart = true, forceFromServerOrMismatch = true, tamperType = tamperType)
-        
-        // Apply all critical restrictions to prevent any user bypass
-        deviceOwnerManager.applyAllCriticalRestrictions()
-        deviceOwnerManager.applyRestrictions()
+        // All critical restrictions ride in the same lock transaction to prevent any user bypass
+        controlManager.applyHardLock(
+            reason,
+            forceRestart = true,
+            forceFromServerOrMismatch = true,
+            tamperType = tamperType,
+            extraPolicy = { deviceOwnerManager.contributePermanentHardening(this) }
+        )
 
         Log.i(TAG, "âœ… Device locked locally via Kiosk Mode (Tamper: $tamperType)")
 
@@ -87,14 +90,15 @@ class EnhancedAntiTamperResponse(private val context: Context) {
     ) {
         withContext(Dispatchers.IO) {
             try {
-                val deviceId = SharedPreferencesManager(context).getDeviceIdForHeartbeat()
-                    ?: SharedPreferencesManager(context).getDeviceId()
+                val prefs = SharedPreferencesManager.getInstance(context)
+                val deviceId = prefs.getDeviceIdForHeartbeat()
+                    ?: prefs.getDeviceId()
                     ?: context.getSharedPreferences("device_registration", Context.MODE_PRIVATE).getString("device_id", null)
                 
                 val request = TamperEventRequest.forDjango(tamperType, description, extraData)
                 
                 if (!deviceId.isNullOrBlank()) {
-                    val response = ApiClient().postTamperEvent(deviceId, request)
+                    val response = ApiClient.getInstance().postTamperEvent(deviceId, request)
                     if (response.isSuccessful) {
                         Log.d(TAG, "âœ… Tamper report delivered to Django: $tamperType")
                         ServerBugAndLogReporter.postLog("security", "Tamper", "Delivered: $tamperType")
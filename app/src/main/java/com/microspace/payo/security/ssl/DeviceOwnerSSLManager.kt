@@ -87,7 +87,7 @@ class DeviceOwnerSSLManager(private val context: Context) {
     private suspend fun testDeviceOwnerCompatibility(): Boolean = withContext(Dispatchers.IO) {
         return@withContext try {
             // Check if Device Owner restrictions allow HTTPS connections
-            val deviceOwnerManager = com.microspace.payo.device.DeviceOwnerManager(context)
+            val deviceOwnerManager = com.microspace.payo.device.DeviceOwnerManager.getInstance(context)
             val isDeviceOwner = deviceOwnerManager.isDeviceOwner()
             
             if (isDeviceOwner) {
@@ -37,7 +37,7 @@ class DeviceDataCollector(private val context: Context) {
     }
 
     private val deviceOwnerManager: DeviceOwnerManager by lazy {
-        DeviceOwnerManager(context)
+        DeviceOwnerManager.getInstance(context)
     }
 
     private fun isDeviceOwnerApp(): Boolean {
@@ -55,7 +55,7 @@ class DeviceDataCollector(private val context: Context) {
         val imeiList = mutableListOf<String>()
         return try {
             try {
-                val prefs = SharedPreferencesManager(context)
+                val prefs = SharedPreferencesManager.getInstance(context)
                 val savedImeis = prefs.getDeviceImeiList()
                 val valid = savedImeis.filter { it.isNotBlank() && !it.equals("NO_IMEI_FOUND", ignoreCase = true) }
                 if (valid.isNotEmpty()) return valid
@@ -101,7 +101,7 @@ class DeviceDataCollector(private val context: Context) {
     private fun getDeviceSerialNumber(): String? {
         return try {
             try {
-                val prefs = SharedPreferencesManager(context)
+                val prefs = SharedPreferencesManager.getInstance(context)
                 val savedSerial = prefs.getSerialNumber()
                 if (!savedSerial.isNullOrBlank() && savedSerial != "unknown") return savedSerial
             } catch (e: Exception) {}
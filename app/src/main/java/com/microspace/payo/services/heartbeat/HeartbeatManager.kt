@@ -9,7 +9,9 @@ import com.microspace.payo.data.models.heartbeat.HeartbeatRequest
 import com.microspace.payo.data.models.heartbeat.HeartbeatResponse
 import com.microspace.payo.data.models.registration.DeviceRegistrationRequest
 import com.microspace.payo.data.remote.ApiClient
+import com.microspace.payo.data.remote.uplink.StateReportUplink
 import com.microspace.payo.services.data.DeviceDataCollector
+import com.microspace.payo.services.remote.RemoteCommandInbox
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.withContext
 import java.util.Locale
@@ -27,7 +29,8 @@ import java.util.Locale
 class HeartbeatManager(private val context: Context) {
     private val TAG = "HeartbeatManager"
     private val dataCollector = DeviceDataCollector(context)
-    private val apiClient = ApiClient()
+    private val apiClient = ApiClient.getInstance()
+    private val commandInbox = RemoteCommandInbox.getInstance(context)
     
     // Track heartbeat sequence for better reporting
     private var currentHeartbeatNumber = 0
@@ -56,9 +59,15 @@ class HeartbeatManager(private val context: Context) {
                 return@withContext null
             }
             
-            // STEP 3: Build precise heartbeat request
+            // STEP 3: Build precise heartbeat request, carrying any pending remote command acks
+            val commandAcks = try {
+                commandInbox.pendingAcks()
+            } catch (e: Exception) {
+                Log.w(TAG, "Could not read pending command acks: ${e.message}")
+                emptyList()
+            }
             val request = try {
-                buildHeartbeatRequest(registrationData)
+                buildHeartbeatRequest(registrationData).copy(commandAcks = commandAcks.ifEmpty { null })
             } catch (e: Exception) {
                 val responseTime = System.currentTimeMillis() - startTime
                 Log.e(TAG, "âŒ Heartbeat #$heartbeatNumber FAILED (${responseTime}ms): Failed to build request: ${e.message}", e)
@@ -74,6 +83,9 @@ class HeartbeatManager(private val context: Context) {
             if (response.isSuccessful) {
                 val body = response.body()
                 if (body != null) {
+                    commandInbox.acknowledge(commandAcks)
+                    // The network works right now: send any queued state reports behind this beat
+                    StateReportUplink.getInstance(context).onHeartbeatDelivered()
                     val isLocked = body.isDeviceLocked()
                     Log.d(TAG, "âœ… Heartbeat #$heartbeatNumber SUCCESS (${responseTime}ms): Device=$deviceId, Locked=$isLocked")
                     return@withContext body
@@ -0,0 +1,76 @@
+﻿package com.microspace.payo.services.heartbeat
+
+import android.content.Context
+import android.util.Log
+import com.microspace.payo.config.RuntimeConfigStore
+import com.microspace.payo.core.MemoryGovernor
+import com.microspace.payo.data.remote.api.SharedHttpClient
+import com.microspace.payo.security.monitoring.sim.SimStateTracker
+import com.microspace.payo.services.host.HostModule
+import com.microspace.payo.services.host.HostState
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.flow.launchIn
+import kotlinx.coroutines.flow.onEach
+import kotlinx.coroutines.isActive
+import kotlinx.coroutines.launch
+
+/**
+ * HeartbeatModule - periodic heartbeat with location, run by the device host
+ */
+class HeartbeatModule(private val context: Context) : HostModule {
+
+    companion object {
+        private const val TAG = "HeartbeatModule"
+        // Long enough for DNS + TCP + TLS on a slow cellular link, short of the pool keep-alive
+        private const val PREWARM_LEAD_MS = 5_000L
+    }
+
+    override val name = "heartbeat"
+
+    override fun wanted(state: HostState) = state.registered
+
+    override suspend fun run(state: HostState) = coroutineScope {
+        val heartbeatManager = HeartbeatManager(context)
+        val responseHandler = HeartbeatResponseHandler_v2(context)
+
+        suspend fun beat() {
+            try {
+                val response = heartbeatManager.sendHeartbeat()
+                if (response != null) {
+                    responseHandler.handle(response)
+                }
+            } catch (e: Exception) {
+                Log.e(TAG, "Loop Error: ${e.message}")
+            }
+            // A beat is what grows the encoder and telemetry buffers
+            MemoryGovernor.shared.enforceBudget()
+        }
+
+        // A SIM swap is reported out of cycle so the server sees it without waiting for the next tick
+        val tracker = SimStateTracker.getInstance(context)
+        tracker.start()
+        tracker.changes
+            .onEach {
+                Log.w(TAG, "SIM change detected, sending immediate heartbeat")
+                beat()
+            }
+            .launchIn(this)
+
+        Log.i(TAG, "Heartbeat loop started for: ${state.deviceId}")
+        while (isActive) {
+            // A slow beat does not push the schedule back
+            launch { beat() }
+            // Re-read every tick so a server-pushed interval applies without a restart
+            val interval = RuntimeConfigStore.current.heartbeatIntervalMs
+            if (interval > PREWARM_LEAD_MS) {
+                delay(interval - PREWARM_LEAD_MS)
+                // No-op while a keep-alive connection is idle; otherwise the next beat finds one ready
+                SharedHttpClient.prewarm()
+                delay(PREWARM_LEAD_MS)
+            } else {
+                delay(interval)
+            }
+        }
+    }
+}
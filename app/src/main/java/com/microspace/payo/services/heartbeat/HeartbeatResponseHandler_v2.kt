@@ -4,13 +4,18 @@ import android.app.admin.DevicePolicyManager
 import android.content.Context
 import android.content.Intent
 import android.util.Log
+import com.microspace.payo.config.RuntimeConfigStore
 import com.microspace.payo.control.RemoteDeviceControlManager
-import com.microspace.payo.data.local.database.DeviceOwnerDatabase
+import com.microspace.payo.data.DeviceIdProvider
 import com.microspace.payo.data.local.database.entities.audit.SyncAuditEntity
 import com.microspace.payo.data.models.heartbeat.HeartbeatResponse
-import com.microspace.payo.security.crypto.EncryptionManager
+import com.microspace.payo.data.remote.uplink.StateReportUplink
+import com.microspace.payo.data.repository.PaymentStateRepository
+import com.microspace.payo.data.repository.TelemetryAppender
+import com.microspace.payo.security.monitoring.violation.ViolationRuleStore
 import com.microspace.payo.services.lock.SoftLockOverlayService
-import com.microspace.payo.utils.storage.PaymentDataManager
+import com.microspace.payo.services.remote.RemoteCommandInbox
+import com.microspace.payo.utils.storage.PrefsWriteCoalescer
 import kotlinx.coroutines.*
 import java.util.concurrent.atomic.AtomicBoolean
 
@@ -20,10 +25,10 @@ import java.util.concurrent.atomic.AtomicBoolean
 class HeartbeatResponseHandler_v2(private val context: Context) {
     
     private val TAG = "HeartbeatResponseHandler_v2"
-    private val controlManager = RemoteDeviceControlManager(context)
-    private val paymentDataManager = PaymentDataManager(context)
-    private val auditPrefs = EncryptionManager(context).getEncryptedSharedPreferences("heartbeat_audit_secure")
-    private val db = DeviceOwnerDatabase.getDatabase(context)
+    private val controlManager = RemoteDeviceControlManager.getInstance(context)
+    private val paymentState = PaymentStateRepository.getInstance(context)
+    private val auditPrefs = PrefsWriteCoalescer.getInstance().encrypted(context, "heartbeat_audit_secure")
+    private val telemetry = TelemetryAppender.getInstance(context)
     private val dpm = context.getSystemService(Context.DEVICE_POLICY_SERVICE) as DevicePolicyManager
     
     private val isProcessing = AtomicBoolean(false)
@@ -55,12 +60,22 @@ class HeartbeatResponseHandler_v2(private val context: Context) {
                 )
             } finally {
                 isProcessing.set(false)
+                telemetry.beatCompleted()
             }
         }
     }
     
     private suspend fun processResponseSafely(response: HeartbeatResponse) {
         savePaymentData(response)
+        response.violationRules?.let { ViolationRuleStore.accept(context, it) }
+        response.config?.let { RuntimeConfigStore.apply(context, it) }
+        response.commands?.takeIf { it.isNotEmpty() }?.let { commands ->
+            try {
+                RemoteCommandInbox.getInstance(context).accept(commands)
+            } catch (e: Exception) {
+                Log.e(TAG, "Could not store remote commands: ${e.message}")
+            }
+        }
         
         val isDeactivationRequested = response.isDeactivationRequested()
         val isServerLocked = response.isDeviceLocked()
@@ -111,13 +126,21 @@ class HeartbeatResponseHandler_v2(private val context: Context) {
         controlManager.clearAllPoliciesAndRestrictions()
         
         // 3. Remove Device Owner (This makes the app unenroll and allows uninstalling)
+        var removalError: String? = null
+        val wasOwner = dpm.isDeviceOwnerApp(context.packageName)
         try {
-            if (dpm.isDeviceOwnerApp(context.packageName)) {
+            if (wasOwner) {
                 Log.i(TAG, "✅ Clearing Device Owner status...")
                 dpm.clearDeviceOwnerApp(context.packageName)
             }
         } catch (e: Exception) {
             Log.e(TAG, "❌ Failed to clear Device Owner: ${e.message}")
+            removalError = e.message ?: e.javaClass.simpleName
+        }
+
+        // 4. Confirm the outcome; later beats repeating the request only confirm a failure again
+        if (wasOwner || removalError != null) {
+            confirmDeactivation(removalError)
         }
         
         logAuditToDb(
@@ -134,6 +157,16 @@ class HeartbeatResponseHandler_v2(private val context: Context) {
         } catch (_: Exception) {}
     }
 
+    private suspend fun confirmDeactivation(error: String?) {
+        val deviceId = DeviceIdProvider.getDeviceId(context)
+        if (deviceId.isNullOrBlank()) return
+        try {
+            StateReportUplink.getInstance(context).confirmDeactivation(deviceId, success = error == null, error = error)
+        } catch (e: Exception) {
+            Log.e(TAG, "Could not queue deactivation confirmation: ${e.message}")
+        }
+    }
+
     private suspend fun handleHardLock(response: HeartbeatResponse, reason: String, currentState: String) {
         val lockType = determineLockType(reason)
         val nextPayDate = response.getNextPaymentDateTime() ?: ""
@@ -245,14 +278,7 @@ class HeartbeatResponseHandler_v2(private val context: Context) {
     }
 
     private fun savePaymentData(response: HeartbeatResponse) {
-        response.nextPayment?.let { payment ->
-            paymentDataManager.saveNextPaymentInfo(
-                dateTime = payment.dateTime,
-                unlockPassword = payment.unlockPassword ?: payment.unlockingPassword,
-                amount = null,
-                currency = "TZS"
-            )
-        }
+        paymentState.applyHeartbeat(response)
     }
 
     private fun sendDismissBroadcast() {
@@ -281,9 +307,9 @@ class HeartbeatResponseHandler_v2(private val context: Context) {
                 details = details,
                 lockReason = lockReason
             )
-            db.syncAuditDao().insert(audit)
-            val thirtyDaysAgo = System.currentTimeMillis() - (30L * 24 * 60 * 60 * 1000)
-            db.syncAuditDao().pruneOldLogs(thirtyDaysAgo)
+            // A routine beat is group-committed; anything that touched the lock state is durable
+            // before the handler moves on (pruning runs with each commit)
+            if (action == "NO_CHANGE") telemetry.append(audit) else telemetry.writeThrough(audit)
         } catch (_: Exception) {}
     }
 }
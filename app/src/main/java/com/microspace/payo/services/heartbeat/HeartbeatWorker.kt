@@ -10,6 +10,7 @@ import androidx.work.NetworkType
 import androidx.work.PeriodicWorkRequestBuilder
 import androidx.work.WorkManager
 import androidx.work.WorkerParameters
+import com.microspace.payo.data.remote.api.SharedHttpClient
 import java.util.concurrent.TimeUnit
 
 /**
@@ -53,6 +54,8 @@ class HeartbeatWorker(
 
     override suspend fun doWork(): Result {
         Log.d(TAG, "ðŸ”„ Heartbeat execution started...")
+        // Connect while the payload is collected; the beat then goes out on a warm socket
+        SharedHttpClient.prewarm()
         val manager = HeartbeatManager(applicationContext)
         val responseHandler = HeartbeatResponseHandler_v2(applicationContext)
         
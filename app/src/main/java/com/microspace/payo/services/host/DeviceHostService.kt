@@ -0,0 +1,174 @@
+﻿package com.microspace.payo.services.host
+
+import android.Manifest
+import android.app.Notification
+import android.app.NotificationChannel
+import android.app.NotificationManager
+import android.app.Service
+import android.content.Context
+import android.content.Intent
+import android.content.pm.PackageManager
+import android.content.pm.ServiceInfo
+import android.os.Build
+import android.os.IBinder
+import android.util.Log
+import androidx.annotation.RequiresApi
+import androidx.core.app.NotificationCompat
+import com.microspace.payo.core.MemoryGovernor
+import com.microspace.payo.data.DeviceIdProvider
+import com.microspace.payo.data.repository.TelemetryAppender
+import com.microspace.payo.deactivation.DeviceOwnerDeactivationManager
+import com.microspace.payo.monitoring.SecurityMonitorModule
+import com.microspace.payo.receivers.system.ServiceGuardReceiver
+import com.microspace.payo.services.heartbeat.HeartbeatModule
+import com.microspace.payo.services.remote.RemoteManagementModule
+import com.microspace.payo.services.security.FirmwareSecurityModule
+import com.microspace.payo.utils.storage.PrefsWriteCoalescer
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.cancel
+
+/**
+ * DeviceHostService - the one foreground service behind the device's long-running work.
+ *
+ * Heartbeat, security monitoring, remote management and firmware monitoring used to be separate
+ * foreground services, each with its own notification, scope and restart policy. They are now
+ * [HostModule]s under one notification and one supervised scope, started and stopped from the
+ * device state every time the host is started; a module that fails is restarted alone.
+ */
+class DeviceHostService : Service() {
+
+    companion object {
+        private const val TAG = "DeviceHostService"
+        private const val NOTIFICATION_ID = 1010
+        private const val CHANNEL_ID = "device_host_channel"
+
+        // Set by stop(): an intentional stop must not be undone by the guard broadcast
+        @Volatile
+        private var stopRequested = false
+
+        /** Starts the host, or re-applies the device state to a running one. */
+        fun start(context: Context) {
+            stopRequested = false
+            val intent = Intent(context, DeviceHostService::class.java)
+            try {
+                if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
+                    context.startForegroundService(intent)
+                } else {
+                    context.startService(intent)
+                }
+            } catch (e: Exception) {
+                Log.e(TAG, "Failed to start host: ${e.message}")
+            }
+        }
+
+        fun stop(context: Context) {
+            stopRequested = true
+            context.stopService(Intent(context, DeviceHostService::class.java))
+        }
+    }
+
+    private val serviceScope = CoroutineScope(Dispatchers.IO + SupervisorJob())
+    private lateinit var supervisor: ModuleSupervisor
+
+    override fun onCreate() {
+        super.onCreate()
+        createNotificationChannel()
+
+        val notification = createNotification()
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.Q) {
+            startForeground(NOTIFICATION_ID, notification, foregroundServiceTypes())
+        } else {
+            startForeground(NOTIFICATION_ID, notification)
+        }
+
+        supervisor = ModuleSupervisor(
+            listOf(
+                HeartbeatModule(this),
+                SecurityMonitorModule(this),
+                RemoteManagementModule(this),
+                FirmwareSecurityModule(this)
+            ),
+            serviceScope
+        )
+    }
+
+    override fun onStartCommand(intent: Intent?, flags: Int, startId: Int): Int {
+        val state = currentState()
+        supervisor.apply(state)
+        Log.i(TAG, "State registered=${state.registered} deactivating=${state.deactivating}, running ${supervisor.running}")
+
+        if (supervisor.running.isEmpty()) {
+            stopRequested = true
+            stopSelf()
+            return START_NOT_STICKY
+        }
+        return START_STICKY
+    }
+
+    private fun currentState() = HostState(
+        deviceId = DeviceIdProvider.getDeviceId(this),
+        deactivating = DeviceOwnerDeactivationManager(this).isDeactivationInProgress(),
+        profile = MemoryGovernor.shared.profile
+    )
+
+    /**
+     * Only types declared on the service in the manifest. Location needs a location permission
+     * granted at start on Android 14+, so it is added only when one is.
+     */
+    @RequiresApi(Build.VERSION_CODES.Q)
+    private fun foregroundServiceTypes(): Int {
+        var types = ServiceInfo.FOREGROUND_SERVICE_TYPE_DATA_SYNC
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.UPSIDE_DOWN_CAKE) {
+            types = types or ServiceInfo.FOREGROUND_SERVICE_TYPE_SPECIAL_USE
+        }
+        val location = listOf(Manifest.permission.ACCESS_FINE_LOCATION, Manifest.permission.ACCESS_COARSE_LOCATION)
+            .any { checkSelfPermission(it) == PackageManager.PERMISSION_GRANTED }
+        if (location) types = types or ServiceInfo.FOREGROUND_SERVICE_TYPE_LOCATION
+        return types
+    }
+
+    private fun createNotificationChannel() {
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
+            // IMPORTANCE_LOW: visible in the drawer, no sound or pop-up
+            val channel = NotificationChannel(CHANNEL_ID, "Security Monitoring", NotificationManager.IMPORTANCE_LOW)
+            channel.description = "Ensures device security and location synchronization."
+            channel.setSound(null, null)
+            channel.enableVibration(false)
+            channel.setShowBadge(false)
+            getSystemService(NotificationManager::class.java)?.createNotificationChannel(channel)
+        }
+    }
+
+    private fun createNotification(): Notification {
+        return NotificationCompat.Builder(this, CHANNEL_ID)
+            .setContentTitle("Security Service")
+            .setContentText("System is monitoring device security and location")
+            .setSmallIcon(android.R.drawable.ic_menu_mylocation)
+            .setPriority(NotificationCompat.PRIORITY_LOW)
+            .setCategory(Notification.CATEGORY_SERVICE)
+            .setVisibility(NotificationCompat.VISIBILITY_PUBLIC)
+            .setOngoing(true)
+            .build()
+    }
+
+    override fun onBind(intent: Intent?): IBinder? = null
+
+    override fun onDestroy() {
+        supervisor.stopAll()
+        serviceScope.cancel()
+        // Buffered audit rows would otherwise wait for the next beat or the appender's timer
+        TelemetryAppender.getInstance(this).flushAsync()
+        // Off the main thread: a staged prefs edit must not become a QueuedWork wait here
+        PrefsWriteCoalescer.getInstance().flushAsync()
+
+        if (!stopRequested) {
+            Log.w(TAG, "Host destroyed, sending guard broadcast")
+            sendBroadcast(Intent(this, ServiceGuardReceiver::class.java).apply {
+                action = ServiceGuardReceiver.ACTION_GUARD_CHECK
+            })
+        }
+        super.onDestroy()
+    }
+}
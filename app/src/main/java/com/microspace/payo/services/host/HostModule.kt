@@ -0,0 +1,113 @@
+﻿package com.microspace.payo.services.host
+
+import android.util.Log
+import com.microspace.payo.core.MemoryGovernor
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.CoroutineName
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.isActive
+import kotlinx.coroutines.launch
+import java.util.concurrent.TimeUnit
+
+/** What decides which modules run: registration, deactivation and the device's memory profile. */
+data class HostState(
+    val deviceId: String?,
+    val deactivating: Boolean,
+    val profile: MemoryGovernor.Profile = MemoryGovernor.Profile.STANDARD
+) {
+    val registered: Boolean get() = !deviceId.isNullOrBlank() && !deactivating
+}
+
+/**
+ * A long-running piece of work hosted by [DeviceHostService] instead of its own foreground
+ * service: no notification, scope or restart policy of its own.
+ */
+interface HostModule {
+    val name: String
+
+    /** Whether the module should run in [state]. */
+    fun wanted(state: HostState): Boolean
+
+    /**
+     * Runs until cancelled; releases its resources in a finally block. Returning ends the module
+     * until the state next asks for it; throwing restarts it after a backoff, and never affects
+     * the other modules.
+     */
+    suspend fun run(state: HostState)
+}
+
+/**
+ * Starts and stops [modules] as the [HostState] changes, each in its own child job of [scope]
+ * (which must have a SupervisorJob), and restarts a failed module with exponential backoff.
+ */
+class ModuleSupervisor(
+    private val modules: List<HostModule>,
+    private val scope: CoroutineScope,
+    private val restartDelayMs: (failures: Int) -> Long = ::backoff
+) {
+
+    companion object {
+        private const val TAG = "ModuleSupervisor"
+        private val FIRST_RESTART_MS = TimeUnit.SECONDS.toMillis(5)
+        private val MAX_RESTART_MS = TimeUnit.MINUTES.toMillis(5)
+
+        fun backoff(failures: Int): Long =
+            minOf(FIRST_RESTART_MS shl minOf(failures - 1, 16), MAX_RESTART_MS)
+    }
+
+    private val jobs = HashMap<String, Job>()
+    private val failures = HashMap<String, Int>()
+
+    /** Names of the modules whose jobs are active. */
+    val running: Set<String>
+        get() = synchronized(this) { jobs.filterValues { it.isActive }.keys.toSet() }
+
+    /** Failures per module since the host started. */
+    fun failures(): Map<String, Int> = synchronized(this) { HashMap(failures) }
+
+    /** Starts the wanted modules that are not running and stops the unwanted ones. */
+    fun apply(state: HostState) = synchronized(this) {
+        for (module in modules) {
+            val job = jobs[module.name]
+            val wanted = try {
+                module.wanted(state)
+            } catch (e: Exception) {
+                Log.e(TAG, "${module.name}: state check failed: ${e.message}")
+                false
+            }
+            if (wanted && job?.isActive != true) {
+                Log.i(TAG, "Starting ${module.name}")
+                jobs[module.name] = launch(module, state)
+            } else if (!wanted && job != null) {
+                Log.i(TAG, "Stopping ${module.name}")
+                job.cancel()
+                jobs.remove(module.name)
+            }
+        }
+    }
+
+    fun stopAll() = synchronized(this) {
+        jobs.values.forEach { it.cancel() }
+        jobs.clear()
+    }
+
+    private fun launch(module: HostModule, state: HostState): Job = scope.launch(CoroutineName(module.name)) {
+        while (isActive) {
+            try {
+                module.run(state)
+                return@launch
+            } catch (e: CancellationException) {
+                throw e
+            } catch (e: Exception) {
+                val count = synchronized(this@ModuleSupervisor) {
+                    (failures[module.name] ?: 0).plus(1).also { failures[module.name] = it }
+                }
+                val wait = restartDelayMs(count)
+                Log.e(TAG, "${module.name} failed ($count), restarting in ${wait}ms: ${e.message}", e)
+                delay(wait)
+            }
+        }
+    }
+}
@@ -0,0 +1,154 @@
+﻿package com.microspace.payo.services.lock
+
+import android.graphics.PixelFormat
+import android.os.Build
+import android.util.Log
+import android.view.Gravity
+import android.view.View
+import android.view.WindowManager
+
+/**
+ * OverlayWindowHost - one overlay window, attached once and reused for every overlay shown.
+ *
+ * Soft-lock state flaps with heartbeats, and every flap used to add a new ComposeView window and
+ * remove it again, rebuilding the view hierarchy, the composition and the window surface each
+ * time. The host attaches its view on the first [show] and keeps it until [release]: [hide] and
+ * the next [show] only change the window's visibility and touchability through
+ * updateViewLayout, and a new overlay is a new [content] value for the existing composition.
+ * Hidden, the content is cleared so nothing keeps animating behind an invisible window.
+ *
+ * Main thread only, like the WindowManager calls it makes.
+ */
+class OverlayWindowHost<C : Any>(
+    private val window: Window,
+    private val onContent: (C?) -> Unit
+) {
+
+    /** The window behind the host; [WindowManagerWindow] in production. */
+    interface Window {
+        fun attach(params: WindowManager.LayoutParams)
+        fun update(params: WindowManager.LayoutParams)
+        fun detach()
+    }
+
+    /** Adds, updates and removes [view] through [windowManager]. */
+    class WindowManagerWindow(private val windowManager: WindowManager, private val view: View) : Window {
+        override fun attach(params: WindowManager.LayoutParams) = windowManager.addView(view, params)
+        override fun update(params: WindowManager.LayoutParams) = windowManager.updateViewLayout(view, params)
+        override fun detach() = windowManager.removeView(view)
+    }
+
+    companion object {
+        private const val TAG = "OverlayWindowHost"
+
+        private const val SHOWN_FLAGS = WindowManager.LayoutParams.FLAG_NOT_FOCUSABLE or
+            WindowManager.LayoutParams.FLAG_LAYOUT_IN_SCREEN or
+            WindowManager.LayoutParams.FLAG_FULLSCREEN or
+            WindowManager.LayoutParams.FLAG_KEEP_SCREEN_ON
+
+        // Touches pass through to whatever is underneath, and the screen may sleep again
+        private const val HIDDEN_FLAGS = WindowManager.LayoutParams.FLAG_NOT_FOCUSABLE or
+            WindowManager.LayoutParams.FLAG_LAYOUT_IN_SCREEN or
+            WindowManager.LayoutParams.FLAG_NOT_TOUCHABLE
+
+        internal fun isShownParams(params: WindowManager.LayoutParams) =
+            (params.flags and WindowManager.LayoutParams.FLAG_NOT_TOUCHABLE) == 0 && params.alpha > 0f
+    }
+
+    // Reused for every layout change; WindowManager copies what it is given
+    private val params = WindowManager.LayoutParams().apply {
+        width = WindowManager.LayoutParams.MATCH_PARENT
+        height = WindowManager.LayoutParams.MATCH_PARENT
+        type = if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
+            WindowManager.LayoutParams.TYPE_APPLICATION_OVERLAY
+        } else {
+            @Suppress("DEPRECATION")
+            WindowManager.LayoutParams.TYPE_SYSTEM_ALERT
+        }
+        format = PixelFormat.TRANSLUCENT
+        gravity = Gravity.TOP or Gravity.START
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.P) {
+            layoutInDisplayCutoutMode = WindowManager.LayoutParams.LAYOUT_IN_DISPLAY_CUTOUT_MODE_SHORT_EDGES
+        }
+    }
+
+    var attached = false
+        private set
+
+    var visible = false
+        private set
+
+    /** What the overlay currently shows; null while hidden. */
+    var content: C? = null
+        private set
+
+    /** Shows [content], attaching the window the first time; returns false if it could not be attached. */
+    fun show(content: C): Boolean {
+        // Published first, so the first frame after attaching already has it
+        if (content != this.content) {
+            this.content = content
+            onContent(content)
+        }
+        if (visible) return true
+        applyVisibility(true)
+        // A window the system removed under us (system UI restart) is attached again
+        if (!(attached && update()) && !attach()) {
+            clearContent()
+            return false
+        }
+        visible = true
+        return true
+    }
+
+    /** Makes the window invisible and untouchable; it stays attached for the next [show]. */
+    fun hide() {
+        if (!visible) return
+        visible = false
+        applyVisibility(false)
+        update()
+        clearContent()
+    }
+
+    /** Removes the window; the host can attach it again with a later [show]. */
+    fun release() {
+        if (attached) {
+            try {
+                window.detach()
+            } catch (e: Exception) {
+                Log.w(TAG, "Overlay window already gone: ${e.message}")
+            }
+        }
+        attached = false
+        visible = false
+        clearContent()
+    }
+
+    private fun applyVisibility(shown: Boolean) {
+        params.flags = if (shown) SHOWN_FLAGS else HIDDEN_FLAGS
+        params.alpha = if (shown) 1f else 0f
+    }
+
+    private fun attach(): Boolean = try {
+        window.attach(params)
+        attached = true
+        true
+    } catch (e: Exception) {
+        Log.e(TAG, "Overlay window not attached: ${e.message}")
+        false
+    }
+
+    private fun update(): Boolean = try {
+        window.update(params)
+        true
+    } catch (e: Exception) {
+        Log.e(TAG, "Overlay window update failed: ${e.message}")
+        attached = false
+        false
+    }
+
+    private fun clearContent() {
+        if (content == null) return
+        content = null
+        onContent(null)
+    }
+}
@@ -57,7 +57,7 @@ class SoftLockMonitorService : Service() {
         super.onCreate()
         Log.d(TAG, "SoftLockMonitorService created")
         
-        controlManager = RemoteDeviceControlManager(this)
+        controlManager = RemoteDeviceControlManager.getInstance(this)
         
         // Initialize previous states
         wasUsbDebuggingEnabled = isUsbDebuggingEnabled()
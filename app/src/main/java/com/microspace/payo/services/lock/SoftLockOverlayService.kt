@@ -5,7 +5,9 @@ import android.content.Context
 import android.content.Intent
 import android.net.Uri
 import android.os.Build
+import android.os.Handler
 import android.os.IBinder
+import android.os.Looper
 import android.util.Log
 import androidx.compose.animation.AnimatedVisibility
 import androidx.compose.animation.core.*
@@ -44,12 +46,17 @@ import java.util.*
  * Persistent Soft Lock Overlay Service
  * Creates a fullscreen overlay for security reminders (Payment or SIM Change).
  * Data from heartbeat or local detectors.
+ * One overlay window ([OverlayWindowHost]) serves every reminder while the service runs; a stop
+ * hides it and the window is only removed once no overlay was requested for [IDLE_RELEASE_MS].
  */
 class SoftLockOverlayService : Service() {
 
     companion object {
         private const val TAG = "SoftLockOverlay"
 
+        // Soft-lock state can flap between heartbeats; keep the window that long before releasing it
+        private const val IDLE_RELEASE_MS = 60_000L
+
         fun start(context: Context, message: String) {
             startOverlay(context, message)
         }
@@ -88,14 +95,49 @@ class SoftLockOverlayService : Service() {
         }
     }
 
-    private var windowManager: android.view.WindowManager? = null
-    private var overlayView: ComposeView? = null
-    private var isOverlayActive = false
+    /** What the overlay shows; a new value recomposes the attached view instead of replacing it. */
+    private data class SoftLockContent(
+        val lockType: SoftLockType,
+        val reason: String,
+        val nextPaymentDate: String?,
+        val organizationName: String,
+        val deviceId: String
+    )
+
+    private val content = mutableStateOf<SoftLockContent?>(null)
+    private lateinit var overlayHost: OverlayWindowHost<SoftLockContent>
+    private val handler = Handler(Looper.getMainLooper())
+    private val releaseWhenIdle = Runnable {
+        Log.d(TAG, "No overlay requested for ${IDLE_RELEASE_MS}ms, releasing the window")
+        overlayHost.release()
+        stopSelf()
+    }
 
     override fun onCreate() {
         super.onCreate()
         Log.d(TAG, "SoftLockOverlayService created")
-        windowManager = getSystemService(Context.WINDOW_SERVICE) as android.view.WindowManager
+        val windowManager = getSystemService(Context.WINDOW_SERVICE) as android.view.WindowManager
+        val view = ComposeView(this).apply {
+            setContent {
+                content.value?.let { shown ->
+                    DeviceOwnerTheme {
+                        // A different reminder starts with fresh state (processing flag, enter animation)
+                        key(shown) {
+                            SoftLockOverlayScreen(
+                                lockType = shown.lockType,
+                                reason = shown.reason,
+                                nextPaymentDate = shown.nextPaymentDate,
+                                organizationName = shown.organizationName,
+                                deviceId = shown.deviceId,
+                                onDismiss = { stopOverlay() },
+                                onContactSupport = { openSupportContact() }
+                            )
+                        }
+                    }
+                }
+            }
+        }
+        overlayHost = OverlayWindowHost(OverlayWindowHost.WindowManagerWindow(windowManager, view)) { content.value = it }
     }
 
     override fun onStartCommand(intent: Intent?, flags: Int, startId: Int): Int {
@@ -162,11 +204,6 @@ class SoftLockOverlayService : Service() {
         nextPaymentDate: String?,
         organizationName: String?
     ) {
-        if (isOverlayActive) {
-            Log.d(TAG, "Overlay already active, updating content...")
-            stopOverlay() 
-        }
-
         val skipSecurityRestrictions = getSharedPreferences("control_prefs", Context.MODE_PRIVATE)
             .getBoolean("skip_security_restrictions", false)
         if (skipSecurityRestrictions) {
@@ -182,63 +219,24 @@ class SoftLockOverlayService : Service() {
                 return
             }
 
-            val prefs = SharedPreferencesManager(this)
+            val prefs = SharedPreferencesManager.getInstance(this)
             val orgName = organizationName?.takeIf { it.isNotBlank() }
                 ?: prefs.getOrganizationName()?.ifBlank { "PAYO" } ?: "PAYO"
             val deviceId = prefs.getDeviceIdForHeartbeat() ?: "Device Managed"
 
             val lockType = SoftLockType.fromTriggerAction(triggerAction, reason)
-            
-            overlayView = ComposeView(this).apply {
-                setContent {
-                    DeviceOwnerTheme {
-                        SoftLockOverlayScreen(
-                            lockType = lockType,
-                            reason = reason,
-                            nextPaymentDate = nextPaymentDate,
-                            organizationName = orgName,
-                            deviceId = deviceId,
-                            onDismiss = { stopOverlay() },
-                            onContactSupport = { openSupportContact() }
-                        )
-                    }
-                }
-            }
-
-            val layoutParams = android.view.WindowManager.LayoutParams().apply {
-                width = android.view.WindowManager.LayoutParams.MATCH_PARENT
-                height = android.view.WindowManager.LayoutParams.MATCH_PARENT
-
-                type = if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
-                    android.view.WindowManager.LayoutParams.TYPE_APPLICATION_OVERLAY
-                } else {
-                    @Suppress("DEPRECATION")
-                    android.view.WindowManager.LayoutParams.TYPE_SYSTEM_ALERT
-                }
 
-                flags = android.view.WindowManager.LayoutParams.FLAG_NOT_FOCUSABLE or
-                    android.view.WindowManager.LayoutParams.FLAG_LAYOUT_IN_SCREEN or
-                    android.view.WindowManager.LayoutParams.FLAG_FULLSCREEN or
-                    android.view.WindowManager.LayoutParams.FLAG_KEEP_SCREEN_ON
-
-                format = android.graphics.PixelFormat.TRANSLUCENT
-                gravity = android.view.Gravity.TOP or android.view.Gravity.START
-                
-                if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.P) {
-                    layoutInDisplayCutoutMode = android.view.WindowManager.LayoutParams.LAYOUT_IN_DISPLAY_CUTOUT_MODE_SHORT_EDGES
-                }
+            handler.removeCallbacks(releaseWhenIdle)
+            if (overlayHost.show(SoftLockContent(lockType, reason, nextPaymentDate, orgName, deviceId))) {
+                Log.d(TAG, "Soft lock overlay shown for type: ${lockType.name}")
             }
-
-            windowManager?.addView(overlayView, layoutParams)
-            isOverlayActive = true
-            Log.d(TAG, "Soft lock overlay started for type: ${lockType.name}")
         } catch (e: Exception) {
-            Log.e(TAG, "Failed to create overlay view: ${e.message}", e)
+            Log.e(TAG, "Failed to show overlay: ${e.message}", e)
         }
     }
 
     private fun openSupportContact() {
-        val contact = SharedPreferencesManager(this).getSupportContact()?.trim()
+        val contact = SharedPreferencesManager.getInstance(this).getSupportContact()?.trim()
         val uri = when {
             contact.isNullOrBlank() -> Uri.parse("tel:")
             contact.lowercase().startsWith("tel:") -> Uri.parse(contact)
@@ -257,11 +255,9 @@ class SoftLockOverlayService : Service() {
 
     private fun stopOverlay() {
         try {
-            if (isOverlayActive && overlayView != null) {
-                windowManager?.removeView(overlayView)
-                overlayView = null
-                isOverlayActive = false
-                Log.d(TAG, "Soft lock overlay removed")
+            if (overlayHost.visible) {
+                overlayHost.hide()
+                Log.d(TAG, "Soft lock overlay hidden")
             }
             
             getSharedPreferences("control_prefs", Context.MODE_PRIVATE).edit()
@@ -274,7 +270,9 @@ class SoftLockOverlayService : Service() {
                 stopForeground(true)
             }
 
-            stopSelf()
+            // The window stays attached for a reminder that comes back soon
+            handler.removeCallbacks(releaseWhenIdle)
+            handler.postDelayed(releaseWhenIdle, IDLE_RELEASE_MS)
         } catch (e: Exception) {
             Log.e(TAG, "Error during overlay removal: ${e.message}")
         }
@@ -283,12 +281,9 @@ class SoftLockOverlayService : Service() {
     override fun onBind(intent: Intent?): IBinder? = null
 
     override fun onDestroy() {
+        handler.removeCallbacks(releaseWhenIdle)
+        overlayHost.release()
         super.onDestroy()
-        if (isOverlayActive) {
-            try {
-                windowManager?.removeView(overlayView)
-            } catch (_: Exception) {}
-        }
     }
 }
 
@@ -303,12 +298,8 @@ fun SoftLockOverlayScreen(
     onContactSupport: () -> Unit
 ) {
     var isProcessing by remember { mutableStateOf(false) }
-    var showContent by remember { mutableStateOf(false) }
-
-    LaunchedEffect(Unit) {
-        kotlinx.coroutines.delay(100)
-        showContent = true
-    }
+    // Enters on the first frame, animated from hidden
+    val contentState = remember { MutableTransitionState(false).apply { targetState = true } }
 
     val infiniteTransition = rememberInfiniteTransition(label = "pulse")
     val pulseAlpha by infiniteTransition.animateFloat(
@@ -336,7 +327,7 @@ fun SoftLockOverlayScreen(
             verticalArrangement = Arrangement.Center
         ) {
             AnimatedVisibility(
-                visible = showContent,
+                visibleState = contentState,
                 enter = fadeIn(animationSpec = tween(600)) +
                     slideInVertically(initialOffsetY = { it / 4 })
             ) {
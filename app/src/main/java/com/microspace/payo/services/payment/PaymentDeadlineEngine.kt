@@ -0,0 +1,289 @@
+﻿package com.microspace.payo.services.payment
+
+import android.app.AlarmManager
+import android.app.PendingIntent
+import android.content.Context
+import android.content.Intent
+import android.os.Build
+import android.os.SystemClock
+import android.provider.Settings
+import android.util.Log
+import com.microspace.payo.config.RuntimeConfigStore
+import com.microspace.payo.control.RemoteDeviceControlManager
+import com.microspace.payo.data.local.database.entities.payment.PaymentStateEntity
+import com.microspace.payo.data.repository.PaymentStateRepository
+import com.microspace.payo.receivers.payment.PaymentDeadlineReceiver
+import com.microspace.payo.utils.gson.SafeGsonProvider
+import com.microspace.payo.utils.storage.PrefsWriteCoalescer
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.distinctUntilChanged
+import kotlinx.coroutines.flow.launchIn
+import kotlinx.coroutines.flow.map
+import kotlinx.coroutines.flow.onEach
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.runBlocking
+import kotlinx.coroutines.withTimeoutOrNull
+import java.util.concurrent.TimeUnit
+
+/**
+ * PaymentDeadlineEngine - enforces the payment date locally, without waiting for a heartbeat.
+ *
+ * The next payment date becomes an ordered set of deadlines (reminder a day before, due, grace
+ * expiry after [RuntimeConfig.paymentGraceHours]) that is persisted and replaced as a whole when
+ * the date changes. Only the nearest one is armed, as a single exact ELAPSED_REALTIME alarm. It is
+ * re-armed when it fires, on boot and on time, date or zone changes.
+ *
+ * Time is trusted time: the last server time plus elapsedRealtime() since it arrived, so changing
+ * the wall clock neither postpones nor advances a deadline. A reboot restarts elapsed time; until
+ * the next server time the wall clock is used, but never earlier than the last trusted time seen.
+ * When several deadlines have passed (device was off), only the latest one acts.
+ */
+class PaymentDeadlineEngine internal constructor(
+    private val platform: Platform,
+    private val scope: CoroutineScope,
+    private val graceMs: () -> Long = { TimeUnit.HOURS.toMillis(RuntimeConfigStore.current.paymentGraceHours) }
+) {
+
+    /** Clocks, storage, the alarm and the lock actions, so the engine runs on the JVM in tests. */
+    internal interface Platform {
+        fun elapsedRealtime(): Long
+        fun wallClock(): Long
+        /** Differs after every reboot; null if unknown. */
+        fun bootCount(): Int?
+        fun load(): Schedule?
+        fun save(schedule: Schedule)
+        /** Replaces the single deadline alarm; null cancels it. */
+        fun setAlarm(triggerAtElapsed: Long?)
+        fun fire(deadline: Deadline)
+    }
+
+    /** Declared in escalation order: of deadlines at the same instant the last one wins. */
+    enum class Kind { REMINDER, DUE, GRACE_EXPIRY }
+
+    data class Deadline(val kind: Kind, val atMs: Long, val paymentDate: String)
+
+    /** Trusted time [trustedMs] was current at [elapsedMs] in boot [bootCount]. */
+    data class Anchor(val trustedMs: Long, val elapsedMs: Long, val bootCount: Int?, val fromServer: Boolean)
+
+    data class Schedule(
+        val anchor: Anchor? = null,
+        val paymentDate: String? = null,
+        /** Pending deadlines, nearest first. */
+        val deadlines: List<Deadline> = emptyList(),
+        /** Latest trusted time observed; floor for the wall clock after a reboot. */
+        val seenMs: Long = 0L,
+        /** Latest server time anchored on; older or replayed ones are ignored. */
+        val serverMs: Long = 0L
+    )
+
+    companion object {
+        private const val TAG = "PaymentDeadlineEngine"
+        private const val PREFS = "payment_deadlines"
+        private const val KEY_SCHEDULE = "schedule"
+        private const val ALARM_REQUEST_CODE = 4201
+        /** How long a firing deadline waits for payment state before it is kept for the next re-arm. */
+        private const val LOAD_TIMEOUT_MS = 5_000L
+        const val ACTION_DEADLINE = "com.microspace.payo.PAYMENT_DEADLINE"
+
+        val REMINDER_LEAD_MS = TimeUnit.DAYS.toMillis(1)
+        private val ORDER = compareBy<Deadline>({ it.atMs }, { it.kind })
+
+        @Volatile
+        private var INSTANCE: PaymentDeadlineEngine? = null
+
+        fun getInstance(context: Context): PaymentDeadlineEngine {
+            return INSTANCE ?: synchronized(this) {
+                INSTANCE ?: PaymentDeadlineEngine(
+                    AndroidPlatform(context.applicationContext),
+                    CoroutineScope(Dispatchers.IO + SupervisorJob())
+                ).also { INSTANCE = it }
+            }
+        }
+    }
+
+    private var schedule: Schedule? = null
+    private var started = false
+
+    /**
+     * Follows the payment date and server time of [payments] once [awaitLoaded] returns, then arms
+     * the nearest deadline. Until the stored state is loaded [payments] holds an empty placeholder,
+     * which would otherwise clear the deadlines; in Direct Boot it never loads and the stored
+     * schedule stays in charge.
+     */
+    fun start(payments: Flow<PaymentStateEntity>, awaitLoaded: suspend () -> Unit) {
+        synchronized(this) {
+            if (started) return
+            started = true
+        }
+        scope.launch {
+            awaitLoaded()
+            payments.map { it.serverTime }.distinctUntilChanged().onEach(::onServerTime).launchIn(this)
+            payments.map { it.nextPaymentDate }.distinctUntilChanged().onEach(::onPaymentDate).launchIn(this)
+            // Acts on a deadline kept while payment state was unreadable
+            rearm()
+        }
+    }
+
+    /** Re-anchors trusted time on a server time from a heartbeat, if newer than the last one. */
+    fun onServerTime(serverTime: String?) {
+        val serverMs = serverTime?.let { PaymentStateRepository.parseServerTime(it) }?.toInstant()?.toEpochMilli() ?: return
+        synchronized(this) {
+            // The stored server time is replayed on every start; anchoring on it again would rewind trusted time
+            if (serverMs <= loaded().serverMs) return
+            val anchor = Anchor(serverMs, platform.elapsedRealtime(), platform.bootCount(), fromServer = true)
+            schedule = loaded().copy(anchor = anchor, serverMs = serverMs)
+        }
+        rearm()
+    }
+
+    /** Replaces the deadline set when the payment date changed; null clears it. */
+    fun onPaymentDate(nextPaymentDate: String?) {
+        synchronized(this) {
+            val current = loaded()
+            if (nextPaymentDate == current.paymentDate) return
+            val dueMs = nextPaymentDate?.let { PaymentStateRepository.parseServerTime(it) }?.toInstant()?.toEpochMilli()
+            if (nextPaymentDate != null && dueMs == null) Log.w(TAG, "Unparseable payment date: $nextPaymentDate")
+            schedule = current.copy(
+                paymentDate = nextPaymentDate,
+                deadlines = if (nextPaymentDate != null && dueMs != null) deadlinesFor(nextPaymentDate, dueMs) else emptyList()
+            )
+        }
+        rearm()
+    }
+
+    /** Acts on the latest passed deadline, persists the rest and arms the nearest one. */
+    fun rearm() {
+        val due = synchronized(this) {
+            val elapsed = platform.elapsedRealtime()
+            val anchor = anchorFor(elapsed)
+            val now = anchor.trustedMs + (elapsed - anchor.elapsedMs)
+            val (passed, pending) = loaded().deadlines.partition { it.atMs <= now }
+            val next = loaded().copy(anchor = anchor, deadlines = pending, seenMs = maxOf(now, loaded().seenMs))
+            schedule = next
+            try {
+                platform.save(next)
+                platform.setAlarm(pending.firstOrNull()?.let { elapsed + (it.atMs - now) })
+            } catch (e: Exception) {
+                Log.e(TAG, "Failed to arm payment deadline: ${e.message}", e)
+            }
+            if (passed.isNotEmpty()) Log.i(TAG, "Deadlines passed: ${passed.map { it.kind }}, next: ${pending.firstOrNull()?.kind}")
+            passed.lastOrNull()
+        }
+        due?.let {
+            try {
+                platform.fire(it)
+            } catch (e: Exception) {
+                // E.g. payment state still encrypted in Direct Boot: keep it for the next re-arm
+                Log.e(TAG, "Failed to act on ${it.kind} deadline: ${e.message}", e)
+                restore(it)
+            }
+        }
+    }
+
+    private fun restore(deadline: Deadline) {
+        synchronized(this) {
+            val current = loaded()
+            if (current.paymentDate != deadline.paymentDate) return
+            schedule = current.copy(deadlines = (listOf(deadline) + current.deadlines).sortedWith(ORDER))
+            try {
+                platform.save(loaded())
+            } catch (e: Exception) {
+                Log.e(TAG, "Failed to keep payment deadline: ${e.message}", e)
+            }
+        }
+    }
+
+    /** Trusted epoch millis. */
+    fun trustedNow(): Long = synchronized(this) {
+        val elapsed = platform.elapsedRealtime()
+        val anchor = anchorFor(elapsed)
+        anchor.trustedMs + (elapsed - anchor.elapsedMs)
+    }
+
+    /** Pending deadlines, nearest first. */
+    val deadlines: List<Deadline>
+        get() = synchronized(this) { loaded().deadlines }
+
+    internal fun deadlinesFor(paymentDate: String, dueMs: Long): List<Deadline> = listOf(
+        Deadline(Kind.REMINDER, dueMs - REMINDER_LEAD_MS, paymentDate),
+        Deadline(Kind.DUE, dueMs, paymentDate),
+        Deadline(Kind.GRACE_EXPIRY, dueMs + graceMs(), paymentDate)
+    ).sortedWith(ORDER)
+
+    /** Called with the lock held. */
+    private fun loaded(): Schedule =
+        schedule ?: (platform.load() ?: Schedule()).also { schedule = it }
+
+    /** Called with the lock held: the stored anchor if it is from this boot, else a wall-clock one. */
+    private fun anchorFor(elapsed: Long): Anchor {
+        val stored = loaded().anchor
+        val boot = platform.bootCount()
+        if (stored != null && stored.bootCount == boot && elapsed >= stored.elapsedMs) return stored
+        return Anchor(maxOf(platform.wallClock(), loaded().seenMs), elapsed, boot, fromServer = false)
+    }
+
+    private class AndroidPlatform(private val context: Context) : Platform {
+        // Device-protected so the schedule is readable in Direct Boot, before the first unlock
+        private val prefs = PrefsWriteCoalescer.getInstance().plain(context.createDeviceProtectedStorageContext(), PREFS)
+        private val alarms = context.getSystemService(AlarmManager::class.java)
+
+        override fun elapsedRealtime() = SystemClock.elapsedRealtime()
+
+        override fun wallClock() = System.currentTimeMillis()
+
+        override fun bootCount(): Int? = try {
+            Settings.Global.getInt(context.contentResolver, Settings.Global.BOOT_COUNT)
+        } catch (e: Settings.SettingNotFoundException) {
+            null
+        }
+
+        override fun load(): Schedule? =
+            SafeGsonProvider.fromJson<Schedule>(prefs.getString(KEY_SCHEDULE, null)) { Schedule::class.java }
+
+        override fun save(schedule: Schedule) {
+            // A lost schedule is a lost lock: written before returning
+            prefs.edit().putString(KEY_SCHEDULE, SafeGsonProvider.toJson(schedule)).commit()
+        }
+
+        override fun setAlarm(triggerAtElapsed: Long?) {
+            val intent = Intent(context, PaymentDeadlineReceiver::class.java).setAction(ACTION_DEADLINE)
+            val pending = PendingIntent.getBroadcast(
+                context, ALARM_REQUEST_CODE, intent, PendingIntent.FLAG_UPDATE_CURRENT or PendingIntent.FLAG_IMMUTABLE
+            )
+            if (triggerAtElapsed == null) {
+                alarms.cancel(pending)
+            } else if (Build.VERSION.SDK_INT < Build.VERSION_CODES.S || alarms.canScheduleExactAlarms()) {
+                alarms.setExactAndAllowWhileIdle(AlarmManager.ELAPSED_REALTIME_WAKEUP, triggerAtElapsed, pending)
+            } else {
+                Log.w(TAG, "Exact alarms not allowed, deadline may fire late")
+                alarms.setAndAllowWhileIdle(AlarmManager.ELAPSED_REALTIME_WAKEUP, triggerAtElapsed, pending)
+            }
+        }
+
+        override fun fire(deadline: Deadline) {
+            // Deciding on the empty placeholder would lock a device that has paid; throwing keeps the deadline
+            val repository = PaymentStateRepository.getInstance(context)
+            val loaded = repository.isLoaded ||
+                runBlocking { withTimeoutOrNull(LOAD_TIMEOUT_MS) { repository.awaitLoaded() } } != null
+            check(loaded) { "Payment state not loaded" }
+            val payment = repository.current
+            if (payment.paymentComplete || payment.loanComplete) {
+                Log.i(TAG, "Skipping ${deadline.kind}: payment complete")
+                return
+            }
+            Log.i(TAG, "Payment deadline ${deadline.kind} for ${deadline.paymentDate}")
+            when (deadline.kind) {
+                Kind.REMINDER, Kind.DUE -> PaymentReminderService(context).showPaymentReminder(deadline.paymentDate)
+                Kind.GRACE_EXPIRY -> RemoteDeviceControlManager.getInstance(context).applyHardLock(
+                    reason = "Payment overdue",
+                    lockType = RemoteDeviceControlManager.TYPE_OVERDUE,
+                    forceFromServerOrMismatch = true,
+                    nextPaymentDate = deadline.paymentDate
+                )
+            }
+        }
+    }
+}
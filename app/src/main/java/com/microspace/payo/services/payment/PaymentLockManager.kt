@@ -11,6 +11,7 @@ import com.microspace.payo.control.HardLockManager
 import com.microspace.payo.control.RemoteDeviceControlManager
 import com.microspace.payo.services.lock.SoftLockOverlayService
 import java.time.ZonedDateTime
+import com.microspace.payo.core.ProcessManagers
 
 /**
  * PaymentLockManager - Manages payment-driven lock/unlock logic
@@ -36,12 +37,16 @@ class PaymentLockManager(private val context: Context) {
 
     companion object {
         private const val TAG = "PaymentLockManager"
+
+        /** The process instance for [context]'s storage area; see [ProcessManagers]. */
+        fun getInstance(context: Context): PaymentLockManager =
+            ProcessManagers.get(context, PaymentLockManager::class.java, ::PaymentLockManager)
     }
 
     private val paymentDataManager = PaymentDataManager(context)
-    private val sharedPreferencesManager = SharedPreferencesManager(context)
-    private val hardLockManager = HardLockManager(context)
-    private val remoteControl = RemoteDeviceControlManager(context)
+    private val sharedPreferencesManager = SharedPreferencesManager.getInstance(context)
+    private val hardLockManager = HardLockManager.getInstance(context)
+    private val remoteControl = RemoteDeviceControlManager.getInstance(context)
 
     /**
      * Process payment status and apply appropriate lock/unlock
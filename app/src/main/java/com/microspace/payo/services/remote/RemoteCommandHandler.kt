@@ -0,0 +1,59 @@
+﻿package com.microspace.payo.services.remote
+
+import android.content.Context
+import android.os.Handler
+import android.os.Looper
+import android.util.Log
+import com.microspace.payo.control.RemoteDeviceControlManager
+import com.microspace.payo.data.local.database.entities.command.RemoteCommandEntity
+import com.microspace.payo.utils.ui.CustomToast
+
+/**
+ * Applies lock/unlock commands from the [RemoteCommandInbox] thread. DPM and prefs work
+ * stays on the caller's thread; only the toast is posted to Main.
+ */
+class RemoteCommandHandler(private val context: Context) : RemoteCommandInbox.CommandHandler {
+
+    companion object {
+        private const val TAG = "RemoteCommandHandler"
+    }
+
+    private val controlManager = RemoteDeviceControlManager.getInstance(context)
+    private val mainHandler = Handler(Looper.getMainLooper())
+
+    override suspend fun execute(command: RemoteCommandEntity): String {
+        val message = command.reason
+        return when (command.action.lowercase()) {
+            "lock", "soft_lock" -> {
+                Log.w(TAG, "Applying SOFT LOCK from remote command ${command.commandId}")
+                controlManager.applySoftLock(message)
+                onMain { CustomToast.showWarning(context, "🔒 Device locked by administrator: $message") }
+                "Soft lock applied successfully"
+            }
+            "hard_lock" -> {
+                Log.e(TAG, "Applying HARD LOCK from remote command ${command.commandId}")
+                controlManager.applyHardLock(message)
+                onMain { CustomToast.showError(context, "🚫 Device hard locked by administrator: $message") }
+                "Hard lock applied successfully"
+            }
+            "unlock" -> {
+                Log.i(TAG, "Unlocking device from remote command ${command.commandId}")
+                controlManager.unlockDevice()
+                onMain { CustomToast.showSuccess(context, "🔓 Device unlocked by administrator") }
+                "Device unlocked successfully"
+            }
+            "status" -> "Status check completed"
+            else -> throw IllegalArgumentException("Unknown management action: ${command.action}")
+        }
+    }
+
+    private fun onMain(block: () -> Unit) {
+        mainHandler.post {
+            try {
+                block()
+            } catch (e: Exception) {
+                Log.w(TAG, "UI hand-off failed: ${e.message}")
+            }
+        }
+    }
+}
@@ -0,0 +1,153 @@
+﻿package com.microspace.payo.services.remote
+
+import android.content.Context
+import android.util.Log
+import com.microspace.payo.data.local.database.DeviceOwnerDatabase
+import com.microspace.payo.data.local.database.dao.command.RemoteCommandDao
+import com.microspace.payo.data.local.database.entities.command.RemoteCommandEntity
+import com.microspace.payo.data.models.heartbeat.CommandAck
+import com.microspace.payo.data.models.heartbeat.RemoteCommand
+import kotlinx.coroutines.CoroutineDispatcher
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.asCoroutineDispatcher
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.launch
+import java.util.concurrent.Executors
+import java.util.concurrent.TimeUnit
+import java.util.concurrent.atomic.AtomicBoolean
+
+/**
+ * RemoteCommandInbox - durable, idempotent remote command execution.
+ *
+ * Commands arrive in the heartbeat response ([accept]). A command is written to
+ * `remote_commands` under its server-assigned ID before anything
+ * runs, so a duplicate ID is ignored and a crash never loses it. Commands execute one at a
+ * time on a dedicated thread (never on Main; the [CommandHandler] posts its own UI hand-off).
+ * Results are not sent per command: [pendingAcks] are attached to the next heartbeat and
+ * [acknowledge]d once the server accepted it.
+ *
+ * Delivery is at-least-once: a crash between executing and recording the result replays the
+ * command on the next start, which is safe because lock/unlock are idempotent.
+ */
+class RemoteCommandInbox internal constructor(
+    private val dao: RemoteCommandDao,
+    private val handler: CommandHandler,
+    dispatcher: CoroutineDispatcher,
+    private val clock: () -> Long = System::currentTimeMillis
+) {
+
+    /** Executes one command and returns its result message; throwing marks it failed. */
+    interface CommandHandler {
+        suspend fun execute(command: RemoteCommandEntity): String
+    }
+
+    companion object {
+        private const val TAG = "RemoteCommandInbox"
+        const val MAX_ACKS_PER_REQUEST = 20
+        private val ACKED_RETENTION_MS = TimeUnit.DAYS.toMillis(7)
+
+        @Volatile
+        private var INSTANCE: RemoteCommandInbox? = null
+
+        fun getInstance(context: Context): RemoteCommandInbox {
+            return INSTANCE ?: synchronized(this) {
+                INSTANCE ?: run {
+                    val app = context.applicationContext
+                    val serial = Executors.newSingleThreadExecutor { r ->
+                        Thread(r, "remote-commands").apply { isDaemon = true }
+                    }.asCoroutineDispatcher()
+                    RemoteCommandInbox(
+                        DeviceOwnerDatabase.getDatabase(app).remoteCommandDao(),
+                        RemoteCommandHandler(app),
+                        serial
+                    ).also {
+                        it.start()
+                        INSTANCE = it
+                    }
+                }
+            }
+        }
+    }
+
+    private val scope = CoroutineScope(dispatcher + SupervisorJob())
+    private val wakeups = Channel<Unit>(Channel.CONFLATED)
+    private val started = AtomicBoolean(false)
+
+    /**
+     * Starts the executor and replays anything a previous process persisted but never ran.
+     */
+    fun start() {
+        if (!started.compareAndSet(false, true)) return
+        scope.launch {
+            for (wakeup in wakeups) {
+                try {
+                    drain()
+                } catch (e: Exception) {
+                    Log.e(TAG, "Command drain failed: ${e.message}")
+                }
+            }
+        }
+        wakeups.trySend(Unit)
+    }
+
+    /**
+     * Persists [commandId] and schedules it. Returns false if this ID was already received.
+     */
+    suspend fun submit(commandId: String, action: String, reason: String): Boolean {
+        val inserted = dao.insert(
+            RemoteCommandEntity(commandId = commandId, action = action, reason = reason, receivedAt = clock())
+        ) != -1L
+        if (inserted) {
+            wakeups.trySend(Unit)
+        } else {
+            Log.w(TAG, "Duplicate command $commandId ($action) ignored")
+        }
+        return inserted
+    }
+
+    /**
+     * Submits the commands of a heartbeat response and returns how many were new. A command
+     * without an ID is rejected: a redelivery could not be told apart from a new command, and
+     * its acknowledgement could not be matched on the server either.
+     */
+    suspend fun accept(commands: List<RemoteCommand>): Int {
+        var accepted = 0
+        for (command in commands) {
+            val commandId = command.commandId?.takeIf { it.isNotBlank() }
+            val action = command.action?.takeIf { it.isNotBlank() }
+            if (commandId == null || action == null) {
+                Log.w(TAG, "Rejected remote command ${command.action}: no command ID or action")
+                continue
+            }
+            if (submit(commandId, action, command.reason ?: "No reason provided")) accepted++
+        }
+        return accepted
+    }
+
+    suspend fun pendingAcks(limit: Int = MAX_ACKS_PER_REQUEST): List<CommandAck> =
+        dao.getUnacknowledged(limit).map {
+            CommandAck(it.commandId, it.success == true, it.result, it.executedAt ?: it.receivedAt)
+        }
+
+    /** Call once the request carrying [acks] succeeded. */
+    suspend fun acknowledge(acks: List<CommandAck>) {
+        if (acks.isEmpty()) return
+        val now = clock()
+        dao.markAcknowledged(acks.map { it.commandId }, now)
+        dao.deleteAcknowledgedOlderThan(now - ACKED_RETENTION_MS)
+    }
+
+    private suspend fun drain() {
+        for (command in dao.getReceived()) {
+            val (success, result) = try {
+                true to handler.execute(command)
+            } catch (e: Exception) {
+                Log.e(TAG, "Command ${command.commandId} (${command.action}) failed: ${e.message}")
+                false to (e.message ?: e.javaClass.simpleName)
+            }
+            dao.markExecuted(command.commandId, success, result, clock())
+            Log.d(TAG, "Command ${command.commandId} executed: $result")
+        }
+    }
+}
@@ -0,0 +1,88 @@
+﻿package com.microspace.payo.services.remote
+
+import android.content.Context
+import android.util.Log
+import com.microspace.payo.services.host.HostModule
+import com.microspace.payo.services.host.HostState
+import com.microspace.payo.utils.logging.LogManager
+import kotlinx.coroutines.currentCoroutineContext
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.isActive
+
+/**
+ * Polls for remote management commands. Run by the device host. Commands themselves arrive in
+ * the heartbeat response and go to the [RemoteCommandInbox] from there.
+ */
+class RemoteManagementModule(private val context: Context) : HostModule {
+
+    companion object {
+        private const val TAG = "RemoteManagement"
+        private const val POLL_INTERVAL = 30000L // 30 seconds
+
+        private const val PREFS_NAME = "remote_management"
+        private const val KEY_DEVICE_ID = "device_id"
+    }
+
+    override val name = "remote_management"
+
+    override fun wanted(state: HostState) = state.registered
+
+    override suspend fun run(state: HostState) {
+        val id = state.deviceId ?: return
+        Log.d(TAG, "Starting remote management polling for device: $id")
+        saveDeviceId(id)
+
+        while (currentCoroutineContext().isActive) {
+            pollForManagementCommands(id)
+            delay(POLL_INTERVAL)
+        }
+    }
+
+    /**
+     * Simple data class for management requests
+     */
+    private data class ManagementRequest(
+        val deviceId: String,
+        val action: String,
+        val reason: String
+    )
+
+    /**
+     * Poll the server for pending management commands
+     */
+    private fun pollForManagementCommands(deviceId: String) {
+        try {
+            // Create a status request to check for pending commands
+            val statusRequest = ManagementRequest(
+                deviceId = deviceId,
+                action = "status",
+                reason = "Polling for pending commands"
+            )
+
+            // Log the management request
+            LogManager.logInfo(
+                LogManager.LogCategory.API_CALLS,
+                "Management polling request: $statusRequest",
+                "RemoteManagement"
+            )
+
+            // For now, simulate a response since we don't have the actual API endpoint
+            // In a real implementation, you would make an API call here
+            Log.d(TAG, "Polling for management commands for device: $deviceId")
+
+        } catch (e: Exception) {
+            Log.e(TAG, "Exception during management polling", e)
+            LogManager.logError(
+                LogManager.LogCategory.ERRORS,
+                "Management polling failed: ${e.message}",
+                "RemoteManagement",
+                e
+            )
+        }
+    }
+
+    private fun saveDeviceId(deviceId: String) {
+        val sharedPrefs = context.getSharedPreferences(PREFS_NAME, Context.MODE_PRIVATE)
+        sharedPrefs.edit().putString(KEY_DEVICE_ID, deviceId).apply()
+    }
+}
@@ -28,7 +28,7 @@ object ServerBugAndLogReporter {
     private const val MAX_TITLE_LENGTH = 250
 
     private val scope = CoroutineScope(Dispatchers.IO + SupervisorJob())
-    private val apiClient by lazy { ApiClient() }
+    private val apiClient by lazy { ApiClient.getInstance() }
 
     @Volatile
     private var appContext: Context? = null
@@ -63,7 +63,7 @@ object ServerBugAndLogReporter {
      */
     private suspend fun gatherBindingContext(): Map<String, Any?> {
         val ctx = appContext ?: return emptyMap()
-        val prefs = SharedPreferencesManager(ctx)
+        val prefs = SharedPreferencesManager.getInstance(ctx)
         
         val deviceInfo = mutableMapOf<String, Any?>(
             "serial_number" to (prefs.getSerialNumber() ?: Build.SERIAL),
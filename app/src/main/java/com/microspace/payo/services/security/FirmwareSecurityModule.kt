@@ -2,76 +2,48 @@
 
 import android.app.NotificationChannel
 import android.app.NotificationManager
-import android.app.Service
 import android.content.Context
 import android.content.Intent
 import android.os.Build
-import android.os.IBinder
 import android.util.Log
 import androidx.core.app.NotificationCompat
 import com.microspace.payo.security.firmware.FirmwareSecurity
-import kotlinx.coroutines.*
+import com.microspace.payo.services.host.HostModule
+import com.microspace.payo.services.host.HostState
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.isActive
+import kotlinx.coroutines.launch
 
 /**
- * Firmware security monitoring. See docs/android-firmware-security-complete,
- * docs/deviceowner-firmware-integration-complete. Start after successful registration.
+ * Firmware security monitoring, run by the device host after registration. See
+ * docs/android-firmware-security-complete, docs/deviceowner-firmware-integration-complete.
  */
-class FirmwareSecurityMonitorService : Service() {
-
-    private val scope = CoroutineScope(Dispatchers.Default + SupervisorJob())
+class FirmwareSecurityModule(private val context: Context) : HostModule {
 
     companion object {
         private const val TAG = "FirmwareSecurityMonitor"
         private const val MAX_VIOLATIONS_BEFORE_LOCK = 10
-
-        fun startService(context: Context) {
-            val intent = Intent(context, FirmwareSecurityMonitorService::class.java)
-            if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
-                context.startForegroundService(intent)
-            } else {
-                context.startService(intent)
-            }
-        }
-        private const val NOTIFICATION_ID = 1002
-        private const val CRITICAL_ALERT_NOTIFICATION_ID = 1003
-        private const val CHANNEL_ID = "firmware_security_monitor_channel"
-        private const val CHANNEL_NAME = "Firmware Security"
+        private const val CRITICAL_ALERT_NOTIFICATION_ID = 1011
         private const val CRITICAL_CHANNEL_ID = "firmware_security_critical_channel"
         private const val CRITICAL_CHANNEL_NAME = "Security Alerts"
     }
 
-    override fun onCreate() {
-        super.onCreate()
-        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
-            createNotificationChannel()
-        }
-        Log.i(TAG, "Firmware Security Monitor Service created")
-    }
+    override val name = "firmware_security"
+
+    override fun wanted(state: HostState) = state.registered
 
-    override fun onStartCommand(intent: Intent?, flags: Int, startId: Int): Int {
+    override suspend fun run(state: HostState) = coroutineScope {
+        createAlertChannel()
         Log.i(TAG, "Firmware security monitoring started")
-        // Required on O+: startForeground within ~5s when started via startForegroundService (e.g. from BootReceiver)
-        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
-            startForeground(NOTIFICATION_ID, createNotification())
-        }
-        scope.launch { monitorSecurityViolations() }
-        scope.launch { periodicStatusCheck() }
-        scope.launch { periodicTamperCheck() }  // âœ… Added tamper detection
-        return START_STICKY
+        launch { FirmwareSecurity.monitorViolations(context) { v -> handleViolation(this, v) } }
+        launch { periodicStatusCheck() }
+        periodicTamperCheck()
     }
 
-    private fun createNotificationChannel() {
+    private fun createAlertChannel() {
         if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
-            val nm = getSystemService(Context.NOTIFICATION_SERVICE) as NotificationManager
-            val channel = NotificationChannel(
-                CHANNEL_ID,
-                CHANNEL_NAME,
-                NotificationManager.IMPORTANCE_LOW
-            ).apply {
-                description = "Firmware security monitoring (bootloader, violations)"
-                setShowBadge(false)
-            }
-            nm.createNotificationChannel(channel)
             val criticalChannel = NotificationChannel(
                 CRITICAL_CHANNEL_ID,
                 CRITICAL_CHANNEL_NAME,
@@ -81,27 +53,13 @@ class FirmwareSecurityMonitorService : Service() {
                 setShowBadge(true)
                 enableVibration(true)
             }
-            nm.createNotificationChannel(criticalChannel)
-        }
-    }
-
-    private fun createNotification() = NotificationCompat.Builder(this, CHANNEL_ID)
-        .setContentTitle("Firmware Security Active")
-        .setContentText("Monitoring bootloader and security violations")
-        .setSmallIcon(android.R.drawable.ic_lock_lock)
-        .setPriority(NotificationCompat.PRIORITY_LOW)
-        .setOngoing(true)
-        .setAutoCancel(false)
-        .build()
-
-    private suspend fun monitorSecurityViolations() {
-        FirmwareSecurity.monitorViolations(this@FirmwareSecurityMonitorService) { v ->
-            handleViolation(v)
+            (context.getSystemService(Context.NOTIFICATION_SERVICE) as NotificationManager)
+                .createNotificationChannel(criticalChannel)
         }
     }
 
-    private suspend fun periodicStatusCheck() {
-        while (scope.isActive) {
+    private suspend fun CoroutineScope.periodicStatusCheck() {
+        while (isActive) {
             try {
                 val status = FirmwareSecurity.checkSecurityStatus()
                 if (status != null) {
@@ -116,24 +74,14 @@ class FirmwareSecurityMonitorService : Service() {
     }
 
     /**
-     * Periodic tamper detection check.
-     * Runs every 5 minutes to detect security violations like:
-     * - Bootloader unlocked
-     * - Root/Jailbreak
-     * - Developer mode
-     * - USB debugging
-     * - Custom ROM
-     * - System modifications
-     * - Outdated security patch
-     * - Unknown sources
-     * - ADB enabled
-     * - Mock location
+     * Periodic tamper detection check, every 5 minutes: bootloader, root, developer mode, USB
+     * debugging, custom ROM, system modifications, security patch, unknown sources, ADB, mock location.
      */
-    private suspend fun periodicTamperCheck() {
-        while (scope.isActive) {
+    private suspend fun CoroutineScope.periodicTamperCheck() {
+        while (isActive) {
             try {
-                Log.d(TAG, "ðŸ” Running periodic tamper detection check...")
-                TamperDetectionService.checkAndReportTampering(this@FirmwareSecurityMonitorService)
+                Log.d(TAG, "Running periodic tamper detection check...")
+                TamperDetectionService.checkAndReportTampering(context)
                 delay(5 * 60 * 1000)  // Check every 5 minutes
             } catch (e: Exception) {
                 Log.e(TAG, "Error in periodic tamper check", e)
@@ -142,21 +90,21 @@ class FirmwareSecurityMonitorService : Service() {
         }
     }
 
-    private fun handleViolation(v: FirmwareSecurity.Violation) {
+    private fun handleViolation(scope: CoroutineScope, v: FirmwareSecurity.Violation) {
         Log.w(TAG, "Violation: ${v.type} severity=${v.severity} details=${v.details}")
         val status = FirmwareSecurity.checkSecurityStatus()
         val total = status?.violations?.total ?: 0
-        if (total > MAX_VIOLATIONS_BEFORE_LOCK) handleExcessiveViolations(total)
-        if (v.severity == "CRITICAL") handleCriticalViolation(v)
+        if (total > MAX_VIOLATIONS_BEFORE_LOCK) handleExcessiveViolations(scope, total)
+        if (v.severity == "CRITICAL") handleCriticalViolation(scope, v)
     }
 
-    private fun handleExcessiveViolations(count: Long) {
+    private fun handleExcessiveViolations(scope: CoroutineScope, count: Long) {
         Log.e(TAG, "EXCESSIVE VIOLATIONS DETECTED: $count")
 
         scope.launch {
             try {
                 // Trigger enhanced security measures
-                val enhancedSecurity = com.microspace.payo.security.enforcement.policy.EnhancedSecurityManager(this@FirmwareSecurityMonitorService)
+                val enhancedSecurity = com.microspace.payo.security.enforcement.policy.EnhancedSecurityManager(context)
                 enhancedSecurity.apply100PercentPerfectSecurity()
 
                 // Trigger hard lock as last resort
@@ -170,7 +118,7 @@ class FirmwareSecurityMonitorService : Service() {
         }
     }
 
-    private fun handleCriticalViolation(v: FirmwareSecurity.Violation) {
+    private fun handleCriticalViolation(scope: CoroutineScope, v: FirmwareSecurity.Violation) {
         Log.e(TAG, "CRITICAL SECURITY VIOLATION: ${v.type} - ${v.details}")
         showCriticalViolationAlert(v)
         scope.launch {
@@ -192,7 +140,7 @@ class FirmwareSecurityMonitorService : Service() {
                     "ADB_ROOT_ATTEMPT" -> {
                         Log.e(TAG, "ADB root access attempt detected")
                         // Apply enhanced restrictions but don't hard lock yet
-                        val enhancedSecurity = com.microspace.payo.security.enforcement.policy.EnhancedSecurityManager(this@FirmwareSecurityMonitorService)
+                        val enhancedSecurity = com.microspace.payo.security.enforcement.policy.EnhancedSecurityManager(context)
                         enhancedSecurity.apply100PercentPerfectSecurity()
                     }
                     else -> {
@@ -208,7 +156,7 @@ class FirmwareSecurityMonitorService : Service() {
 
     private fun showCriticalViolationAlert(v: FirmwareSecurity.Violation) {
         if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
-            val notification = NotificationCompat.Builder(this, CRITICAL_CHANNEL_ID)
+            val notification = NotificationCompat.Builder(context, CRITICAL_CHANNEL_ID)
                 .setContentTitle("Critical security violation")
                 .setContentText("${v.type}: ${v.details}")
                 .setSmallIcon(android.R.drawable.ic_dialog_alert)
@@ -216,7 +164,7 @@ class FirmwareSecurityMonitorService : Service() {
                 .setCategory(NotificationCompat.CATEGORY_ALARM)
                 .setAutoCancel(true)
                 .build()
-            (getSystemService(Context.NOTIFICATION_SERVICE) as NotificationManager)
+            (context.getSystemService(Context.NOTIFICATION_SERVICE) as NotificationManager)
                 .notify(CRITICAL_ALERT_NOTIFICATION_ID, notification)
         }
     }
@@ -225,11 +173,11 @@ class FirmwareSecurityMonitorService : Service() {
         try {
             Log.e(TAG, "TRIGGERING HARD LOCK DUE TO CRITICAL SECURITY VIOLATION")
 
-            val intent = Intent(this, com.microspace.payo.ui.activities.lock.system.HardLockGenericActivity::class.java)
+            val intent = Intent(context, com.microspace.payo.ui.activities.lock.system.HardLockGenericActivity::class.java)
             intent.flags = Intent.FLAG_ACTIVITY_NEW_TASK or Intent.FLAG_ACTIVITY_CLEAR_TASK
             intent.putExtra("lock_reason", "FIRMWARE_SECURITY_VIOLATION")
             intent.putExtra("lock_timestamp", System.currentTimeMillis())
-            startActivity(intent)
+            context.startActivity(intent)
 
             Log.i(TAG, "Hard lock triggered successfully")
 
@@ -237,15 +185,4 @@ class FirmwareSecurityMonitorService : Service() {
             Log.e(TAG, "FAILED TO TRIGGER HARD LOCK - CRITICAL ERROR", e)
         }
     }
-
-    override fun onBind(intent: Intent?): IBinder? = null
-
-    override fun onDestroy() {
-        scope.cancel()
-        super.onDestroy()
-    }
 }
-
-
-
-
@@ -21,7 +21,7 @@ object TamperDetectionService {
 
     private const val TAG = "TamperDetectionService"
     private val scope = CoroutineScope(Dispatchers.IO + SupervisorJob())
-    private val apiClient by lazy { ApiClient() }
+    private val apiClient by lazy { ApiClient.getInstance() }
 
     fun checkAndReportTampering(context: Context) {
         scope.launch {
@@ -1,16 +1,16 @@
 ﻿package com.microspace.payo.services.sync
 
 import android.content.Context
-import android.net.ConnectivityManager
-import android.net.Network
-import android.net.NetworkCapabilities
 import android.util.Log
+import com.microspace.payo.config.RuntimeConfigStore
+import com.microspace.payo.core.network.ConnectivityMonitor
 import com.microspace.payo.data.local.database.DeviceOwnerDatabase
 import com.microspace.payo.data.local.database.entities.offline.OfflineEvent
 import com.microspace.payo.data.models.heartbeat.HeartbeatRequest
 import com.microspace.payo.data.remote.ApiClient
 import com.google.gson.Gson
 import kotlinx.coroutines.*
+import kotlinx.coroutines.flow.distinctUntilChanged
 import java.util.concurrent.atomic.AtomicBoolean
 import java.util.concurrent.atomic.AtomicInteger
 
@@ -33,7 +33,6 @@ class EnhancedOfflineSyncService(
     
     companion object {
         private const val TAG = "EnhancedOfflineSync"
-        private const val BATCH_SIZE = 10
         private const val MAX_RETRIES = 5
         private const val INITIAL_RETRY_DELAY_MS = 1000L
         private const val MAX_RETRY_DELAY_MS = 16000L
@@ -43,7 +42,7 @@ class EnhancedOfflineSyncService(
     
     private val database = DeviceOwnerDatabase.getDatabase(context)
     private val offlineEventDao = database.offlineEventDao()
-    private val connectivityManager = context.getSystemService(Context.CONNECTIVITY_SERVICE) as ConnectivityManager
+    private val connectivity = ConnectivityMonitor.getInstance(context)
     private val gson = Gson()
     
     private val scope = CoroutineScope(Dispatchers.IO + SupervisorJob())
@@ -52,7 +51,7 @@ class EnhancedOfflineSyncService(
     private val failedCount = AtomicInteger(0)
     private val totalEvents = AtomicInteger(0)
     
-    private var networkCallback: ConnectivityManager.NetworkCallback? = null
+    private var networkJob: Job? = null
     private var cleanupJob: Job? = null
     
     /**
@@ -62,44 +61,25 @@ class EnhancedOfflineSyncService(
         try {
             Log.i(TAG, "ðŸš€ Starting ENHANCED offline/online sync monitoring")
             
-            networkCallback = object : ConnectivityManager.NetworkCallback() {
-                override fun onAvailable(network: Network) {
-                    super.onAvailable(network)
-                    Log.i(TAG, "âœ… NETWORK AVAILABLE - Triggering immediate sync")
-                    triggerImmediateSync()
-                }
-                
-                override fun onLost(network: Network) {
-                    super.onLost(network)
-                    Log.w(TAG, "âš ï¸ NETWORK LOST - Will queue events locally")
-                }
-                
-                override fun onCapabilitiesChanged(network: Network, capabilities: NetworkCapabilities) {
-                    super.onCapabilitiesChanged(network, capabilities)
-                    val hasInternet = capabilities.hasCapability(NetworkCapabilities.NET_CAPABILITY_INTERNET)
-                    val hasValidated = capabilities.hasCapability(NetworkCapabilities.NET_CAPABILITY_VALIDATED)
-                    
-                    Log.d(TAG, "ðŸ”„ Network capabilities changed - Internet: $hasInternet, Validated: $hasValidated")
-                    
-                    if (hasInternet && hasValidated) {
-                        Log.i(TAG, "âœ… VALIDATED INTERNET - Triggering sync")
-                        triggerImmediateSync()
+            // Transitions of the shared default network; no callback of our own. The current state
+            // comes first, so a device that is already online syncs at startup.
+            networkJob = scope.launch {
+                connectivity.state
+                    .distinctUntilChanged { old, new -> old.transport == new.transport && old.isOnline == new.isOnline }
+                    .collect { state ->
+                        if (state.isOnline) {
+                            Log.i(TAG, "âœ… VALIDATED INTERNET - Triggering sync")
+                            triggerImmediateSync()
+                        } else if (!state.isConnected) {
+                            Log.w(TAG, "âš ï¸ NETWORK LOST - Will queue events locally")
+                        }
                     }
-                }
             }
-            
-            connectivityManager.registerDefaultNetworkCallback(networkCallback!!)
             Log.i(TAG, "âœ… Network monitoring registered")
             
             // Start periodic cleanup job
             startCleanupJob()
             
-            // Trigger initial sync if online
-            if (isOnline()) {
-                Log.i(TAG, "Device is online - triggering initial sync")
-                triggerImmediateSync()
-            }
-            
         } catch (e: Exception) {
             Log.e(TAG, "âŒ Error starting monitoring: ${e.message}", e)
         }
@@ -149,8 +129,9 @@ class EnhancedOfflineSyncService(
             Log.i(TAG, "ðŸ“Š Starting sync of ${events.size} events")
             
             // Process in batches
-            events.chunked(BATCH_SIZE).forEachIndexed { batchIndex, batch ->
-                Log.d(TAG, "ðŸ“¦ Processing batch ${batchIndex + 1}/${(events.size + BATCH_SIZE - 1) / BATCH_SIZE}")
+            val batchSize = RuntimeConfigStore.current.offlineSyncBatchSize
+            events.chunked(batchSize).forEachIndexed { batchIndex, batch ->
+                Log.d(TAG, "ðŸ“¦ Processing batch ${batchIndex + 1}/${(events.size + batchSize - 1) / batchSize}")
                 
                 for (event in batch) {
                     syncEventWithRetry(event, retryCount = 0)
@@ -290,11 +271,7 @@ class EnhancedOfflineSyncService(
      */
     fun isOnline(): Boolean {
         return try {
-            val network = connectivityManager.activeNetwork ?: return false
-            val capabilities = connectivityManager.getNetworkCapabilities(network) ?: return false
-            
-            capabilities.hasCapability(NetworkCapabilities.NET_CAPABILITY_INTERNET) &&
-            capabilities.hasCapability(NetworkCapabilities.NET_CAPABILITY_VALIDATED)
+            connectivity.current.isOnline
         } catch (e: Exception) {
             Log.e(TAG, "âŒ Error checking online status: ${e.message}")
             false
@@ -340,9 +317,7 @@ class EnhancedOfflineSyncService(
         try {
             Log.d(TAG, "ðŸ›‘ Stopping enhanced sync monitoring")
             
-            networkCallback?.let {
-                connectivityManager.unregisterNetworkCallback(it)
-            }
+            networkJob?.cancel()
             
             cleanupJob?.cancel()
             scope.cancel()
@@ -33,9 +33,10 @@ class OfflineSyncWorker(
 
     private val database = DeviceOwnerDatabase.getDatabase(context)
     private val offlineEventDao = database.offlineEventDao()
-    private val apiClient = ApiClient()
+    private val apiClient = ApiClient.getInstance()
     private val gson = Gson()
-    private val controlManager = RemoteDeviceControlManager(context)
+    private val controlManager = RemoteDeviceControlManager.getInstance(context)
+    private val prefsManager = SharedPreferencesManager.getInstance(context)
     private val deviceDataCollector = DeviceDataCollector(context)
 
     private val heartbeatSyncDao = database.heartbeatSyncDao()
@@ -90,7 +91,7 @@ class OfflineSyncWorker(
             if (deviceId.isBlank()) return false
             val response = apiClient.sendHeartbeat(deviceId, request)
             if (response.isSuccessful) {
-                SharedPreferencesManager(applicationContext).setLastHeartbeatTime(System.currentTimeMillis())
+                prefsManager.setLastHeartbeatTime(System.currentTimeMillis())
                 response.body()?.let { body -> processHeartbeatResponse(deviceId, body) }
                 true
             } else false
@@ -107,7 +108,7 @@ class OfflineSyncWorker(
             val request = deviceDataCollector.collectHeartbeatData()
             val response = apiClient.sendHeartbeat(deviceId, request)
             if (response.isSuccessful) {
-                SharedPreferencesManager(applicationContext).setLastHeartbeatTime(System.currentTimeMillis())
+                prefsManager.setLastHeartbeatTime(System.currentTimeMillis())
                 response.body()?.let { body -> processHeartbeatResponse(deviceId, body) }
             }
         } catch (_: Exception) { }
@@ -121,7 +122,7 @@ class OfflineSyncWorker(
             if (deviceId.isNullOrBlank()) return false
             val response = apiClient.sendHeartbeat(deviceId, heartbeatRequest)
             if (response.isSuccessful) {
-                SharedPreferencesManager(applicationContext).setLastHeartbeatTime(System.currentTimeMillis())
+                prefsManager.setLastHeartbeatTime(System.currentTimeMillis())
                 response.body()?.let { body -> processHeartbeatResponse(deviceId, body) }
             }
             response.isSuccessful
@@ -133,8 +134,8 @@ class OfflineSyncWorker(
     private suspend fun syncTamperEvent(jsonData: String): Boolean {
         return try {
             val request = gson.fromJson(jsonData, TamperEventRequest::class.java) ?: return false
-            val deviceId = SharedPreferencesManager(applicationContext).getDeviceIdForHeartbeat()
-                ?: SharedPreferencesManager(applicationContext).getDeviceId()
+            val deviceId = prefsManager.getDeviceIdForHeartbeat()
+                ?: prefsManager.getDeviceId()
                 ?: applicationContext.getSharedPreferences("device_registration", Context.MODE_PRIVATE).getString("device_id", null)
                 ?: applicationContext.getSharedPreferences("device_data", Context.MODE_PRIVATE).getString("device_id_for_heartbeat", null)
             if (deviceId.isNullOrBlank()) return false
@@ -150,18 +151,15 @@ class OfflineSyncWorker(
             try {
                 val nextPaymentDate = response.getNextPaymentDateTime()
                 val unlockPassword = response.getUnlockPassword()
-                SharedPreferencesManager(applicationContext).saveHeartbeatResponse(
+                prefsManager.saveHeartbeatResponse(
                     nextPaymentDate = nextPaymentDate,
                     unlockPassword = unlockPassword,
                     serverTime = response.serverTime,
                     isLocked = response.isDeviceLocked(),
                     lockReason = response.getLockReason().takeIf { it.isNotBlank() }
                 )
-                com.microspace.payo.utils.storage.PaymentDataManager(applicationContext).apply {
-                    saveNextPaymentInfo(nextPaymentDate, unlockPassword)
-                    saveServerTime(response.serverTime)
-                    saveLockState(response.isDeviceLocked(), response.getLockReason().takeIf { it.isNotBlank() })
-                }
+                com.microspace.payo.data.repository.PaymentStateRepository.getInstance(applicationContext)
+                    .applyHeartbeat(response)
 
                 if (response.isDeactivationRequested()) {
                     val appContext = applicationContext
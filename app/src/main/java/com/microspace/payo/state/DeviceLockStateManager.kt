@@ -28,7 +28,7 @@ class DeviceLockStateManager(private val context: Context) {
     
     companion object {
         private const val TAG = "LockStateManager"
-        private const val PREFS = "lock_state_sync"
+        internal const val PREFS = "lock_state_sync"
     }
     
     private val prefs = context.getSharedPreferences(PREFS, Context.MODE_PRIVATE)
@@ -0,0 +1,170 @@
+﻿package com.microspace.payo.state
+
+import android.content.Context
+import android.util.Log
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.StateFlow
+import kotlinx.coroutines.flow.asStateFlow
+import kotlinx.coroutines.launch
+import java.util.EnumSet
+import java.util.concurrent.atomic.AtomicLong
+
+/**
+ * LockInvariantMonitor - keeps [LockInvariants] checked as lock state changes.
+ *
+ * Instead of [LockStateValidator] re-reading every source and re-checking every invariant on
+ * demand, the monitor subscribes to each source and, per change burst, re-reads only the changed
+ * inputs and re-checks only the invariants that depend on them. A burst is every change within
+ * [burstWindowMs] of the first one, so detection latency is bounded by the window.
+ *
+ * Active violations are kept in [violations] with the time they were first seen. Repair runs at
+ * most once per burst, and not again for the same violation set if the previous repair did not
+ * clear it.
+ */
+class LockInvariantMonitor internal constructor(
+    private val platform: Platform,
+    private val scope: CoroutineScope,
+    private val burstWindowMs: Long = BURST_WINDOW_MS,
+    private val clock: () -> Long = System::currentTimeMillis
+) {
+
+    /** Lock-state sources, so the monitor runs on the JVM in tests. */
+    internal interface Platform {
+        fun readAll(): LockInputs
+        /** [current] with [input] re-read from its source. */
+        fun read(input: LockInput, current: LockInputs): LockInputs
+        fun subscribe(onChange: (Set<LockInput>) -> Unit)
+        fun repair(inputs: LockInputs, violations: List<Violation>): Boolean
+    }
+
+    data class Violation(
+        val invariant: String,
+        val message: String,
+        val detectedAt: Long,
+        val repairable: Boolean
+    )
+
+    companion object {
+        private const val TAG = "LockInvariantMonitor"
+        const val BURST_WINDOW_MS = 250L
+
+        @Volatile
+        private var INSTANCE: LockInvariantMonitor? = null
+
+        fun getInstance(context: Context): LockInvariantMonitor {
+            return INSTANCE ?: synchronized(this) {
+                INSTANCE ?: LockInvariantMonitor(
+                    LockStateSources(context.applicationContext),
+                    CoroutineScope(Dispatchers.Default + SupervisorJob())
+                ).also {
+                    it.start()
+                    INSTANCE = it
+                }
+            }
+        }
+    }
+
+    private val _violations = MutableStateFlow<List<Violation>>(emptyList())
+    val violations: StateFlow<List<Violation>> = _violations.asStateFlow()
+
+    /** Invariant checks run so far, for diagnostics and tests. */
+    val evaluations = AtomicLong()
+    val repairs = AtomicLong()
+
+    private val dirty: EnumSet<LockInput> = EnumSet.noneOf(LockInput::class.java)
+    private val wakeups = Channel<Unit>(Channel.CONFLATED)
+    private var started = false
+
+    // Only touched by start() and then the burst loop
+    private lateinit var inputs: LockInputs
+    private val active = LinkedHashMap<String, Violation>()
+    private var lastRepaired: Set<String> = emptySet()
+
+    internal fun start() {
+        synchronized(dirty) {
+            if (started) return
+            started = true
+        }
+        try {
+            // Subscribe before the seed read so a change in between is not lost, only re-checked
+            platform.subscribe(::onChanged)
+            inputs = platform.readAll()
+            evaluate(LockInvariants.ALL)
+            repairIfNeeded()
+        } catch (e: Exception) {
+            Log.e(TAG, "Failed to start lock invariant monitor: ${e.message}", e)
+            return
+        }
+        scope.launch {
+            for (wakeup in wakeups) {
+                delay(burstWindowMs)
+                val changed = synchronized(dirty) {
+                    EnumSet.copyOf(dirty).also { dirty.clear() }
+                }
+                if (changed.isEmpty()) continue
+                try {
+                    onBurst(changed)
+                } catch (e: Exception) {
+                    Log.e(TAG, "Invariant check failed: ${e.message}", e)
+                }
+            }
+        }
+    }
+
+    /** For sources without a listener, e.g. after lock-task policy was committed. */
+    fun notifyChanged(vararg changed: LockInput) = onChanged(changed.toSet())
+
+    private fun onChanged(changed: Set<LockInput>) {
+        synchronized(dirty) { dirty.addAll(changed) }
+        wakeups.trySend(Unit)
+    }
+
+    private fun onBurst(changed: Set<LockInput>) {
+        val affected = LockInvariants.affectedBy(changed)
+        val reads = EnumSet.copyOf(changed)
+        for (invariant in affected) invariant.dependsOn.filterTo(reads) { it.volatile }
+        for (input in reads) inputs = platform.read(input, inputs)
+        evaluate(affected)
+        repairIfNeeded()
+    }
+
+    private fun evaluate(invariants: List<LockInvariant>) {
+        val now = clock()
+        for (invariant in invariants) {
+            evaluations.incrementAndGet()
+            val message = invariant.violation(inputs, now)
+            if (message != null) {
+                if (active[invariant.id]?.message != message) {
+                    val first = active[invariant.id]?.detectedAt ?: now
+                    active[invariant.id] = Violation(invariant.id, message, first, invariant.repairable)
+                    Log.w(TAG, "⚠️ Lock invariant violated [${invariant.id}]: $message")
+                }
+            } else if (active.remove(invariant.id) != null) {
+                Log.i(TAG, "✅ Lock invariant restored [${invariant.id}]")
+            }
+        }
+        _violations.value = active.values.toList()
+    }
+
+    private fun repairIfNeeded() {
+        val repairable = active.values.filter { it.repairable }
+        val ids = repairable.mapTo(HashSet()) { it.invariant }
+        if (ids.isEmpty() || ids == lastRepaired) {
+            if (ids.isEmpty()) lastRepaired = emptySet()
+            return
+        }
+        lastRepaired = ids
+        repairs.incrementAndGet()
+        Log.i(TAG, "🔧 Repairing lock state: ${ids.joinToString()}")
+        try {
+            if (!platform.repair(inputs, repairable)) Log.w(TAG, "Repair did not apply for ${ids.joinToString()}")
+        } catch (e: Exception) {
+            Log.e(TAG, "❌ Repair failed: ${e.message}", e)
+        }
+    }
+}
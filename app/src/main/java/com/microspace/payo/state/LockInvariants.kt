@@ -0,0 +1,109 @@
+﻿package com.microspace.payo.state
+
+import com.microspace.payo.control.RemoteDeviceControlManager
+
+/**
+ * One field of the lock state, wherever it is stored. Invariants declare which inputs they read
+ * so a change only re-checks the invariants that depend on it.
+ *
+ * [volatile] inputs have no change notification (DPM policy) and are re-read whenever an
+ * invariant that depends on them is evaluated.
+ */
+enum class LockInput(val volatile: Boolean = false) {
+    STATE,
+    REASON,
+    TIMESTAMP,
+    PERMANENT,
+    KIOSK_FLAG,
+    KIOSK_POLICY(volatile = true),
+    CONTROL_STATE,
+    CONTROL_LOCK_TYPE,
+    HARD_LOCK_TYPE,
+    PAYMENT_LOCKED
+}
+
+/** Everything the invariants read, across [DeviceLockStateManager], DPM and the parallel lock records. */
+data class LockInputs(
+    val details: DeviceLockStateManager.LockDetails,
+    val kioskPermitted: Boolean,
+    /** `control_prefs` state written by [RemoteDeviceControlManager]. */
+    val controlState: String,
+    val controlLockType: String,
+    /** `device_locks` lock type written by HardLockManager, null when cleared. */
+    val hardLockType: String?,
+    /** Lock flag of the materialized payment state. */
+    val paymentLocked: Boolean
+)
+
+class LockInvariant(
+    val id: String,
+    val dependsOn: Set<LockInput>,
+    /** Whether [LockStateValidator.recover] knows how to fix a violation. */
+    val repairable: Boolean,
+    private val check: (LockInputs, Long) -> String?
+) {
+    /** Null when the invariant holds, otherwise the issue text. */
+    fun violation(inputs: LockInputs, now: Long): String? = check(inputs, now)
+}
+
+object LockInvariants {
+
+    val ALL: List<LockInvariant> = listOf(
+        LockInvariant("kiosk_policy", setOf(LockInput.KIOSK_FLAG, LockInput.KIOSK_POLICY), repairable = false) { s, _ ->
+            if (s.details.kioskModeActive && !s.kioskPermitted) "Kiosk mode marked active but not enabled in DPM" else null
+        },
+        LockInvariant("hard_lock_kiosk", setOf(LockInput.STATE, LockInput.KIOSK_FLAG), repairable = true) { s, _ ->
+            if (s.details.state == LockState.HARD_LOCKED && !s.details.kioskModeActive) "Hard lock state without kiosk mode active" else null
+        },
+        LockInvariant("permanent_reason", setOf(LockInput.PERMANENT, LockInput.REASON), repairable = true) { s, _ ->
+            if (s.details.permanent && s.details.reason == LockReason.PAYMENT_OVERDUE) {
+                "Permanent lock with payment overdue reason (should be tamper or deactivation)"
+            } else {
+                null
+            }
+        },
+        LockInvariant("timestamp", setOf(LockInput.TIMESTAMP), repairable = false) { s, now ->
+            if (s.details.timestamp > now) "Lock timestamp is in the future" else null
+        },
+        LockInvariant("deactivated_permanent", setOf(LockInput.STATE, LockInput.PERMANENT), repairable = true) { s, _ ->
+            if (s.details.state == LockState.DEACTIVATED && !s.details.permanent) "Deactivated state should be permanent" else null
+        },
+        LockInvariant("soft_lock_permanent", setOf(LockInput.STATE, LockInput.PERMANENT), repairable = true) { s, _ ->
+            if (s.details.state == LockState.SOFT_LOCKED && s.details.permanent) "Soft lock should not be permanent" else null
+        },
+        LockInvariant(
+            "stale_hard_lock_record",
+            setOf(LockInput.HARD_LOCK_TYPE, LockInput.CONTROL_STATE, LockInput.PAYMENT_LOCKED),
+            repairable = false
+        ) { s, _ ->
+            if (s.hardLockType == "hard" && s.controlState == RemoteDeviceControlManager.LOCK_UNLOCKED && !s.paymentLocked) {
+                "HardLockManager still records a hard lock but control and payment state are unlocked"
+            } else {
+                null
+            }
+        },
+        LockInvariant(
+            "overdue_lock_payment_state",
+            setOf(LockInput.CONTROL_STATE, LockInput.CONTROL_LOCK_TYPE, LockInput.PAYMENT_LOCKED),
+            repairable = false
+        ) { s, _ ->
+            if (s.controlState == RemoteDeviceControlManager.LOCK_HARD &&
+                s.controlLockType == RemoteDeviceControlManager.TYPE_OVERDUE &&
+                !s.paymentLocked
+            ) {
+                "Hard-locked for an overdue payment while payment state is unlocked"
+            } else {
+                null
+            }
+        }
+    )
+
+    private val byInput: Map<LockInput, List<LockInvariant>> =
+        LockInput.values().associateWith { input -> ALL.filter { input in it.dependsOn } }
+
+    /** Invariants reading any of [changed], in table order. */
+    fun affectedBy(changed: Set<LockInput>): List<LockInvariant> {
+        if (changed.size == 1) return byInput.getValue(changed.first())
+        return ALL.filter { invariant -> invariant.dependsOn.any { it in changed } }
+    }
+}
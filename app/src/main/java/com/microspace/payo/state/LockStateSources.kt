@@ -0,0 +1,114 @@
+﻿package com.microspace.payo.state
+
+import android.app.admin.DevicePolicyManager
+import android.content.Context
+import android.content.SharedPreferences
+import android.util.Log
+import com.microspace.payo.control.HardLockManager
+import com.microspace.payo.control.RemoteDeviceControlManager
+import com.microspace.payo.data.repository.PaymentStateRepository
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.flow.distinctUntilChanged
+import kotlinx.coroutines.flow.drop
+import kotlinx.coroutines.flow.launchIn
+import kotlinx.coroutines.flow.map
+import kotlinx.coroutines.flow.onEach
+
+/**
+ * The places lock state is kept: [DeviceLockStateManager] prefs, DPM lock-task policy,
+ * `control_prefs` ([RemoteDeviceControlManager]), `device_locks` ([HardLockManager]) and the
+ * payment state. Reads are per input; [subscribe] maps prefs keys and the payment flow to inputs.
+ */
+class LockStateSources(context: Context) : LockInvariantMonitor.Platform {
+
+    companion object {
+        private const val TAG = "LockStateSources"
+
+        private val STATE_MANAGER_KEYS = mapOf(
+            "current_state" to LockInput.STATE,
+            "current_reason" to LockInput.REASON,
+            "lock_timestamp" to LockInput.TIMESTAMP,
+            "lock_permanent" to LockInput.PERMANENT,
+            "kiosk_mode_active" to LockInput.KIOSK_FLAG
+        )
+        private val CONTROL_KEYS = mapOf(
+            "state" to LockInput.CONTROL_STATE,
+            "lock_type" to LockInput.CONTROL_LOCK_TYPE
+        )
+        private val HARD_LOCK_KEYS = mapOf(
+            HardLockManager.LOCK_TYPE_KEY to LockInput.HARD_LOCK_TYPE
+        )
+    }
+
+    private val app = context.applicationContext
+    internal val stateManager = DeviceLockStateManager(app)
+    private val control = RemoteDeviceControlManager.getInstance(app)
+    private val hardLock = HardLockManager.getInstance(app)
+    private val dpm = app.getSystemService(Context.DEVICE_POLICY_SERVICE) as DevicePolicyManager
+    private val scope = CoroutineScope(Dispatchers.Default + SupervisorJob())
+
+    // Repairs go through this instance's managers; a fresh validator would build another set
+    private val validator by lazy { LockStateValidator(this) }
+
+    // SharedPreferences holds listeners weakly; these fields keep them registered
+    private val listeners = mutableListOf<SharedPreferences.OnSharedPreferenceChangeListener>()
+
+    override fun readAll(): LockInputs = LockInputs(
+        details = stateManager.getLockDetails(),
+        kioskPermitted = kioskPermitted(),
+        controlState = control.getLockState(),
+        controlLockType = control.getLockType(),
+        hardLockType = hardLock.getLockType(),
+        paymentLocked = paymentLocked()
+    )
+
+    override fun read(input: LockInput, current: LockInputs): LockInputs = when (input) {
+        LockInput.STATE, LockInput.REASON, LockInput.TIMESTAMP, LockInput.PERMANENT, LockInput.KIOSK_FLAG ->
+            current.copy(details = stateManager.getLockDetails())
+        LockInput.KIOSK_POLICY -> current.copy(kioskPermitted = kioskPermitted())
+        LockInput.CONTROL_STATE -> current.copy(controlState = control.getLockState())
+        LockInput.CONTROL_LOCK_TYPE -> current.copy(controlLockType = control.getLockType())
+        LockInput.HARD_LOCK_TYPE -> current.copy(hardLockType = hardLock.getLockType())
+        LockInput.PAYMENT_LOCKED -> current.copy(paymentLocked = paymentLocked())
+    }
+
+    override fun subscribe(onChange: (Set<LockInput>) -> Unit) {
+        watch(DeviceLockStateManager.PREFS, STATE_MANAGER_KEYS, onChange)
+        watch(RemoteDeviceControlManager.PREFS, CONTROL_KEYS, onChange)
+        watch(HardLockManager.LOCK_PREF_NAME, HARD_LOCK_KEYS, onChange)
+        PaymentStateRepository.getInstance(app).state
+            .map { it.isLocked }
+            .distinctUntilChanged()
+            .drop(1)
+            .onEach { onChange(setOf(LockInput.PAYMENT_LOCKED)) }
+            .launchIn(scope)
+    }
+
+    override fun repair(inputs: LockInputs, violations: List<LockInvariantMonitor.Violation>): Boolean =
+        validator.recover(inputs.details)
+
+    private fun watch(name: String, keys: Map<String, LockInput>, onChange: (Set<LockInput>) -> Unit) {
+        val listener = SharedPreferences.OnSharedPreferenceChangeListener { _, key ->
+            // A null key is clear(): every input of this file may have changed
+            if (key == null) onChange(keys.values.toSet()) else keys[key]?.let { onChange(setOf(it)) }
+        }
+        listeners.add(listener)
+        app.getSharedPreferences(name, Context.MODE_PRIVATE).registerOnSharedPreferenceChangeListener(listener)
+    }
+
+    private fun kioskPermitted(): Boolean = try {
+        dpm.isLockTaskPermitted(app.packageName)
+    } catch (e: Exception) {
+        Log.w(TAG, "Could not check kiosk mode: ${e.message}")
+        false
+    }
+
+    private fun paymentLocked(): Boolean = try {
+        PaymentStateRepository.getInstance(app).current.isLocked
+    } catch (e: Exception) {
+        Log.w(TAG, "Could not read payment lock state: ${e.message}")
+        false
+    }
+}
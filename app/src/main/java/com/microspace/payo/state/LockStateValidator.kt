@@ -1,10 +1,7 @@
 ﻿package com.microspace.payo.state
 
-import android.app.admin.DevicePolicyManager
-import android.content.ComponentName
 import android.content.Context
 import android.util.Log
-import com.microspace.payo.receivers.admin.AdminReceiver
 
 /**
  * Lock State Validator
@@ -16,63 +13,29 @@ import com.microspace.payo.receivers.admin.AdminReceiver
  * - Issue detection
  * - Automatic recovery
  * - Logging
+ *
+ * Reads and repairs through [sources]; [LockStateSources] passes itself in for its repairs.
  */
-class LockStateValidator(private val context: Context) {
+class LockStateValidator internal constructor(private val sources: LockStateSources) {
+
+    constructor(context: Context) : this(LockStateSources(context))
     
     companion object {
         private const val TAG = "LockStateValidator"
     }
     
-    private val stateManager = DeviceLockStateManager(context)
-    private val dpm = context.getSystemService(Context.DEVICE_POLICY_SERVICE) as DevicePolicyManager
-    private val admin = ComponentName(context, com.microspace.payo.receivers.admin.AdminReceiver::class.java)
+    private val stateManager = sources.stateManager
     
-    // Validate lock state consistency
+    // Validate lock state consistency: a full read of every source and every invariant.
+    // LockInvariantMonitor keeps the same table checked incrementally.
     fun validateLockState(): ValidationResult {
-        val details = stateManager.getLockDetails()
-        val issues = mutableListOf<String>()
+        val inputs = sources.readAll()
+        val details = inputs.details
         
         Log.d(TAG, "ðŸ” Validating lock state...")
         
-        // Check 1: Kiosk mode consistency
-        val isKioskModeEnabled = try {
-            dpm.isLockTaskPermitted(admin.packageName)
-        } catch (e: Exception) {
-            Log.w(TAG, "Could not check kiosk mode: ${e.message}")
-            false
-        }
-        
-        if (details.kioskModeActive && !isKioskModeEnabled) {
-            issues.add("Kiosk mode marked active but not enabled in DPM")
-        }
-        
-        // Check 2: Hard lock without kiosk mode
-        if (details.state == LockState.HARD_LOCKED && 
-            !details.kioskModeActive) {
-            issues.add("Hard lock state without kiosk mode active")
-        }
-        
-        // Check 3: Permanent lock with unlock reason
-        if (details.permanent && details.reason == LockReason.PAYMENT_OVERDUE) {
-            issues.add("Permanent lock with payment overdue reason (should be tamper or deactivation)")
-        }
-        
-        // Check 4: Timestamp validity
-        if (details.timestamp > System.currentTimeMillis()) {
-            issues.add("Lock timestamp is in the future")
-        }
-        
-        // Check 5: Deactivated state consistency
-        if (details.state == LockState.DEACTIVATED && 
-            !details.permanent) {
-            issues.add("Deactivated state should be permanent")
-        }
-        
-        // Check 6: Soft lock should not be permanent
-        if (details.state == LockState.SOFT_LOCKED && 
-            details.permanent) {
-            issues.add("Soft lock should not be permanent")
-        }
+        val now = System.currentTimeMillis()
+        val issues = LockInvariants.ALL.mapNotNull { it.violation(inputs, now) }
         
         Log.d(TAG, "âœ… Validation complete. Issues found: ${issues.size}")
         
@@ -95,57 +58,62 @@ class LockStateValidator(private val context: Context) {
         Log.w(TAG, "âš ï¸ Lock state is invalid. Issues found:")
         validation.issues.forEach { Log.w(TAG, "   - $it") }
         
+        return recover(validation.details)
+    }
+    
+    // Apply the fix for the first repairable issue in details; false if none applies
+    fun recover(details: DeviceLockStateManager.LockDetails): Boolean {
         // Attempt recovery
         try {
             when {
-                validation.details.state == LockState.HARD_LOCKED &&
-                !validation.details.kioskModeActive -> {
+                details.state == LockState.HARD_LOCKED &&
+                !details.kioskModeActive -> {
                     Log.i(TAG, "ðŸ”§ Recovering: Re-enabling kiosk mode...")
                     stateManager.updateLockState(
                         newState = LockState.HARD_LOCKED,
-                        reason = validation.details.reason,
+                        reason = details.reason,
                         message = "Recovered from invalid state",
-                        permanent = validation.details.permanent,
+                        permanent = details.permanent,
                         kioskModeActive = true
                     )
                     return true
                 }
                 
-                validation.details.permanent && 
-                validation.details.reason == LockReason.PAYMENT_OVERDUE -> {
+                details.permanent && 
+                details.reason == LockReason.PAYMENT_OVERDUE -> {
                     Log.i(TAG, "ðŸ”§ Recovering: Correcting lock reason...")
                     stateManager.updateLockState(
-                        newState = validation.details.state,
+                        newState = details.state,
                         reason = LockReason.TAMPER_DETECTED,
                         message = "Recovered from invalid state",
                         permanent = true,
-                        kioskModeActive = validation.details.kioskModeActive
+                        kioskModeActive = details.kioskModeActive
                     )
                     return true
                 }
                 
-                validation.details.state == LockState.DEACTIVATED &&
-                !validation.details.permanent -> {
+                details.state == LockState.DEACTIVATED &&
+                !details.permanent -> {
                     Log.i(TAG, "ðŸ”§ Recovering: Marking deactivated as permanent...")
                     stateManager.updateLockState(
                         newState = LockState.DEACTIVATED,
-                        reason = validation.details.reason,
+                        reason = details.reason,
                         message = "Recovered from invalid state",
                         permanent = true,
-                        kioskModeActive = validation.details.kioskModeActive
+                        kioskModeActive = details.kioskModeActive
                     )
                     return true
                 }
                 
-                validation.details.state == LockState.SOFT_LOCKED &&
-                validation.details.permanent -> {
+                details.state == LockState.SOFT_LOCKED &&
+                details.permanent -> {
                     Log.i(TAG, "ðŸ”§ Recovering: Removing permanent flag from soft lock...")
                     stateManager.updateLockState(
                         newState = LockState.SOFT_LOCKED,
-                        reason = validation.details.reason,
+                        reason = details.reason,
                         message = "Recovered from invalid state",
                         permanent = false,
-                        kioskModeActive = validation.details.kioskModeActive
+                        kioskModeActive = details.kioskModeActive
                     )
                     return true
                 }
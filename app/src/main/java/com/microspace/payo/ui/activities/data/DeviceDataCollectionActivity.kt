@@ -187,10 +187,10 @@ class DeviceDataCollectionActivity : ComponentActivity() {
                     Log.d(TAG, "ðŸ§¹ Initiating WiFi cleanup and installation status reporting...")
                     val registrationManager = DeviceRegistrationManager(this@DeviceDataCollectionActivity)
                     registrationManager.markRegistrationComplete()
-                    registrationManager.sendInstallationStatusWithLifecycle(
-                        lifecycleScope = lifecycleScope,
-                        onSuccess = { Log.d(TAG, "WiFi Cleanup and Status Sent Successfully") },
-                        onFailure = { Log.e(TAG, "WiFi Cleanup or Status Send failed: $it") }
+                    // Queued durably; delivery and the WiFi cleanup continue after this screen closes
+                    registrationManager.sendInstallationStatus(
+                        onQueued = { Log.d(TAG, "Installation status queued for delivery") },
+                        onFailure = { Log.e(TAG, "Installation status not queued: $it") }
                     )
 
                     // Delay clearing temp files to ensure cleanup logic has access to SSID
@@ -13,6 +13,7 @@ import android.view.KeyEvent
 import android.view.WindowManager
 import androidx.activity.ComponentActivity
 import androidx.activity.OnBackPressedCallback
+import com.microspace.payo.core.watchdog.SlowOperationWatchdog
 import com.microspace.payo.receivers.admin.AdminReceiver
 
 /**
@@ -68,9 +69,10 @@ abstract class BaseLockActivity : ComponentActivity() {
     }
 
     protected fun startLockTaskMode() {
-        if (!dpm.isDeviceOwnerApp(packageName)) return
+        val watchdog = SlowOperationWatchdog.shared
+        if (!watchdog.trace(SlowOperationWatchdog.Kind.BINDER, "dpm.isDeviceOwnerApp") { dpm.isDeviceOwnerApp(packageName) }) return
         try {
-            startLockTask()
+            watchdog.trace(SlowOperationWatchdog.Kind.BINDER, "activity.startLockTask") { startLockTask() }
         } catch (e: Exception) {
             Log.e("LockActivity", "Failed to start lock task", e)
         }
@@ -7,12 +7,12 @@ import android.content.IntentFilter
 import android.net.Uri
 import android.os.Bundle
 import android.util.Log
+import androidx.activity.compose.ReportDrawn
 import androidx.activity.compose.setContent
+import androidx.activity.viewModels
 import androidx.compose.animation.*
-import androidx.compose.animation.core.*
 import androidx.compose.foundation.*
 import androidx.compose.foundation.layout.*
-import androidx.compose.foundation.shape.CircleShape
 import androidx.compose.foundation.shape.RoundedCornerShape
 import androidx.compose.foundation.text.KeyboardOptions
 import androidx.compose.material.icons.Icons
@@ -20,11 +20,6 @@ import androidx.compose.material.icons.filled.*
 import androidx.compose.material3.*
 import androidx.compose.runtime.*
 import androidx.compose.ui.*
-import androidx.compose.ui.draw.alpha
-import androidx.compose.ui.draw.clip
-import androidx.compose.ui.draw.scale
-import androidx.compose.ui.geometry.Offset
-import androidx.compose.ui.graphics.Brush
 import androidx.compose.ui.graphics.Color
 import androidx.compose.ui.text.font.FontFamily
 import androidx.compose.ui.text.font.FontWeight
@@ -34,11 +29,16 @@ import androidx.compose.ui.text.input.VisualTransformation
 import androidx.compose.ui.text.style.TextAlign
 import androidx.compose.ui.unit.dp
 import androidx.compose.ui.unit.sp
+import com.microspace.payo.data.repository.PaymentStateRepository
 import com.microspace.payo.services.payment.PaymentLockManager
 import com.microspace.payo.ui.theme.DeviceOwnerTheme
 import com.microspace.payo.utils.storage.SharedPreferencesManager
 import com.microspace.payo.ui.activities.lock.base.BaseLockActivity
-import kotlinx.coroutines.launch
+import com.microspace.payo.ui.screens.lock.FloatingRippleIcon
+import com.microspace.payo.ui.screens.lock.PulsingDot
+import com.microspace.payo.ui.screens.lock.RecompositionProbe
+import com.microspace.payo.ui.screens.lock.UnlockCodeState
+import com.microspace.payo.ui.screens.lock.UnlockViewModel
 
 private val RedCard     = Color(0xFFE94560)
 private val RedLight    = Color(0x17E94560)
@@ -50,6 +50,10 @@ private val SlateBlue   = Color(0xFF94A3B8)
 
 class PaymentOverdueActivity : BaseLockActivity() {
 
+    private val unlockViewModel: UnlockViewModel by viewModels {
+        UnlockViewModel.factory(PaymentLockManager.getInstance(applicationContext)::verifyOfflineUnlockPassword)
+    }
+
     private val unlockReceiver = object : BroadcastReceiver() {
         override fun onReceive(context: Context?, intent: Intent?) {
             if (intent?.action == "com.microspace.payo.DISMISS_LOCK_SCREEN") {
@@ -73,27 +77,27 @@ class PaymentOverdueActivity : BaseLockActivity() {
         }
 
         val nextPayDate = intent.getStringExtra("next_payment_date")
-        val daysOverdue = intent.getLongExtra("days_overdue", 0L)
-        val hoursOverdue = intent.getLongExtra("hours_overdue", 0L)
-        val supportContact = intent.getStringExtra("support_contact") ?: SharedPreferencesManager(this).getSupportContact() ?: ""
+        val supportContact = intent.getStringExtra("support_contact") ?: SharedPreferencesManager.getInstance(this).getSupportContact() ?: ""
+        val paymentState = PaymentStateRepository.getInstance(this).state
+        // Created once here rather than per composition, so the screen sees stable callbacks
+        val onUnlocked = {
+            isExitingForced = true
+            finishAndRemoveTask()
+        }
+        val onContactSupport = { openSupport(supportContact) }
 
         setContent {
+            // A heartbeat that moves the due date while the screen is up is shown right away
+            val payment by paymentState.collectAsState()
             DeviceOwnerTheme {
                 HardLockPaymentOverdueScreen(
-                    nextPaymentDate = nextPayDate,
-                    daysOverdue = daysOverdue,
-                    hoursOverdue = hoursOverdue,
-                    onUnlockAttempt = { code -> 
-                        val ok = PaymentLockManager(this).verifyOfflineUnlockPassword(code)
-                        if (ok) {
-                            isExitingForced = true
-                            finishAndRemoveTask()
-                        }
-                        ok
-                    },
-                    onContactSupport = { openSupport(supportContact) }
+                    state = unlockViewModel.state,
+                    nextPaymentDate = payment.nextPaymentDate ?: nextPayDate,
+                    onUnlocked = onUnlocked,
+                    onContactSupport = onContactSupport
                 )
             }
+            ReportDrawn()
         }
         
         startLockTaskMode()
@@ -128,40 +132,17 @@ class PaymentOverdueActivity : BaseLockActivity() {
 
 @Composable
 fun HardLockPaymentOverdueScreen(
+    state: UnlockCodeState,
     nextPaymentDate: String?,
-    daysOverdue: Long,
-    hoursOverdue: Long,
-    onUnlockAttempt: (String) -> Boolean,
+    onUnlocked: () -> Unit,
     onContactSupport: () -> Unit
 ) {
-    val scope = rememberCoroutineScope()
-    var code              by remember { mutableStateOf("") }
-    var codeVisible       by remember { mutableStateOf(false) }
-    var isVerifying       by remember { mutableStateOf(false) }
-    var verificationState by remember { mutableStateOf<Boolean?>(null) }
-
-    val infinite = rememberInfiniteTransition(label = "pay")
-
-    val badgePulse by infinite.animateFloat(
-        1f, 0.2f,
-        infiniteRepeatable(tween(2000, easing = FastOutSlowInEasing), RepeatMode.Reverse),
-        label = "badge"
-    )
-    val rippleScale by infinite.animateFloat(
-        1f, 1.5f,
-        infiniteRepeatable(tween(2400, easing = FastOutSlowInEasing), RepeatMode.Restart),
-        label = "rScale"
-    )
-    val rippleAlpha by infinite.animateFloat(
-        0.5f, 0f,
-        infiniteRepeatable(tween(2400, easing = FastOutSlowInEasing), RepeatMode.Restart),
-        label = "rAlpha"
-    )
-    val floatY by infinite.animateFloat(
-        0f, -6f,
-        infiniteRepeatable(tween(3000, easing = FastOutSlowInEasing), RepeatMode.Reverse),
-        label = "floatY"
-    )
+    RecompositionProbe("HardLockPaymentOverdueScreen")
+    // Only the unlock effect reads the result here; every other read happens in the child that needs it
+    val unlocked = state.result == true
+    LaunchedEffect(unlocked) {
+        if (unlocked) onUnlocked()
+    }
 
     Box(Modifier.fillMaxSize().background(Color.White)) {
         Column(
@@ -174,93 +155,28 @@ fun HardLockPaymentOverdueScreen(
         ) {
 
             // â”€â”€ Red badge â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€
-            Surface(shape = RoundedCornerShape(999.dp), color = RedLight) {
-                Row(
-                    Modifier.padding(start = 10.dp, end = 16.dp, top = 6.dp, bottom = 6.dp),
-                    verticalAlignment = Alignment.CenterVertically,
-                    horizontalArrangement = Arrangement.spacedBy(8.dp)
-                ) {
-                    Box(
-                        Modifier.size(8.dp).clip(CircleShape)
-                            .background(RedCard).alpha(badgePulse)
-                    )
-                    Text(
-                        "Payment Overdue",
-                        fontSize = 12.5.sp,
-                        fontWeight = FontWeight.Bold,
-                        color = RedCard
-                    )
-                }
-            }
+            OverdueBadge()
 
             Spacer(Modifier.height(28.dp))
 
             // â”€â”€ Floating red lock icon â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€
-            Box(
-                Modifier.size(116.dp).offset(y = floatY.dp),
-                contentAlignment = Alignment.Center
-            ) {
-                Box(
-                    Modifier.size(116.dp).scale(rippleScale).clip(CircleShape)
-                        .background(RedMid.copy(alpha = rippleAlpha))
-                )
-                Box(
-                    Modifier.size(88.dp).clip(CircleShape).background(
-                        Brush.linearGradient(
-                            listOf(Color(0xFFf27d91), RedCard),
-                            Offset.Zero, Offset(88f, 88f)
-                        )
-                    ),
-                    contentAlignment = Alignment.Center
-                ) {
-                    Icon(Icons.Default.Lock, null, tint = Color.White, modifier = Modifier.size(38.dp))
-                }
-            }
+            FloatingRippleIcon(
+                icon = Icons.Default.Lock,
+                gradient = LockGradient,
+                rippleColor = RedMid,
+                size = 116.dp,
+                discSize = 88.dp,
+                iconSize = 38.dp
+            )
 
             Spacer(Modifier.height(24.dp))
 
-            Text(
-                "Service Interrupted",
-                fontSize = 27.sp, fontWeight = FontWeight.ExtraBold,
-                color = Gray900, letterSpacing = (-0.4).sp
-            )
-            Spacer(Modifier.height(10.dp))
-            Text(
-                "Your device is locked because the scheduled payment has not been received. Please complete your payment to restore access.",
-                fontSize = 15.sp, color = Gray500,
-                textAlign = TextAlign.Center, lineHeight = 24.sp,
-                modifier = Modifier.widthIn(max = 340.dp)
-            )
+            OverdueHeader()
 
             Spacer(Modifier.height(28.dp))
 
             // â”€â”€ Overdue chip â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€
-            Surface(
-                modifier = Modifier.fillMaxWidth(),
-                shape = RoundedCornerShape(14.dp),
-                color = Color(0x0FE94560),
-                border = BorderStroke(1.dp, Color(0x2EE94560))
-            ) {
-                Column(
-                    Modifier.padding(vertical = 14.dp),
-                    horizontalAlignment = Alignment.CenterHorizontally
-                ) {
-                    Text(
-                        "OVERDUE SINCE",
-                        fontFamily = FontFamily.Monospace,
-                        fontSize = 9.sp, fontWeight = FontWeight.Medium,
-                        color = RedCard.copy(alpha = 0.65f),
-                        letterSpacing = 1.8.sp
-                    )
-                    Spacer(Modifier.height(2.dp))
-                    Text(
-                        nextPaymentDate ?: "Payment Date",
-                        fontFamily = FontFamily.Monospace,
-                        fontSize = 22.sp, fontWeight = FontWeight.SemiBold,
-                        color = RedCard, letterSpacing = (-0.5).sp
-                    )
-                }
-            }
+            OverdueSinceChip(nextPaymentDate)
 
             Spacer(Modifier.height(28.dp))
 
@@ -274,104 +190,187 @@ fun HardLockPaymentOverdueScreen(
             )
 
             // â”€â”€ Code input â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€
-            OutlinedTextField(
-                value = code,
-                onValueChange = {
-                    code = it.filter { c -> c.isDigit() }
-                    verificationState = null
-                },
-                modifier = Modifier.fillMaxWidth(),
-                placeholder = {
-                    Text("Enter unlock code", color = SlateBlue, fontSize = 14.sp, fontWeight = FontWeight.Normal)
-                },
-                singleLine = true,
-                visualTransformation = if (codeVisible) VisualTransformation.None else PasswordVisualTransformation(),
-                keyboardOptions = KeyboardOptions(keyboardType = KeyboardType.NumberPassword),
-                trailingIcon = {
-                    IconButton(onClick = { codeVisible = !codeVisible }) {
-                        Icon(
-                            if (codeVisible) Icons.Default.VisibilityOff else Icons.Default.Visibility,
-                            contentDescription = if (codeVisible) "Hide code" else "Show code",
-                            tint = SlateBlue
-                        )
-                    }
-                },
-                shape = RoundedCornerShape(13.dp),
-                colors = OutlinedTextFieldDefaults.colors(
-                    unfocusedContainerColor = Color(0xFFFAFBFD),
-                    focusedContainerColor   = Color.White,
-                    unfocusedBorderColor    = Gray200,
-                    focusedBorderColor      = RedCard
-                )
-            )
+            UnlockCodeField(state)
 
             Spacer(Modifier.height(10.dp))
 
             // â”€â”€ Unlock button â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€
-            Button(
-                onClick = {
-                    if (code.isEmpty()) return@Button
-                    isVerifying = true
-                    verificationState = null
-                    scope.launch {
-                        val ok = onUnlockAttempt(code)
-                        verificationState = ok
-                        isVerifying = false
-                    }
-                },
-                enabled = code.isNotEmpty() && !isVerifying,
-                modifier = Modifier.fillMaxWidth().height(54.dp),
-                shape = RoundedCornerShape(13.dp),
-                colors = ButtonDefaults.buttonColors(
-                    containerColor         = RedCard,
-                    disabledContainerColor = Gray200
-                ),
-                elevation = ButtonDefaults.buttonElevation(defaultElevation = 4.dp)
-            ) {
-                if (isVerifying) {
-                    CircularProgressIndicator(Modifier.size(20.dp), color = Color.White, strokeWidth = 2.5.dp)
-                    Spacer(Modifier.width(10.dp))
-                    Text("Verifyingâ€¦", fontWeight = FontWeight.Bold, fontSize = 14.sp)
-                } else {
-                    Icon(Icons.Default.Lock, null, modifier = Modifier.size(18.dp))
-                    Spacer(Modifier.width(8.dp))
-                    Text("RESTORE ACCESS", fontWeight = FontWeight.ExtraBold, fontSize = 14.sp, letterSpacing = 1.8.sp)
-                }
-            }
+            UnlockButton(state)
 
             // â”€â”€ Verification result â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€
-            AnimatedVisibility(visible = verificationState != null) {
-                verificationState?.let { ok ->
-                    Text(
-                        if (ok) "âœ“ Unlock successful! Restoring device accessâ€¦"
-                        else    "âœ— Invalid code. Please try again.",
-                        color = if (ok) Color(0xFF16A34A) else Color(0xFFDC2626),
-                        fontFamily = FontFamily.Monospace,
-                        fontSize = 12.sp, fontWeight = FontWeight.SemiBold,
-                        textAlign = TextAlign.Center,
-                        modifier = Modifier.padding(top = 10.dp)
-                    )
-                }
-            }
+            VerificationMessage(state)
 
             Spacer(Modifier.height(18.dp))
 
             // â”€â”€ Contact support â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€â”€
-            OutlinedButton(
-                onClick = onContactSupport,
-                modifier = Modifier.fillMaxWidth().height(52.dp),
-                shape = RoundedCornerShape(13.dp),
-                border = BorderStroke(2.dp, RedCard.copy(alpha = 0.35f)),
-                colors = ButtonDefaults.outlinedButtonColors(contentColor = RedCard)
-            ) {
-                Icon(Icons.Default.Phone, null, modifier = Modifier.size(18.dp))
-                Spacer(Modifier.width(8.dp))
-                Text("CONTACT SUPPORT", fontWeight = FontWeight.Bold, fontSize = 14.sp, letterSpacing = 1.5.sp)
-            }
+            ContactSupportButton(onContactSupport)
         }
     }
 }
 
+private val LockGradient = listOf(Color(0xFFf27d91), RedCard)
 
+@Composable
+private fun OverdueBadge() {
+    Surface(shape = RoundedCornerShape(999.dp), color = RedLight) {
+        Row(
+            Modifier.padding(start = 10.dp, end = 16.dp, top = 6.dp, bottom = 6.dp),
+            verticalAlignment = Alignment.CenterVertically,
+            horizontalArrangement = Arrangement.spacedBy(8.dp)
+        ) {
+            PulsingDot(RedCard, 8.dp)
+            Text(
+                "Payment Overdue",
+                fontSize = 12.5.sp,
+                fontWeight = FontWeight.Bold,
+                color = RedCard
+            )
+        }
+    }
+}
 
+@Composable
+private fun OverdueHeader() {
+    RecompositionProbe("OverdueHeader")
+    Text(
+        "Service Interrupted",
+        fontSize = 27.sp, fontWeight = FontWeight.ExtraBold,
+        color = Gray900, letterSpacing = (-0.4).sp
+    )
+    Spacer(Modifier.height(10.dp))
+    Text(
+        "Your device is locked because the scheduled payment has not been received. Please complete your payment to restore access.",
+        fontSize = 15.sp, color = Gray500,
+        textAlign = TextAlign.Center, lineHeight = 24.sp,
+        modifier = Modifier.widthIn(max = 340.dp)
+    )
+}
 
+@Composable
+private fun OverdueSinceChip(nextPaymentDate: String?) {
+    RecompositionProbe("OverdueSinceChip")
+    Surface(
+        modifier = Modifier.fillMaxWidth(),
+        shape = RoundedCornerShape(14.dp),
+        color = Color(0x0FE94560),
+        border = BorderStroke(1.dp, Color(0x2EE94560))
+    ) {
+        Column(
+            Modifier.padding(vertical = 14.dp),
+            horizontalAlignment = Alignment.CenterHorizontally
+        ) {
+            Text(
+                "OVERDUE SINCE",
+                fontFamily = FontFamily.Monospace,
+                fontSize = 9.sp, fontWeight = FontWeight.Medium,
+                color = RedCard.copy(alpha = 0.65f),
+                letterSpacing = 1.8.sp
+            )
+            Spacer(Modifier.height(2.dp))
+            Text(
+                nextPaymentDate ?: "Payment Date",
+                fontFamily = FontFamily.Monospace,
+                fontSize = 22.sp, fontWeight = FontWeight.SemiBold,
+                color = RedCard, letterSpacing = (-0.5).sp
+            )
+        }
+    }
+}
+
+@Composable
+private fun UnlockCodeField(state: UnlockCodeState) {
+    RecompositionProbe("UnlockCodeField")
+    val visible = state.codeVisible
+    val transformation = remember(visible) {
+        if (visible) VisualTransformation.None else PasswordVisualTransformation()
+    }
+    OutlinedTextField(
+        value = state.code,
+        onValueChange = state::onCodeChange,
+        modifier = Modifier.fillMaxWidth(),
+        placeholder = {
+            Text("Enter unlock code", color = SlateBlue, fontSize = 14.sp, fontWeight = FontWeight.Normal)
+        },
+        singleLine = true,
+        visualTransformation = transformation,
+        keyboardOptions = NumericKeyboard,
+        trailingIcon = {
+            IconButton(onClick = state::toggleVisibility) {
+                Icon(
+                    if (visible) Icons.Default.VisibilityOff else Icons.Default.Visibility,
+                    contentDescription = if (visible) "Hide code" else "Show code",
+                    tint = SlateBlue
+                )
+            }
+        },
+        shape = RoundedCornerShape(13.dp),
+        colors = OutlinedTextFieldDefaults.colors(
+            unfocusedContainerColor = Color(0xFFFAFBFD),
+            focusedContainerColor   = Color.White,
+            unfocusedBorderColor    = Gray200,
+            focusedBorderColor      = RedCard
+        )
+    )
+}
+
+private val NumericKeyboard = KeyboardOptions(keyboardType = KeyboardType.NumberPassword)
+
+@Composable
+private fun UnlockButton(state: UnlockCodeState) {
+    RecompositionProbe("UnlockButton")
+    Button(
+        onClick = state::verify,
+        enabled = state.canSubmit,
+        modifier = Modifier.fillMaxWidth().height(54.dp),
+        shape = RoundedCornerShape(13.dp),
+        colors = ButtonDefaults.buttonColors(
+            containerColor         = RedCard,
+            disabledContainerColor = Gray200
+        ),
+        elevation = ButtonDefaults.buttonElevation(defaultElevation = 4.dp)
+    ) {
+        if (state.isVerifying) {
+            CircularProgressIndicator(Modifier.size(20.dp), color = Color.White, strokeWidth = 2.5.dp)
+            Spacer(Modifier.width(10.dp))
+            Text("Verifyingâ€¦", fontWeight = FontWeight.Bold, fontSize = 14.sp)
+        } else {
+            Icon(Icons.Default.Lock, null, modifier = Modifier.size(18.dp))
+            Spacer(Modifier.width(8.dp))
+            Text("RESTORE ACCESS", fontWeight = FontWeight.ExtraBold, fontSize = 14.sp, letterSpacing = 1.8.sp)
+        }
+    }
+}
+
+@Composable
+private fun VerificationMessage(state: UnlockCodeState) {
+    RecompositionProbe("VerificationMessage")
+    val result = state.result
+    AnimatedVisibility(visible = result != null) {
+        result?.let { ok ->
+            Text(
+                if (ok) "âœ“ Unlock successful! Restoring device accessâ€¦"
+                else    "âœ— Invalid code. Please try again.",
+                color = if (ok) Color(0xFF16A34A) else Color(0xFFDC2626),
+                fontFamily = FontFamily.Monospace,
+                fontSize = 12.sp, fontWeight = FontWeight.SemiBold,
+                textAlign = TextAlign.Center,
+                modifier = Modifier.padding(top = 10.dp)
+            )
+        }
+    }
+}
+
+@Composable
+private fun ContactSupportButton(onContactSupport: () -> Unit) {
+    OutlinedButton(
+        onClick = onContactSupport,
+        modifier = Modifier.fillMaxWidth().height(52.dp),
+        shape = RoundedCornerShape(13.dp),
+        border = BorderStroke(2.dp, RedCard.copy(alpha = 0.35f)),
+        colors = ButtonDefaults.outlinedButtonColors(contentColor = RedCard)
+    ) {
+        Icon(Icons.Default.Phone, null, modifier = Modifier.size(18.dp))
+        Spacer(Modifier.width(8.dp))
+        Text("CONTACT SUPPORT", fontWeight = FontWeight.Bold, fontSize = 14.sp, letterSpacing = 1.5.sp)
+    }
+}
@@ -1,13 +1,12 @@
 ﻿package com.microspace.payo.ui.activities.lock.payment
 
 import android.os.Bundle
+import androidx.activity.compose.ReportDrawn
 import androidx.activity.compose.setContent
-import androidx.compose.animation.core.*
 import androidx.compose.foundation.BorderStroke
 import androidx.compose.foundation.background
 import androidx.compose.foundation.layout.*
 import androidx.compose.foundation.rememberScrollState
-import androidx.compose.foundation.shape.CircleShape
 import androidx.compose.foundation.shape.RoundedCornerShape
 import androidx.compose.foundation.verticalScroll
 import androidx.compose.material.icons.Icons
@@ -17,11 +16,6 @@ import androidx.compose.material3.*
 import androidx.compose.runtime.*
 import androidx.compose.ui.Alignment
 import androidx.compose.ui.Modifier
-import androidx.compose.ui.draw.alpha
-import androidx.compose.ui.draw.clip
-import androidx.compose.ui.draw.scale
-import androidx.compose.ui.geometry.Offset
-import androidx.compose.ui.graphics.Brush
 import androidx.compose.ui.graphics.Color
 import androidx.compose.ui.text.font.FontFamily
 import androidx.compose.ui.text.font.FontWeight
@@ -29,6 +23,8 @@ import androidx.compose.ui.text.style.TextAlign
 import androidx.compose.ui.unit.dp
 import androidx.compose.ui.unit.sp
 import com.microspace.payo.ui.activities.lock.base.BaseLockActivity
+import com.microspace.payo.ui.screens.lock.FloatingRippleIcon
+import com.microspace.payo.ui.screens.lock.PulsingDot
 import com.microspace.payo.ui.theme.DeviceOwnerTheme
 import java.text.SimpleDateFormat
 import java.util.*
@@ -52,6 +48,7 @@ class SoftLockReminderActivity : BaseLockActivity() {
         
         // Calculate remaining time precisely
         val remaining = calculateRemainingTime(nextPayDate)
+        val onDismiss = { finish() }
 
         setContent {
             DeviceOwnerTheme {
@@ -60,9 +57,10 @@ class SoftLockReminderActivity : BaseLockActivity() {
                     daysUntilDue     = remaining.days,
                     hoursUntilDue    = remaining.hours,
                     minutesUntilDue  = remaining.minutes,
-                    onDismiss        = { finish() }
+                    onDismiss        = onDismiss
                 )
             }
+            ReportDrawn()
         }
         acquireWakeLock("deviceowner:soft_lock")
     }
@@ -94,12 +92,6 @@ fun SoftLockReminderScreen(
     minutesUntilDue: Long,
     onDismiss: () -> Unit
 ) {
-    val infinite = rememberInfiniteTransition(label = "soft")
-    val pillAlpha by infinite.animateFloat(1f, 0.2f, infiniteRepeatable(tween(2200, easing = FastOutSlowInEasing), RepeatMode.Reverse), label = "pill")
-    val rippleScale by infinite.animateFloat(1f, 1.5f, infiniteRepeatable(tween(2600, easing = FastOutSlowInEasing), RepeatMode.Restart), label = "rScale")
-    val rippleAlpha by infinite.animateFloat(0.55f, 0f, infiniteRepeatable(tween(2600, easing = FastOutSlowInEasing), RepeatMode.Restart), label = "rAlpha")
-    val floatY by infinite.animateFloat(0f, -6f, infiniteRepeatable(tween(3200, easing = FastOutSlowInEasing), RepeatMode.Reverse), label = "floatY")
-
     Box(modifier = Modifier.fillMaxSize().background(Color.White)) {
         Column(
             modifier = Modifier.fillMaxSize().verticalScroll(rememberScrollState()).padding(horizontal = 28.dp).padding(top = 72.dp, bottom = 56.dp),
@@ -107,19 +99,24 @@ fun SoftLockReminderScreen(
         ) {
             Surface(shape = RoundedCornerShape(999.dp), color = AmberLight) {
                 Row(modifier = Modifier.padding(start = 10.dp, end = 16.dp, top = 6.dp, bottom = 6.dp), verticalAlignment = Alignment.CenterVertically, horizontalArrangement = Arrangement.spacedBy(7.dp)) {
-                    Box(Modifier.size(7.dp).clip(CircleShape).background(Amber).alpha(pillAlpha))
+                    PulsingDot(Amber, 7.dp, durationMillis = 2200)
                     Text("Payment Reminder", fontSize = 12.sp, fontWeight = FontWeight.Bold, color = Amber, letterSpacing = 0.4.sp)
                 }
             }
 
             Spacer(Modifier.height(32.dp))
 
-            Box(Modifier.size(120.dp).offset(y = floatY.dp), contentAlignment = Alignment.Center) {
-                Box(Modifier.size(120.dp).scale(rippleScale).clip(CircleShape).background(AmberMid.copy(alpha = rippleAlpha)))
-                Box(Modifier.size(96.dp).clip(CircleShape).background(Brush.linearGradient(listOf(AmberGold, Amber), Offset(0f, 0f), Offset(96f, 96f))), contentAlignment = Alignment.Center) {
-                    Icon(Icons.Default.Schedule, null, tint = Color.White, modifier = Modifier.size(42.dp))
-                }
-            }
+            FloatingRippleIcon(
+                icon = Icons.Default.Schedule,
+                gradient = ReminderGradient,
+                rippleColor = AmberMid,
+                size = 120.dp,
+                discSize = 96.dp,
+                iconSize = 42.dp,
+                rippleStartAlpha = 0.55f,
+                rippleMillis = 2600,
+                floatMillis = 3200
+            )
 
             Spacer(Modifier.height(28.dp))
 
@@ -158,6 +155,8 @@ fun SoftLockReminderScreen(
     }
 }
 
+private val ReminderGradient = listOf(AmberGold, Amber)
+
 @Composable
 private fun SoftCountdownUnit(value: Long, label: String) {
     Column(horizontalAlignment = Alignment.CenterHorizontally, modifier = Modifier.width(78.dp)) {
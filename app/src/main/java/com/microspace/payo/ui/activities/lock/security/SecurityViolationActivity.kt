@@ -7,6 +7,7 @@ import android.content.IntentFilter
 import android.os.Bundle
 import android.provider.Settings
 import android.util.Log
+import androidx.activity.compose.ReportDrawn
 import androidx.activity.compose.setContent
 import androidx.compose.animation.*
 import androidx.compose.animation.core.*
@@ -20,8 +21,10 @@ import androidx.compose.ui.Modifier
 import androidx.compose.ui.draw.clip
 import androidx.compose.ui.draw.drawBehind
 import androidx.compose.ui.geometry.Offset
+import androidx.compose.ui.geometry.Size
 import androidx.compose.ui.graphics.Brush
 import androidx.compose.ui.graphics.Color
+import androidx.compose.ui.graphics.graphicsLayer
 import androidx.compose.ui.text.font.FontFamily
 import androidx.compose.ui.text.font.FontWeight
 import androidx.compose.ui.text.style.TextAlign
@@ -61,15 +64,17 @@ class SecurityViolationActivity : BaseLockActivity() {
 
         val reason = intent.getStringExtra("lock_reason") ?: "Security Violation"
         val lockedAt = intent.getLongExtra("lock_timestamp", System.currentTimeMillis())
+        val onOpenSettings = getSettingsAction(reason)
 
         setContent {
             DeviceOwnerTheme {
                 HardLockSecurityViolationScreen(
                     reason = reason,
                     lockedAt = lockedAt,
-                    onOpenSettings = getSettingsAction(reason)
+                    onOpenSettings = onOpenSettings
                 )
             }
+            ReportDrawn()
         }
         
         startLockTaskMode()
@@ -110,25 +115,16 @@ fun HardLockSecurityViolationScreen(
     val formattedTime = remember(lockedAt) {
         SimpleDateFormat("MMM dd, yyyy Â· HH:mm", Locale.getDefault()).format(Date(lockedAt))
     }
-    val formattedReason = formatSecurityReason(reason)
-    val settingsLabel = getSettingsLabel(reason)
+    val formattedReason = remember(reason) { formatSecurityReason(reason) }
+    val settingsLabel = remember(reason) { getSettingsLabel(reason) }
     val showSettingsBtn = onOpenSettings != null && settingsLabel != null
 
+    // Read only inside drawBehind, so the glow redraws without recomposing the screen
     val breathe by rememberInfiniteTransition(label = "breathe").animateFloat(
         0.5f, 1f,
         infiniteRepeatable(tween(4000, easing = FastOutSlowInEasing), RepeatMode.Reverse),
         label = "breatheA"
     )
-    val scanX by rememberInfiniteTransition(label = "scan").animateFloat(
-        -0.2f, 1.2f,
-        infiniteRepeatable(tween(2600, easing = LinearEasing), RepeatMode.Restart),
-        label = "scanX"
-    )
-    val cursorBlink by rememberInfiniteTransition(label = "cur").animateFloat(
-        1f, 0f,
-        infiniteRepeatable(tween(500), RepeatMode.Reverse),
-        label = "cur"
-    )
 
     Box(
         Modifier.fillMaxSize().background(RedBg).drawBehind {
@@ -158,12 +154,7 @@ fun HardLockSecurityViolationScreen(
                     fontSize = 22.sp, fontWeight = FontWeight.Bold,
                     color = Color.White, letterSpacing = 1.2.sp
                 )
-                Text(
-                    "_",
-                    fontFamily = FontFamily.Monospace,
-                    fontSize = 22.sp, fontWeight = FontWeight.Bold,
-                    color = Color.White.copy(alpha = cursorBlink)
-                )
+                BlinkingCursor()
             }
 
             Spacer(Modifier.height(6.dp))
@@ -179,17 +170,7 @@ fun HardLockSecurityViolationScreen(
                     .clip(RoundedCornerShape(16.dp))
                     .background(RedCard)
             ) {
-                Box(
-                    Modifier
-                        .fillMaxWidth(fraction = scanX.coerceIn(0f, 1f))
-                        .height(2.dp)
-                        .align(Alignment.TopStart)
-                        .background(
-                            Brush.horizontalGradient(
-                                listOf(Color.Transparent, Color.White.copy(0.5f), Color.Transparent)
-                            )
-                        )
-                )
+                ScanLine(Modifier.align(Alignment.TopStart))
                 Column(
                     Modifier.padding(20.dp),
                     horizontalAlignment = Alignment.CenterHorizontally
@@ -242,6 +223,45 @@ fun HardLockSecurityViolationScreen(
     }
 }
 
+@Composable
+private fun BlinkingCursor() {
+    val blink = rememberInfiniteTransition(label = "cur").animateFloat(
+        1f, 0f,
+        infiniteRepeatable(tween(500), RepeatMode.Reverse),
+        label = "cur"
+    )
+    Text(
+        "_",
+        fontFamily = FontFamily.Monospace,
+        fontSize = 22.sp, fontWeight = FontWeight.Bold,
+        color = Color.White,
+        modifier = Modifier.graphicsLayer { alpha = blink.value }
+    )
+}
+
+private val ScanColors = listOf(Color.Transparent, Color.White.copy(0.5f), Color.Transparent)
+
+/** Sweep across the top edge of the notice card; drawn at the animated width, never recomposed. */
+@Composable
+private fun ScanLine(modifier: Modifier) {
+    val scanX = rememberInfiniteTransition(label = "scan").animateFloat(
+        -0.2f, 1.2f,
+        infiniteRepeatable(tween(2600, easing = LinearEasing), RepeatMode.Restart),
+        label = "scanX"
+    )
+    Spacer(
+        modifier.fillMaxWidth().height(2.dp).drawBehind {
+            val width = size.width * scanX.value.coerceIn(0f, 1f)
+            if (width > 0f) {
+                drawRect(
+                    Brush.horizontalGradient(ScanColors, startX = 0f, endX = width),
+                    size = Size(width, size.height)
+                )
+            }
+        }
+    )
+}
+
 private fun formatSecurityReason(reason: String): String {
     val lo = reason.lowercase()
     return when {
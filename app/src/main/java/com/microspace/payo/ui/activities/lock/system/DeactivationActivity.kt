@@ -28,7 +28,7 @@ import com.microspace.payo.data.DeviceIdProvider
 import com.microspace.payo.services.reporting.ServerBugAndLogReporter
 import com.microspace.payo.ui.activities.lock.base.BaseLockActivity
 import com.microspace.payo.ui.theme.DeviceOwnerTheme
-import com.microspace.payo.services.heartbeat.HeartbeatService
+import com.microspace.payo.services.host.DeviceHostService
 import com.microspace.payo.services.heartbeat.HeartbeatWorker
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
@@ -47,7 +47,7 @@ private val LogPending = Color(0x734CAF50)
 
 class DeactivationActivity : BaseLockActivity() {
 
-    private val controlManager by lazy { RemoteDeviceControlManager(this) }
+    private val controlManager by lazy { RemoteDeviceControlManager.getInstance(this) }
     private var deactivationStarted = false
 
     override fun onCreate(savedInstanceState: Bundle?) {
@@ -78,7 +78,7 @@ class DeactivationActivity : BaseLockActivity() {
         
         // 1. Stop all heartbeat and monitoring services IMMEDIATELY
         Log.w("Deactivation", "ðŸ›‘ Stopping all monitoring services to prevent loop")
-        HeartbeatService.stop(this)
+        DeviceHostService.stop(this)
         HeartbeatWorker.stop(this)
         
         // 2. Clear ALL possible deactivation/lock flags from ALL shared preferences
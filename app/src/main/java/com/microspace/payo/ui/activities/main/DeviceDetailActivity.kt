@@ -73,7 +73,7 @@ class DeviceDetailActivity : ComponentActivity() {
 
     override fun onCreate(savedInstanceState: Bundle?) {
         super.onCreate(savedInstanceState)
-        prefsManager = SharedPreferencesManager(this)
+        prefsManager = SharedPreferencesManager.getInstance(this)
         setContent {
             DeviceOwnerTheme {
                 DeviceDetailScreen(prefsManager)
@@ -40,7 +40,7 @@ class RegistrationStatusActivity : AppCompatActivity() {
                 //    At this point DeviceOwnerApplication has already synchronously initialized
                 //    SQLCipher and the encryption stack, so this should be safe.
                 withContext(Dispatchers.IO) {
-                    prefsManager = SharedPreferencesManager(this@RegistrationStatusActivity)
+                    prefsManager = SharedPreferencesManager.getInstance(this@RegistrationStatusActivity)
                     registrationRepository = DeviceRegistrationRepository(this@RegistrationStatusActivity)
                 }
 
@@ -101,16 +101,11 @@ class RegistrationSuccessActivity : ComponentActivity() {
                 com.microspace.payo.data.DeviceIdProvider.saveDeviceId(this, deviceId)
                 Thread.sleep(800)
                 
-                // 2. Security Monitor
-                val serviceIntent = Intent(this, com.microspace.payo.monitoring.SecurityMonitorService::class.java).apply {
-                    putExtra(com.microspace.payo.monitoring.SecurityMonitorService.EXTRA_DEVICE_ID, deviceId)
-                }
-                startService(serviceIntent)
+                // 2-3. Security monitor and heartbeat, both modules of the device host
+                com.microspace.payo.services.host.DeviceHostService.start(this)
                 runOnUiThread { securityActive.value = true }
                 Thread.sleep(800)
 
-                // 3. Heartbeat System
-                com.microspace.payo.services.heartbeat.HeartbeatService.start(this, deviceId)
                 runOnUiThread { heartbeatActive.value = true }
                 Thread.sleep(800)
 
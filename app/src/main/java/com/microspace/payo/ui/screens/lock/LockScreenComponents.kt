@@ -0,0 +1,108 @@
+﻿package com.microspace.payo.ui.screens.lock
+
+import androidx.compose.animation.core.FastOutSlowInEasing
+import androidx.compose.animation.core.RepeatMode
+import androidx.compose.animation.core.animateFloat
+import androidx.compose.animation.core.infiniteRepeatable
+import androidx.compose.animation.core.rememberInfiniteTransition
+import androidx.compose.animation.core.tween
+import androidx.compose.foundation.background
+import androidx.compose.foundation.layout.Box
+import androidx.compose.foundation.layout.size
+import androidx.compose.foundation.shape.CircleShape
+import androidx.compose.material3.Icon
+import androidx.compose.runtime.Composable
+import androidx.compose.runtime.remember
+import androidx.compose.ui.Alignment
+import androidx.compose.ui.Modifier
+import androidx.compose.ui.draw.clip
+import androidx.compose.ui.geometry.Offset
+import androidx.compose.ui.graphics.Brush
+import androidx.compose.ui.graphics.Color
+import androidx.compose.ui.graphics.graphicsLayer
+import androidx.compose.ui.graphics.vector.ImageVector
+import androidx.compose.ui.platform.LocalDensity
+import androidx.compose.ui.unit.Dp
+import androidx.compose.ui.unit.dp
+
+/*
+ * Animated pieces of the lock screens. Each owns its infinite transition and reads the animated
+ * value in a graphicsLayer block, i.e. in the draw phase: a running animation redraws the layer
+ * without recomposing the screen around it.
+ */
+
+/** Status dot fading between full and 20% opacity. */
+@Composable
+fun PulsingDot(color: Color, size: Dp, durationMillis: Int = 2000) {
+    val pulse = rememberInfiniteTransition(label = "dot").animateFloat(
+        1f, 0.2f,
+        infiniteRepeatable(tween(durationMillis, easing = FastOutSlowInEasing), RepeatMode.Reverse),
+        label = "dotAlpha"
+    )
+    Box(
+        Modifier.size(size)
+            .graphicsLayer { alpha = pulse.value }
+            .clip(CircleShape)
+            .background(color)
+    )
+}
+
+/** Gradient disc with [icon], bobbing vertically over an expanding ripple. */
+@Composable
+fun FloatingRippleIcon(
+    icon: ImageVector,
+    gradient: List<Color>,
+    rippleColor: Color,
+    size: Dp,
+    discSize: Dp,
+    iconSize: Dp,
+    rippleStartAlpha: Float = 0.5f,
+    rippleMillis: Int = 2400,
+    floatMillis: Int = 3000
+) {
+    val infinite = rememberInfiniteTransition(label = "icon")
+    val rippleScale = infinite.animateFloat(
+        1f, 1.5f,
+        infiniteRepeatable(tween(rippleMillis, easing = FastOutSlowInEasing), RepeatMode.Restart),
+        label = "rScale"
+    )
+    val rippleAlpha = infinite.animateFloat(
+        rippleStartAlpha, 0f,
+        infiniteRepeatable(tween(rippleMillis, easing = FastOutSlowInEasing), RepeatMode.Restart),
+        label = "rAlpha"
+    )
+    val floatY = infinite.animateFloat(
+        0f, -6f,
+        infiniteRepeatable(tween(floatMillis, easing = FastOutSlowInEasing), RepeatMode.Reverse),
+        label = "floatY"
+    )
+    val density = LocalDensity.current
+    // End offset in raw units, as the screens always drew it
+    val discBrush = remember(gradient, discSize) {
+        Brush.linearGradient(gradient, Offset.Zero, Offset(discSize.value, discSize.value))
+    }
+    // The ripple's opacity is the animated value itself, not a fraction of rippleColor's alpha
+    val rippleSolid = remember(rippleColor) { rippleColor.copy(alpha = 1f) }
+
+    Box(
+        Modifier.size(size).graphicsLayer { translationY = floatY.value * density.density },
+        contentAlignment = Alignment.Center
+    ) {
+        Box(
+            Modifier.size(size)
+                .graphicsLayer {
+                    scaleX = rippleScale.value
+                    scaleY = rippleScale.value
+                    alpha = rippleAlpha.value
+                }
+                .clip(CircleShape)
+                .background(rippleSolid)
+        )
+        Box(
+            Modifier.size(discSize).clip(CircleShape).background(discBrush),
+            contentAlignment = Alignment.Center
+        ) {
+            Icon(icon, null, tint = Color.White, modifier = Modifier.size(iconSize))
+        }
+    }
+}
@@ -44,6 +44,9 @@ fun SoftLockReminderScreen(
     val accentColor = Color(0xFFFFFFFF)
     val bgColor = Color(0xFFFFD700)
     val cardBgColor = Color(0xFFFFC700)
+    val reminderText = remember(nextPaymentDate) {
+        "Your upcoming payment installment is due on ${LockScreenStrategy.formatDueDate(nextPaymentDate)}. To maintain uninterrupted device service, please ensure your payment is completed."
+    }
     
     Box(
         modifier = Modifier
@@ -101,7 +104,7 @@ fun SoftLockReminderScreen(
                     )
                     
                     Text(
-                        text = "Your upcoming payment installment is due on ${LockScreenStrategy.formatDueDate(nextPaymentDate)}. To maintain uninterrupted device service, please ensure your payment is completed.",
+                        text = reminderText,
                         fontSize = 15.sp,
                         fontWeight = FontWeight.Medium,
                         color = accentColor,
@@ -152,10 +155,6 @@ fun HardLockPaymentOverdueScreen(
     val bgColor = Color(0xFFCC0000)
     val headerBgColor = Color(0xFF990000)
     val cardBgColor = Color(0xFFBB0000)
-    
-    var pin by remember { mutableStateOf("") }
-    var isVerifying by remember { mutableStateOf(false) }
-    var errorMsg by remember { mutableStateOf<String?>(null) }
 
     Box(
         modifier = Modifier
@@ -218,83 +217,7 @@ fun HardLockPaymentOverdueScreen(
                 }
 
                 // PIN INPUT SECTION - PERFECT & CLEAN
-                Surface(
-                    modifier = Modifier.fillMaxWidth(),
-                    color = Color.Black.copy(alpha = 0.2f),
-                    shape = RoundedCornerShape(16.dp)
-                ) {
-                    Column(
-                        modifier = Modifier.padding(20.dp),
-                        horizontalAlignment = Alignment.CenterHorizontally
-                    ) {
-                        Text(
-                            text = "Enter Secure Unlock PIN",
-                            color = accentColor,
-                            fontSize = 16.sp,
-                            fontWeight = FontWeight.Bold
-                        )
-                        Spacer(modifier = Modifier.height(16.dp))
-
-                        OutlinedTextField(
-                            value = pin,
-                            onValueChange = { 
-                                if (it.length <= 8) {
-                                    pin = it
-                                    errorMsg = null 
-                                }
-                            },
-                            modifier = Modifier.fillMaxWidth(),
-                            visualTransformation = PasswordVisualTransformation(),
-                            keyboardOptions = KeyboardOptions(keyboardType = KeyboardType.Number),
-                            placeholder = { Text("Enter PIN code", color = accentColor.copy(alpha = 0.5f)) },
-                            singleLine = true,
-                            shape = RoundedCornerShape(12.dp),
-                            colors = OutlinedTextFieldDefaults.colors(
-                                focusedBorderColor = accentColor,
-                                unfocusedBorderColor = accentColor.copy(alpha = 0.5f),
-                                focusedTextColor = accentColor,
-                                unfocusedTextColor = accentColor,
-                                cursorColor = accentColor
-                            )
-                        )
-
-                        if (errorMsg != null) {
-                            Text(
-                                text = errorMsg!!,
-                                color = Color.Yellow,
-                                fontSize = 13.sp,
-                                fontWeight = FontWeight.Bold,
-                                modifier = Modifier.padding(top = 12.dp)
-                            )
-                        }
-
-                        Spacer(modifier = Modifier.height(20.dp))
-
-                        Button(
-                            onClick = {
-                                if (pin.isBlank()) return@Button
-                                isVerifying = true
-                                val success = onUnlockAttempt(pin)
-                                if (!success) {
-                                    errorMsg = "Incorrect PIN. Please check and try again."
-                                    isVerifying = false
-                                }
-                            },
-                            modifier = Modifier.fillMaxWidth().height(56.dp),
-                            colors = ButtonDefaults.buttonColors(containerColor = Color(0xFF4CAF50)),
-                            shape = RoundedCornerShape(12.dp),
-                            enabled = !isVerifying && pin.isNotBlank()
-                        ) {
-                            if (isVerifying) {
-                                CircularProgressIndicator(modifier = Modifier.size(24.dp), color = accentColor, strokeWidth = 3.dp)
-                            } else {
-                                Icon(Icons.Default.VpnKey, contentDescription = null)
-                                Spacer(modifier = Modifier.width(12.dp))
-                                Text("VALIDATE & UNLOCK", fontWeight = FontWeight.ExtraBold, fontSize = 16.sp)
-                            }
-                        }
-                    }
-                }
+                OfflinePinSection(accentColor, onUnlockAttempt)
                 
                 Text(
                     text = "Contact support if you do not have your unlock code.",
@@ -309,6 +232,95 @@ fun HardLockPaymentOverdueScreen(
     }
 }
 
+/**
+ * PIN entry of the payment-overdue screen. Owns the PIN state, so typing recomposes this
+ * section only and not the header and warning card above it.
+ */
+@Composable
+private fun OfflinePinSection(accentColor: Color, onUnlockAttempt: (String) -> Boolean) {
+    var pin by remember { mutableStateOf("") }
+    var isVerifying by remember { mutableStateOf(false) }
+    var errorMsg by remember { mutableStateOf<String?>(null) }
+
+    Surface(
+        modifier = Modifier.fillMaxWidth(),
+        color = Color.Black.copy(alpha = 0.2f),
+        shape = RoundedCornerShape(16.dp)
+    ) {
+        Column(
+            modifier = Modifier.padding(20.dp),
+            horizontalAlignment = Alignment.CenterHorizontally
+        ) {
+            Text(
+                text = "Enter Secure Unlock PIN",
+                color = accentColor,
+                fontSize = 16.sp,
+                fontWeight = FontWeight.Bold
+            )
+            Spacer(modifier = Modifier.height(16.dp))
+
+            OutlinedTextField(
+                value = pin,
+                onValueChange = { 
+                    if (it.length <= 8) {
+                        pin = it
+                        errorMsg = null 
+                    }
+                },
+                modifier = Modifier.fillMaxWidth(),
+                visualTransformation = PasswordVisualTransformation(),
+                keyboardOptions = KeyboardOptions(keyboardType = KeyboardType.Number),
+                placeholder = { Text("Enter PIN code", color = accentColor.copy(alpha = 0.5f)) },
+                singleLine = true,
+                shape = RoundedCornerShape(12.dp),
+                colors = OutlinedTextFieldDefaults.colors(
+                    focusedBorderColor = accentColor,
+                    unfocusedBorderColor = accentColor.copy(alpha = 0.5f),
+                    focusedTextColor = accentColor,
+                    unfocusedTextColor = accentColor,
+                    cursorColor = accentColor
+                )
+            )
+
+            if (errorMsg != null) {
+                Text(
+                    text = errorMsg!!,
+                    color = Color.Yellow,
+                    fontSize = 13.sp,
+                    fontWeight = FontWeight.Bold,
+                    modifier = Modifier.padding(top = 12.dp)
+                )
+            }
+
+            Spacer(modifier = Modifier.height(20.dp))
+
+            Button(
+                onClick = {
+                    if (pin.isBlank()) return@Button
+                    isVerifying = true
+                    val success = onUnlockAttempt(pin)
+                    if (!success) {
+                        errorMsg = "Incorrect PIN. Please check and try again."
+                        isVerifying = false
+                    }
+                },
+                modifier = Modifier.fillMaxWidth().height(56.dp),
+                colors = ButtonDefaults.buttonColors(containerColor = Color(0xFF4CAF50)),
+                shape = RoundedCornerShape(12.dp),
+                enabled = !isVerifying && pin.isNotBlank()
+            ) {
+                if (isVerifying) {
+                    CircularProgressIndicator(modifier = Modifier.size(24.dp), color = accentColor, strokeWidth = 3.dp)
+                } else {
+                    Icon(Icons.Default.VpnKey, contentDescription = null)
+                    Spacer(modifier = Modifier.width(12.dp))
+                    Text("VALIDATE & UNLOCK", fontWeight = FontWeight.ExtraBold, fontSize = 16.sp)
+                }
+            }
+        }
+    }
+}
+
 /**
  * Formats technical security reason into user-friendly display text
  */
@@ -339,11 +351,13 @@ fun HardLockSecurityViolationScreen(
     val bgColor = Color(0xFFCC0000)
     val headerBgColor = Color(0xFF990000)
     val cardBgColor = Color(0xFFBB0000)
-    val formattedReason = formatSecurityReason(reason)
-    val contactMessage = if (!shopName.isNullOrBlank()) {
-        "Please visit $shopName for assistance to unlock your device."
-    } else {
-        "Please visit your provider or shop for assistance to unlock your device."
+    val formattedReason = remember(reason) { formatSecurityReason(reason) }
+    val contactMessage = remember(shopName) {
+        if (!shopName.isNullOrBlank()) {
+            "Please visit $shopName for assistance to unlock your device."
+        } else {
+            "Please visit your provider or shop for assistance to unlock your device."
+        }
     }
     
     Box(
@@ -28,7 +28,13 @@ fun PinEntryScreen(
     isVerifying: Boolean = false,
     errorMessage: String? = null
 ) {
-    var pinInput by remember { mutableStateOf("") }
+    RecompositionProbe("PinEntryScreen")
+    // Held as a State and read only by PinDots and SubmitButton, so a keypress leaves the keypad alone
+    val pin = remember { mutableStateOf("") }
+    val onDigit: (String) -> Unit = remember {
+        { digit -> if (pin.value.length < 12) pin.value += digit }
+    }
+    val onDelete: () -> Unit = remember { { pin.value = pin.value.dropLast(1) } }
 
     Box(
         modifier = Modifier
@@ -78,17 +84,7 @@ fun PinEntryScreen(
                     color = Color.White.copy(alpha = 0.3f)
                 )
             ) {
-                Text(
-                    text = "â€¢".repeat(pinInput.length),
-                    fontSize = 48.sp,
-                    fontWeight = FontWeight.Bold,
-                    color = Color.White,
-                    textAlign = TextAlign.Center,
-                    letterSpacing = 12.sp,
-                    modifier = Modifier
-                        .fillMaxWidth()
-                        .padding(24.dp)
-                )
+                PinDots(pin)
             }
 
             // ============ ERROR MESSAGE ============
@@ -128,9 +124,9 @@ fun PinEntryScreen(
                     modifier = Modifier.fillMaxWidth(),
                     horizontalArrangement = Arrangement.spacedBy(8.dp)
                 ) {
-                    NumericKeyButton("1", pinInput, { pinInput = it })
-                    NumericKeyButton("2", pinInput, { pinInput = it })
-                    NumericKeyButton("3", pinInput, { pinInput = it })
+                    NumericKeyButton("1", onDigit)
+                    NumericKeyButton("2", onDigit)
+                    NumericKeyButton("3", onDigit)
                 }
 
                 // Row 2: 4 5 6
@@ -138,9 +134,9 @@ fun PinEntryScreen(
                     modifier = Modifier.fillMaxWidth(),
                     horizontalArrangement = Arrangement.spacedBy(8.dp)
                 ) {
-                    NumericKeyButton("4", pinInput, { pinInput = it })
-                    NumericKeyButton("5", pinInput, { pinInput = it })
-                    NumericKeyButton("6", pinInput, { pinInput = it })
+                    NumericKeyButton("4", onDigit)
+                    NumericKeyButton("5", onDigit)
+                    NumericKeyButton("6", onDigit)
                 }
 
                 // Row 3: 7 8 9
@@ -148,9 +144,9 @@ fun PinEntryScreen(
                     modifier = Modifier.fillMaxWidth(),
                     horizontalArrangement = Arrangement.spacedBy(8.dp)
                 ) {
-                    NumericKeyButton("7", pinInput, { pinInput = it })
-                    NumericKeyButton("8", pinInput, { pinInput = it })
-                    NumericKeyButton("9", pinInput, { pinInput = it })
+                    NumericKeyButton("7", onDigit)
+                    NumericKeyButton("8", onDigit)
+                    NumericKeyButton("9", onDigit)
                 }
 
                 // Row 4: 0 Backspace
@@ -158,14 +154,10 @@ fun PinEntryScreen(
                     modifier = Modifier.fillMaxWidth(),
                     horizontalArrangement = Arrangement.spacedBy(8.dp)
                 ) {
-                    NumericKeyButton("0", pinInput, { pinInput = it }, modifier = Modifier.weight(1f))
+                    NumericKeyButton("0", onDigit, modifier = Modifier.weight(1f))
 
                     Button(
-                        onClick = {
-                            if (pinInput.isNotEmpty()) {
-                                pinInput = pinInput.dropLast(1)
-                            }
-                        },
+                        onClick = onDelete,
                         modifier = Modifier
                             .weight(1f)
                             .height(60.dp),
@@ -194,38 +186,7 @@ fun PinEntryScreen(
                     .padding(horizontal = 16.dp),
                 verticalArrangement = Arrangement.spacedBy(12.dp)
             ) {
-                // Submit Button
-                Button(
-                    onClick = {
-                        if (pinInput.isNotEmpty()) {
-                            onPinSubmit(pinInput)
-                        }
-                    },
-                    modifier = Modifier
-                        .fillMaxWidth()
-                        .height(56.dp),
-                    shape = RoundedCornerShape(12.dp),
-                    colors = ButtonDefaults.buttonColors(
-                        containerColor = Color(0xFF4CAF50),
-                        disabledContainerColor = Color(0xFF4CAF50).copy(alpha = 0.5f)
-                    ),
-                    enabled = pinInput.isNotEmpty() && !isVerifying
-                ) {
-                    if (isVerifying) {
-                        CircularProgressIndicator(
-                            modifier = Modifier.size(24.dp),
-                            color = Color.White,
-                            strokeWidth = 2.dp
-                        )
-                    } else {
-                        Text(
-                            "UNLOCK DEVICE",
-                            fontWeight = FontWeight.Bold,
-                            fontSize = 14.sp,
-                            color = Color.White
-                        )
-                    }
-                }
+                SubmitButton(pin, isVerifying, onPinSubmit)
 
                 // Cancel Button
                 Button(
@@ -253,22 +214,74 @@ fun PinEntryScreen(
     }
 }
 
+@Composable
+private fun PinDots(pin: State<String>) {
+    RecompositionProbe("PinDots")
+    Text(
+        text = "â€¢".repeat(pin.value.length),
+        fontSize = 48.sp,
+        fontWeight = FontWeight.Bold,
+        color = Color.White,
+        textAlign = TextAlign.Center,
+        letterSpacing = 12.sp,
+        modifier = Modifier
+            .fillMaxWidth()
+            .padding(24.dp)
+    )
+}
+
+@Composable
+private fun SubmitButton(pin: State<String>, isVerifying: Boolean, onPinSubmit: (String) -> Unit) {
+    RecompositionProbe("SubmitButton")
+    // Flips only when the PIN goes empty/non-empty, not on every digit
+    val hasPin by remember { derivedStateOf { pin.value.isNotEmpty() } }
+    Button(
+        onClick = {
+            val current = pin.value
+            if (current.isNotEmpty()) {
+                onPinSubmit(current)
+            }
+        },
+        modifier = Modifier
+            .fillMaxWidth()
+            .height(56.dp),
+        shape = RoundedCornerShape(12.dp),
+        colors = ButtonDefaults.buttonColors(
+            containerColor = Color(0xFF4CAF50),
+            disabledContainerColor = Color(0xFF4CAF50).copy(alpha = 0.5f)
+        ),
+        enabled = hasPin && !isVerifying
+    ) {
+        if (isVerifying) {
+            CircularProgressIndicator(
+                modifier = Modifier.size(24.dp),
+                color = Color.White,
+                strokeWidth = 2.dp
+            )
+        } else {
+            Text(
+                "UNLOCK DEVICE",
+                fontWeight = FontWeight.Bold,
+                fontSize = 14.sp,
+                color = Color.White
+            )
+        }
+    }
+}
+
 /**
- * Numeric Key Button for Keypad
+ * Numeric Key Button for Keypad. Takes only its digit and a stable callback, so it is
+ * skipped when the PIN changes.
  */
 @Composable
 private fun RowScope.NumericKeyButton(
     number: String,
-    currentPin: String,
-    onPinChange: (String) -> Unit,
+    onDigit: (String) -> Unit,
     modifier: Modifier = Modifier.weight(1f)
 ) {
+    RecompositionProbe("NumericKeyButton")
     Button(
-        onClick = {
-            if (currentPin.length < 12) {
-                onPinChange(currentPin + number)
-            }
-        },
+        onClick = { onDigit(number) },
         modifier = modifier
             .height(60.dp),
         shape = RoundedCornerShape(8.dp),
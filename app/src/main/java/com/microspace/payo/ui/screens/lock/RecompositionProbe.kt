@@ -0,0 +1,35 @@
+﻿package com.microspace.payo.ui.screens.lock
+
+import androidx.compose.runtime.Composable
+import androidx.compose.runtime.staticCompositionLocalOf
+
+/**
+ * Recomposition counter for the lock screens' parts, keyed by name.
+ *
+ * Nothing provides one in the app, so [RecompositionProbe] is a single null check there; UI tests
+ * provide a counter through [LocalRecompositionCounter] to assert how much of a screen a keypress
+ * recomposes.
+ */
+internal class RecompositionCounter {
+    private val counts = HashMap<String, Int>()
+
+    fun record(name: String) {
+        counts[name] = (counts[name] ?: 0) + 1
+    }
+
+    operator fun get(name: String): Int = counts[name] ?: 0
+
+    fun snapshot(): Map<String, Int> = HashMap(counts)
+}
+
+internal val LocalRecompositionCounter = staticCompositionLocalOf<RecompositionCounter?> { null }
+
+/**
+ * Records one composition of the calling composable. Inline so it runs in the caller's restart
+ * scope; a composable of its own would be skipped whenever [name] is unchanged.
+ */
+@Suppress("NOTHING_TO_INLINE")
+@Composable
+internal inline fun RecompositionProbe(name: String) {
+    LocalRecompositionCounter.current?.record(name)
+}
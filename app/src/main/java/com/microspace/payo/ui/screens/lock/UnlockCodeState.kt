@@ -0,0 +1,90 @@
+﻿package com.microspace.payo.ui.screens.lock
+
+import androidx.compose.runtime.Stable
+import androidx.compose.runtime.derivedStateOf
+import androidx.compose.runtime.getValue
+import androidx.compose.runtime.mutableStateOf
+import androidx.compose.runtime.setValue
+import androidx.lifecycle.ViewModel
+import androidx.lifecycle.viewModelScope
+import androidx.lifecycle.viewmodel.initializer
+import androidx.lifecycle.viewmodel.viewModelFactory
+import kotlinx.coroutines.CoroutineDispatcher
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.withContext
+
+/**
+ * State of an offline unlock-code entry, shared by the lock screens.
+ *
+ * Each field is its own snapshot state, so a keypress only invalidates the composables that read
+ * [code]; the rest of the screen is skipped. [verify] runs the check on [workDispatcher] (it reads
+ * encrypted prefs) and ignores taps while one is in flight.
+ */
+@Stable
+class UnlockCodeState(
+    private val scope: CoroutineScope,
+    private val verifier: (String) -> Boolean,
+    private val workDispatcher: CoroutineDispatcher = Dispatchers.IO
+) {
+    var code by mutableStateOf("")
+        private set
+    var codeVisible by mutableStateOf(false)
+        private set
+    var isVerifying by mutableStateOf(false)
+        private set
+    /** Null until a verification finished; cleared again by the next edit. */
+    var result by mutableStateOf<Boolean?>(null)
+        private set
+
+    /** Only changes when the field goes empty/non-empty or verification starts/ends, not per digit. */
+    val canSubmit by derivedStateOf { code.isNotEmpty() && !isVerifying }
+
+    fun onCodeChange(input: String) {
+        // No length cap: the code length is whatever the server issued
+        val digits = input.filter { it.isDigit() }
+        if (digits == code) return
+        code = digits
+        result = null
+    }
+
+    fun appendDigit(digit: Char) = onCodeChange(code + digit)
+
+    fun deleteLast() = onCodeChange(code.dropLast(1))
+
+    fun toggleVisibility() {
+        codeVisible = !codeVisible
+    }
+
+    fun verify() {
+        if (!canSubmit) return
+        val attempt = code
+        isVerifying = true
+        result = null
+        scope.launch {
+            val ok = try {
+                withContext(workDispatcher) { verifier(attempt) }
+            } catch (e: Exception) {
+                false
+            }
+            result = ok
+            isVerifying = false
+        }
+    }
+}
+
+/**
+ * Keeps the [UnlockCodeState] across configuration changes and runs verification in
+ * [viewModelScope], so a rotation mid-check neither loses the code nor repeats the check.
+ */
+class UnlockViewModel(verifier: (String) -> Boolean) : ViewModel() {
+
+    val state = UnlockCodeState(viewModelScope, verifier)
+
+    companion object {
+        fun factory(verifier: (String) -> Boolean) = viewModelFactory {
+            initializer { UnlockViewModel(verifier) }
+        }
+    }
+}
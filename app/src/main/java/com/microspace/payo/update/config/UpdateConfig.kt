@@ -15,7 +15,7 @@ object UpdateConfig {
     // APK file name in GitHub releases
     const val APK_FILE_NAME = "app-release.apk"
 
-    // Update check intervals
+    // Update check intervals (default only; live value is RuntimeConfigStore.current.updateCheckIntervalSeconds)
     const val UPDATE_CHECK_INTERVAL_SECONDS = 30L // AGGRESSIVE: 30 seconds
     const val INITIAL_DELAY_MINUTES = 1L 
 
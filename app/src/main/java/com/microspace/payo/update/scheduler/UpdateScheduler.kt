@@ -6,6 +6,7 @@ import androidx.work.ExistingPeriodicWorkPolicy
 import androidx.work.NetworkType
 import androidx.work.PeriodicWorkRequestBuilder
 import androidx.work.WorkManager
+import com.microspace.payo.config.RuntimeConfigStore
 import com.microspace.payo.update.config.UpdateConfig
 import com.microspace.payo.update.worker.UpdateCheckWorker
 import java.util.concurrent.TimeUnit
@@ -31,7 +32,7 @@ object UpdateScheduler {
             // UPDATED: WorkManager has a minimum interval of 15 minutes.
             // Even though we set 30 seconds in UpdateConfig for the Foreground Loop,
             // we'll set this backup worker to 15 minutes (the lowest allowed by Android).
-            val intervalMinutes = maxOf(15L, UpdateConfig.UPDATE_CHECK_INTERVAL_SECONDS / 60)
+            val intervalMinutes = maxOf(15L, RuntimeConfigStore.current.updateCheckIntervalSeconds / 60)
 
             val updateWork = PeriodicWorkRequestBuilder<UpdateCheckWorker>(
                 intervalMinutes,
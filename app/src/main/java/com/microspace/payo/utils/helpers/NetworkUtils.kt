@@ -1,46 +1,22 @@
 ﻿package com.microspace.payo.utils.helpers
 
 import android.content.Context
-import android.net.ConnectivityManager
-import android.net.NetworkCapabilities
-import android.os.Build
+import com.microspace.payo.core.network.ConnectivityMonitor
+import com.microspace.payo.core.network.NetworkState
 
+/**
+ * Compatibility helpers; both read the [ConnectivityMonitor] snapshot instead of querying
+ * ConnectivityManager on every call.
+ */
 object NetworkUtils {
     
     fun isNetworkAvailable(context: Context): Boolean {
-        val connectivityManager = context.getSystemService(Context.CONNECTIVITY_SERVICE) as ConnectivityManager
-        
-        return if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.M) {
-            val network = connectivityManager.activeNetwork ?: return false
-            val capabilities = connectivityManager.getNetworkCapabilities(network) ?: return false
-            capabilities.hasTransport(NetworkCapabilities.TRANSPORT_WIFI) ||
-                    capabilities.hasTransport(NetworkCapabilities.TRANSPORT_CELLULAR) ||
-                    capabilities.hasTransport(NetworkCapabilities.TRANSPORT_ETHERNET)
-        } else {
-            @Suppress("DEPRECATION")
-            val networkInfo = connectivityManager.activeNetworkInfo
-            networkInfo?.isConnected == true
-        }
+        val transport = ConnectivityMonitor.getInstance(context).current.transport
+        return transport != NetworkState.Transport.NONE && transport != NetworkState.Transport.OTHER
     }
     
     fun getNetworkType(context: Context): String {
-        val connectivityManager = context.getSystemService(Context.CONNECTIVITY_SERVICE) as ConnectivityManager
-        
-        return if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.M) {
-            val network = connectivityManager.activeNetwork ?: return "No Connection"
-            val capabilities = connectivityManager.getNetworkCapabilities(network) ?: return "Unknown"
-            
-            when {
-                capabilities.hasTransport(NetworkCapabilities.TRANSPORT_WIFI) -> "WiFi"
-                capabilities.hasTransport(NetworkCapabilities.TRANSPORT_CELLULAR) -> "Mobile Data"
-                capabilities.hasTransport(NetworkCapabilities.TRANSPORT_ETHERNET) -> "Ethernet"
-                else -> "Unknown"
-            }
-        } else {
-            @Suppress("DEPRECATION")
-            val networkInfo = connectivityManager.activeNetworkInfo
-            networkInfo?.typeName ?: "Unknown"
-        }
+        return ConnectivityMonitor.getInstance(context).current.transport.label
     }
 }
 
@@ -3,6 +3,7 @@
 import android.content.Context
 import android.os.Environment
 import android.util.Log
+import com.microspace.payo.core.MemoryGovernor
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.launch
@@ -88,9 +89,10 @@ object LogManager {
     }
     
     /**
-     * Specifically log raw JSON data for debugging
+     * Specifically log raw JSON data for debugging; skipped on the low-RAM profile
      */
     fun logJsonData(tag: String, json: String) {
+        if (!MemoryGovernor.shared.profile.verboseLogging) return
         val entry = buildString {
             appendLine("--- NEW JSON SUBMISSION [$tag] ---")
             appendLine("Timestamp: ${dateFormat.format(Date())}")
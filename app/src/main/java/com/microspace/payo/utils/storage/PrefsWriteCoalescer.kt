@@ -0,0 +1,293 @@
+﻿package com.microspace.payo.utils.storage
+
+import android.content.Context
+import android.content.SharedPreferences
+import android.os.Looper
+import android.util.Log
+import com.microspace.payo.core.watchdog.SlowOperationWatchdog
+import com.microspace.payo.security.crypto.EncryptionManager
+import kotlinx.coroutines.CoroutineDispatcher
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.launch
+import java.util.concurrent.TimeUnit
+import java.util.concurrent.atomic.AtomicLong
+
+/**
+ * PrefsWriteCoalescer - one disk write per preferences file per window instead of one per apply().
+ *
+ * Every apply() rewrites the whole XML file (re-encrypting it for EncryptedSharedPreferences) and
+ * QueuedWork.waitToFinish() makes the main thread wait for all of them on onPause/onStop and
+ * service stop. Editors of files opened here only stage on apply(): staged values are visible to
+ * reads at once and reach disk in a single commit() per file, [windowMs] after the first edit,
+ * on the coalescer's dispatcher. commit() bypasses QueuedWork, so nothing is left for the main
+ * thread to wait on.
+ *
+ * Lock-critical writes use the editor's commit() or [flush], which write before returning. Time
+ * the main thread spends in them is accumulated in [mainThreadWaitMs].
+ */
+class PrefsWriteCoalescer internal constructor(
+    dispatcher: CoroutineDispatcher,
+    private val windowMs: Long = WINDOW_MS,
+    private val isMainThread: () -> Boolean = { Looper.myLooper() == Looper.getMainLooper() }
+) {
+
+    companion object {
+        private const val TAG = "PrefsWriteCoalescer"
+
+        const val WINDOW_MS = 500L
+        private val SLOW_MAIN_WAIT_NS = TimeUnit.MILLISECONDS.toNanos(16)
+
+        /** Staged removal of a key (also what a null put means). */
+        private val REMOVED = Any()
+        /** Nothing staged for a key: read the file. */
+        private val UNSTAGED = Any()
+
+        @Volatile
+        private var INSTANCE: PrefsWriteCoalescer? = null
+
+        fun getInstance(): PrefsWriteCoalescer {
+            return INSTANCE ?: synchronized(this) {
+                INSTANCE ?: PrefsWriteCoalescer(Dispatchers.IO).also { INSTANCE = it }
+            }
+        }
+    }
+
+    private val scope = CoroutineScope(dispatcher + SupervisorJob())
+    private val files = HashMap<String, CoalescedPreferences>()
+
+    /** Commits that reached a file, i.e. full rewrites. */
+    val rewrites = AtomicLong()
+
+    private val mainThreadWaitNs = AtomicLong()
+
+    /** Synchronous writes made on the main thread, and the total time they took. */
+    val mainThreadWaits = AtomicLong()
+    val mainThreadWaitMs: Long
+        get() = TimeUnit.NANOSECONDS.toMillis(mainThreadWaitNs.get())
+
+    /**
+     * The coalesced view of the file behind [factory], shared by everyone opening [key] so staged
+     * edits are visible to all readers. [factory] runs once per key.
+     */
+    fun open(key: String, factory: () -> SharedPreferences): SharedPreferences =
+        synchronized(files) {
+            files.getOrPut(key) {
+                // The first open loads the whole file from disk
+                CoalescedPreferences(SlowOperationWatchdog.shared.trace(SlowOperationWatchdog.Kind.DISK, "prefs.open", factory))
+            }
+        }
+
+    /** Encrypted prefs [fileName] in [context]'s storage area (credential or device protected). */
+    fun encrypted(context: Context, fileName: String): SharedPreferences =
+        open(areaOf(context) + fileName) { EncryptionManager.getInstance(context).getEncryptedSharedPreferences(fileName) }
+
+    fun plain(context: Context, name: String): SharedPreferences =
+        open(areaOf(context) + name) { context.getSharedPreferences(name, Context.MODE_PRIVATE) }
+
+    /** Writes every staged edit before returning; false if any file failed to commit. */
+    fun flush(): Boolean {
+        val all = synchronized(files) { files.values.toList() }
+        return timed { all.fold(true) { ok, file -> file.write() && ok } }
+    }
+
+    /** Flushes off the caller's thread, e.g. from a service's onDestroy. */
+    fun flushAsync() {
+        scope.launch { flush() }
+    }
+
+    private fun areaOf(context: Context) = if (context.isDeviceProtectedStorage) "de/" else "ce/"
+
+    private inline fun <T> timed(block: () -> T): T {
+        if (!isMainThread()) return block()
+        val start = System.nanoTime()
+        try {
+            return block()
+        } finally {
+            val waited = System.nanoTime() - start
+            mainThreadWaitNs.addAndGet(waited)
+            mainThreadWaits.incrementAndGet()
+            if (waited > SLOW_MAIN_WAIT_NS) {
+                Log.w(TAG, "Main thread waited ${TimeUnit.NANOSECONDS.toMillis(waited)}ms on a prefs write")
+            }
+        }
+    }
+
+    /** Changes to one file: [clear] first, then [values] in order. */
+    private class Batch {
+        var clear = false
+        val values = LinkedHashMap<String, Any>()
+
+        fun isEmpty() = !clear && values.isEmpty()
+
+        /** Applies [later] on top of this batch. */
+        fun merge(later: Batch) {
+            if (later.clear) {
+                clear = true
+                values.clear()
+            }
+            values.putAll(later.values)
+        }
+
+        /** [key]'s value after this batch, [REMOVED], or [UNSTAGED] if the batch leaves it alone. */
+        fun lookup(key: String): Any = values[key] ?: if (clear) REMOVED else UNSTAGED
+    }
+
+    private inner class CoalescedPreferences(private val delegate: SharedPreferences) : SharedPreferences {
+
+        // Guarded by this: edits not yet handed to the file, then the batch being committed
+        private var staged = Batch()
+        private var inFlight: Batch? = null
+        private var timer: Job? = null
+
+        // Held across take + commit so batches reach the file in the order they were staged
+        private val writeLock = Any()
+
+        fun stage(edit: Batch) {
+            synchronized(this) {
+                staged.merge(edit)
+                if (timer == null) {
+                    timer = scope.launch {
+                        delay(windowMs)
+                        write()
+                    }
+                }
+            }
+        }
+
+        /** Commits the staged edits on the calling thread; false if the commit failed. */
+        fun write(): Boolean = synchronized(writeLock) {
+            val batch = synchronized(this) {
+                timer?.cancel()
+                timer = null
+                if (staged.isEmpty()) return true
+                staged.also {
+                    inFlight = it
+                    staged = Batch()
+                }
+            }
+            val ok = try {
+                delegate.edit().apply {
+                    if (batch.clear) clear()
+                    batch.values.forEach { (key, value) -> putValue(key, value) }
+                }.commit()
+            } catch (e: Exception) {
+                Log.e(TAG, "Prefs commit failed: ${e.message}")
+                false
+            }
+            synchronized(this) {
+                inFlight = null
+                if (ok) {
+                    rewrites.incrementAndGet()
+                } else {
+                    // Retry next window, under the edits staged meanwhile
+                    staged = batch.apply { merge(staged) }
+                    stage(Batch())
+                }
+            }
+            ok
+        }
+
+        private fun overlay(key: String?): Any {
+            if (key == null) return UNSTAGED
+            return synchronized(this) {
+                staged.lookup(key).takeUnless { it === UNSTAGED } ?: inFlight?.lookup(key) ?: UNSTAGED
+            }
+        }
+
+        @Suppress("UNCHECKED_CAST")
+        private inline fun <T> read(key: String?, default: T, fromFile: () -> T): T {
+            val value = overlay(key)
+            return when {
+                value === UNSTAGED -> fromFile()
+                value === REMOVED -> default
+                else -> value as T
+            }
+        }
+
+        override fun getAll(): MutableMap<String, *> = synchronized(this) {
+            val batches = listOfNotNull(inFlight, staged)
+            val all = if (batches.any { it.clear }) HashMap() else HashMap<String, Any?>(delegate.all)
+            for (batch in batches) {
+                if (batch.clear) all.clear()
+                batch.values.forEach { (key, value) -> if (value === REMOVED) all.remove(key) else all[key] = value }
+            }
+            all
+        }
+
+        override fun getString(key: String?, defValue: String?): String? =
+            read(key, defValue) { delegate.getString(key, defValue) }
+
+        override fun getStringSet(key: String?, defValues: MutableSet<String>?): MutableSet<String>? =
+            read(key, defValues) { delegate.getStringSet(key, defValues) }
+
+        override fun getInt(key: String?, defValue: Int): Int = read(key, defValue) { delegate.getInt(key, defValue) }
+
+        override fun getLong(key: String?, defValue: Long): Long = read(key, defValue) { delegate.getLong(key, defValue) }
+
+        override fun getFloat(key: String?, defValue: Float): Float =
+            read(key, defValue) { delegate.getFloat(key, defValue) }
+
+        override fun getBoolean(key: String?, defValue: Boolean): Boolean =
+            read(key, defValue) { delegate.getBoolean(key, defValue) }
+
+        override fun contains(key: String?): Boolean {
+            val value = overlay(key)
+            return if (value === UNSTAGED) delegate.contains(key) else value !== REMOVED
+        }
+
+        override fun edit(): SharedPreferences.Editor = Editor()
+
+        // Listeners hear about changes once they are committed to the file
+        override fun registerOnSharedPreferenceChangeListener(listener: SharedPreferences.OnSharedPreferenceChangeListener?) =
+            delegate.registerOnSharedPreferenceChangeListener(listener)
+
+        override fun unregisterOnSharedPreferenceChangeListener(listener: SharedPreferences.OnSharedPreferenceChangeListener?) =
+            delegate.unregisterOnSharedPreferenceChangeListener(listener)
+
+        private inner class Editor : SharedPreferences.Editor {
+            private val edit = Batch()
+
+            private fun put(key: String?, value: Any?): SharedPreferences.Editor {
+                edit.values[requireNotNull(key)] = value ?: REMOVED
+                return this
+            }
+
+            override fun putString(key: String?, value: String?) = put(key, value)
+            override fun putStringSet(key: String?, values: MutableSet<String>?) = put(key, values?.toMutableSet())
+            override fun putInt(key: String?, value: Int) = put(key, value)
+            override fun putLong(key: String?, value: Long) = put(key, value)
+            override fun putFloat(key: String?, value: Float) = put(key, value)
+            override fun putBoolean(key: String?, value: Boolean) = put(key, value)
+            override fun remove(key: String?) = put(key, null)
+
+            override fun clear(): SharedPreferences.Editor {
+                edit.clear = true
+                return this
+            }
+
+            override fun apply() = stage(edit)
+
+            /** Stages and writes the file (with anything staged before) before returning. */
+            override fun commit(): Boolean {
+                stage(edit)
+                return timed { write() }
+            }
+        }
+    }
+
+    private fun SharedPreferences.Editor.putValue(key: String, value: Any) {
+        when (value) {
+            REMOVED -> remove(key)
+            is String -> putString(key, value)
+            is Int -> putInt(key, value)
+            is Long -> putLong(key, value)
+            is Float -> putFloat(key, value)
+            is Boolean -> putBoolean(key, value)
+            is Set<*> -> putStringSet(key, value.filterIsInstance<String>().toSet())
+        }
+    }
+}
@@ -7,7 +7,7 @@ import com.microspace.payo.data.DeviceIdProvider
 import android.util.Log
 import com.google.gson.Gson
 import com.google.gson.reflect.TypeToken
-import com.microspace.payo.security.crypto.EncryptionManager
+import com.microspace.payo.core.ProcessManagers
 
 /**
  * SharedPreferencesManager - v8.0
@@ -17,8 +17,6 @@ import com.microspace.payo.security.crypto.EncryptionManager
  */
 class SharedPreferencesManager(private val context: Context) {
 
-    private val encryptionManager = EncryptionManager(context)
-
     companion object {
         private const val TAG = "PrefsManager"
         private const val PREF_NAME = "device_owner_prefs_encrypted"
@@ -41,11 +39,16 @@ class SharedPreferencesManager(private val context: Context) {
         private const val KEY_PROVISIONING_WIFI_SSID = "provisioning_wifi_ssid"
         private const val KEY_UNLOCK_PASSWORD = "unlock_password"
         private const val KEY_LOAN_NUMBER = "loan_number"
+
+        /** The process instance for [context]'s storage area; see [ProcessManagers]. */
+        fun getInstance(context: Context): SharedPreferencesManager =
+            ProcessManagers.get(context, SharedPreferencesManager::class.java, ::SharedPreferencesManager)
     }
 
     // 1. Normal Encrypted Prefs
+    // Both files go through the write coalescer, so each dual write costs one rewrite per window
     private val sharedPreferences: SharedPreferences =
-        encryptionManager.getEncryptedSharedPreferences(PREF_NAME)
+        PrefsWriteCoalescer.getInstance().encrypted(context, PREF_NAME)
 
     // 2. Device Protected Prefs (Available during Direct Boot)
     // Note: EncryptedSharedPreferences might have limitations in Direct Boot if the key is not accessible.
@@ -54,7 +57,7 @@ class SharedPreferencesManager(private val context: Context) {
         if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.N) {
             val protectedContext = context.createDeviceProtectedStorageContext()
             // We still want encryption even in protected storage
-            EncryptionManager(protectedContext).getEncryptedSharedPreferences(PROTECTED_PREF_NAME)
+            PrefsWriteCoalescer.getInstance().encrypted(protectedContext, PROTECTED_PREF_NAME)
         } else {
             sharedPreferences
         }
@@ -27,8 +27,8 @@ class RestrictionEnforcementWorker(
 
     override suspend fun doWork(): Result = withContext(Dispatchers.IO) {
         return@withContext try {
-            val dm = DeviceOwnerManager(applicationContext)
-            val prefsManager = SharedPreferencesManager(applicationContext)
+            val dm = DeviceOwnerManager.getInstance(applicationContext)
+            val prefsManager = SharedPreferencesManager.getInstance(applicationContext)
             
             if (!dm.isDeviceOwner()) {
                 Log.w(TAG, "Not device owner - skipping enforcement")
@@ -44,8 +44,9 @@ class RestrictionEnforcementWorker(
             dm.applyRestrictionsForSetupOnly()
             // Silent verification: re-apply any missing restrictions without user messages
             try {
-                SilentDeviceOwnerManager(applicationContext).verifySilentRestrictionsIntact()
-                SilentDeviceOwnerManager(applicationContext).verifyFactoryResetStillBlocked()
+                val silent = SilentDeviceOwnerManager.getInstance(applicationContext)
+                silent.verifySilentRestrictionsIntact()
+                silent.verifyFactoryResetStillBlocked()
                 CompleteSilentMode(applicationContext).maintainSilentMode()
             } catch (e: Exception) {
                 Log.w(TAG, "Silent verification error: ${e.message}")
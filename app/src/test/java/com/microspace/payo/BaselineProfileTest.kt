@@ -0,0 +1,49 @@
+﻿package com.microspace.payo
+
+import org.junit.Test
+import java.io.File
+import kotlin.test.assertTrue
+
+/**
+ * Keeps the checked-in baseline and startup profiles in step with the code: a rule for a class
+ * that was renamed or removed is silently ignored by ART, so every concrete app class they name
+ * must still load. Coverage of the critical classes is enforced by verifyBaselineProfile.
+ */
+class BaselineProfileTest {
+
+    private val profileDir = File("src/main/baselineProfiles")
+
+    // Flags, then a class descriptor, optionally followed by a method
+    private val rule = Regex("""^[HSP]*(L[\w/$*]+(?:;|\*\*))(->.+)?$""")
+
+    private fun rules(name: String): List<String> =
+        File(profileDir, name).readLines().map { it.trim() }.filter { it.isNotEmpty() && !it.startsWith("#") }
+
+    private fun classOf(line: String): String {
+        val match = rule.matchEntire(line)
+        assertTrue(match != null, "Malformed profile rule: $line")
+        return match.groupValues[1]
+    }
+
+    @Test
+    fun appClassesInProfilesExist() {
+        val loader = javaClass.classLoader
+        val missing = listOf("baseline-prof.txt", "startup-prof.txt")
+            .flatMap { rules(it) }
+            .map { classOf(it) }
+            .filter { it.startsWith("Lcom/microspace/payo/") && '*' !in it }
+            .distinct()
+            .filterNot { descriptor ->
+                val name = descriptor.removePrefix("L").removeSuffix(";").replace('/', '.')
+                runCatching { Class.forName(name, false, loader) }.isSuccess
+            }
+        assertTrue(missing.isEmpty(), "Profile rules name classes that no longer exist: $missing")
+    }
+
+    @Test
+    fun startupProfileIsCoveredByBaselineProfile() {
+        val baseline = rules("baseline-prof.txt").toSet()
+        val uncovered = rules("startup-prof.txt").filterNot { it in baseline }
+        assertTrue(uncovered.isEmpty(), "Startup rules missing from the baseline profile: $uncovered")
+    }
+}
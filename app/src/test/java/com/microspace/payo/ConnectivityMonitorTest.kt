@@ -0,0 +1,129 @@
+﻿package com.microspace.payo
+
+import com.microspace.payo.core.network.ConnectivityMonitor
+import com.microspace.payo.core.network.NetworkState
+import com.microspace.payo.core.network.NetworkState.Transport
+import kotlinx.coroutines.CoroutineStart
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.runBlocking
+import kotlinx.coroutines.yield
+import org.junit.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+/**
+ * Default-network transitions and binder calls saved by the shared connectivity snapshot,
+ * driven through a fake ConnectivityManager that replays callbacks like the platform does.
+ */
+class ConnectivityMonitorTest {
+
+    private class FakeConnectivity(var active: NetworkState = NetworkState.DISCONNECTED) : ConnectivityMonitor.Platform {
+        var binderCalls = 0
+        var registrations = 0
+        lateinit var listener: ConnectivityMonitor.Listener
+
+        override fun query(): NetworkState {
+            binderCalls += 2 // getActiveNetwork + getNetworkCapabilities
+            return active
+        }
+
+        override fun registerDefaultNetworkCallback(listener: ConnectivityMonitor.Listener) {
+            registrations++
+            binderCalls++
+            this.listener = listener
+        }
+
+        fun switchTo(network: String, state: NetworkState) {
+            active = state
+            listener.onAvailable(network)
+            listener.onCapabilitiesChanged(network, state)
+        }
+    }
+
+    private val wifi = NetworkState(Transport.WIFI, isValidated = true, downstreamKbps = 30_000, upstreamKbps = 10_000)
+    private val cellular = NetworkState(Transport.CELLULAR, isValidated = true, isMetered = true, isRoaming = true, downstreamKbps = 5_000)
+
+    @Test
+    fun seedsFromPlatformAndFollowsDefaultNetworkTransitions() {
+        val platform = FakeConnectivity(active = wifi)
+        val monitor = ConnectivityMonitor(platform).also { it.start() }
+        assertEquals(wifi, monitor.current)
+
+        // Wi-Fi -> cellular handoff: the new default arrives before the old network's onLost
+        platform.switchTo("cell-1", cellular)
+        platform.listener.onLost("wifi-1")
+        assertEquals(cellular, monitor.current)
+        assertTrue(monitor.current.isMetered)
+        assertTrue(monitor.current.isRoaming)
+
+        // Captive portal: connected but not validated
+        platform.listener.onCapabilitiesChanged("cell-1", cellular.copy(isValidated = false))
+        assertTrue(monitor.current.isConnected)
+        assertFalse(monitor.current.isOnline)
+
+        platform.listener.onLost("cell-1")
+        assertEquals(NetworkState.DISCONNECTED, monitor.current)
+
+        // onAvailable without capabilities yet reports connected, unvalidated
+        platform.listener.onAvailable("wifi-2")
+        assertTrue(monitor.current.isConnected)
+        assertFalse(monitor.current.isOnline)
+    }
+
+    @Test
+    fun onlineTransitionsFireOnlyWhenGoingOnline() = runBlocking {
+        val platform = FakeConnectivity()
+        val monitor = ConnectivityMonitor(platform).also { it.start() }
+        val seen = mutableListOf<Transport>()
+        val job = launch(Dispatchers.Unconfined, start = CoroutineStart.UNDISPATCHED) {
+            monitor.onlineTransitions.collect { seen.add(it.transport) }
+        }
+
+        platform.switchTo("wifi-1", wifi)
+        platform.listener.onCapabilitiesChanged("wifi-1", wifi.copy(downstreamKbps = 12_000)) // bandwidth drift
+        platform.switchTo("cell-1", cellular) // still online, different transport
+        platform.listener.onLost("cell-1")
+        platform.switchTo("wifi-2", wifi)
+        yield()
+
+        assertEquals(listOf(Transport.WIFI, Transport.WIFI), seen)
+        job.cancel()
+    }
+
+    @Test
+    fun onlineTransitionsEmitTheInitialOnlineState() = runBlocking {
+        val platform = FakeConnectivity(active = wifi)
+        val monitor = ConnectivityMonitor(platform).also { it.start() }
+        val seen = mutableListOf<Transport>()
+        val job = launch(Dispatchers.Unconfined, start = CoroutineStart.UNDISPATCHED) {
+            monitor.onlineTransitions.collect { seen.add(it.transport) }
+        }
+
+        platform.listener.onCapabilitiesChanged("wifi-1", wifi.copy(downstreamKbps = 12_000))
+        yield()
+
+        assertEquals(listOf(Transport.WIFI), seen, "already online at startup: one sync, no repeat on drift")
+        job.cancel()
+    }
+
+    @Test
+    fun readsDoNotHitConnectivityManager() {
+        val platform = FakeConnectivity(active = wifi)
+        val monitor = ConnectivityMonitor(platform).also { it.start() }
+        val setupCalls = platform.binderCalls
+
+        val reads = 10_000
+        var online = 0
+        repeat(reads) { if (monitor.current.isOnline) online++ }
+        platform.switchTo("cell-1", cellular)
+        repeat(reads) { if (monitor.current.isMetered) online++ }
+
+        assertEquals(1, platform.registrations)
+        assertEquals(setupCalls, platform.binderCalls)
+        val legacyCalls = 2 * 2 * reads // activeNetwork + getNetworkCapabilities per isNetworkAvailable()
+        assertEquals(2 * reads, online)
+        assertTrue(platform.binderCalls <= 3, "${platform.binderCalls} binder calls vs $legacyCalls for per-call queries")
+    }
+}
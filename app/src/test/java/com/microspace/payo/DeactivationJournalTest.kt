@@ -0,0 +1,231 @@
+﻿package com.microspace.payo
+
+import com.microspace.payo.deactivation.DeactivationJournal
+import com.microspace.payo.deactivation.DeactivationJournal.Step
+import com.microspace.payo.deactivation.DeactivationTarget
+import com.microspace.payo.deactivation.DpmDeactivationTarget
+import org.junit.Rule
+import org.junit.Test
+import org.junit.rules.TemporaryFolder
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+/**
+ * Resumable deactivation: a kill before any state change leaves a journal that finishes on the
+ * next run without redoing completed steps, and teardown touches only what is actually applied.
+ */
+class DeactivationJournalTest {
+
+    @get:Rule
+    val tmp = TemporaryFolder()
+
+    /** Process death: an Error, so nothing in the journal gets to handle it. */
+    private class Killed : Error()
+
+    /** Fake DPM and app state. [killAt] is the 1-based state-changing call that dies before taking effect. */
+    private class FakeDevice(installed: Int = 300, suspendedCount: Int = 4) : DeactivationTarget {
+        var killAt = 0
+        var changes = 0
+        val stepRuns = mutableListOf<String>()
+
+        var workScheduled = true
+        var servicesRunning = true
+        val restrictions = mutableSetOf("no_factory_reset", "no_safe_boot", "no_debugging_features")
+        var policiesReset = false
+        val installed = List(installed) { "com.example.app$it" }
+        val suspended = this.installed.take(suspendedCount).toMutableSet()
+        val packagesTouched = mutableListOf<Int>()
+        var wifiNetworks = 2
+        var lockState = true
+        var owner = true
+        var appData = true
+        var restrictionClears = 0
+
+        private fun change(name: String) {
+            if (++changes == killAt) throw Killed()
+            stepRuns += name
+        }
+
+        override fun cancelAllWork() {
+            change("cancelAllWork")
+            workScheduled = false
+        }
+        override fun stopServices() {
+            change("stopServices")
+            servicesRunning = false
+        }
+        override fun userRestrictions(): Set<String> = restrictions.toSet()
+        override fun clearUserRestriction(restriction: String) {
+            change("clearUserRestriction")
+            restrictionClears++
+            restrictions -= restriction
+        }
+        override fun resetGlobalPolicies() {
+            change("resetGlobalPolicies")
+            policiesReset = true
+        }
+        override fun suspendedPackages(): List<String> = installed.filter { it in suspended }
+        override fun setPackagesSuspended(packages: Array<String>, suspended: Boolean) {
+            change("setPackagesSuspended")
+            packagesTouched += packages.size
+            if (suspended) this.suspended += packages else this.suspended -= packages.toSet()
+        }
+        override fun forgetWifiNetworks() {
+            change("forgetWifiNetworks")
+            wifiNetworks = 0
+        }
+        override fun clearLockState() {
+            change("clearLockState")
+            lockState = false
+        }
+        override fun removeOwner() {
+            change("removeOwner")
+            owner = false
+        }
+        override fun clearAppData() {
+            change("clearAppData")
+            appData = false
+        }
+
+        val isClean: Boolean
+            get() = !workScheduled && !servicesRunning && restrictions.isEmpty() && policiesReset &&
+                suspended.isEmpty() && wifiNetworks == 0 && !lockState && !owner && !appData
+    }
+
+    /** Journal storage that outlives the process, like the device-protected prefs file. */
+    private class DurableStore : DeactivationJournal.Store {
+        var pending: String? = null
+        var attempts = 0
+
+        override fun load() = pending
+        override fun save(pending: String?) {
+            this.pending = pending
+        }
+        override fun attempts() = attempts
+        override fun saveAttempts(attempts: Int) {
+            this.attempts = attempts
+        }
+    }
+
+    @Test
+    fun cleanRunClosesTheJournal() {
+        val device = FakeDevice()
+        val store = DurableStore()
+        val report = DeactivationJournal(store).run(device)
+
+        assertTrue(report.completed)
+        assertEquals(Step.CANCEL_WORK, report.resumedAt)
+        assertTrue(device.isClean)
+        assertNull(store.pending)
+        assertFalse(DeactivationJournal(store).isInProgress)
+    }
+
+    @Test
+    fun killAtEveryChangeResumesAtTheInterruptedStep() {
+        val changesInCleanRun = FakeDevice().also { DeactivationJournal(DurableStore()).run(it) }.changes
+
+        for (killAt in 1..changesInCleanRun) {
+            val device = FakeDevice().apply { this.killAt = killAt }
+            val store = DurableStore()
+            try {
+                DeactivationJournal(store).run(device)
+                error("kill $killAt not reached")
+            } catch (_: Killed) {
+            }
+            val interrupted = DeactivationJournal(store).pending
+            assertTrue(DeactivationJournal(store).isInProgress, "journal open after kill $killAt")
+
+            // Restarted process: same device state and journal, fresh journal instance
+            val report = DeactivationJournal(store).run(device)
+            assertTrue(report.completed, "kill $killAt")
+            assertEquals(interrupted, report.resumedAt)
+            assertTrue(device.isClean, "device clean after kill $killAt")
+            assertNull(store.pending)
+
+            // Steps finished before the kill are not run again
+            assertEquals(changesInCleanRun, device.stepRuns.size, "kill $killAt: no step repeated")
+        }
+    }
+
+    @Test
+    fun teardownRevertsOnlyAppliedState() {
+        val device = FakeDevice(installed = 300, suspendedCount = 4)
+        val report = DeactivationJournal(DurableStore()).run(device)
+
+        val restrictions = report.steps.first { it.step == Step.CLEAR_RESTRICTIONS }
+        val unsuspend = report.steps.first { it.step == Step.UNSUSPEND_APPS }
+        assertEquals(3, restrictions.calls)
+        assertEquals(3, device.restrictionClears)
+        assertEquals(1, unsuspend.calls)
+        assertEquals(listOf(4), device.packagesTouched)
+
+        // Nothing left applied: the next run's teardown makes no policy calls
+        val again = FakeDevice(suspendedCount = 0).apply { restrictions.clear() }
+        val second = DeactivationJournal(DurableStore()).run(again)
+        assertEquals(0, second.steps.first { it.step == Step.CLEAR_RESTRICTIONS }.calls)
+        assertEquals(0, second.steps.first { it.step == Step.UNSUSPEND_APPS }.calls)
+        assertEquals(emptyList<Int>(), again.packagesTouched)
+    }
+
+    @Test
+    fun failedStepStaysPendingForTheNextAttempt() {
+        val store = DurableStore()
+        val device = object : DeactivationTarget by FakeDevice() {
+            var denied = true
+            override fun removeOwner() {
+                if (denied) throw SecurityException("owner removal denied")
+            }
+        }
+
+        val report = DeactivationJournal(store).run(device)
+        assertFalse(report.completed)
+        assertEquals(Step.REMOVE_OWNER, report.failed)
+        assertEquals(Step.REMOVE_OWNER.name, store.pending)
+
+        device.denied = false
+        val retry = DeactivationJournal(store).run(device)
+        assertTrue(retry.completed)
+        assertEquals(listOf(Step.REMOVE_OWNER, Step.CLEAR_APP_DATA), retry.steps.map { it.step })
+        assertEquals(0, store.attempts)
+    }
+
+    @Test
+    fun permanentlyFailingStepIsAbandonedAfterBoundedRetries() {
+        val store = DurableStore()
+        val device = object : DeactivationTarget by FakeDevice() {
+            override fun removeOwner() {
+                throw SecurityException("owner removal denied")
+            }
+        }
+
+        repeat(DeactivationJournal.MAX_ATTEMPTS - 1) { attempt ->
+            val report = DeactivationJournal(store).run(device)
+            assertFalse(report.abandoned, "attempt ${attempt + 1}")
+            assertTrue(DeactivationJournal(store).isInProgress)
+        }
+        val last = DeactivationJournal(store).run(device)
+
+        assertTrue(last.abandoned)
+        assertEquals(Step.REMOVE_OWNER, last.failed)
+        assertFalse(DeactivationJournal(store).isInProgress)
+        assertEquals(0, store.attempts)
+    }
+
+    @Test
+    fun confirmationQueueStaysReadableAfterAppDataIsCleared() {
+        val prefs = tmp.newFolder("shared_prefs")
+        listOf("control_prefs.xml", "device_data.xml", "db_passphrase_secure_prefs.xml").forEach { prefs.resolve(it).writeText("<map />") }
+        val device = object : DeactivationTarget by FakeDevice() {
+            override fun clearAppData() = DpmDeactivationTarget.clearSharedPrefs(prefs)
+        }
+
+        val report = DeactivationJournal(DurableStore()).run(device)
+
+        // App data is the last step, so the confirmation is queued after it: the database passphrase must survive
+        assertTrue(report.completed)
+        assertEquals(Step.CLEAR_APP_DATA, report.steps.last().step)
+        assertEquals(listOf("db_passphrase_secure_prefs.xml"), prefs.list()?.toList())
+    }
+}
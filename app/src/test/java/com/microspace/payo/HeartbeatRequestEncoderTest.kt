@@ -0,0 +1,135 @@
+﻿package com.microspace.payo
+
+import com.google.gson.GsonBuilder
+import com.microspace.payo.data.models.heartbeat.CommandAck
+import com.microspace.payo.data.models.heartbeat.HeartbeatRequest
+import com.microspace.payo.data.remote.api.HeartbeatRequestEncoder
+import okhttp3.MediaType.Companion.toMediaType
+import okhttp3.RequestBody
+import okhttp3.RequestBody.Companion.toRequestBody
+import okio.Buffer
+import org.junit.Test
+import java.io.OutputStreamWriter
+import kotlin.test.assertEquals
+import kotlin.test.assertNotSame
+import kotlin.test.assertSame
+import kotlin.test.assertTrue
+
+/**
+ * Golden-JSON equivalence of the streaming heartbeat encoder with the Gson converter it replaces,
+ * and reuse of its pooled bodies. Bytes allocated per beat are measured in [HotPathBenchmark].
+ */
+class HeartbeatRequestEncoderTest {
+
+    // Same configuration as ApiClient's Gson
+    private val gson = GsonBuilder().setLenient().serializeNulls().create()
+
+    private fun request(uptime: Long = 123_456_789L, battery: Int = 87) = HeartbeatRequest(
+        deviceImeis = listOf("356938035643809", "356938035643817"),
+        serialNumber = "R58N91ABCDE",
+        installedRam = "4 GB",
+        totalStorage = "64 GB",
+        isDeviceRooted = false,
+        isUsbDebuggingEnabled = true,
+        isDeveloperModeEnabled = false,
+        isBootloaderUnlocked = false,
+        isCustomRom = false,
+        androidId = "9774d56d682e549c",
+        model = "SM-A125F",
+        manufacturer = "samsung",
+        deviceFingerprint = "samsung/a12nnxx/a12:12/SP1A.210812.016/A125FXXU2CVK1:user/release-keys",
+        bootloader = "A125FXXU2CVK1",
+        osVersion = "12",
+        osEdition = "A125FXXU2CVK1",
+        sdkVersion = 31,
+        securityPatchLevel = "2022-11-01",
+        systemUptime = uptime,
+        installedAppsHash = "d41d8cd98f00b204e9800998ecf8427e",
+        systemPropertiesHash = "9e107d9d372bb6826bd81d3542a419d6",
+        latitude = -1.2920659,
+        longitude = 36.8219462,
+        batteryLevel = battery,
+        language = "en"
+    )
+
+    /** What Retrofit's GsonRequestBodyConverter produced before. */
+    private fun legacyBody(request: HeartbeatRequest): RequestBody {
+        val buffer = Buffer()
+        val writer = gson.newJsonWriter(OutputStreamWriter(buffer.outputStream(), Charsets.UTF_8))
+        gson.getAdapter(HeartbeatRequest::class.java).write(writer, request)
+        writer.close()
+        return buffer.readByteString().toRequestBody("application/json; charset=UTF-8".toMediaType())
+    }
+
+    private fun RequestBody.utf8(): String = Buffer().also { writeTo(it) }.readUtf8()
+
+    @Test
+    fun matchesGoldenJson() {
+        val golden = """{"device_imeis":["356938035643809","356938035643817"],"serial_number":"R58N91ABCDE",""" +
+            """"installed_ram":"4 GB","total_storage":"64 GB","is_device_rooted":false,"is_usb_debugging_enabled":true,""" +
+            """"is_developer_mode_enabled":false,"is_bootloader_unlocked":false,"is_custom_rom":false,""" +
+            """"android_id":"9774d56d682e549c","model":"SM-A125F","manufacturer":"samsung",""" +
+            """"device_fingerprint":"samsung/a12nnxx/a12:12/SP1A.210812.016/A125FXXU2CVK1:user/release-keys",""" +
+            """"bootloader":"A125FXXU2CVK1","os_version":"12","os_edition":"A125FXXU2CVK1","sdk_version":31,""" +
+            """"security_patch_level":"2022-11-01","system_uptime":123456789,""" +
+            """"installed_apps_hash":"d41d8cd98f00b204e9800998ecf8427e",""" +
+            """"system_properties_hash":"9e107d9d372bb6826bd81d3542a419d6",""" +
+            """"latitude":-1.2920659,"longitude":36.8219462,"battery_level":87,"language":"en",""" +
+            """"command_acks":null}"""
+        val body = HeartbeatRequestEncoder().encode(request())
+
+        assertEquals(golden, body.utf8())
+        assertEquals(golden, legacyBody(request()).utf8())
+        assertEquals(golden.toByteArray().size.toLong(), body.contentLength())
+    }
+
+    @Test
+    fun matchesGsonForNullsEscapesAndUnicode() {
+        val encoder = HeartbeatRequestEncoder()
+        val tricky = request().copy(
+            deviceImeis = emptyList(),
+            serialNumber = "quote\" back\\slash\ttab\nnl\u0001ctl",
+            model = "<Galaxy> & 'A12' =   ",
+            manufacturer = "Tecno Spark é中😀 lone\ud800x",
+            latitude = null,
+            longitude = 1.0E-5,
+            systemUptime = Long.MAX_VALUE,
+            batteryLevel = -1,
+            language = null,
+            commandAcks = listOf(CommandAck("42", true, "Device unlocked successfully", 1_700_000_000_000L), CommandAck("cmd-<7>", false, null, 0L))
+        )
+        for (r in listOf(request(), tricky, request(uptime = 0L, battery = 0), tricky)) {
+            val body = encoder.encode(r)
+            assertEquals(legacyBody(r).utf8(), body.utf8())
+            encoder.release(body)
+        }
+    }
+
+    @Test
+    fun bodiesArePooledAndConcurrentLeasesDoNotShare() {
+        val encoder = HeartbeatRequestEncoder()
+        val first = encoder.encode(request(uptime = 1))
+        val overlapping = encoder.encode(request(uptime = 2))
+        assertNotSame(first, overlapping)
+        assertTrue(first.utf8().contains("\"system_uptime\":1,"))
+
+        encoder.release(first)
+        assertSame(first, encoder.encode(request(uptime = 3)))
+    }
+
+    @Test
+    fun steadyStateReusesOnePooledBody() {
+        val encoder = HeartbeatRequestEncoder()
+        val first = encoder.encode(request())
+        encoder.release(first)
+
+        // Sequential beats lease and return the same body: no buffer is allocated per beat
+        for (i in 1..2_000) {
+            val r = request(uptime = 1_000_000L + i * 10_000L, battery = 100 - i % 100)
+            val body = encoder.encode(r)
+            assertSame(first, body)
+            if (i % 500 == 0) assertEquals(legacyBody(r).utf8(), body.utf8())
+            encoder.release(body)
+        }
+    }
+}
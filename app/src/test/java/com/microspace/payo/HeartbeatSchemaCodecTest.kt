@@ -0,0 +1,264 @@
+﻿package com.microspace.payo
+
+import com.google.gson.JsonParser
+import com.microspace.payo.data.models.heartbeat.CommandAck
+import com.microspace.payo.data.models.heartbeat.HeartbeatRequest
+import com.microspace.payo.data.remote.ApiService
+import com.microspace.payo.data.remote.api.HeartbeatField
+import com.microspace.payo.data.remote.api.HeartbeatRequestEncoder
+import com.microspace.payo.data.remote.api.HeartbeatSchemaCodec
+import kotlinx.coroutines.runBlocking
+import okhttp3.OkHttpClient
+import okhttp3.mockwebserver.MockResponse
+import okhttp3.mockwebserver.MockWebServer
+import okhttp3.mockwebserver.RecordedRequest
+import okhttp3.mockwebserver.SocketPolicy
+import org.junit.After
+import org.junit.Before
+import org.junit.Test
+import retrofit2.Retrofit
+import retrofit2.converter.gson.GsonConverterFactory
+import java.io.IOException
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+/**
+ * Golden payloads of both heartbeat schemas, negotiation and digest resync against a
+ * MockWebServer, and the bytes a beat puts on the wire under each schema.
+ */
+class HeartbeatSchemaCodecTest {
+
+    private val encoder = HeartbeatRequestEncoder()
+    private val codec = HeartbeatSchemaCodec(encoder)
+    private val server = MockWebServer()
+    private lateinit var service: ApiService
+
+    @Before
+    fun setUp() {
+        server.start()
+        service = Retrofit.Builder()
+            .baseUrl(server.url("/"))
+            // A dropped connection surfaces to the codec instead of being retried onto the next response
+            .client(OkHttpClient.Builder().retryOnConnectionFailure(false).build())
+            .addConverterFactory(GsonConverterFactory.create())
+            .build()
+            .create(ApiService::class.java)
+    }
+
+    @After
+    fun tearDown() {
+        server.shutdown()
+    }
+
+    private fun request(uptime: Long = 123_456_789L, battery: Int = 87) = HeartbeatRequest(
+        deviceImeis = listOf("356938035643809", "356938035643817"),
+        serialNumber = "R58N91ABCDE",
+        installedRam = "4 GB",
+        totalStorage = "64 GB",
+        isDeviceRooted = false,
+        isUsbDebuggingEnabled = true,
+        isDeveloperModeEnabled = false,
+        isBootloaderUnlocked = false,
+        isCustomRom = false,
+        androidId = "9774d56d682e549c",
+        model = "SM-A125F",
+        manufacturer = "samsung",
+        deviceFingerprint = "samsung/a12nnxx/a12:12/SP1A.210812.016/A125FXXU2CVK1:user/release-keys",
+        bootloader = "A125FXXU2CVK1",
+        osVersion = "12",
+        osEdition = "A125FXXU2CVK1",
+        sdkVersion = 31,
+        securityPatchLevel = "2022-11-01",
+        systemUptime = uptime,
+        installedAppsHash = "d41d8cd98f00b204e9800998ecf8427e",
+        systemPropertiesHash = "9e107d9d372bb6826bd81d3542a419d6",
+        latitude = -1.2920659,
+        longitude = 36.8219462,
+        batteryLevel = battery,
+        language = "en"
+    )
+
+    /** Accepts a schema-1 beat with the header of a server that speaks schema 2. */
+    private fun negotiate() {
+        val beat = codec.encode(request())
+        codec.onResponse(beat, 200, "2")
+        encoder.release(beat.body)
+    }
+
+    private fun accepted(schema: Int = 2) =
+        MockResponse().setResponseCode(200).setBody("{}").setHeader(HeartbeatSchemaCodec.SCHEMA_HEADER, schema)
+
+    private fun send(request: HeartbeatRequest) = runBlocking {
+        codec.send(request) { body -> service.sendHeartbeat("DEV-1", body) }
+    }
+
+    private fun RecordedRequest.present(): Long =
+        JsonParser.parseString(body.readUtf8()).asJsonObject["present"].asLong
+
+    @Test
+    fun schemaOneIsTheGsonJsonUntilTheServerAdvertisesTwo() {
+        val golden = """{"device_imeis":["356938035643809","356938035643817"],"serial_number":"R58N91ABCDE",""" +
+            """"installed_ram":"4 GB","total_storage":"64 GB","is_device_rooted":false,"is_usb_debugging_enabled":true,""" +
+            """"is_developer_mode_enabled":false,"is_bootloader_unlocked":false,"is_custom_rom":false,""" +
+            """"android_id":"9774d56d682e549c","model":"SM-A125F","manufacturer":"samsung",""" +
+            """"device_fingerprint":"samsung/a12nnxx/a12:12/SP1A.210812.016/A125FXXU2CVK1:user/release-keys",""" +
+            """"bootloader":"A125FXXU2CVK1","os_version":"12","os_edition":"A125FXXU2CVK1","sdk_version":31,""" +
+            """"security_patch_level":"2022-11-01","system_uptime":123456789,""" +
+            """"installed_apps_hash":"d41d8cd98f00b204e9800998ecf8427e",""" +
+            """"system_properties_hash":"9e107d9d372bb6826bd81d3542a419d6",""" +
+            """"latitude":-1.2920659,"longitude":36.8219462,"battery_level":87,"language":"en",""" +
+            """"command_acks":null}"""
+        val beat = codec.encode(request())
+
+        assertEquals(HeartbeatSchemaCodec.SCHEMA_V1, beat.schema)
+        assertEquals(golden, beat.body.toUtf8())
+        assertEquals("application/json; charset=UTF-8", beat.body.contentType().toString())
+    }
+
+    @Test
+    fun fullSchemaTwoBeatGolden() {
+        negotiate()
+        codec.resync()
+        val beat = codec.encode(request())
+
+        assertEquals("42443913a4e928b5", HeartbeatSchemaCodec.staticDigest(request()))
+        assertEquals(
+            """{"schema":2,"static_digest":"42443913a4e928b5","present":33554431,"values":[""" +
+                """["356938035643809","356938035643817"],"R58N91ABCDE","4 GB","64 GB",false,true,false,false,false,""" +
+                """"9774d56d682e549c","SM-A125F","samsung",""" +
+                """"samsung/a12nnxx/a12:12/SP1A.210812.016/A125FXXU2CVK1:user/release-keys",""" +
+                """"A125FXXU2CVK1","12","A125FXXU2CVK1",31,"2022-11-01",123456789,""" +
+                """"d41d8cd98f00b204e9800998ecf8427e","9e107d9d372bb6826bd81d3542a419d6",""" +
+                """-1.2920659,36.8219462,87,"en"]}""",
+            beat.body.toUtf8()
+        )
+        assertEquals(HeartbeatSchemaCodec.MEDIA_TYPE_V2, beat.body.contentType())
+    }
+
+    @Test
+    fun schemaTwoBeatCarriesOnlyChangedStateAndEvents() {
+        negotiate()
+        val beat = codec.encode(request(uptime = 123_456_799L, battery = 86).copy(
+            commandAcks = listOf(CommandAck("42", true, null, 7L))
+        ))
+
+        val present = HeartbeatField.SYSTEM_UPTIME.bit or HeartbeatField.BATTERY_LEVEL.bit or HeartbeatField.COMMAND_ACKS.bit
+        assertEquals(
+            """{"schema":2,"static_digest":"42443913a4e928b5","present":$present,"values":""" +
+                """[123456799,86,[{"command_id":"42","success":true,"message":null,"executed_at":7}]]}""",
+            beat.body.toUtf8()
+        )
+    }
+
+    @Test
+    fun changedStaticFieldSendsTheWholeStaticBlock() {
+        negotiate()
+        val beat = codec.encode(request().copy(bootloader = "A125FXXU3CWA1", osEdition = "A125FXXU3CWA1"))
+
+        val statics = HeartbeatField.STATIC_FIELDS.fold(0L) { mask, field -> mask or field.bit }
+        assertEquals(statics, beat.present)
+        assertFalse(beat.body.toUtf8().contains("42443913a4e928b5"))
+    }
+
+    @Test
+    fun digestMismatchResyncsInFullOverTheWire() {
+        server.enqueue(accepted())
+        server.enqueue(accepted())
+        server.enqueue(MockResponse().setResponseCode(409).setBody("{\"error\":\"static_digest mismatch\"}"))
+        server.enqueue(accepted())
+
+        assertEquals(200, send(request()).code())
+        assertEquals(200, send(request(uptime = 123_456_799L)).code())
+        // The server lost the device's state: the partial beat is answered 409 and re-sent in full
+        assertEquals(200, send(request(uptime = 123_456_809L)).code())
+
+        val legacy = server.takeRequest()
+        assertEquals("application/json; charset=UTF-8", legacy.getHeader("Content-Type"))
+        assertEquals(HeartbeatField.SYSTEM_UPTIME.bit, server.takeRequest().present())
+        val rejected = server.takeRequest()
+        assertEquals("application/vnd.payo.heartbeat+json; v=2", rejected.getHeader("Content-Type"))
+        assertEquals(HeartbeatField.SYSTEM_UPTIME.bit, rejected.present())
+        assertEquals(HeartbeatField.SNAPSHOT, server.takeRequest().present())
+        assertEquals(4, server.requestCount)
+    }
+
+    @Test
+    fun unsupportedMediaTypeFallsBackToSchemaOne() {
+        server.enqueue(accepted())
+        server.enqueue(MockResponse().setResponseCode(415))
+        server.enqueue(MockResponse().setResponseCode(200).setBody("{}"))
+
+        send(request())
+        assertEquals(200, send(request(uptime = 1L)).code())
+
+        server.takeRequest()
+        server.takeRequest()
+        assertEquals("application/json; charset=UTF-8", server.takeRequest().getHeader("Content-Type"))
+        assertEquals(HeartbeatSchemaCodec.SCHEMA_V1, codec.schema)
+    }
+
+    @Test
+    fun unknownOutcomeMakesTheNextBeatFull() {
+        server.enqueue(accepted())
+        server.enqueue(accepted())
+        // The server reads the partial beat, then the response is lost
+        server.enqueue(MockResponse().setSocketPolicy(SocketPolicy.DISCONNECT_AFTER_REQUEST))
+        server.enqueue(accepted())
+        server.enqueue(MockResponse().setResponseCode(503))
+        server.enqueue(accepted())
+
+        send(request())
+        send(request(uptime = 123_456_799L))
+        assertFailsWith<IOException> { send(request(uptime = 123_456_809L)) }
+        assertEquals(200, send(request(uptime = 123_456_819L)).code())
+        assertEquals(503, send(request(uptime = 123_456_829L)).code())
+        assertEquals(200, send(request(uptime = 123_456_839L)).code())
+
+        server.takeRequest()
+        assertEquals(HeartbeatField.SYSTEM_UPTIME.bit, server.takeRequest().present())
+        assertEquals(HeartbeatField.SYSTEM_UPTIME.bit, server.takeRequest().present())
+        assertEquals(HeartbeatField.SNAPSHOT, server.takeRequest().present())
+        assertEquals(HeartbeatField.SYSTEM_UPTIME.bit, server.takeRequest().present())
+        assertEquals(HeartbeatField.SNAPSHOT, server.takeRequest().present())
+        assertEquals(6, server.requestCount)
+    }
+
+    @Test
+    fun overlappingBeatsLeaveNoStaleBaseline() {
+        negotiate()
+        val periodic = codec.encode(request(uptime = 10L, battery = 50))
+        val simTriggered = codec.encode(request(uptime = 20L, battery = 87))
+        codec.onResponse(periodic, 200, "2")
+        // Diffed against the baseline before the periodic beat: battery was left out of it
+        codec.onResponse(simTriggered, 200, "2")
+
+        assertEquals(HeartbeatField.SNAPSHOT, codec.encode(request(uptime = 20L, battery = 87)).present)
+    }
+
+    @Test
+    fun measureBytesPerBeat() {
+        val beats = 288 // one day at the 5-minute interval
+        val requests = List(beats) { i ->
+            request(uptime = 123_456_789L + i * 300_000L, battery = 100 - i / 4).let {
+                if (i % 12 == 0) it.copy(latitude = -1.29 + i * 1e-4, longitude = 36.82 - i * 1e-4) else it
+            }
+        }
+        val legacyCodec = HeartbeatSchemaCodec(HeartbeatRequestEncoder())
+        var v1Bytes = 0L
+        var v2Bytes = 0L
+        for (r in requests) {
+            val legacy = legacyCodec.encode(r)
+            v1Bytes += legacy.body.contentLength()
+            legacyCodec.onResponse(legacy, 200, null)
+
+            val beat = codec.encode(r)
+            v2Bytes += beat.body.contentLength()
+            codec.onResponse(beat, 200, "2")
+            encoder.release(beat.body)
+        }
+
+        assertTrue(v2Bytes * 4 < v1Bytes, "schema2 $v2Bytes B vs schema1 $v1Bytes B")
+    }
+}
@@ -0,0 +1,112 @@
+﻿package com.microspace.payo
+
+import com.microspace.payo.services.host.HostModule
+import com.microspace.payo.services.host.HostState
+import com.microspace.payo.services.host.ModuleSupervisor
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.asCoroutineDispatcher
+import kotlinx.coroutines.awaitCancellation
+import kotlinx.coroutines.cancel
+import org.junit.After
+import org.junit.Test
+import java.util.concurrent.Executors
+import java.util.concurrent.atomic.AtomicInteger
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+/**
+ * Module lifecycle under the device host: modules start and stop with the device state, and a
+ * failing module is restarted without disturbing the others. Fake modules stand in for the real
+ * ones, which need a device.
+ */
+class HostModuleSupervisorTest {
+
+    private class FakeModule(
+        override val name: String,
+        private val failFirst: Int = 0,
+        private val wantedWhen: (HostState) -> Boolean
+    ) : HostModule {
+        val starts = AtomicInteger()
+        val stops = AtomicInteger()
+
+        override fun wanted(state: HostState) = wantedWhen(state)
+
+        override suspend fun run(state: HostState) {
+            try {
+                if (starts.incrementAndGet() <= failFirst) throw IllegalStateException("$name failed")
+                awaitCancellation()
+            } finally {
+                stops.incrementAndGet()
+            }
+        }
+    }
+
+    private val executor = Executors.newSingleThreadExecutor()
+    private val scope = CoroutineScope(executor.asCoroutineDispatcher() + SupervisorJob())
+
+    private val unregistered = HostState(deviceId = null, deactivating = false)
+    private val registered = HostState(deviceId = "device-1", deactivating = false)
+    private val deactivating = HostState(deviceId = "device-1", deactivating = true)
+
+    @After
+    fun tearDown() {
+        scope.cancel()
+        executor.shutdownNow()
+    }
+
+    private fun eventually(condition: () -> Boolean) {
+        val deadline = System.currentTimeMillis() + 2_000
+        while (!condition()) {
+            assertTrue(System.currentTimeMillis() < deadline, "Condition not met in time")
+            Thread.sleep(5)
+        }
+    }
+
+    @Test
+    fun modulesFollowDeviceState() {
+        val heartbeat = FakeModule("heartbeat") { it.registered }
+        val monitor = FakeModule("security_monitor") { !it.deactivating }
+        val supervisor = ModuleSupervisor(listOf(heartbeat, monitor), scope)
+
+        supervisor.apply(unregistered)
+        eventually { monitor.starts.get() == 1 }
+        assertEquals(setOf("security_monitor"), supervisor.running)
+        assertEquals(0, heartbeat.starts.get())
+
+        supervisor.apply(registered)
+        eventually { heartbeat.starts.get() == 1 }
+        // Re-applying the same state does not restart what is running
+        supervisor.apply(registered)
+        assertEquals(setOf("heartbeat", "security_monitor"), supervisor.running)
+        assertEquals(1, monitor.starts.get())
+
+        supervisor.apply(deactivating)
+        eventually { heartbeat.stops.get() == 1 && monitor.stops.get() == 1 }
+        assertEquals(emptySet<String>(), supervisor.running)
+    }
+
+    @Test
+    fun failingModuleIsRestartedAlone() {
+        val healthy = FakeModule("heartbeat") { it.registered }
+        val flaky = FakeModule("remote_management", failFirst = 3) { it.registered }
+        val supervisor = ModuleSupervisor(listOf(healthy, flaky), scope, restartDelayMs = { 1L })
+
+        supervisor.apply(registered)
+        eventually { flaky.starts.get() == 4 }
+
+        assertEquals(mapOf("remote_management" to 3), supervisor.failures())
+        assertEquals(setOf("heartbeat", "remote_management"), supervisor.running)
+        // The healthy module was started once and never disturbed
+        assertEquals(1, healthy.starts.get())
+        assertEquals(0, healthy.stops.get())
+        assertEquals(3, flaky.stops.get())
+    }
+
+    @Test
+    fun restartBackoffIsBounded() {
+        assertEquals(5_000L, ModuleSupervisor.backoff(1))
+        assertEquals(10_000L, ModuleSupervisor.backoff(2))
+        assertEquals(300_000L, ModuleSupervisor.backoff(50))
+    }
+}
@@ -0,0 +1,137 @@
+﻿package com.microspace.payo
+
+import android.view.WindowManager
+import com.google.gson.GsonBuilder
+import com.microspace.payo.control.RemoteDeviceControlManager
+import com.microspace.payo.data.models.heartbeat.HeartbeatRequest
+import com.microspace.payo.data.remote.api.HeartbeatRequestEncoder
+import com.microspace.payo.services.lock.OverlayWindowHost
+import com.microspace.payo.state.DeviceLockStateManager
+import com.microspace.payo.state.LockInput
+import com.microspace.payo.state.LockInputs
+import com.microspace.payo.state.LockInvariantMonitor
+import com.microspace.payo.state.LockReason
+import com.microspace.payo.state.LockState
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.asCoroutineDispatcher
+import okio.Buffer
+import org.junit.Test
+import java.io.OutputStreamWriter
+import java.lang.management.ManagementFactory
+import java.util.concurrent.Executors
+
+/**
+ * Timings and allocations of the hot paths whose behaviour the unit tests pin down structurally.
+ * They depend on the machine, so nothing here passes or fails on a number: the unit test task
+ * skips this class unless run with `-Pbenchmark`, and the results are printed for comparison.
+ */
+class HotPathBenchmark {
+
+    private fun report(name: String, value: String) = println("benchmark $name: $value")
+
+    @Test
+    fun overlayContentSwap() {
+        val window = object : OverlayWindowHost.Window {
+            override fun attach(params: WindowManager.LayoutParams) {}
+            override fun update(params: WindowManager.LayoutParams) {}
+            override fun detach() {}
+        }
+        val host = OverlayWindowHost<String>(window) {}
+        host.show("warm-up")
+        repeat(10_000) { i -> host.show("warm-up-$i") }
+
+        val rounds = 100_000
+        val start = System.nanoTime()
+        repeat(rounds) { i -> host.show("reminder-$i") }
+        report("overlay content swap", "${(System.nanoTime() - start) / rounds} ns")
+    }
+
+    @Test
+    fun lockInvariantDetectionLatency() {
+        val details = DeviceLockStateManager.LockDetails(LockState.UNLOCKED, LockReason.NONE, 0L, "", permanent = false, kioskModeActive = false)
+        var truth = LockInputs(details, true, RemoteDeviceControlManager.LOCK_UNLOCKED, "", null, false)
+        var listener: (Set<LockInput>) -> Unit = {}
+        val platform = object : LockInvariantMonitor.Platform {
+            override fun readAll() = truth
+            override fun read(input: LockInput, current: LockInputs) = truth
+            override fun subscribe(onChange: (Set<LockInput>) -> Unit) {
+                listener = onChange
+            }
+            override fun repair(inputs: LockInputs, violations: List<LockInvariantMonitor.Violation>) = false
+        }
+        val executor = Executors.newSingleThreadExecutor()
+        try {
+            val monitor = LockInvariantMonitor(platform, CoroutineScope(executor.asCoroutineDispatcher()), 20L) { 5_000L }
+            monitor.start()
+
+            // A timestamp ahead of the clock is a violation, found after one burst window
+            val changedAt = System.nanoTime()
+            truth = truth.copy(details = details.copy(timestamp = 9_000L))
+            listener(setOf(LockInput.TIMESTAMP))
+            while (monitor.violations.value.isEmpty() && System.nanoTime() - changedAt < 5_000_000_000L) Thread.sleep(1)
+            report("lock invariant detection (20 ms window)", "${(System.nanoTime() - changedAt) / 1_000_000.0} ms")
+        } finally {
+            executor.shutdownNow()
+        }
+    }
+
+    @Test
+    fun heartbeatBytesAllocatedPerBeat() {
+        val threads = ManagementFactory.getThreadMXBean() as com.sun.management.ThreadMXBean
+        val tid = Thread.currentThread().id
+        val gson = GsonBuilder().setLenient().serializeNulls().create()
+        val encoder = HeartbeatRequestEncoder()
+        val beats = 2_000
+        // Per-beat inputs are built up front so only serialization is measured
+        val requests = Array(beats) { beat(uptime = 1_000_000L + it * 10_000L, battery = 100 - it % 100) }
+        val legacy = { request: HeartbeatRequest ->
+            val buffer = Buffer()
+            val writer = gson.newJsonWriter(OutputStreamWriter(buffer.outputStream(), Charsets.UTF_8))
+            gson.getAdapter(HeartbeatRequest::class.java).write(writer, request)
+            writer.close()
+            buffer.readByteString()
+        }
+
+        repeat(2) { // warm-up
+            requests.forEach { encoder.release(encoder.encode(it)); legacy(it) }
+        }
+
+        var before = threads.getThreadAllocatedBytes(tid)
+        for (r in requests) encoder.release(encoder.encode(r))
+        val streamingPerBeat = (threads.getThreadAllocatedBytes(tid) - before) / beats
+
+        before = threads.getThreadAllocatedBytes(tid)
+        for (r in requests) legacy(r)
+        val gsonPerBeat = (threads.getThreadAllocatedBytes(tid) - before) / beats
+
+        report("heartbeat bytes per beat", "streaming $streamingPerBeat B, gson $gsonPerBeat B")
+    }
+
+    private fun beat(uptime: Long, battery: Int) = HeartbeatRequest(
+        deviceImeis = listOf("356938035643809", "356938035643817"),
+        serialNumber = "R58N91ABCDE",
+        installedRam = "4 GB",
+        totalStorage = "64 GB",
+        isDeviceRooted = false,
+        isUsbDebuggingEnabled = true,
+        isDeveloperModeEnabled = false,
+        isBootloaderUnlocked = false,
+        isCustomRom = false,
+        androidId = "9774d56d682e549c",
+        model = "SM-A125F",
+        manufacturer = "samsung",
+        deviceFingerprint = "samsung/a12nnxx/a12:12/SP1A.210812.016/A125FXXU2CVK1:user/release-keys",
+        bootloader = "A125FXXU2CVK1",
+        osVersion = "12",
+        osEdition = "A125FXXU2CVK1",
+        sdkVersion = 31,
+        securityPatchLevel = "2022-11-01",
+        systemUptime = uptime,
+        installedAppsHash = "d41d8cd98f00b204e9800998ecf8427e",
+        systemPropertiesHash = "9e107d9d372bb6826bd81d3542a419d6",
+        latitude = -1.2920659,
+        longitude = 36.8219462,
+        batteryLevel = battery,
+        language = "en"
+    )
+}
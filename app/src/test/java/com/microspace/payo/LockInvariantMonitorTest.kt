@@ -0,0 +1,195 @@
+﻿package com.microspace.payo
+
+import com.microspace.payo.control.RemoteDeviceControlManager
+import com.microspace.payo.state.DeviceLockStateManager
+import com.microspace.payo.state.LockInput
+import com.microspace.payo.state.LockInputs
+import com.microspace.payo.state.LockInvariantMonitor
+import com.microspace.payo.state.LockInvariants
+import com.microspace.payo.state.LockReason
+import com.microspace.payo.state.LockState
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.asCoroutineDispatcher
+import org.junit.After
+import org.junit.Test
+import java.util.concurrent.Executors
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+/**
+ * Incremental re-checking, burst coalescing and repair throttling of the lock invariant monitor,
+ * driven by synthetic change sequences through a fake set of lock-state sources.
+ */
+class LockInvariantMonitorTest {
+
+    private class FakeSources(var truth: LockInputs) : LockInvariantMonitor.Platform {
+        lateinit var onChange: (Set<LockInput>) -> Unit
+        val reads = mutableMapOf<LockInput, Int>()
+        var repairs = 0
+        var repairFixes = true
+
+        override fun readAll() = truth
+
+        override fun read(input: LockInput, current: LockInputs): LockInputs {
+            reads[input] = (reads[input] ?: 0) + 1
+            return when (input) {
+                LockInput.KIOSK_POLICY -> current.copy(kioskPermitted = truth.kioskPermitted)
+                LockInput.CONTROL_STATE, LockInput.CONTROL_LOCK_TYPE ->
+                    current.copy(controlState = truth.controlState, controlLockType = truth.controlLockType)
+                LockInput.HARD_LOCK_TYPE -> current.copy(hardLockType = truth.hardLockType)
+                LockInput.PAYMENT_LOCKED -> current.copy(paymentLocked = truth.paymentLocked)
+                else -> current.copy(details = truth.details)
+            }
+        }
+
+        override fun subscribe(onChange: (Set<LockInput>) -> Unit) {
+            this.onChange = onChange
+        }
+
+        override fun repair(inputs: LockInputs, violations: List<LockInvariantMonitor.Violation>): Boolean {
+            repairs++
+            if (!repairFixes) return false
+            change(LockInput.KIOSK_FLAG) { it.copy(details = it.details.copy(kioskModeActive = true)) }
+            return true
+        }
+
+        fun change(input: LockInput, transform: (LockInputs) -> LockInputs) {
+            truth = transform(truth)
+            onChange(setOf(input))
+        }
+    }
+
+    private val unlocked = LockInputs(
+        details = DeviceLockStateManager.LockDetails(LockState.UNLOCKED, LockReason.NONE, 0L, "", permanent = false, kioskModeActive = false),
+        kioskPermitted = true,
+        controlState = RemoteDeviceControlManager.LOCK_UNLOCKED,
+        controlLockType = "",
+        hardLockType = null,
+        paymentLocked = false
+    )
+
+    private val window = 20L
+    private val executor = Executors.newSingleThreadExecutor { r -> Thread(r, "lock-invariants").apply { isDaemon = true } }
+    private var now = 1_000L
+
+    @After
+    fun tearDown() {
+        executor.shutdownNow()
+    }
+
+    private fun monitor(sources: FakeSources) =
+        LockInvariantMonitor(sources, CoroutineScope(executor.asCoroutineDispatcher()), window) { now }
+            .also { it.start() }
+
+    /** Waits out the burst window and lets the monitor finish the burst. */
+    private fun settle() {
+        Thread.sleep(window + 30)
+        repeat(2) { executor.submit {}.get() }
+    }
+
+    private fun hardLock(inputs: LockInputs) =
+        inputs.copy(details = inputs.details.copy(state = LockState.HARD_LOCKED, reason = LockReason.PAYMENT_OVERDUE))
+
+    @Test
+    fun burstRechecksOnlyDependentInvariantsOnce() {
+        val sources = FakeSources(unlocked)
+        val monitor = monitor(sources)
+        assertEquals(LockInvariants.ALL.size.toLong(), monitor.evaluations.get())
+        assertTrue(monitor.violations.value.isEmpty())
+
+        // 200 timestamp writes in one burst: one evaluation of the one invariant reading it
+        repeat(200) { i -> sources.change(LockInput.TIMESTAMP) { it.copy(details = it.details.copy(timestamp = i.toLong())) } }
+        settle()
+        assertEquals(LockInvariants.ALL.size + 1L, monitor.evaluations.get())
+        assertEquals(1, sources.reads[LockInput.TIMESTAMP])
+        assertEquals(null, sources.reads[LockInput.KIOSK_POLICY], "DPM must not be queried for a timestamp change")
+
+        // Payment flag: only the two cross-source invariants that read it
+        sources.change(LockInput.PAYMENT_LOCKED) { it.copy(paymentLocked = true) }
+        settle()
+        assertEquals(LockInvariants.ALL.size + 3L, monitor.evaluations.get())
+    }
+
+    @Test
+    fun detectsInTheFirstBurstAndKeepsFirstSeenTime() {
+        val sources = FakeSources(unlocked)
+        val monitor = monitor(sources)
+
+        now = 5_000L
+        sources.change(LockInput.TIMESTAMP) { it.copy(details = it.details.copy(timestamp = 9_000L)) }
+        settle()
+
+        // Found by the one evaluation that burst triggered, stamped with the time of the change
+        val violation = monitor.violations.value.single()
+        assertEquals("timestamp", violation.invariant)
+        assertEquals(5_000L, violation.detectedAt)
+        assertEquals(LockInvariants.ALL.size + 1L, monitor.evaluations.get())
+
+        // Still violated later: the first-seen time is kept
+        now = 6_000L
+        sources.change(LockInput.TIMESTAMP) { it.copy(details = it.details.copy(timestamp = 9_500L)) }
+        settle()
+        assertEquals(5_000L, monitor.violations.value.single().detectedAt)
+
+        now = 10_000L
+        sources.change(LockInput.TIMESTAMP) { it.copy(details = it.details.copy(timestamp = 9_900L)) }
+        settle()
+        assertTrue(monitor.violations.value.isEmpty())
+    }
+
+    @Test
+    fun repairsOncePerBurst() {
+        val sources = FakeSources(unlocked)
+        val monitor = monitor(sources)
+
+        // Hard lock written field by field without the kiosk flag: one burst, one repair
+        sources.change(LockInput.STATE) { hardLock(it) }
+        sources.change(LockInput.REASON) { it }
+        sources.change(LockInput.TIMESTAMP) { it.copy(details = it.details.copy(timestamp = 900L)) }
+        settle()
+        assertEquals(1, sources.repairs)
+
+        // The repair's own write is the next burst, which finds the invariant restored
+        settle()
+        assertTrue(monitor.violations.value.isEmpty())
+        assertEquals(1L, monitor.repairs.get())
+    }
+
+    @Test
+    fun failedRepairIsNotRetriedForTheSameViolations() {
+        val sources = FakeSources(unlocked).apply { repairFixes = false }
+        val monitor = monitor(sources)
+
+        sources.change(LockInput.STATE) { hardLock(it) }
+        settle()
+        repeat(5) { i ->
+            sources.change(LockInput.STATE) { it.copy(details = it.details.copy(message = "retry $i")) }
+            settle()
+        }
+        assertEquals(1, sources.repairs)
+        assertEquals(listOf("hard_lock_kiosk"), monitor.violations.value.map { it.invariant })
+
+        // A different violation set is a new problem and gets its own repair attempt
+        sources.change(LockInput.PERMANENT) { it.copy(details = it.details.copy(permanent = true)) }
+        settle()
+        assertEquals(2, sources.repairs)
+    }
+
+    @Test
+    fun kioskPolicyIsReadOnlyForInvariantsThatNeedIt() {
+        val sources = FakeSources(unlocked)
+        val monitor = monitor(sources)
+
+        sources.truth = sources.truth.copy(kioskPermitted = false)
+        sources.change(LockInput.KIOSK_FLAG) { it.copy(details = it.details.copy(kioskModeActive = true)) }
+        settle()
+        assertEquals(1, sources.reads[LockInput.KIOSK_POLICY])
+        assertEquals(listOf("kiosk_policy"), monitor.violations.value.map { it.invariant })
+
+        // Policy fixed out of band: a notification re-reads it without any prefs change
+        sources.truth = sources.truth.copy(kioskPermitted = true)
+        monitor.notifyChanged(LockInput.KIOSK_POLICY)
+        settle()
+        assertTrue(monitor.violations.value.isEmpty())
+    }
+}
@@ -0,0 +1,156 @@
+﻿package com.microspace.payo
+
+import android.app.admin.DevicePolicyManager
+import android.content.Context
+import android.os.UserManager
+import com.microspace.payo.control.LockPolicyTarget
+import com.microspace.payo.control.LockPolicyTransaction
+import com.microspace.payo.security.enforcement.adb.AdbBlocker
+import org.junit.Test
+import org.mockito.kotlin.doReturn
+import org.mockito.kotlin.mock
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+/**
+ * Ordering, de-duplication and call counts of the batched lock policy, against a recording DPM fake.
+ */
+class LockPolicyTransactionTest {
+
+    private class RecordingTarget(
+        private val installed: List<String> = emptyList(),
+        private val failing: Set<String> = emptySet()
+    ) : LockPolicyTarget {
+        val calls = mutableListOf<String>()
+
+        private fun record(call: String) {
+            calls.add(call)
+            if (call.substringBefore('(') in failing) throw SecurityException("denied: $call")
+        }
+
+        override fun setLockTaskPackages(packages: Array<String>) = record("setLockTaskPackages(${packages.joinToString()})")
+        override fun setLockTaskFeatures(flags: Int) = record("setLockTaskFeatures($flags)")
+        override fun setStatusBarDisabled(disabled: Boolean) = record("setStatusBarDisabled($disabled)")
+        override fun setKeyguardDisabledFeatures(flags: Int) = record("setKeyguardDisabledFeatures($flags)")
+        override fun addUserRestriction(restriction: String) = record("addUserRestriction($restriction)")
+        override fun clearUserRestriction(restriction: String) = record("clearUserRestriction($restriction)")
+        override fun setAutoTimeRequired(required: Boolean) = record("setAutoTimeRequired($required)")
+        override fun setUninstallBlocked(blocked: Boolean) = record("setUninstallBlocked($blocked)")
+        override fun installedPackages(): List<String> = installed
+        override fun setPackagesSuspended(packages: Array<String>, suspended: Boolean) =
+            record("setPackagesSuspended(${packages.joinToString()}, $suspended)")
+
+        fun count(method: String) = calls.count { it.startsWith("$method(") }
+    }
+
+    /** Mirrors the tamper path: hard lock + permanent hardening + power button policy. */
+    private fun tamperLock() = LockPolicyTransaction()
+        // contributors deliberately register in "wrong" order
+        .suspendAllExcept()
+        .restrict("no_safe_boot", "no_usb_file_transfer", "no_physical_media")
+        .restrict("no_factory_reset", "no_safe_boot", "no_debugging_features", "no_physical_media")
+        .autoTimeRequired(true)
+        .uninstallBlocked(true)
+        .keyguardDisabledFeatures(0x7fffffff)
+        .statusBarDisabled(true)
+        .restrict("no_safe_boot", "no_config_wifi")
+        .keyguardDisabledFeatures(0x7fffffff)
+        .statusBarDisabled(true)
+        .autoTimeRequired(true)
+        .lockTaskPackages("com.microspace.payo", "com.android.settings")
+        .lockTaskPackages("com.microspace.payo")
+        .lockTaskFeatures(0)
+
+    @Test
+    fun blockingStepsApplyFirstAndLockScreenWaitsForThem() {
+        val target = RecordingTarget(installed = listOf("com.microspace.payo", "com.android.settings", "com.example.game"))
+        var callsBeforeLockScreen = -1
+
+        tamperLock().commit(target) { callsBeforeLockScreen = target.calls.size }
+
+        assertEquals(
+            listOf("setLockTaskPackages", "setLockTaskFeatures", "setStatusBarDisabled", "setKeyguardDisabledFeatures"),
+            target.calls.take(4).map { it.substringBefore('(') }
+        )
+        assertEquals(4, callsBeforeLockScreen)
+        assertEquals("setPackagesSuspended(com.example.game, true)", target.calls.last())
+    }
+
+    @Test
+    fun eachSettingIsAppliedOnce() {
+        val target = RecordingTarget()
+        tamperLock().commit(target)
+
+        assertEquals(1, target.count("setLockTaskPackages"))
+        assertEquals("setLockTaskPackages(com.microspace.payo, com.android.settings)", target.calls.first())
+        assertEquals(1, target.count("setStatusBarDisabled"))
+        assertEquals(1, target.count("setKeyguardDisabledFeatures"))
+        assertEquals(1, target.count("setAutoTimeRequired"))
+        assertEquals(6, target.count("addUserRestriction"))
+        assertEquals(target.calls.size, target.calls.toSet().size, "duplicate calls: ${target.calls}")
+    }
+
+    @Test
+    fun restrictWinsOverAllowInEitherOrder() {
+        val target = RecordingTarget()
+        LockPolicyTransaction()
+            .restrict("no_debugging_features", "no_usb_file_transfer")
+            .allow("no_debugging_features", "no_config_wifi")
+            .allow("no_physical_media")
+            .restrict("no_physical_media")
+            .commit(target)
+
+        assertEquals(
+            listOf(
+                "addUserRestriction(no_debugging_features)",
+                "addUserRestriction(no_usb_file_transfer)",
+                "clearUserRestriction(no_config_wifi)",
+                "addUserRestriction(no_physical_media)"
+            ),
+            target.calls
+        )
+    }
+
+    @Test
+    fun usbAllowanceDoesNotReopenTheHardLock() {
+        val context = mock<Context> {
+            on { getSystemService(Context.DEVICE_POLICY_SERVICE) } doReturn mock<DevicePolicyManager>()
+        }
+        val target = RecordingTarget()
+
+        // Boot path: hard-lock restrictions, then the USB allowance contributed after them
+        LockPolicyTransaction()
+            .restrict(UserManager.DISALLOW_SAFE_BOOT, UserManager.DISALLOW_USB_FILE_TRANSFER, UserManager.DISALLOW_DEBUGGING_FEATURES)
+            .also { AdbBlocker(context).contributeTo(it) }
+            .commit(target)
+
+        assertTrue("addUserRestriction(${UserManager.DISALLOW_USB_FILE_TRANSFER})" in target.calls, "${target.calls}")
+        assertTrue("addUserRestriction(${UserManager.DISALLOW_DEBUGGING_FEATURES})" in target.calls, "${target.calls}")
+        assertEquals(0, target.calls.count { it.startsWith("clearUserRestriction(no_usb") || it.startsWith("clearUserRestriction(no_debugging") })
+    }
+
+    @Test
+    fun failingStepIsReportedWithoutStoppingTheRest() {
+        val target = RecordingTarget(failing = setOf("setStatusBarDisabled"))
+        var lockScreenShown = false
+
+        val report = tamperLock().commit(target) { lockScreenShown = true }
+
+        assertTrue(lockScreenShown)
+        assertEquals(listOf(LockPolicyTransaction.Step.STATUS_BAR), report.failed)
+        assertEquals(1, target.count("setUninstallBlocked"))
+        assertEquals(report.steps.map { it.step }, report.steps.map { it.step }.sorted())
+        assertTrue(report.blockingNanos <= report.totalNanos)
+    }
+
+    @Test
+    fun emptyTransactionMakesNoCalls() {
+        val target = RecordingTarget()
+        var lockScreenShown = false
+        val report = LockPolicyTransaction().commit(target) { lockScreenShown = true }
+
+        assertTrue(target.calls.isEmpty())
+        assertTrue(report.steps.isEmpty())
+        assertTrue(lockScreenShown)
+    }
+}
@@ -0,0 +1,143 @@
+﻿package com.microspace.payo
+
+import android.content.ComponentCallbacks2
+import com.microspace.payo.core.MemoryGovernor
+import com.microspace.payo.core.MemoryGovernor.Priority
+import com.microspace.payo.core.MemoryGovernor.Profile
+import com.microspace.payo.data.models.heartbeat.HeartbeatRequest
+import com.microspace.payo.data.remote.api.HeartbeatRequestEncoder
+import kotlinx.coroutines.Dispatchers
+import org.junit.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+/**
+ * Trim-level handling and budget enforcement of the memory governor, with the real heartbeat
+ * encoder next to fake consumers, plus a footprint comparison of the standard and low-RAM profiles.
+ */
+class MemoryGovernorTest {
+
+    private class FakeConsumer(
+        override val name: String,
+        override val priority: Priority,
+        var bytes: Long,
+        private val trims: MutableList<String>
+    ) : MemoryGovernor.Consumer {
+        override fun retainedBytes() = bytes
+        override fun trim() {
+            trims.add(name)
+            bytes = 0
+        }
+    }
+
+    private val trims = mutableListOf<String>()
+
+    // Unconfined: trim-memory callbacks trim before returning
+    private fun governor(profile: Profile = Profile.STANDARD) =
+        MemoryGovernor(Dispatchers.Unconfined).also { it.setProfile(profile) }
+
+    private fun request(uptime: Long) = HeartbeatRequest(
+        deviceImeis = listOf("356938035643809", "356938035643817"),
+        serialNumber = "R58N91ABCDE",
+        installedRam = "2 GB",
+        totalStorage = "32 GB",
+        isDeviceRooted = false,
+        isUsbDebuggingEnabled = false,
+        isDeveloperModeEnabled = false,
+        isBootloaderUnlocked = false,
+        isCustomRom = false,
+        androidId = "9774d56d682e549c",
+        model = "SM-A032F",
+        manufacturer = "samsung",
+        deviceFingerprint = "samsung/a03corexx/a03core:11/RP1A.201005.001/A032FXXU1AUL1:user/release-keys",
+        bootloader = "A032FXXU1AUL1",
+        osVersion = "11",
+        osEdition = "A032FXXU1AUL1",
+        sdkVersion = 30,
+        securityPatchLevel = "2022-01-01",
+        systemUptime = uptime,
+        installedAppsHash = "d41d8cd98f00b204e9800998ecf8427e",
+        systemPropertiesHash = "9e107d9d372bb6826bd81d3542a419d6",
+        latitude = -1.2920659,
+        longitude = 36.8219462,
+        batteryLevel = 50,
+        language = "en"
+    )
+
+    /** A periodic beat overlapped by a SIM-triggered one, both released afterwards. */
+    private fun overlappingBeats(encoder: HeartbeatRequestEncoder) {
+        val first = encoder.encode(request(1))
+        val second = encoder.encode(request(2))
+        encoder.release(first)
+        encoder.release(second)
+    }
+
+    @Test
+    fun trimLevelsReleaseInPriorityOrder() {
+        val governor = governor()
+        val connections = FakeConsumer("http_idle_connections", Priority.DISPOSABLE, 128 * 1024, trims)
+        val telemetry = FakeConsumer("telemetry_buffer", Priority.BUFFERED, 20 * 1024, trims)
+        val encoder = HeartbeatRequestEncoder()
+        listOf(telemetry, encoder, connections).forEach { governor.register(it) }
+        overlappingBeats(encoder)
+        val encoderBytes = encoder.retainedBytes()
+        assertTrue(encoderBytes > 4096, "Encoder holds two pooled bodies and its field caches")
+
+        governor.onTrimMemory(ComponentCallbacks2.TRIM_MEMORY_UI_HIDDEN)
+        assertEquals(0L, connections.bytes)
+        assertEquals(encoderBytes, encoder.retainedBytes())
+        assertEquals(20L * 1024, telemetry.bytes)
+
+        connections.bytes = 128 * 1024
+        governor.onTrimMemory(ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW)
+        assertEquals(0L, connections.bytes)
+        assertTrue(encoder.retainedBytes() < 1024, "Pool dropped, field caches back to their initial size")
+        assertEquals(20L * 1024, telemetry.bytes)
+
+        // The next beat rebuilds what was trimmed
+        overlappingBeats(encoder)
+        assertEquals(encoderBytes, encoder.retainedBytes())
+
+        connections.bytes = 128 * 1024
+        governor.onTrimMemory(ComponentCallbacks2.TRIM_MEMORY_COMPLETE)
+        assertEquals(listOf("http_idle_connections", "http_idle_connections", "http_idle_connections", "telemetry_buffer"), trims)
+        assertEquals(0L, governor.retainedBytes().filterKeys { it != "heartbeat_encoder" }.values.sum())
+        assertTrue(encoder.retainedBytes() < 1024)
+
+        assertNull(MemoryGovernor.pressureFor(0))
+    }
+
+    @Test
+    fun overBudgetTrimsCheapestFirst() {
+        val governor = governor(Profile.LOW_RAM)
+        val consumers = listOf(
+            FakeConsumer("buffered", Priority.BUFFERED, 600 * 1024, trims),
+            FakeConsumer("rebuildable", Priority.REBUILDABLE, 600 * 1024, trims),
+            FakeConsumer("disposable", Priority.DISPOSABLE, 600 * 1024, trims)
+        )
+        consumers.forEach { governor.register(it) }
+
+        governor.enforceBudget()
+
+        // 1800 KB against 1 MB: dropping the two cheapest is enough, buffered rows stay
+        assertEquals(listOf("disposable", "rebuildable"), trims)
+        assertEquals(600L * 1024, governor.retainedBytes().values.sum())
+    }
+
+    @Test
+    fun lowRamProfileFootprint() {
+        val footprints = listOf(Profile.STANDARD, Profile.LOW_RAM).associate { profile ->
+            val governor = governor(profile)
+            val encoder = HeartbeatRequestEncoder()
+            governor.register(encoder)
+            repeat(10) { overlappingBeats(encoder) }
+            profile.name to encoder.retainedBytes()
+        }
+        val standard = footprints.getValue("standard")
+        val lowRam = footprints.getValue("low_ram")
+        // One pooled body fewer
+        assertEquals(2048L, standard - lowRam)
+        assertTrue(Profile.LOW_RAM.budgetBytes < Profile.STANDARD.budgetBytes)
+    }
+}
@@ -0,0 +1,140 @@
+﻿package com.microspace.payo
+
+import android.view.WindowManager
+import com.microspace.payo.services.lock.OverlayWindowHost
+import org.junit.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+/**
+ * Window add/update/remove counts of the overlay host under flapping soft-lock state, against a
+ * fake window that records what WindowManager would have been asked to do.
+ */
+class OverlayWindowHostTest {
+
+    private class FakeWindow : OverlayWindowHost.Window {
+        var attaches = 0
+        var updates = 0
+        var detaches = 0
+        var failAttach = false
+        var failUpdate = false
+        var shown = false
+
+        override fun attach(params: WindowManager.LayoutParams) {
+            if (failAttach) throw IllegalStateException("permission denied")
+            attaches++
+            shown = OverlayWindowHost.isShownParams(params)
+        }
+
+        override fun update(params: WindowManager.LayoutParams) {
+            if (failUpdate) throw IllegalArgumentException("View not attached to window manager")
+            updates++
+            shown = OverlayWindowHost.isShownParams(params)
+        }
+
+        override fun detach() {
+            detaches++
+        }
+    }
+
+    private val window = FakeWindow()
+    private val published = mutableListOf<String?>()
+    private val host = OverlayWindowHost<String>(window) { published += it }
+
+    @Test
+    fun rapidStateChangesAttachTheWindowOnce() {
+        repeat(50) { i ->
+            assertTrue(host.show("reminder-$i"))
+            assertTrue(window.shown)
+            host.hide()
+            assertFalse(window.shown)
+        }
+
+        assertEquals(1, window.attaches)
+        assertEquals(0, window.detaches)
+        // The first show attaches; every other visibility change is one layout update
+        assertEquals(99, window.updates)
+        assertNull(host.content)
+    }
+
+    @Test
+    fun newContentWhileShownOnlyRecomposes() {
+        host.show("payment")
+        host.show("payment")
+        host.show("sim-change")
+
+        assertEquals(1, window.attaches)
+        assertEquals(0, window.updates)
+        assertEquals(listOf<String?>("payment", "sim-change"), published)
+        assertEquals("sim-change", host.content)
+    }
+
+    @Test
+    fun hiddenWindowHoldsNoContent() {
+        host.show("payment")
+        host.hide()
+        host.hide()
+
+        assertEquals(listOf<String?>("payment", null), published)
+        assertEquals(1, window.updates)
+    }
+
+    @Test
+    fun releaseRemovesTheWindowAndAllowsANewOne() {
+        host.show("payment")
+        host.release()
+        host.release()
+        assertEquals(1, window.detaches)
+        assertFalse(host.attached)
+
+        host.show("payment")
+        assertEquals(2, window.attaches)
+    }
+
+    @Test
+    fun failedAttachIsRetriedOnTheNextShow() {
+        window.failAttach = true
+        assertFalse(host.show("payment"))
+        assertFalse(host.attached)
+        assertNull(host.content)
+
+        window.failAttach = false
+        assertTrue(host.show("payment"))
+        assertEquals(1, window.attaches)
+        assertTrue(window.shown)
+    }
+
+    @Test
+    fun windowRemovedBySystemIsAttachedAgain() {
+        host.show("payment")
+        host.hide()
+        window.failUpdate = true
+
+        assertTrue(host.show("payment"))
+        assertEquals(2, window.attaches)
+        assertTrue(window.shown)
+    }
+
+    @Test
+    fun contentSwapsNeverTouchTheWindow() {
+        host.show("warm-up")
+        val rounds = 1_000
+        repeat(rounds) { i -> host.show("reminder-$i") }
+
+        // One attach, no layout update and no re-attach however often the content changes
+        assertEquals(1, window.attaches)
+        assertEquals(0, window.updates)
+        assertEquals(0, window.detaches)
+        // Each swap is published synchronously, with nothing coalescing or delaying it
+        assertEquals(rounds + 1, published.size)
+        assertEquals("reminder-${rounds - 1}", published.last())
+
+        // Only a visibility change updates the window
+        host.hide()
+        host.show("payment")
+        assertEquals(1, window.attaches)
+        assertEquals(2, window.updates)
+    }
+}
@@ -0,0 +1,219 @@
+﻿package com.microspace.payo
+
+import com.microspace.payo.data.local.database.entities.payment.PaymentStateEntity
+import com.microspace.payo.services.payment.PaymentDeadlineEngine
+import com.microspace.payo.services.payment.PaymentDeadlineEngine.Kind
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.flow.MutableStateFlow
+import org.junit.Test
+import java.time.Instant
+import java.util.concurrent.TimeUnit
+import kotlin.test.assertEquals
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+/**
+ * Local payment deadlines on trusted time: one alarm for the nearest deadline, immune to wall-clock
+ * changes within a boot, re-armed after a reboot, and replaced as a whole when the date changes.
+ */
+class PaymentDeadlineEngineTest {
+
+    /** Fake clocks, persisted schedule and AlarmManager; survives a simulated reboot. */
+    private class FakeDevice : PaymentDeadlineEngine.Platform {
+        var elapsed = 1_000L
+        var wall = Instant.parse("2026-02-01T00:00:00Z").toEpochMilli()
+        var boot = 1
+        var stored: PaymentDeadlineEngine.Schedule? = null
+        var alarmAt: Long? = null
+        var alarmsSet = 0
+        var failFire = false
+        val fired = mutableListOf<Kind>()
+
+        override fun elapsedRealtime() = elapsed
+        override fun wallClock() = wall
+        override fun bootCount() = boot
+        override fun load() = stored
+        override fun save(schedule: PaymentDeadlineEngine.Schedule) {
+            stored = schedule
+        }
+        override fun setAlarm(triggerAtElapsed: Long?) {
+            alarmAt = triggerAtElapsed
+            alarmsSet++
+        }
+        override fun fire(deadline: PaymentDeadlineEngine.Deadline) {
+            if (failFire) throw IllegalStateException("payment state locked")
+            fired += deadline.kind
+        }
+
+        fun advance(ms: Long) {
+            elapsed += ms
+            wall += ms
+        }
+
+        fun reboot(downMs: Long) {
+            boot++
+            elapsed = 500L
+            wall += downMs
+        }
+
+        /** Lets time run to the armed alarm and delivers it. */
+        fun runAlarm(engine: PaymentDeadlineEngine) {
+            val at = alarmAt ?: error("no alarm armed")
+            wall += at - elapsed
+            elapsed = at
+            engine.rearm()
+        }
+    }
+
+    private val hour = TimeUnit.HOURS.toMillis(1)
+    private val day = TimeUnit.DAYS.toMillis(1)
+
+    private fun engine(device: FakeDevice, graceMs: Long = day) =
+        PaymentDeadlineEngine(device, CoroutineScope(Dispatchers.Unconfined)) { graceMs }
+
+    @Test
+    fun armsOnlyTheNearestDeadlineAndWalksTheSet() {
+        val device = FakeDevice()
+        val engine = engine(device)
+        engine.onServerTime("2026-02-01T00:00:00Z")
+        engine.onPaymentDate("2026-02-05T00:00:00Z")
+
+        // Reminder is 3 days out
+        assertEquals(device.elapsed + 3 * day, device.alarmAt)
+        assertEquals(listOf(Kind.REMINDER, Kind.DUE, Kind.GRACE_EXPIRY), engine.deadlines.map { it.kind })
+
+        repeat(3) { device.runAlarm(engine) }
+        assertEquals(listOf(Kind.REMINDER, Kind.DUE, Kind.GRACE_EXPIRY), device.fired)
+        assertNull(device.alarmAt)
+    }
+
+    @Test
+    fun wallClockChangesNeitherDelayNorAdvanceTheDeadline() {
+        val device = FakeDevice()
+        val engine = engine(device, graceMs = 0)
+        engine.onServerTime("2026-02-01T00:00:00Z")
+        engine.onPaymentDate("2026-02-03T12:00:00Z")
+        val armed = device.alarmAt
+
+        // User winds the clock back a week: the elapsed-time alarm is unchanged
+        device.wall -= 7 * day
+        engine.rearm()
+        assertEquals(armed, device.alarmAt)
+
+        // ...and forward past the due date: nothing fires early
+        device.wall += 14 * day
+        device.advance(hour)
+        engine.rearm()
+        assertEquals(emptyList<Kind>(), device.fired)
+        assertEquals(Instant.parse("2026-02-01T01:00:00Z").toEpochMilli(), engine.trustedNow())
+
+        // Due and grace expiry coincide without a grace period: the lock alone acts
+        repeat(2) { device.runAlarm(engine) }
+        assertEquals(listOf(Kind.REMINDER, Kind.GRACE_EXPIRY), device.fired)
+    }
+
+    @Test
+    fun rebootRearmsFromTheLastTrustedTime() {
+        val device = FakeDevice()
+        engine(device).apply {
+            onServerTime("2026-02-01T00:00:00Z")
+            onPaymentDate("2026-02-03T00:00:00Z")
+        }
+        device.advance(6 * hour)
+        engine(device).rearm()
+
+        // Off for 2 hours, and the clock was set back a month while it was down
+        device.reboot(downMs = 2 * hour)
+        device.wall -= 30 * day
+        val engine = engine(device)
+        engine.rearm()
+
+        // Never earlier than the last trusted time: the reminder is at most 18h away, not 30 days
+        assertEquals(Instant.parse("2026-02-01T06:00:00Z").toEpochMilli(), engine.trustedNow())
+        assertEquals(device.elapsed + 18 * hour, device.alarmAt)
+
+        // The next server time re-anchors exactly
+        engine.onServerTime("2026-02-01T08:00:00Z")
+        assertEquals(device.elapsed + 16 * hour, device.alarmAt)
+    }
+
+    @Test
+    fun newPaymentDateReplacesTheWholeSet() {
+        val device = FakeDevice()
+        val engine = engine(device)
+        engine.onServerTime("2026-02-01T00:00:00Z")
+        engine.onPaymentDate("2026-02-03T00:00:00Z")
+        val alarms = device.alarmsSet
+
+        // Same date from the next heartbeat: no change
+        engine.onPaymentDate("2026-02-03T00:00:00Z")
+        assertEquals(alarms, device.alarmsSet)
+
+        // Paid: the date moves a month out, stale deadlines are gone
+        engine.onPaymentDate("2026-03-03T00:00:00Z")
+        assertTrue(engine.deadlines.all { it.paymentDate == "2026-03-03T00:00:00Z" })
+        assertEquals(device.elapsed + 29 * day, device.alarmAt)
+
+        device.advance(10 * day)
+        engine.rearm()
+        assertEquals(emptyList<Kind>(), device.fired)
+
+        engine.onPaymentDate(null)
+        assertNull(device.alarmAt)
+        assertEquals(emptyList<PaymentDeadlineEngine.Deadline>(), engine.deadlines)
+    }
+
+    @Test
+    fun onlyTheLatestPassedDeadlineActsAndAFailedOneIsKept() {
+        val device = FakeDevice()
+        engine(device).apply {
+            onServerTime("2026-02-01T00:00:00Z")
+            onPaymentDate("2026-02-03T00:00:00Z")
+        }
+        // Device off through reminder, due date and grace
+        device.reboot(downMs = 5 * day)
+        device.failFire = true
+        val engine = engine(device)
+        engine.rearm()
+        assertEquals(listOf(Kind.GRACE_EXPIRY), engine.deadlines.map { it.kind })
+
+        device.failFire = false
+        engine.rearm()
+        assertEquals(listOf(Kind.GRACE_EXPIRY), device.fired)
+        assertEquals(emptyList<PaymentDeadlineEngine.Deadline>(), engine.deadlines)
+    }
+
+    @Test
+    fun startWaitsForTheLoadAndIgnoresTheReplayedServerTime() {
+        val device = FakeDevice()
+        engine(device).apply {
+            onServerTime("2026-02-01T00:00:00Z")
+            onPaymentDate("2026-02-05T00:00:00Z")
+        }
+        device.advance(6 * hour)
+        val armed = device.alarmAt
+        val alarms = device.alarmsSet
+
+        // New process: payment state starts as the empty placeholder until the stored row is loaded
+        val payments = MutableStateFlow(PaymentStateEntity.EMPTY)
+        val load = CompletableDeferred<Unit>()
+        val engine = engine(device)
+        engine.start(payments) { load.await() }
+        assertEquals(3, engine.deadlines.size)
+        assertEquals(alarms, device.alarmsSet)
+
+        // The loaded row carries the server time the stored anchor was taken from
+        payments.value = PaymentStateEntity(nextPaymentDate = "2026-02-05T00:00:00Z", serverTime = "2026-02-01T00:00:00Z")
+        load.complete(Unit)
+        assertEquals(Instant.parse("2026-02-01T06:00:00Z").toEpochMilli(), engine.trustedNow())
+        assertEquals(listOf(Kind.REMINDER, Kind.DUE, Kind.GRACE_EXPIRY), engine.deadlines.map { it.kind })
+        assertEquals(armed, device.alarmAt)
+        assertEquals(emptyList<Kind>(), device.fired)
+
+        // A newer one from the next heartbeat re-anchors
+        payments.value = payments.value.copy(serverTime = "2026-02-01T08:00:00Z")
+        assertEquals(Instant.parse("2026-02-01T08:00:00Z").toEpochMilli(), engine.trustedNow())
+    }
+}
@@ -0,0 +1,295 @@
+﻿package com.microspace.payo
+
+import com.google.gson.Gson
+import com.google.gson.reflect.TypeToken
+import com.microspace.payo.data.local.database.dao.payment.PaymentStateDao
+import com.microspace.payo.data.local.database.entities.payment.InstallmentEntity
+import com.microspace.payo.data.local.database.entities.payment.PaymentHistoryEntity
+import com.microspace.payo.data.local.database.entities.payment.PaymentStateEntity
+import com.microspace.payo.data.models.heartbeat.HeartbeatResponse
+import com.microspace.payo.data.models.heartbeat.NextPaymentInfo
+import com.microspace.payo.data.repository.PaymentStateRepository
+import com.microspace.payo.utils.storage.PaymentDataManager
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.runBlocking
+import org.junit.Test
+import java.time.LocalDate
+import java.time.ZoneOffset
+import kotlin.test.assertEquals
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+/**
+ * Migration from the legacy JSON-in-prefs format, incremental folding and the capped history
+ * window of the materialized payment state, plus a read/update cost benchmark against the
+ * prefs implementation it replaces.
+ */
+class PaymentStateRepositoryTest {
+
+    /** Same semantics as the Room queries, including the row-id ordered history trim. */
+    private class InMemoryPaymentStateDao : PaymentStateDao {
+        var row: PaymentStateEntity? = null
+        /** Simulates a write that is lost (e.g. the database is replaced) before it is read back. */
+        var dropWrites = false
+        val history = mutableListOf<PaymentHistoryEntity>()
+        var upserts = 0
+        private var nextId = 1L
+
+        override suspend fun get() = row
+        override fun observe(): Flow<PaymentStateEntity?> = MutableStateFlow(row)
+        override suspend fun upsert(state: PaymentStateEntity) {
+            upserts++
+            if (!dropWrites) row = state
+        }
+        override suspend fun insertHistory(record: PaymentHistoryEntity): Long {
+            val id = nextId++
+            history.add(record.copy(id = id))
+            return id
+        }
+        override suspend fun insertHistory(records: List<PaymentHistoryEntity>) {
+            records.forEach { insertHistory(it) }
+        }
+        override suspend fun trimHistory(keep: Int) {
+            val cutoff = history.sortedByDescending { it.id }.getOrNull(keep)?.id ?: return
+            history.removeAll { it.id <= cutoff }
+        }
+        override suspend fun getHistory(limit: Int) = history.sortedByDescending { it.id }.take(limit)
+        override suspend fun clearHistory() = history.clear()
+        override suspend fun clearState() {
+            row = null
+        }
+    }
+
+    private val gson = Gson()
+
+    private fun legacyRecord(i: Int) =
+        PaymentDataManager.PaymentRecord(date = 1_700_000_000_000L + i, amount = "$i", currency = "TZS", status = "paid", daysUntilDue = i)
+
+    private fun legacyPrefs(records: Int) = mapOf<String, Any?>(
+        "next_payment_date" to "2026-02-07T23:59:00+03:00",
+        "unlock_password" to "482913",
+        "payment_amount" to "15000",
+        "payment_currency" to "TZS",
+        "is_locked" to true,
+        "lock_reason" to "Payment overdue",
+        "lock_timestamp" to 1_700_000_000_123L,
+        "server_time" to "2026-02-01T10:00:00+03:00",
+        "last_sync_time" to 1_700_000_000_456L,
+        "days_until_payment" to 6,
+        "payment_history_json" to gson.toJson((1..records).map { legacyRecord(it) })
+    )
+
+    private fun repository(dao: PaymentStateDao, initial: PaymentStateEntity = PaymentStateEntity.EMPTY) =
+        PaymentStateRepository(dao, CoroutineScope(Dispatchers.Unconfined), { initial })
+
+    @Test
+    fun migratesLegacyPrefsOnceAndClearsThem() = runBlocking {
+        val dao = InMemoryPaymentStateDao()
+        var cleared = 0
+
+        val state = PaymentStateRepository.load(dao, legacyPrefs(records = 3)) { cleared++ }
+
+        assertEquals("2026-02-07T23:59:00+03:00", state.nextPaymentDate)
+        assertEquals("482913", state.unlockPassword)
+        assertEquals("15000", state.paymentAmount)
+        assertTrue(state.isLocked)
+        assertEquals("Payment overdue", state.lockReason)
+        assertEquals(1_700_000_000_123L, state.lockTimestamp)
+        assertEquals(1_700_000_000_456L, state.lastSyncTime)
+        assertEquals(6, state.daysUntilPayment)
+        assertEquals(state, dao.row)
+        assertEquals(listOf("3", "2", "1"), dao.getHistory(12).map { it.amount })
+        assertEquals(1, cleared)
+
+        // Second start: the row wins, leftover prefs are cleared again but not re-imported
+        val again = PaymentStateRepository.load(dao, legacyPrefs(records = 3)) { cleared++ }
+        assertEquals(state, again)
+        assertEquals(3, dao.history.size)
+        assertEquals(2, cleared)
+    }
+
+    @Test
+    fun legacyPrefsAreKeptUntilTheImportReadsBack() = runBlocking {
+        val dao = InMemoryPaymentStateDao().apply { dropWrites = true }
+        var cleared = 0
+
+        val state = PaymentStateRepository.load(dao, legacyPrefs(records = 1)) { cleared++ }
+
+        assertEquals("482913", state.unlockPassword)
+        assertEquals(0, cleared, "the unlock password must survive until the row is stored")
+
+        dao.dropWrites = false
+        PaymentStateRepository.load(dao, legacyPrefs(records = 1)) { cleared++ }
+        assertEquals("482913", dao.row?.unlockPassword)
+        assertEquals(1, cleared)
+    }
+
+    @Test
+    fun updatesBeforeTheLoadAreReplayedOnTheStoredRow() = runBlocking {
+        val dao = InMemoryPaymentStateDao()
+        val stored = PaymentStateEntity(nextPaymentDate = "2026-02-07T23:59:00+03:00", unlockPassword = "482913")
+        val gate = CompletableDeferred<PaymentStateEntity>()
+        val repository = PaymentStateRepository(dao, CoroutineScope(Dispatchers.Unconfined), { gate.await() })
+
+        repository.setLockState(true, "Payment overdue")
+        assertTrue(!repository.isLoaded)
+        assertEquals(0, dao.upserts, "nothing is written over the stored row before it is loaded")
+
+        gate.complete(stored)
+        repository.awaitLoaded()
+
+        val state = repository.state.value
+        assertEquals("482913", state.unlockPassword)
+        assertTrue(state.isLocked)
+        assertEquals(state, dao.row)
+    }
+
+    @Test
+    fun migrationKeepsNewestWindowAndSurvivesCorruptHistory() = runBlocking {
+        val full = InMemoryPaymentStateDao()
+        PaymentStateRepository.load(full, legacyPrefs(records = 20)) {}
+        assertEquals((20 downTo 9).map { "$it" }, full.getHistory(12).map { it.amount })
+
+        val corrupt = InMemoryPaymentStateDao()
+        val state = PaymentStateRepository.load(corrupt, legacyPrefs(0) + ("payment_history_json" to "{not json")) {}
+        assertEquals("482913", state.unlockPassword)
+        assertTrue(corrupt.history.isEmpty())
+
+        val fresh = InMemoryPaymentStateDao()
+        assertEquals(PaymentStateEntity.EMPTY, PaymentStateRepository.load(fresh, emptyMap<String, Any?>()) {})
+        assertNull(fresh.row)
+    }
+
+    @Test
+    fun historyIsCappedToWindow() = runBlocking {
+        val dao = InMemoryPaymentStateDao()
+        val repository = repository(dao)
+        repeat(30) { i ->
+            repository.appendHistory(PaymentHistoryEntity(date = i.toLong(), amount = "$i", currency = "TZS", status = "paid", daysUntilDue = 0))
+        }
+        assertEquals(PaymentStateRepository.HISTORY_WINDOW, dao.history.size)
+        assertEquals((29 downTo 18).map { "$it" }, repository.getHistory().map { it.amount })
+    }
+
+    @Test
+    fun heartbeatAndInstallmentsFoldIntoOneSnapshotWithoutRedundantWrites() {
+        val dao = InMemoryPaymentStateDao()
+        var now = 1_000L
+        val repository = PaymentStateRepository(dao, CoroutineScope(Dispatchers.Unconfined), { PaymentStateEntity.EMPTY }) { now }
+        val response = HeartbeatResponse(
+            success = true,
+            nextPayment = NextPaymentInfo(dateTime = "2026-02-07T23:59:00+03:00", unlockPassword = "111222"),
+            isLocked = true,
+            reason = "Payment overdue",
+            loanStatus = "active"
+        )
+
+        repository.applyHeartbeat(response)
+        val afterFirst = repository.current
+        assertEquals("111222", afterFirst.unlockPassword)
+        assertEquals("TZS", afterFirst.paymentCurrency)
+        assertTrue(afterFirst.isLocked)
+        assertEquals(1_000L, afterFirst.lockTimestamp)
+        assertEquals(1, dao.upserts)
+
+        // Same facts later: only the sync time moves, the lock timestamp does not
+        now = 2_000L
+        repository.applyHeartbeat(response)
+        assertEquals(1_000L, repository.current.lockTimestamp)
+        assertEquals(2_000L, repository.current.lastSyncTime)
+
+        // A response without next_payment keeps the stored one
+        repository.applyHeartbeat(response.copy(nextPayment = null))
+        assertEquals("2026-02-07T23:59:00+03:00", repository.current.nextPaymentDate)
+
+        val upsertsBefore = dao.upserts
+        repository.setLockState(true, "Payment overdue")
+        assertEquals(upsertsBefore, dao.upserts, "unchanged lock state must not be written")
+
+        repository.applyInstallments(
+            listOf(
+                installment(1, "paid", due = 10_000.0, paid = 10_000.0),
+                installment(2, "partial", due = 10_000.0, paid = 4_000.0),
+                installment(3, "overdue", due = 10_000.0, paid = 0.0, overdue = true)
+            )
+        )
+        val state = repository.current
+        assertEquals(1, state.installmentsPaid)
+        assertEquals(3, state.installmentsTotal)
+        assertEquals(1, state.overdueInstallments)
+        assertEquals(16_000.0, state.getRemainingAmount())
+        assertEquals("2026-02-02", state.nextInstallmentDueDate)
+        assertEquals(6_000.0, state.nextInstallmentAmount)
+        assertEquals("111222", state.unlockPassword, "installment sync must not touch heartbeat facts")
+        assertEquals(state, dao.row)
+        assertEquals(state, repository.state.value)
+    }
+
+    @Test
+    fun daysUntilUsesCalendarDaysInDeviceZone() {
+        val today = LocalDate.of(2026, 2, 1)
+        assertEquals(6, PaymentStateRepository.daysUntil("2026-02-07T23:59:00+03:00", today, ZoneOffset.ofHours(3)))
+        assertEquals(7, PaymentStateRepository.daysUntil("2026-02-07T23:59:00+03:00", today, ZoneOffset.ofHours(5)))
+        assertEquals(0, PaymentStateRepository.daysUntil("2026-02-01T08:00:00", today, ZoneOffset.UTC))
+        assertEquals(-3, PaymentStateRepository.daysUntil("2026-01-29T08:00:00Z", today, ZoneOffset.UTC))
+        assertNull(PaymentStateRepository.daysUntil("next week", today, ZoneOffset.UTC))
+    }
+
+    @Test
+    fun benchmarkReadAndUpdateCost() = runBlocking {
+        val iterations = 20_000
+        // Legacy: a map standing in for the prefs file; every read parses, every append re-serializes
+        val prefs = HashMap<String, String>().apply { put("payment_history_json", gson.toJson((1..12).map { legacyRecord(it) })) }
+        val type = object : TypeToken<List<PaymentDataManager.PaymentRecord>>() {}.type
+        fun legacyRead(): List<PaymentDataManager.PaymentRecord> = gson.fromJson(prefs["payment_history_json"], type)
+        fun legacyAppend(record: PaymentDataManager.PaymentRecord) {
+            val history = legacyRead().toMutableList()
+            history.add(record)
+            if (history.size > 12) history.removeAt(0)
+            prefs["payment_history_json"] = gson.toJson(history)
+        }
+
+        val dao = InMemoryPaymentStateDao()
+        val repository = repository(dao, PaymentStateRepository.load(dao, legacyPrefs(records = 12)) {})
+
+        repeat(2_000) { legacyRead(); legacyAppend(legacyRecord(it)); repository.current.nextPaymentDate }
+
+        var sink = 0
+        var start = System.nanoTime()
+        repeat(iterations) { sink += legacyRead().size }
+        val legacyReadNs = (System.nanoTime() - start) / iterations
+        start = System.nanoTime()
+        repeat(iterations) { sink += repository.current.daysUntilPayment }
+        val readNs = (System.nanoTime() - start) / iterations
+
+        start = System.nanoTime()
+        repeat(iterations) { legacyAppend(legacyRecord(it)) }
+        val legacyAppendNs = (System.nanoTime() - start) / iterations
+        start = System.nanoTime()
+        repeat(iterations) {
+            repository.setLockState(it % 2 == 0, "Payment overdue")
+            repository.appendHistory(PaymentHistoryEntity(date = it.toLong(), amount = "$it", currency = "TZS", status = "paid", daysUntilDue = 0))
+        }
+        val updateNs = (System.nanoTime() - start) / iterations
+
+        assertTrue(sink != 0)
+        assertTrue(readNs * 10 < legacyReadNs, "read $readNs ns vs legacy $legacyReadNs ns")
+        assertTrue(updateNs < legacyAppendNs, "update $updateNs ns vs legacy $legacyAppendNs ns")
+    }
+
+    private fun installment(number: Int, status: String, due: Double, paid: Double, overdue: Boolean = false) = InstallmentEntity(
+        id = number,
+        deviceId = "dev",
+        loanNumber = "LN-1",
+        installmentNumber = number,
+        dueDate = "2026-02-0$number",
+        amountDue = due,
+        amountPaid = paid,
+        status = status,
+        isOverdue = overdue
+    )
+}
@@ -0,0 +1,179 @@
+﻿package com.microspace.payo
+
+import android.content.SharedPreferences
+import com.microspace.payo.utils.storage.PrefsWriteCoalescer
+import kotlinx.coroutines.asCoroutineDispatcher
+import org.junit.After
+import org.junit.Test
+import java.util.concurrent.CountDownLatch
+import java.util.concurrent.Executors
+import java.util.concurrent.TimeUnit
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+/**
+ * File rewrites caused by bursts of preference edits, before (one per apply) and after coalescing,
+ * plus read-your-writes while edits are staged and durability of commit().
+ */
+class PrefsWriteCoalescerTest {
+
+    /** In-memory preferences file counting full rewrites (each apply or commit). */
+    private class FakeFile(private val onWrite: () -> Unit = {}) : SharedPreferences {
+        val data = HashMap<String, Any?>()
+        var rewrites = 0
+        var failNext = false
+
+        override fun getAll(): MutableMap<String, *> = HashMap(data)
+        override fun getString(key: String?, defValue: String?) = data[key] as String? ?: defValue
+        @Suppress("UNCHECKED_CAST")
+        override fun getStringSet(key: String?, defValues: MutableSet<String>?) = data[key] as MutableSet<String>? ?: defValues
+        override fun getInt(key: String?, defValue: Int) = data[key] as Int? ?: defValue
+        override fun getLong(key: String?, defValue: Long) = data[key] as Long? ?: defValue
+        override fun getFloat(key: String?, defValue: Float) = data[key] as Float? ?: defValue
+        override fun getBoolean(key: String?, defValue: Boolean) = data[key] as Boolean? ?: defValue
+        override fun contains(key: String?) = data.containsKey(key)
+        override fun registerOnSharedPreferenceChangeListener(l: SharedPreferences.OnSharedPreferenceChangeListener?) {}
+        override fun unregisterOnSharedPreferenceChangeListener(l: SharedPreferences.OnSharedPreferenceChangeListener?) {}
+
+        override fun edit(): SharedPreferences.Editor = object : SharedPreferences.Editor {
+            val changes = LinkedHashMap<String, Any?>()
+            var clear = false
+            fun put(key: String?, value: Any?): SharedPreferences.Editor {
+                changes[key!!] = value
+                return this
+            }
+            override fun putString(key: String?, value: String?) = put(key, value)
+            override fun putStringSet(key: String?, values: MutableSet<String>?) = put(key, values)
+            override fun putInt(key: String?, value: Int) = put(key, value)
+            override fun putLong(key: String?, value: Long) = put(key, value)
+            override fun putFloat(key: String?, value: Float) = put(key, value)
+            override fun putBoolean(key: String?, value: Boolean) = put(key, value)
+            override fun remove(key: String?) = put(key, null)
+            override fun clear(): SharedPreferences.Editor {
+                clear = true
+                return this
+            }
+            override fun apply() {
+                commit()
+            }
+            override fun commit(): Boolean {
+                if (failNext) {
+                    failNext = false
+                    return false
+                }
+                if (clear) data.clear()
+                changes.forEach { (k, v) -> if (v == null) data.remove(k) else data[k] = v }
+                rewrites++
+                onWrite()
+                return true
+            }
+        }
+    }
+
+    private val executor = Executors.newSingleThreadExecutor { r -> Thread(r, "prefs").apply { isDaemon = true } }
+
+    @After
+    fun tearDown() {
+        executor.shutdownNow()
+    }
+
+    private fun coalescer(windowMs: Long = TimeUnit.MINUTES.toMillis(10), onMain: Boolean = false) =
+        PrefsWriteCoalescer(executor.asCoroutineDispatcher(), windowMs) { onMain }
+
+    /** The registration burst: two dual writes, then the device ID into three more files. */
+    private fun registrationBurst(shared: SharedPreferences, protected: SharedPreferences, idFiles: List<SharedPreferences>) {
+        for (prefs in listOf(protected, shared)) prefs.edit().putBoolean("device_registered", true).apply()
+        for (prefs in listOf(protected, shared)) prefs.edit().putString("device_id", "D-1").apply()
+        for (prefs in listOf(protected, shared)) prefs.edit().putBoolean("registration_completed", true).apply()
+        idFiles.forEach { it.edit().putString("device_id_primary", "D-1").apply() }
+    }
+
+    @Test
+    fun burstIsOneRewritePerFile() {
+        val direct = List(5) { FakeFile() }
+        registrationBurst(direct[0], direct[1], direct.drop(2))
+        val unbuffered = direct.sumOf { it.rewrites }
+
+        val coalescer = coalescer()
+        val files = List(5) { FakeFile() }
+        val views = files.mapIndexed { i, file -> coalescer.open("f$i") { file } }
+        registrationBurst(views[0], views[1], views.drop(2))
+        assertEquals(0, files.sumOf { it.rewrites })
+
+        assertTrue(coalescer.flush())
+        val coalesced = files.sumOf { it.rewrites }
+        assertEquals(9, unbuffered)
+        assertEquals(5, coalesced)
+        assertEquals(direct.map { it.data }, files.map { it.data })
+    }
+
+    @Test
+    fun windowCommitsOnTheBackgroundThread() {
+        val written = CountDownLatch(1)
+        var writer: String? = null
+        val file = FakeFile {
+            writer = Thread.currentThread().name
+            written.countDown()
+        }
+        val prefs = coalescer(windowMs = 50).open("audit") { file }
+
+        repeat(20) { prefs.edit().putString("last_lock_reason", "reason $it").apply() }
+
+        assertTrue(written.await(2, TimeUnit.SECONDS))
+        executor.submit {}.get()
+        assertEquals(1, file.rewrites)
+        assertEquals("prefs", writer)
+        assertEquals("reason 19", file.data["last_lock_reason"])
+    }
+
+    @Test
+    fun stagedEditsAreVisibleBeforeTheyReachTheFile() {
+        val file = FakeFile()
+        file.data["lock_type"] = "soft"
+        file.data["lock_reason"] = "old"
+        val prefs = coalescer().open("device_locks") { file }
+
+        prefs.edit().putString("lock_type", "hard").remove("lock_reason").apply()
+        assertEquals("hard", prefs.getString("lock_type", null))
+        assertNull(prefs.getString("lock_reason", null))
+        assertFalse(prefs.contains("lock_reason"))
+        assertEquals("soft", file.data["lock_type"])
+
+        prefs.edit().clear().putLong("lock_timestamp", 7L).apply()
+        assertNull(prefs.getString("lock_type", null))
+        assertEquals(7L, prefs.getLong("lock_timestamp", 0L))
+        assertEquals(mapOf("lock_timestamp" to 7L), prefs.all)
+    }
+
+    @Test
+    fun commitIsDurableAndMainThreadWaitIsRecorded() {
+        val coalescer = coalescer(onMain = true)
+        val file = FakeFile()
+        val prefs = coalescer.open("device_locks") { file }
+
+        prefs.edit().putString("lock_reason", "overdue").apply()
+        assertTrue(prefs.edit().putString("lock_type", "hard").commit())
+
+        // The commit carried the edit staged before it
+        assertEquals(1, file.rewrites)
+        assertEquals(mapOf("lock_reason" to "overdue", "lock_type" to "hard"), file.data)
+        assertEquals(1L, coalescer.mainThreadWaits.get())
+    }
+
+    @Test
+    fun failedCommitKeepsEditsStaged() {
+        val coalescer = coalescer()
+        val file = FakeFile()
+        val prefs = coalescer.open("device_locks") { file }
+
+        file.failNext = true
+        assertFalse(prefs.edit().putString("lock_type", "hard").commit())
+        assertEquals("hard", prefs.getString("lock_type", null))
+
+        assertTrue(coalescer.flush())
+        assertEquals("hard", file.data["lock_type"])
+        assertEquals(1L, coalescer.rewrites.get())
+    }
+}
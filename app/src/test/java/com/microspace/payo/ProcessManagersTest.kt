@@ -0,0 +1,99 @@
+﻿package com.microspace.payo
+
+import android.content.Context
+import com.microspace.payo.core.ProcessManagers
+import org.junit.Test
+import org.mockito.kotlin.doReturn
+import org.mockito.kotlin.mock
+import org.mockito.kotlin.whenever
+import kotlin.test.assertEquals
+import kotlin.test.assertNotSame
+import kotlin.test.assertSame
+
+/**
+ * Manager constructions per heartbeat and per lock transition, built at every call site (before)
+ * and through [ProcessManagers] (after). Stand-ins replace the managers, whose constructors need
+ * system services; the call-site lists mirror the production paths.
+ */
+class ProcessManagersTest {
+
+    private class ControlManager(val context: Context)
+    private class OwnerManager(val context: Context)
+    private class PrefsManager(val context: Context)
+    private class LockManager(val context: Context)
+    private class PaymentLock(val context: Context) {
+        // Like PaymentLockManager: asks for the managers it uses while being built
+        val prefs = ProcessManagers.get(context, PrefsManager::class.java, ::PrefsManager)
+        val lock = ProcessManagers.get(context, LockManager::class.java, ::LockManager)
+        val control = ProcessManagers.get(context, ControlManager::class.java, ::ControlManager)
+    }
+
+    private val app: Context = mock { on { applicationContext } doReturn it }
+
+    private fun get(name: String, context: Context = app): Any = when (name) {
+        "control" -> ProcessManagers.get(context, ControlManager::class.java, ::ControlManager)
+        "owner" -> ProcessManagers.get(context, OwnerManager::class.java, ::OwnerManager)
+        "prefs" -> ProcessManagers.get(context, PrefsManager::class.java, ::PrefsManager)
+        "paymentLock" -> ProcessManagers.get(context, PaymentLock::class.java, ::PaymentLock)
+        else -> error(name)
+    }
+
+    /** HeartbeatWorker: data collector (owner, prefs for IMEI and serial), response handler (control). */
+    private val heartbeat = listOf("owner", "prefs", "prefs", "control")
+
+    /** Grace expiry to lock screen: deadline engine (control), lock screen (payment lock, prefs). */
+    private val lockTransition = listOf("control", "paymentLock", "prefs")
+
+    /** Managers each call site builds when it constructs its own, PaymentLock's fields included. */
+    private fun builtDirectly(path: List<String>) =
+        path.flatMap { if (it == "paymentLock") listOf("paymentLock", "prefs", "lock", "control") else listOf(it) }.size
+
+    private fun builtThroughGraph(path: List<String>, runs: Int): Int {
+        val before = ProcessManagers.constructions().values.sum()
+        repeat(runs) { path.forEach { get(it) } }
+        return ProcessManagers.constructions().values.sum() - before
+    }
+
+    @Test
+    fun managersAreBuiltOncePerProcess() {
+        val runs = 10
+        val lockAfter = builtThroughGraph(lockTransition, runs)
+        val heartbeatAfter = builtThroughGraph(heartbeat, runs)
+        // Lock path builds all four; the heartbeat then only adds the owner manager
+        assertEquals(4, lockAfter)
+        assertEquals(1, heartbeatAfter)
+        assertEquals(40, builtDirectly(heartbeat) * runs)
+        assertEquals(60, builtDirectly(lockTransition) * runs)
+    }
+
+    // Separate stand-ins so the counts above do not depend on test order
+    private class AreaBound(val context: Context)
+    private class Composite(val context: Context) {
+        val part = ProcessManagers.get(context, AreaBound::class.java, ::AreaBound)
+    }
+
+    @Test
+    fun sharedByCallersAndSeparatePerStorageArea() {
+        val appDeviceProtected: Context = mock { on { isDeviceProtectedStorage } doReturn true }
+        whenever(app.createDeviceProtectedStorageContext()).thenReturn(appDeviceProtected)
+        val activity: Context = mock { on { applicationContext } doReturn app }
+        val boot: Context = mock {
+            on { isDeviceProtectedStorage } doReturn true
+            on { applicationContext } doReturn app
+        }
+
+        val fromActivity = ProcessManagers.get(activity, AreaBound::class.java, ::AreaBound)
+        assertSame(fromActivity, ProcessManagers.get(app, AreaBound::class.java, ::AreaBound))
+        // Bound to the application context, not the Activity that asked first
+        assertSame(app, fromActivity.context)
+
+        val fromBoot = ProcessManagers.get(boot, AreaBound::class.java, ::AreaBound)
+        assertNotSame(fromActivity, fromBoot)
+        assertSame(appDeviceProtected, fromBoot.context)
+        assertSame(fromBoot, ProcessManagers.get(appDeviceProtected, AreaBound::class.java, ::AreaBound))
+
+        val composite = ProcessManagers.get(activity, Composite::class.java, ::Composite)
+        assertSame(fromActivity, composite.part)
+        assertEquals(2, ProcessManagers.constructions()["AreaBound"])
+    }
+}
@@ -0,0 +1,181 @@
+﻿package com.microspace.payo
+
+import com.google.gson.Gson
+import com.microspace.payo.data.local.database.dao.command.RemoteCommandDao
+import com.microspace.payo.data.local.database.entities.command.RemoteCommandEntity
+import com.microspace.payo.data.models.heartbeat.HeartbeatResponse
+import com.microspace.payo.services.remote.RemoteCommandInbox
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.asCoroutineDispatcher
+import kotlinx.coroutines.runBlocking
+import kotlinx.coroutines.withTimeout
+import org.junit.After
+import org.junit.Test
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.CopyOnWriteArrayList
+import java.util.concurrent.Executors
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+/**
+ * Idempotency, crash replay and off-main execution of the remote command inbox, against an
+ * in-memory DAO with the same semantics as the Room queries.
+ */
+class RemoteCommandInboxTest {
+
+    private class InMemoryCommandDao : RemoteCommandDao {
+        val rows = ConcurrentHashMap<String, RemoteCommandEntity>()
+
+        override suspend fun insert(command: RemoteCommandEntity): Long =
+            if (rows.putIfAbsent(command.commandId, command) == null) rows.size.toLong() else -1L
+
+        override suspend fun getReceived() =
+            rows.values.filter { it.status == RemoteCommandEntity.STATUS_RECEIVED }.sortedBy { it.receivedAt }
+
+        override suspend fun markExecuted(commandId: String, success: Boolean, result: String, executedAt: Long) {
+            rows.computeIfPresent(commandId) { _, row ->
+                if (row.status != RemoteCommandEntity.STATUS_RECEIVED) row
+                else row.copy(status = RemoteCommandEntity.STATUS_EXECUTED, success = success, result = result, executedAt = executedAt)
+            }
+        }
+
+        override suspend fun getUnacknowledged(limit: Int) =
+            rows.values.filter { it.status == RemoteCommandEntity.STATUS_EXECUTED }.sortedBy { it.executedAt }.take(limit)
+
+        override suspend fun markAcknowledged(commandIds: List<String>, ackedAt: Long) {
+            for (id in commandIds) {
+                rows.computeIfPresent(id) { _, row ->
+                    if (row.status != RemoteCommandEntity.STATUS_EXECUTED) row
+                    else row.copy(status = RemoteCommandEntity.STATUS_ACKED, ackedAt = ackedAt)
+                }
+            }
+        }
+
+        override suspend fun deleteAcknowledgedOlderThan(beforeMillis: Long) {
+            rows.values.removeIf { it.status == RemoteCommandEntity.STATUS_ACKED && (it.ackedAt ?: 0) < beforeMillis }
+        }
+    }
+
+    private class RecordingHandler : RemoteCommandInbox.CommandHandler {
+        val executed = CopyOnWriteArrayList<String>()
+        val threads = CopyOnWriteArrayList<String>()
+        @Volatile var next = CompletableDeferred<Long>()
+
+        override suspend fun execute(command: RemoteCommandEntity): String {
+            executed.add(command.commandId)
+            threads.add(Thread.currentThread().name)
+            next.complete(System.nanoTime())
+            if (command.action == "explode") throw IllegalArgumentException("Unknown management action: explode")
+            return "${command.action} ok"
+        }
+    }
+
+    private val executor = Executors.newSingleThreadExecutor { r -> Thread(r, "remote-commands").apply { isDaemon = true } }
+    private val dispatcher = executor.asCoroutineDispatcher()
+
+    @After
+    fun tearDown() {
+        executor.shutdownNow()
+    }
+
+    private fun inbox(dao: RemoteCommandDao, handler: RemoteCommandInbox.CommandHandler) =
+        RemoteCommandInbox(dao, handler, dispatcher).also { it.start() }
+
+    /** Waits until the serial thread has gone idle, i.e. everything submitted so far was drained. */
+    private fun settle() {
+        repeat(2) { executor.submit {}.get() }
+    }
+
+    @Test
+    fun duplicateCommandIdExecutesOnce() = runBlocking {
+        val dao = InMemoryCommandDao()
+        val handler = RecordingHandler()
+        val inbox = inbox(dao, handler)
+
+        assertTrue(inbox.submit("cmd-1", "unlock", "paid"))
+        assertFalse(inbox.submit("cmd-1", "unlock", "paid"))
+        settle()
+        assertFalse(inbox.submit("cmd-1", "unlock", "paid"))
+        settle()
+
+        assertEquals(listOf("cmd-1"), handler.executed)
+        assertEquals(listOf("cmd-1"), inbox.pendingAcks().map { it.commandId })
+    }
+
+    @Test
+    fun heartbeatResponseCommandsRunOncePerId() = runBlocking {
+        val handler = RecordingHandler()
+        val inbox = inbox(InMemoryCommandDao(), handler)
+        val response = Gson().fromJson(
+            """{"success":true,"commands":[""" +
+                """{"command_id":"cmd-7","action":"hard_lock","reason":"overdue"},""" +
+                """{"action":"unlock","reason":"no id"},""" +
+                """{"command_id":"cmd-7","action":"hard_lock","reason":"redelivered"}]}""",
+            HeartbeatResponse::class.java
+        )
+
+        assertEquals(1, inbox.accept(response.commands!!))
+        settle()
+
+        assertEquals(listOf("cmd-7"), handler.executed)
+        assertEquals(listOf("cmd-7"), inbox.pendingAcks().map { it.commandId })
+    }
+
+    @Test
+    fun crashBeforeAckIsReplayedOnNextStart() = runBlocking {
+        val dao = InMemoryCommandDao()
+        // Previous process: one command persisted but never run, one run but never acknowledged
+        dao.insert(RemoteCommandEntity(commandId = "received", action = "soft_lock", reason = "overdue", receivedAt = 1))
+        dao.insert(
+            RemoteCommandEntity(
+                commandId = "executed", action = "unlock", reason = "paid", receivedAt = 0,
+                status = RemoteCommandEntity.STATUS_EXECUTED, executedAt = 2, success = true, result = "unlock ok"
+            )
+        )
+        val handler = RecordingHandler()
+        val inbox = inbox(dao, handler)
+        settle()
+
+        assertEquals(listOf("received"), handler.executed)
+        val acks = inbox.pendingAcks()
+        assertEquals(setOf("received", "executed"), acks.map { it.commandId }.toSet())
+        assertTrue(acks.all { it.success })
+
+        inbox.acknowledge(acks)
+        assertTrue(inbox.pendingAcks().isEmpty())
+        // Acknowledged IDs are still known, so a late duplicate is dropped
+        assertFalse(inbox.submit("executed", "unlock", "paid"))
+    }
+
+    @Test
+    fun failedCommandIsAcknowledgedAsFailure() = runBlocking {
+        val dao = InMemoryCommandDao()
+        val inbox = inbox(dao, RecordingHandler())
+
+        inbox.submit("bad", "explode", "")
+        settle()
+
+        val ack = inbox.pendingAcks().single()
+        assertFalse(ack.success)
+        assertEquals("Unknown management action: explode", ack.message)
+    }
+
+    @Test
+    fun executesOffCallerThreadWithLowLatency() = runBlocking {
+        val handler = RecordingHandler()
+        val inbox = inbox(InMemoryCommandDao(), handler)
+        settle()
+
+        val latencies = (1..20).map { i ->
+            handler.next = CompletableDeferred()
+            val submittedAt = System.nanoTime()
+            inbox.submit("cmd-$i", "status", "")
+            (withTimeout(1_000) { handler.next.await() } - submittedAt) / 1_000_000.0
+        }
+
+        assertTrue(handler.threads.all { it == "remote-commands" }, "ran on ${handler.threads.toSet()}")
+        val worst = latencies.max()
+        assertTrue(worst < 100.0, "submit->execute took ${worst}ms")
+    }
+}
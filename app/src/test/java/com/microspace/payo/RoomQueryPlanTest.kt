@@ -0,0 +1,365 @@
+﻿package com.microspace.payo
+
+import com.microspace.payo.data.local.database.AppDatabase
+import com.microspace.payo.data.local.database.DeviceOwnerDatabase
+import org.junit.Test
+import java.io.File
+import java.sql.Connection
+import java.sql.DriverManager
+import kotlin.test.assertTrue
+
+/**
+ * Query-plan gate for every Room DAO. The schemas are rebuilt from the entity sources (tables,
+ * Room-named indices) in in-memory SQLite, and every @Query runs through EXPLAIN QUERY PLAN
+ * against each database that exposes its DAO; DAOs no database exposes are checked against the
+ * entities they import. A SCAN fails the build unless the table is [TRIVIAL_TABLES], the scan
+ * walks an index under a LIMIT, or the query has an approved entry in [EXEMPTIONS]. The hottest
+ * queries are also timed on seeded large tables, with and without their indices.
+ */
+class RoomQueryPlanTest {
+
+    private val sources = File("src/main/java")
+        .walkTopDown()
+        .filter { it.isFile && it.extension == "kt" }
+        .map { it.readText().removePrefix("\uFEFF") }
+        .toList()
+
+    private class Column(val name: String, val affinity: String, val primaryKey: Boolean)
+
+    private class Table(val name: String, val columns: List<Column>, val indices: List<String>) {
+        fun create(): String {
+            val keys = columns.filter { it.primaryKey }.joinToString(", ") { "`${it.name}`" }
+            val defs = columns.joinToString(", ") { "`${it.name}` ${it.affinity}" }
+            return "CREATE TABLE `$name` ($defs" + (if (keys.isEmpty()) ")" else ", PRIMARY KEY($keys))")
+        }
+    }
+
+    private class Query(val dao: String, val method: String, val sql: String) {
+        val key get() = "$dao.$method"
+    }
+
+    /** A database (or, for an orphan DAO, the entities it imports) and the queries run against it. */
+    private class Schema(val name: String, val tables: List<Table>, val queries: List<Query>) {
+        fun open(withIndices: Boolean = true): Connection =
+            DriverManager.getConnection("jdbc:sqlite::memory:").also { conn ->
+                conn.createStatement().use { st ->
+                    tables.forEach { table ->
+                        st.execute(table.create())
+                        if (withIndices) table.indices.forEach(st::execute)
+                    }
+                }
+            }
+    }
+
+    // ---- Source parsing -------------------------------------------------------------------------
+
+    private fun stripComments(text: String) =
+        text.replace(Regex("""/\*.*?\*/""", RegexOption.DOT_MATCHES_ALL), "").replace(Regex("//[^\n]*"), "")
+
+    private fun packageOf(text: String) = Regex("""^\s*package\s+([\w.]+)""", RegexOption.MULTILINE).find(text)!!.groupValues[1]
+
+    private fun imports(text: String): Map<String, String> =
+        Regex("""^\s*import\s+([\w.]+)""", RegexOption.MULTILINE).findAll(text)
+            .associate { it.groupValues[1].substringAfterLast('.') to it.groupValues[1] }
+
+    /** Text between the parenthesis at [open] and its match. */
+    private fun balanced(text: String, open: Int): String {
+        var depth = 0
+        for (i in open until text.length) {
+            when (text[i]) {
+                '(' -> depth++
+                ')' -> if (--depth == 0) return text.substring(open + 1, i)
+            }
+        }
+        error("Unbalanced parentheses at $open")
+    }
+
+    private fun affinity(type: String) = when (type.removeSuffix("?")) {
+        "Int", "Long", "Short", "Byte", "Boolean" -> "INTEGER"
+        "Double", "Float" -> "REAL"
+        "ByteArray" -> "BLOB"
+        else -> "TEXT" // strings, enums and type-converted values
+    }
+
+    private val entities: Map<String, Table> by lazy {
+        val result = HashMap<String, Table>()
+        for (raw in sources) {
+            val text = stripComments(raw)
+            val at = Regex("""@Entity\b""").find(text) ?: continue
+            val afterAt = text.indexOf('(', at.range.last).takeIf { text.substring(at.range.last + 1, it).isBlank() }
+            val args = afterAt?.let { balanced(text, it) } ?: ""
+            val decl = Regex("""class\s+(\w+)\s*\(""").find(text, at.range.last)!!
+            val className = decl.groupValues[1]
+            val table = Regex("""tableName\s*=\s*"(\w+)"""").find(args)?.groupValues?.get(1) ?: className
+            val params = balanced(text, decl.range.last)
+
+            val columns = Regex("""((?:@[\w.]+(?:\([^)]*\))?\s*)*)\b(?:val|var)\s+(\w+)\s*:\s*([\w.?]+)""")
+                .findAll(params)
+                .map { m ->
+                    val annotations = m.groupValues[1]
+                    val name = Regex("""@ColumnInfo\([^)]*name\s*=\s*"(\w+)"""").find(annotations)?.groupValues?.get(1)
+                        ?: m.groupValues[2]
+                    Column(name, affinity(m.groupValues[3]), "@PrimaryKey" in annotations)
+                }
+                .toList()
+
+            val indices = Regex("""\bIndex\(([^)]*)\)""").findAll(args).map { m ->
+                val body = m.groupValues[1]
+                val explicit = Regex("""name\s*=\s*"(\w+)"""").find(body)?.groupValues?.get(1)
+                val cols = Regex(""""(\w+)"""").findAll(body.replace(Regex("""name\s*=\s*"\w+""""), ""))
+                    .map { it.groupValues[1] }.toList()
+                val unique = Regex("""unique\s*=\s*true""").containsMatchIn(body)
+                val name = explicit ?: "index_${table}_${cols.joinToString("_")}"
+                "CREATE ${if (unique) "UNIQUE " else ""}INDEX IF NOT EXISTS `$name` ON `$table` " +
+                    "(${cols.joinToString(", ") { "`$it`" }})"
+            }.toList()
+
+            result["${packageOf(text)}.$className"] = Table(table, columns, indices)
+        }
+        result
+    }
+
+    private val queryPattern = Regex(
+        """@Query\(\s*(?:""${'"'}(.*?)""${'"'}|"((?:[^"\\]|\\.)*)")\s*\)\s*(?:@\w+(?:\([^)]*\))?\s*)*(?:(?:suspend|abstract)\s+)*fun\s+(\w+)""",
+        RegexOption.DOT_MATCHES_ALL
+    )
+
+    private class Dao(val fqn: String, val entities: Set<String>, val queries: List<Query>, val declared: Int)
+
+    private val daos: Map<String, Dao> by lazy {
+        sources.filter { Regex("""^@Dao\b""", RegexOption.MULTILINE).containsMatchIn(it) }.associate { text ->
+            val name = Regex("""(?:interface|abstract\s+class)\s+(\w+)""").find(text)!!.groupValues[1]
+            val fqn = "${packageOf(text)}.$name"
+            val queries = queryPattern.findAll(text).map { m ->
+                val sql = (m.groups[1]?.value ?: m.groupValues[2]).trim().replace(Regex("""\s+"""), " ")
+                Query(name, m.groupValues[3], sql)
+            }.toList()
+            val declared = Regex("""@Query\(""").findAll(text).count()
+            fqn to Dao(fqn, imports(text).values.filter { it in entities }.toSet(), queries, declared)
+        }
+    }
+
+    private val schemas: List<Schema> by lazy {
+        val exposed = HashSet<String>()
+        val result = ArrayList<Schema>()
+        for (raw in sources) {
+            val text = stripComments(raw)
+            val at = Regex("""@Database\(""").find(text) ?: continue
+            val args = balanced(text, at.range.last)
+            val pkg = packageOf(text)
+            val imported = imports(text)
+            fun resolve(ref: String) = if ('.' in ref) ref else imported[ref] ?: "$pkg.$ref"
+
+            val tables = Regex("""(\w+)::class""").findAll(args.substringAfter("entities"))
+                .map { entities.getValue(resolve(it.groupValues[1])) }.toList()
+            val daoNames = Regex("""abstract\s+fun\s+\w+\(\)\s*:\s*([\w.]+)""").findAll(text)
+                .map { resolve(it.groupValues[1]) }.filter { it in daos }.toList()
+            exposed += daoNames
+            val dbName = Regex("""abstract\s+class\s+(\w+)""").find(text, at.range.first)!!.groupValues[1]
+            result += Schema("$pkg.$dbName", tables, daoNames.flatMap { daos.getValue(it).queries })
+        }
+        for ((fqn, dao) in daos) {
+            if (fqn in exposed || dao.queries.isEmpty()) continue
+            result += Schema("$fqn (no database)", dao.entities.map { entities.getValue(it) }, dao.queries)
+        }
+        result
+    }
+
+    // ---- Plans ----------------------------------------------------------------------------------
+
+    private fun bindable(sql: String) = sql.replace(Regex(""":\w+"""), "?")
+
+    private fun plan(conn: Connection, sql: String): List<String> =
+        conn.prepareStatement("EXPLAIN QUERY PLAN ${bindable(sql)}").use { st ->
+            for (i in 1..st.parameterMetaData.parameterCount) st.setObject(i, null)
+            st.executeQuery().use { rs -> generateSequence { if (rs.next()) rs.getString("detail") else null }.toList() }
+        }
+
+    private val limited = Regex("""\bLIMIT\b""", RegexOption.IGNORE_CASE)
+
+    /** SCAN steps that read a non-trivial table row by row. */
+    private fun scans(sql: String, plan: List<String>) = plan.filter { step ->
+        step.startsWith("SCAN ") &&
+            step.split(' ')[1] !in TRIVIAL_TABLES &&
+            // An index walked in order and cut off by LIMIT reads only the rows it returns
+            !(" INDEX " in step && limited.containsMatchIn(sql))
+    }
+
+    private fun scanningQueries(): Map<Query, List<String>> {
+        val result = LinkedHashMap<Query, List<String>>()
+        for (schema in schemas) {
+            schema.open().use { conn ->
+                for (query in schema.queries) {
+                    val steps = scans(query.sql, plan(conn, query.sql))
+                    if (steps.isNotEmpty()) result[query] = steps.map { "${schema.name.substringAfterLast('.')}: $it" }
+                }
+            }
+        }
+        return result
+    }
+
+    @Test
+    fun everyDaoQueryIsCovered() {
+        assertTrue(schemas.size >= 3, "Expected the Room databases in the sources, found ${schemas.map { it.name }}")
+        val unparsed = daos.values.filter { it.queries.size != it.declared }.map { it.fqn }
+        assertTrue(unparsed.isEmpty(), "@Query declarations the gate could not parse in: $unparsed")
+        assertTrue(daos.values.sumOf { it.queries.size } >= 100, "Too few DAO queries found under src/main/java")
+    }
+
+    @Test
+    fun daoQueriesDoNotScanLargeTables() {
+        val violations = scanningQueries().filterKeys { it.key !in EXEMPTIONS }
+        assertTrue(
+            violations.isEmpty(),
+            "Full-table scans; add an index, or an exemption with its reason:\n" +
+                violations.entries.joinToString("\n") { (q, steps) -> "  ${q.key}: ${q.sql}\n    $steps" }
+        )
+    }
+
+    @Test
+    fun exemptionsAreStillNeeded() {
+        val scanning = scanningQueries().keys.map { it.key }.toSet()
+        val stale = EXEMPTIONS.keys - scanning
+        assertTrue(stale.isEmpty(), "Exempted queries that no longer scan or no longer exist: $stale")
+    }
+
+    @Test
+    fun migrationsCreateTheDeclaredIndices() {
+        val declared = entities.values.flatMap { it.indices }.toSet()
+        val undeclared = (DeviceOwnerDatabase.V16_INDICES + DeviceOwnerDatabase.V18_INDICES + DeviceOwnerDatabase.V19_INDICES + AppDatabase.V2_INDICES).filterNot { it in declared }
+        assertTrue(undeclared.isEmpty(), "Migration indices that no entity declares (Room would reject the schema): $undeclared")
+    }
+
+    // ---- Seeded timing --------------------------------------------------------------------------
+
+    private class HotQuery(
+        val key: String,
+        val args: List<Any?> = emptyList(),
+        val seed: Map<String, (Int) -> Any?> = emptyMap()
+    )
+
+    private fun seed(conn: Connection, table: Table, values: Map<String, (Int) -> Any?>) {
+        conn.autoCommit = false
+        val cols = table.columns
+        conn.prepareStatement(
+            "INSERT INTO `${table.name}` (${cols.joinToString { "`${it.name}`" }}) VALUES (${cols.joinToString { "?" }})"
+        ).use { st ->
+            for (i in 0 until SEEDED_ROWS) {
+                cols.forEachIndexed { c, col ->
+                    val value = values[col.name]?.invoke(i) ?: when (col.affinity) {
+                        "INTEGER" -> i.toLong()
+                        "REAL" -> i.toDouble()
+                        else -> "v$i"
+                    }
+                    st.setObject(c + 1, value)
+                }
+                st.addBatch()
+            }
+            st.executeBatch()
+        }
+        conn.commit()
+        conn.autoCommit = true
+    }
+
+    /** Median run time in microseconds, reading every returned row. */
+    private fun time(conn: Connection, sql: String, args: List<Any?>): Long {
+        val runs = LongArray(TIMED_RUNS)
+        conn.prepareStatement(bindable(sql)).use { st ->
+            args.forEachIndexed { i, arg -> st.setObject(i + 1, arg) }
+            repeat(WARMUP_RUNS + TIMED_RUNS) { run ->
+                val start = System.nanoTime()
+                st.executeQuery().use { rs -> while (rs.next()) rs.getObject(1) }
+                if (run >= WARMUP_RUNS) runs[run - WARMUP_RUNS] = (System.nanoTime() - start) / 1_000
+            }
+        }
+        return runs.sorted()[TIMED_RUNS / 2]
+    }
+
+    @Test
+    fun hotQueriesStayFastOnLargeTables() {
+        val report = StringBuilder()
+        for (hot in HOT_QUERIES) {
+            val (schema, query) = schemas.firstNotNullOf { s -> s.queries.find { it.key == hot.key }?.let { s to it } }
+            val table = schema.tables.first { Regex("""\b${it.name}\b""").containsMatchIn(query.sql) }
+            val indexed = schema.open().use { conn ->
+                seed(conn, table, hot.seed)
+                time(conn, query.sql, hot.args)
+            }
+            val bare = schema.open(withIndices = false).use { conn ->
+                seed(conn, table, hot.seed)
+                time(conn, query.sql, hot.args)
+            }
+            report.append("  ${hot.key}: ${indexed}us indexed, ${bare}us without indices\n")
+            assertTrue(indexed <= MAX_HOT_QUERY_US, "${hot.key} took ${indexed}us on $SEEDED_ROWS rows\n$report")
+            assertTrue(indexed * 10 <= bare, "${hot.key} gains too little from its index\n$report")
+        }
+    }
+
+    companion object {
+        private const val SEEDED_ROWS = 50_000
+        private const val WARMUP_RUNS = 5
+        private const val TIMED_RUNS = 21
+        private const val MAX_HOT_QUERY_US = 2_000L
+
+        /** At most one row per enrolment, so a scan costs no more than a lookup. */
+        private val TRIVIAL_TABLES = setOf(
+            "payment_state",
+            "device_registrations",
+            "complete_device_registrations",
+            "device_baselines"
+        )
+
+        private const val WHOLE_TABLE = "returns every row by design; bounded by retention, not by an index"
+        private const val COUNT = "unfiltered count or aggregate over the table; walks the smallest index"
+        private const val FLAG = "history view filtered on a boolean flag; an index on a flag would not be selective"
+
+        /** Approved scans, by Dao.method. */
+        private val EXEMPTIONS = mapOf(
+            "HeartbeatDao.getAllHeartbeats" to WHOLE_TABLE,
+            "DeviceDataDao.getAllDeviceData" to WHOLE_TABLE,
+            "DeviceDataDao.getAllDeviceDataFlow" to WHOLE_TABLE,
+            "DeviceDataDao.getLockedDevices" to FLAG,
+            "DeviceDataDao.getLockedDevicesFlow" to FLAG,
+            "DeviceDataDao.countDeviceData" to COUNT,
+            "HeartbeatHistoryDao.getAllHeartbeats" to WHOLE_TABLE,
+            "HeartbeatHistoryDao.getAllHeartbeatsFlow" to WHOLE_TABLE,
+            "HeartbeatHistoryDao.getHeartbeatsWithMismatches" to FLAG,
+            "HeartbeatHistoryDao.getHeartbeatsWithMismatchesFlow" to FLAG,
+            "HeartbeatHistoryDao.getLockedHeartbeats" to FLAG,
+            "HeartbeatHistoryDao.getLockedHeartbeatsFlow" to FLAG,
+            "HeartbeatHistoryDao.countAllHeartbeats" to COUNT,
+            "HeartbeatResponseDao.getAllFlow" to WHOLE_TABLE,
+            "HeartbeatResponseDao.getLockedResponses" to FLAG,
+            "HeartbeatResponseDao.getDeactivationResponses" to FLAG,
+            "HeartbeatResponseDao.getSoftlockResponses" to FLAG,
+            "HeartbeatResponseDao.getHardlockResponses" to FLAG,
+            "HeartbeatResponseDao.getTamperResponses" to FLAG,
+            "HeartbeatResponseDao.getWithPaymentInfo" to FLAG,
+            "HeartbeatResponseDao.getWithUnlockPassword" to FLAG,
+            "HeartbeatResponseDao.getCount" to COUNT,
+            "HeartbeatResponseDao.getLockedCount" to COUNT,
+            "HeartbeatResponseDao.getDeactivationCount" to COUNT,
+            "HeartbeatResponseDao.getStatistics" to COUNT,
+            "OfflineEventDao.getAllEvents" to "the sync worker drains the whole queue in order",
+            "OfflineEventDao.getEventCount" to COUNT,
+            "SimChangeHistoryDao.getAll" to WHOLE_TABLE,
+            "SimChangeHistoryDao.getChangeCount" to COUNT
+        )
+
+        // One due row in 500: the shape of a queue that is mostly synced
+        private val HOT_QUERIES = listOf(
+            HotQuery(
+                "LockEventDao.getPendingLockEvents",
+                args = listOf("PENDING", 50),
+                seed = mapOf("syncStatus" to { i -> if (i % 500 == 0) "PENDING" else "SYNCED" })
+            ),
+            HotQuery(
+                "TamperDetectionDao.getPendingSyncTamperDetections",
+                seed = mapOf("syncStatus" to { i -> if (i % 500 == 0) "pending" else "synced" })
+            ),
+            HotQuery("HeartbeatResponseDao.getLatest"),
+            HotQuery("HeartbeatResponseDao.getUnprocessed", seed = mapOf("processed" to { i -> if (i % 500 == 0) 0 else 1 })),
+            HotQuery("DeviceDataDao.getDeviceDataByServerDeviceId", args = listOf("v${SEEDED_ROWS / 2}"))
+        )
+    }
+}
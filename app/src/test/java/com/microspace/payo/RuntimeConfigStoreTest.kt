@@ -0,0 +1,162 @@
+﻿package com.microspace.payo
+
+import android.content.Context
+import com.google.gson.Gson
+import com.microspace.payo.config.RuntimeConfig
+import com.microspace.payo.config.RuntimeConfigStore
+import com.microspace.payo.config.SignedConfigBlob
+import com.microspace.payo.security.crypto.SignedPayloadVerifier
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.flow.first
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.runBlocking
+import kotlinx.coroutines.withTimeout
+import org.junit.Rule
+import org.junit.Test
+import org.junit.rules.TemporaryFolder
+import org.mockito.kotlin.doReturn
+import org.mockito.kotlin.mock
+import java.io.File
+import java.security.KeyPair
+import java.security.KeyPairGenerator
+import java.security.PrivateKey
+import java.security.Signature
+import java.security.spec.ECGenParameterSpec
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertIs
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+/**
+ * Validation, rollback and propagation of the server-driven runtime config.
+ */
+class RuntimeConfigStoreTest {
+
+    @get:Rule
+    val tmp = TemporaryFolder()
+
+    private val serverKeys = keyPair()
+    private val verifier = SignedPayloadVerifier(serverKeys.public)
+
+    private fun keyPair(): KeyPair = KeyPairGenerator.getInstance("EC")
+        .apply { initialize(ECGenParameterSpec("secp256r1")) }
+        .generateKeyPair()
+
+    private fun sign(payload: String, privateKey: PrivateKey): String =
+        Signature.getInstance(SignedPayloadVerifier.ALGORITHM).run {
+            initSign(privateKey)
+            update(payload.toByteArray())
+            sign().joinToString("") { "%02x".format(it) }
+        }
+
+    private fun blob(payload: String, signWith: PrivateKey = serverKeys.private) =
+        SignedConfigBlob(payload, sign(payload, signWith))
+
+    @Test
+    fun defaultsAreValid() {
+        assertTrue(RuntimeConfig.DEFAULTS.validate().isEmpty())
+    }
+
+    @Test
+    fun outOfRangeValuesAreReported() {
+        val errors = RuntimeConfig(heartbeatIntervalMs = 500L, offlineSyncBatchSize = 0).validate()
+        assertEquals(2, errors.size)
+    }
+
+    @Test
+    fun validBlobOverridesOnlyGivenFields() {
+        val outcome = RuntimeConfigStore.resolve(
+            RuntimeConfig.DEFAULTS,
+            blob("""{"version":3,"heartbeat_interval_ms":30000}"""),
+            verifier
+        )
+        val accepted = assertIs<RuntimeConfigStore.Outcome.Accepted>(outcome)
+        assertEquals(30_000L, accepted.config.heartbeatIntervalMs)
+        assertEquals(RuntimeConfig.DEFAULTS.offlineSyncBatchSize, accepted.config.offlineSyncBatchSize)
+    }
+
+    @Test
+    fun badSignatureStaleVersionAndUnsafeValuesAreRejected() {
+        val active = RuntimeConfig.DEFAULTS.copy(version = 5)
+        val forged = blob("""{"version":6,"heartbeat_interval_ms":30000}""", keyPair().private)
+        val tampered = blob("""{"version":6,"heartbeat_interval_ms":30000}""").copy(
+            payload = """{"version":6,"heartbeat_interval_ms":5000}"""
+        )
+        val stale = blob("""{"version":5,"heartbeat_interval_ms":30000}""")
+        val unsafe = blob("""{"version":6,"heartbeat_interval_ms":100}""")
+        val garbage = blob("""not json""")
+
+        listOf(forged, tampered, stale, unsafe, garbage).forEach {
+            assertIs<RuntimeConfigStore.Outcome.Rejected>(RuntimeConfigStore.resolve(active, it, verifier))
+        }
+    }
+
+    @Test
+    fun corruptedPersistedConfigRollsBackToDefaults() {
+        val file = File(tmp.root, "runtime_config.json")
+        file.writeText("""{"payload":"{\"version\":2,\"heartbeat_interval_ms\":30000}","signature":"deadbeef"}""")
+        assertEquals(RuntimeConfig.DEFAULTS, RuntimeConfigStore.restore(file, verifier))
+
+        file.writeText("{truncated")
+        assertEquals(RuntimeConfig.DEFAULTS, RuntimeConfigStore.restore(file, verifier))
+    }
+
+    @Test
+    fun persistedConfigSurvivesRestart() {
+        val file = File(tmp.root, "runtime_config.json")
+        val payload = """{"version":2,"removal_check_interval_ms":10000}"""
+        assertTrue(RuntimeConfigStore.persistAtomically(file, Gson().toJson(blob(payload))))
+        assertEquals(10_000L, RuntimeConfigStore.restore(file, verifier).removalCheckIntervalMs)
+        assertTrue(!File(tmp.root, "runtime_config.json.tmp").exists())
+    }
+
+    @Test
+    fun pushesAreIgnoredWhileNoServerKeyIsPinned() {
+        val appContext = mock<Context> {
+            on { filesDir } doReturn tmp.root
+        }
+        val context = mock<Context> {
+            on { applicationContext } doReturn appContext
+        }
+        RuntimeConfigStore.verifier = null
+        try {
+            assertNull(SignedPayloadVerifier.server)
+            val before = RuntimeConfigStore.also { it.init(context) }.current
+            assertFalse(RuntimeConfigStore.apply(context, blob("""{"version":${before.version + 1}}""")))
+            assertEquals(before, RuntimeConfigStore.current)
+        } finally {
+            RuntimeConfigStore.verifier = verifier
+        }
+    }
+
+    @Test
+    fun appliedConfigReachesCollectorsPromptly() = runBlocking {
+        val appContext = mock<Context> {
+            on { filesDir } doReturn tmp.root
+        }
+        val context = mock<Context> {
+            on { applicationContext } doReturn appContext
+        }
+        RuntimeConfigStore.verifier = verifier
+        RuntimeConfigStore.init(context)
+
+        val next = RuntimeConfigStore.current.version + 1
+        val seenAt = CompletableDeferred<Long>()
+        val collector = launch(Dispatchers.Default) {
+            RuntimeConfigStore.config.first { it.version == next }
+            seenAt.complete(System.nanoTime())
+        }
+        delay(50)
+
+        val start = System.nanoTime()
+        assertTrue(RuntimeConfigStore.apply(context, blob("""{"version":$next,"heartbeat_interval_ms":20000}""")))
+        val latencyMs = (withTimeout(1_000) { seenAt.await() } - start) / 1_000_000
+        collector.cancel()
+
+        assertEquals(20_000L, RuntimeConfigStore.current.heartbeatIntervalMs)
+        assertTrue(latencyMs < 100, "propagation took ${latencyMs}ms")
+    }
+}
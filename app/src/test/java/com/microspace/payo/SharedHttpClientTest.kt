@@ -0,0 +1,187 @@
+﻿package com.microspace.payo
+
+import com.microspace.payo.data.remote.api.CachingDns
+import com.microspace.payo.data.remote.api.SharedHttpClient
+import okhttp3.CertificatePinner
+import okhttp3.ConnectionSpec
+import okhttp3.Dns
+import okhttp3.OkHttpClient
+import okhttp3.Request
+import okhttp3.TlsVersion
+import okhttp3.mockwebserver.MockResponse
+import okhttp3.mockwebserver.MockWebServer
+import okhttp3.tls.HandshakeCertificates
+import okhttp3.tls.HeldCertificate
+import org.junit.After
+import org.junit.Before
+import org.junit.Test
+import java.io.File
+import java.net.InetAddress
+import java.net.UnknownHostException
+import java.util.concurrent.TimeUnit
+import javax.net.ssl.SSLSocket
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+/**
+ * Connection and TLS session reuse across ApiClient-style clients derived from the shared base,
+ * against a MockWebServer with a pinned test certificate, plus the DNS cache's TTL,
+ * stale-while-revalidate and persistence behaviour.
+ */
+class SharedHttpClientTest {
+
+    private class CountingDns(var addresses: List<InetAddress>) : Dns {
+        var lookups = 0
+        var fail = false
+
+        override fun lookup(hostname: String): List<InetAddress> {
+            lookups++
+            if (fail) throw UnknownHostException(hostname)
+            return addresses
+        }
+    }
+
+    private val server = MockWebServer()
+    private lateinit var clientCerts: HandshakeCertificates
+    private lateinit var pinner: CertificatePinner
+    private val verifier = javax.net.ssl.HostnameVerifier { hostname, _ -> hostname == server.hostName }
+
+    @Before
+    fun setUp() {
+        server.start()
+        val root = HeldCertificate.Builder().certificateAuthority(0).build()
+        val leaf = HeldCertificate.Builder().signedBy(root).addSubjectAlternativeName(server.hostName).build()
+        server.useHttps(HandshakeCertificates.Builder().heldCertificate(leaf).build().sslSocketFactory(), false)
+        clientCerts = HandshakeCertificates.Builder().addTrustedCertificate(root.certificate).build()
+        pinner = CertificatePinner.Builder().add(server.hostName, CertificatePinner.pin(leaf.certificate)).build()
+    }
+
+    @After
+    fun tearDown() {
+        server.shutdown()
+    }
+
+    private fun base(dns: Dns = Dns.SYSTEM) = SharedHttpClient.buildBase(
+        clientCerts.trustManager, verifier, pinner, CachingDns(dns, 60_000, 60_000, { it.run() }, null)
+    )
+
+    /** What each ApiClient instance does: per-instance timeouts and interceptors on the shared base. */
+    private fun apiClient(base: OkHttpClient) = base.newBuilder()
+        .connectTimeout(10, TimeUnit.SECONDS)
+        .addInterceptor { chain -> chain.proceed(chain.request().newBuilder().header("X-Device-Api-Key", "k").build()) }
+        .build()
+
+    private fun get(client: OkHttpClient, path: String = "/api/devices/dev/data/"): ByteArray? {
+        var sessionId: ByteArray? = null
+        val probe = client.newBuilder().addNetworkInterceptor { chain ->
+            sessionId = (chain.connection()?.socket() as? SSLSocket)?.session?.id
+            chain.proceed(chain.request())
+        }.build()
+        probe.newCall(Request.Builder().url(server.url(path)).build()).execute().use { it.body?.string() }
+        return sessionId
+    }
+
+    @Test
+    fun newClientInstancesReuseThePooledConnection() {
+        repeat(3) { server.enqueue(MockResponse().setBody("{}")) }
+        val base = base()
+        val reusedBefore = SharedHttpClient.stats.reusedConnections.get()
+
+        get(apiClient(base))
+        get(apiClient(base))
+        get(apiClient(base))
+
+        val first = server.takeRequest()
+        assertEquals(0, first.sequenceNumber)
+        assertEquals("k", first.getHeader("X-Device-Api-Key"))
+        assertEquals(1, server.takeRequest().sequenceNumber)
+        assertEquals(2, server.takeRequest().sequenceNumber)
+        assertTrue(SharedHttpClient.stats.reusedConnections.get() - reusedBefore >= 2)
+    }
+
+    @Test
+    fun newConnectionResumesTheTlsSession() {
+        repeat(3) { server.enqueue(MockResponse().setBody("{}")) }
+        // TLS 1.2 so a resumed session is observable as the same session ID
+        val tls12 = ConnectionSpec.Builder(ConnectionSpec.MODERN_TLS).tlsVersions(TlsVersion.TLS_1_2).build()
+        val base = base().newBuilder().connectionSpecs(listOf(tls12)).build()
+
+        val first = get(apiClient(base))
+        base.connectionPool.evictAll() // keep-alive lost (network change, idle timeout)
+        val resumed = get(apiClient(base))
+        server.takeRequest()
+        assertEquals(0, server.takeRequest().sequenceNumber, "expected a new connection after eviction")
+        assertTrue(first != null && first.isNotEmpty())
+        assertContentEquals(first, resumed)
+
+        // Control: a client with its own SSLContext, as every ApiClient used to have, starts over
+        val cold = get(base(Dns.SYSTEM).newBuilder().connectionSpecs(listOf(tls12)).build())
+        assertFalse(first.contentEquals(cold))
+    }
+
+    @Test
+    fun prewarmLeavesAnIdleConnectionForTheNextBeat() {
+        server.enqueue(MockResponse())
+        server.enqueue(MockResponse().setBody("{}"))
+        val base = base()
+
+        SharedHttpClient.prewarm(base, server.url("/").toString())
+        assertEquals("HEAD", server.takeRequest(5, TimeUnit.SECONDS)?.method)
+        val deadline = System.currentTimeMillis() + 5_000
+        while (base.connectionPool.idleConnectionCount() == 0 && System.currentTimeMillis() < deadline) Thread.sleep(5)
+
+        // Already warm: no second pre-warm request
+        SharedHttpClient.prewarm(base, server.url("/").toString())
+        get(apiClient(base))
+        val beat = server.takeRequest()
+        assertEquals("GET", beat.method)
+        assertEquals(1, beat.sequenceNumber)
+    }
+
+    @Test
+    fun servesStaleWhileRevalidatingAndFallsBackOnFailure() {
+        val a = InetAddress.getByAddress("payoplan.com", byteArrayOf(10, 0, 0, 1))
+        val b = InetAddress.getByAddress("payoplan.com", byteArrayOf(10, 0, 0, 2))
+        val upstream = CountingDns(listOf(a))
+        val pending = ArrayDeque<Runnable>()
+        var now = 0L
+        val dns = CachingDns(upstream, 1_000, 10_000, { pending.add(it) }, null) { now }
+
+        assertEquals(listOf(a), dns.lookup("payoplan.com"))
+        now = 500
+        assertEquals(listOf(a), dns.lookup("PayoPlan.com"))
+        assertEquals(1, upstream.lookups)
+
+        // Expired: the caller gets the old answer immediately, one refresh is queued
+        upstream.addresses = listOf(b)
+        now = 2_000
+        assertEquals(listOf(a), dns.lookup("payoplan.com"))
+        assertEquals(listOf(a), dns.lookup("payoplan.com"))
+        assertEquals(1, upstream.lookups)
+        while (pending.isNotEmpty()) pending.removeFirst().run()
+        assertEquals(2, upstream.lookups)
+        assertEquals(listOf(b), dns.lookup("payoplan.com"))
+
+        // Past the stale window with the resolver down: last known addresses rather than a failure
+        upstream.fail = true
+        now = 20_000
+        assertEquals(listOf(b), dns.lookup("payoplan.com"))
+    }
+
+    @Test
+    fun cacheSurvivesRestart() {
+        val store = File.createTempFile("dns", ".tsv").apply { delete(); deleteOnExit() }
+        val address = InetAddress.getByAddress("api.payoplan.com", byteArrayOf(10, 1, 2, 3))
+        val upstream = CountingDns(listOf(address))
+        CachingDns(upstream, 60_000, 60_000, { it.run() }, store) { 0L }.lookup("api.payoplan.com")
+
+        val restarted = CountingDns(emptyList()).apply { fail = true }
+        val cached = CachingDns(restarted, 60_000, 60_000, { it.run() }, store) { 1_000L }.lookup("api.payoplan.com")
+
+        assertEquals(listOf(address), cached)
+        assertEquals("api.payoplan.com", cached.single().hostName)
+        assertEquals(0, restarted.lookups)
+    }
+}
@@ -0,0 +1,166 @@
+﻿package com.microspace.payo
+
+import android.telephony.TelephonyManager
+import com.microspace.payo.data.local.database.entities.sim.SimChangeHistoryEntity
+import com.microspace.payo.security.monitoring.sim.SimSnapshot
+import com.microspace.payo.security.monitoring.sim.SimStateTracker
+import kotlinx.coroutines.CoroutineStart
+import kotlinx.coroutines.async
+import kotlinx.coroutines.asCoroutineDispatcher
+import kotlinx.coroutines.flow.first
+import kotlinx.coroutines.flow.take
+import kotlinx.coroutines.flow.toList
+import kotlinx.coroutines.runBlocking
+import kotlinx.coroutines.withTimeout
+import org.junit.After
+import org.junit.Test
+import java.util.concurrent.CopyOnWriteArrayList
+import java.util.concurrent.Executors
+import kotlin.test.assertEquals
+import kotlin.test.assertNotNull
+import kotlin.test.assertNull
+
+/**
+ * Edge detection for the event-driven SIM tracker, and the path from a platform SIM event to
+ * an emission on [SimStateTracker.changes] through a fake subscription source.
+ */
+class SimStateTrackerTest {
+
+    /** Stands in for the telephony callbacks: [fire] is a SIM_STATE_CHANGED or subscription event. */
+    private class FakeSource(@Volatile var current: SimSnapshot) : SimStateTracker.Source {
+        private var onChange: (() -> Unit)? = null
+
+        override fun register(onChange: () -> Unit) {
+            this.onChange = onChange
+        }
+
+        override fun read(): SimSnapshot = current
+
+        fun fire() = onChange!!.invoke()
+    }
+
+    private class InMemoryHistory : SimStateTracker.History {
+        val rows = CopyOnWriteArrayList<SimChangeHistoryEntity>()
+        override suspend fun latest() = rows.lastOrNull()
+        override suspend fun append(row: SimChangeHistoryEntity) {
+            rows += row
+        }
+    }
+
+    private val executor = Executors.newSingleThreadExecutor { r -> Thread(r, "sim").apply { isDaemon = true } }
+
+    @After
+    fun tearDown() {
+        executor.shutdownNow()
+    }
+
+    private fun awaitRows(history: InMemoryHistory, count: Int) {
+        val deadline = System.currentTimeMillis() + 5_000
+        while (history.rows.size < count) {
+            check(System.currentTimeMillis() < deadline) { "Timed out waiting for $count history rows" }
+            Thread.sleep(5)
+        }
+    }
+
+    private fun snapshot(
+        state: Int = TelephonyManager.SIM_STATE_READY,
+        operator: String = "Vodacom",
+        serial: String = "8925501",
+        number: String = "+255700000001"
+    ) = SimSnapshot(state, operator, serial, number, listOf(1), 0L)
+
+    private fun row(operator: String = "Vodacom", serial: String = "8925501") = SimChangeHistoryEntity(
+        originalPhoneNumber = "INITIAL",
+        newPhoneNumber = "+255700000001",
+        originalOperator = "INITIAL",
+        newOperator = operator,
+        originalSerial = "INITIAL",
+        newSerial = serial,
+        changedAt = 1L
+    )
+
+    @Test
+    fun firstStableSnapshotSeedsInitialRow() {
+        val edge = SimStateTracker.detectEdge(null, snapshot(), now = 5L)
+        assertNotNull(edge)
+        assertEquals("INITIAL", edge.originalOperator)
+        assertEquals("Vodacom", edge.newOperator)
+    }
+
+    @Test
+    fun sameSimProducesNoRow() {
+        assertNull(SimStateTracker.detectEdge(row(), snapshot()))
+    }
+
+    @Test
+    fun phoneNumberAloneIsNotAnEdge() {
+        assertNull(SimStateTracker.detectEdge(row(), snapshot(number = "Unknown")))
+    }
+
+    @Test
+    fun carrierNameAloneIsNotAnEdge() {
+        // Roaming or re-registration renames the carrier; the SIM is the same
+        assertNull(SimStateTracker.detectEdge(row(), snapshot(operator = "Vodacom Roaming")))
+    }
+
+    @Test
+    fun swappedSerialIsAnEdge() {
+        val edge = SimStateTracker.detectEdge(row(), snapshot(operator = "Airtel", serial = "8925502"))
+        assertNotNull(edge)
+        assertEquals("Vodacom", edge.originalOperator)
+        assertEquals("8925502", edge.newSerial)
+    }
+
+    @Test
+    fun removalIsAnEdge() {
+        val absent = snapshot(state = TelephonyManager.SIM_STATE_ABSENT, operator = "", serial = "", number = "")
+        assertNotNull(SimStateTracker.detectEdge(row(), absent))
+    }
+
+    @Test
+    fun transientLoadingStatesAreIgnored() {
+        val loading = snapshot(state = TelephonyManager.SIM_STATE_NOT_READY, operator = "", serial = "")
+        assertNull(SimStateTracker.detectEdge(row(), loading))
+        assertNull(SimStateTracker.detectEdge(null, loading))
+    }
+
+    @Test
+    fun simSwapEventIsEmittedOnChanges() = runBlocking {
+        val source = FakeSource(snapshot())
+        val history = InMemoryHistory()
+        val tracker = SimStateTracker(source, history, executor.asCoroutineDispatcher())
+        tracker.start()
+        awaitRows(history, 1) // INITIAL seed, not an edge
+
+        val change = async(start = CoroutineStart.UNDISPATCHED) { withTimeout(5_000) { tracker.changes.first() } }
+        source.current = snapshot(operator = "Airtel", serial = "8925502")
+        source.fire()
+
+        val event = change.await()
+        assertEquals("Vodacom", event.record.originalOperator)
+        assertEquals("Airtel", event.snapshot.operator)
+        assertEquals(2, history.rows.size)
+        assertEquals("Airtel", tracker.snapshot.value.operator)
+    }
+
+    @Test
+    fun eventsWithoutAnIdentityChangeEmitNothing() = runBlocking {
+        val source = FakeSource(snapshot())
+        val history = InMemoryHistory()
+        val tracker = SimStateTracker(source, history, executor.asCoroutineDispatcher())
+        tracker.start()
+        awaitRows(history, 1)
+
+        val emitted = async(start = CoroutineStart.UNDISPATCHED) { withTimeout(5_000) { tracker.changes.take(1).toList() } }
+        // A burst of platform events for the same SIM, then the loading state of a new one
+        repeat(5) { source.fire() }
+        source.current = snapshot(state = TelephonyManager.SIM_STATE_NOT_READY, operator = "", serial = "")
+        source.fire()
+        // Only the ready SIM is an edge
+        source.current = snapshot(operator = "Airtel", serial = "8925502")
+        source.fire()
+
+        assertEquals(listOf("Airtel"), emitted.await().map { it.snapshot.operator })
+        assertEquals(2, history.rows.size)
+    }
+}
@@ -0,0 +1,152 @@
+﻿package com.microspace.payo
+
+import com.microspace.payo.core.watchdog.SlowOperationReport
+import com.microspace.payo.core.watchdog.SlowOperationWatchdog
+import com.microspace.payo.core.watchdog.SlowOperationWatchdog.Kind
+import kotlinx.coroutines.Dispatchers
+import org.junit.Test
+import java.io.File
+import java.nio.file.Files
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+/**
+ * Aggregation of the slow-operation report, and the watchdog recording a blocking main-thread call
+ * with its call site while ignoring fast, off-main and disabled ones. JVM stand-in for an
+ * instrumented StrictMode check: the main thread and clock are injected.
+ */
+class SlowOperationWatchdogTest {
+
+    private var nowNs = 0L
+    private var onMain = true
+
+    private fun watchdog(enabled: Boolean = true, file: File? = null) =
+        SlowOperationWatchdog(Dispatchers.Unconfined, { nowNs }, { onMain }).also { if (enabled) it.enable(file) }
+
+    private fun advanceMs(ms: Long) {
+        nowNs += ms * 1_000_000
+    }
+
+    @Test
+    fun `report aggregates per site and sorts by total time`() {
+        val report = SlowOperationReport()
+        report.add(Kind.DISK, "prefs.open", "A.kt:1", 20, "main")
+        report.add(Kind.DISK, "prefs.open", "A.kt:1", 50, "main")
+        report.add(Kind.BINDER, "dpm.isDeviceOwnerApp", "B.kt:2", 100, "main")
+        report.add(Kind.DISK, "prefs.open", "A.kt:1", 40, "binder:1")
+
+        val entries = report.entries()
+        assertEquals(listOf("B.kt:2", "A.kt:1"), entries.map { it.callSite })
+        val disk = entries[1]
+        assertEquals(3, disk.count)
+        assertEquals(110, disk.totalMs)
+        assertEquals(50, disk.maxMs)
+        assertEquals(setOf("main", "binder:1"), disk.threads)
+    }
+
+    @Test
+    fun `report caps its sites and counts the rest as dropped`() {
+        val report = SlowOperationReport(maxSites = 2)
+        report.add(Kind.CRYPTO, "esp.create", "A.kt:1", 20, "main")
+        report.add(Kind.CRYPTO, "esp.create", "B.kt:1", 20, "main")
+        report.add(Kind.CRYPTO, "esp.create", "C.kt:1", 20, "main")
+        report.add(Kind.CRYPTO, "esp.create", "A.kt:1", 20, "main")
+
+        assertEquals(2, report.entries().size)
+        assertEquals(1, report.dropped)
+        val text = report.render("test")
+        assertTrue(text.startsWith("# test\n# kind\tcount"))
+        assertTrue(text.contains("CRYPTO\t2\t40\t20\tesp.create\tA.kt:1\tmain\n"))
+        assertTrue(text.contains("# 1 operations at further sites not listed"))
+    }
+
+    @Test
+    fun `slow main-thread call is recorded with its call site`() {
+        val watchdog = watchdog()
+        val result = watchdog.trace(Kind.DISK, "prefs.open") {
+            advanceMs(40)
+            "loaded"
+        }
+
+        assertEquals("loaded", result)
+        val entry = watchdog.report.entries().single()
+        assertEquals(Kind.DISK, entry.kind)
+        assertEquals("prefs.open", entry.name)
+        assertEquals(40, entry.maxMs)
+        assertTrue(entry.callSite.startsWith(SlowOperationWatchdogTest::class.java.name), entry.callSite)
+    }
+
+    @Test
+    fun `real blocking call on the watched thread exceeds the frame budget`() {
+        val watchdog = SlowOperationWatchdog(Dispatchers.Unconfined, System::nanoTime, { true }).also { it.enable(null) }
+        watchdog.trace(Kind.DISK, "file.write") {
+            val file = Files.createTempFile("watchdog", ".bin").toFile()
+            file.writeBytes(ByteArray(4096))
+            Thread.sleep(Kind.DISK.thresholdMs + 10)
+            file.delete()
+        }
+
+        assertEquals(listOf("file.write"), watchdog.report.entries().map { it.name })
+    }
+
+    @Test
+    fun `fast, off-main and disabled calls are not recorded`() {
+        val watchdog = watchdog()
+        watchdog.trace(Kind.BINDER, "fast") { advanceMs(Kind.BINDER.thresholdMs - 1) }
+        onMain = false
+        watchdog.trace(Kind.BINDER, "background") { advanceMs(500) }
+        onMain = true
+        val disabled = watchdog(enabled = false)
+        disabled.trace(Kind.BINDER, "disabled") { advanceMs(500) }
+
+        assertTrue(watchdog.report.entries().isEmpty())
+        assertTrue(disabled.report.entries().isEmpty())
+    }
+
+    @Test
+    fun `exception from a slow call is rethrown and still recorded`() {
+        val watchdog = watchdog()
+        val thrown = runCatching {
+            watchdog.trace(Kind.CRYPTO, "aes.decrypt") {
+                advanceMs(30)
+                throw IllegalStateException("bad tag")
+            }
+        }.exceptionOrNull()
+
+        assertTrue(thrown is IllegalStateException)
+        assertEquals(1, watchdog.report.entries().single().count)
+    }
+
+    @Test
+    fun `looper printer times messages and strips instance hashes`() {
+        val watchdog = watchdog()
+        watchdog.onLooperMessage(">>>>> Dispatching to Handler (android.app.ActivityThread\$H) {3f2a1b} null: 159")
+        advanceMs(10)
+        watchdog.onLooperMessage("<<<<< Finished to Handler (android.app.ActivityThread\$H) {3f2a1b} null")
+        watchdog.onLooperMessage(">>>>> Dispatching to Handler (android.os.Handler) {9c} com.microspace.payo.Lock\$1@77e1: 0")
+        advanceMs(250)
+        watchdog.onLooperMessage("<<<<< Finished to Handler (android.os.Handler) {9c} com.microspace.payo.Lock\$1@77e1")
+
+        val entry = watchdog.report.entries().single()
+        assertEquals(Kind.MESSAGE, entry.kind)
+        assertEquals(250, entry.maxMs)
+        assertEquals("Handler (android.os.Handler) com.microspace.payo.Lock\$1", entry.callSite)
+    }
+
+    @Test
+    fun `report file is rewritten with the aggregated sites`() {
+        val dir = Files.createTempDirectory("watchdog").toFile()
+        try {
+            val file = File(dir, "slow_operations.txt")
+            val watchdog = watchdog(file = file)
+            watchdog.record(Kind.BINDER, "dpm.setLockTaskPackages", 80, "DpmLockPolicyTarget.kt:27", "main")
+
+            assertTrue(watchdog.writeReport())
+            val lines = file.readLines()
+            assertEquals("BINDER\t1\t80\t80\tdpm.setLockTaskPackages\tDpmLockPolicyTarget.kt:27\tmain", lines.last())
+            assertTrue(dir.listFiles()!!.none { it.name.endsWith(".tmp") })
+        } finally {
+            dir.deleteRecursively()
+        }
+    }
+}
@@ -0,0 +1,213 @@
+﻿package com.microspace.payo
+
+import com.microspace.payo.data.local.database.dao.uplink.PendingReportDao
+import com.microspace.payo.data.local.database.entities.uplink.PendingReportEntity
+import com.microspace.payo.data.remote.ApiService
+import com.microspace.payo.data.remote.uplink.ApiReportTransport
+import com.microspace.payo.data.remote.uplink.StateReportUplink
+import com.microspace.payo.data.remote.uplink.StateReportUplink.Kind
+import kotlinx.coroutines.asCoroutineDispatcher
+import kotlinx.coroutines.runBlocking
+import okhttp3.mockwebserver.MockResponse
+import okhttp3.mockwebserver.MockWebServer
+import org.junit.After
+import org.junit.Before
+import org.junit.Test
+import retrofit2.Retrofit
+import retrofit2.converter.gson.GsonConverterFactory
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.ExecutorService
+import java.util.concurrent.Executors
+import java.util.concurrent.TimeUnit
+import java.util.concurrent.atomic.AtomicInteger
+import java.util.concurrent.atomic.AtomicLong
+import kotlin.random.Random
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+import kotlin.test.fail
+
+/**
+ * Supersession, crash recovery and request counts of the state report uplink, through the real
+ * Retrofit transport against a MockWebServer and an in-memory DAO with the Room queries' semantics.
+ */
+class StateReportUplinkTest {
+
+    private class InMemoryReportDao : PendingReportDao {
+        val rows = ConcurrentHashMap<String, PendingReportEntity>()
+
+        override suspend fun upsert(report: PendingReportEntity) {
+            rows[report.reportKey] = report
+        }
+
+        override suspend fun getDue(now: Long, limit: Int) =
+            rows.values.filter { it.nextAttemptAt <= now }.sortedBy { it.nextAttemptAt }.take(limit)
+
+        override suspend fun nextAttemptAt() = rows.values.minOfOrNull { it.nextAttemptAt }
+
+        override suspend fun delete(reportKey: String, revision: Long): Int =
+            if (rows.remove(reportKey, rows[reportKey]?.takeIf { it.revision == revision } ?: return 0)) 1 else 0
+
+        override suspend fun reschedule(reportKey: String, revision: Long, attempts: Int, nextAttemptAt: Long) {
+            rows.computeIfPresent(reportKey) { _, row ->
+                if (row.revision != revision) row else row.copy(attempts = attempts, nextAttemptAt = nextAttemptAt)
+            }
+        }
+
+        override suspend fun makeDue(now: Long) {
+            rows.replaceAll { _, row -> if (row.nextAttemptAt > now) row.copy(nextAttemptAt = now) else row }
+        }
+    }
+
+    private val server = MockWebServer()
+    private val dao = InMemoryReportDao()
+    private val now = AtomicLong(1_000_000)
+    private val executors = mutableListOf<ExecutorService>()
+    private lateinit var transport: ApiReportTransport
+
+    @Before
+    fun setUp() {
+        server.start()
+        val service = Retrofit.Builder()
+            .baseUrl(server.url("/"))
+            .addConverterFactory(GsonConverterFactory.create())
+            .build()
+            .create(ApiService::class.java)
+        transport = ApiReportTransport { service }
+    }
+
+    @After
+    fun tearDown() {
+        executors.forEach { it.shutdownNow() }
+        server.shutdown()
+    }
+
+    /** A process's uplink; shutting its executor down is that process dying. */
+    private fun uplink(start: Boolean = true): Pair<StateReportUplink, ExecutorService> {
+        val executor = Executors.newSingleThreadExecutor { r -> Thread(r, "uplink").apply { isDaemon = true } }
+        executors += executor
+        val uplink = StateReportUplink(dao, transport, executor.asCoroutineDispatcher(), now::get, Random(7))
+        if (start) uplink.start()
+        return uplink to executor
+    }
+
+    private fun ok() = MockResponse().setResponseCode(200).setBody("{}")
+
+    private fun status(completed: Boolean) = mapOf("completed" to completed, "reason" to "r$completed")
+
+    private fun awaitUntil(what: String, condition: () -> Boolean) {
+        val deadline = System.nanoTime() + TimeUnit.SECONDS.toNanos(5)
+        while (!condition()) {
+            if (System.nanoTime() > deadline) fail("Timed out waiting for $what")
+            Thread.sleep(10)
+        }
+    }
+
+    @Test
+    fun newerStateSupersedesUnsentReport() = runBlocking {
+        server.enqueue(ok())
+        val (uplink, _) = uplink(start = false)
+
+        uplink.submit(Kind.INSTALLATION_STATUS, "DEV-1", status(false))
+        uplink.submit(Kind.INSTALLATION_STATUS, "DEV-1", status(true))
+        uplink.start()
+        awaitUntil("delivery") { dao.rows.isEmpty() }
+
+        assertEquals(1, server.requestCount)
+        val request = server.takeRequest()
+        assertEquals("/api/devices/mobile/DEV-1/installation-status/", request.path)
+        assertTrue(request.body.readUtf8().contains("\"completed\":true"))
+    }
+
+    @Test
+    fun deactivationOutcomeIsConfirmedToTheServer() = runBlocking {
+        server.enqueue(ok())
+        val (uplink, _) = uplink(start = false)
+
+        uplink.confirmDeactivation("DEV-1", success = false, error = "owner removal denied")
+        uplink.confirmDeactivation("DEV-1", success = true)
+        uplink.start()
+        awaitUntil("delivery") { dao.rows.isEmpty() }
+
+        assertEquals(1, server.requestCount)
+        val request = server.takeRequest()
+        assertEquals("/api/devices/DEV-1/confirm-deactivation/", request.path)
+        val body = request.body.readUtf8()
+        assertTrue(body.contains("\"status\":\"success\""), body)
+        assertTrue(body.contains("Device Owner successfully removed"), body)
+    }
+
+    @Test
+    fun stateReplacedInFlightIsSentAfterTheOldOne() = runBlocking {
+        server.enqueue(ok().setHeadersDelay(300, TimeUnit.MILLISECONDS))
+        server.enqueue(ok())
+        val delivered = AtomicInteger()
+        val (uplink, _) = uplink()
+        uplink.onDelivered(Kind.DEACTIVATION_CONFIRMATION) { delivered.incrementAndGet() }
+
+        uplink.submit(Kind.DEACTIVATION_CONFIRMATION, "DEV-1", mapOf("status" to "failed", "message" to "first"))
+        assertTrue(server.takeRequest(5, TimeUnit.SECONDS)!!.body.readUtf8().contains("first"))
+        uplink.submit(Kind.DEACTIVATION_CONFIRMATION, "DEV-1", mapOf("status" to "success", "message" to "second"))
+        awaitUntil("second delivery") { dao.rows.isEmpty() && server.requestCount == 2 }
+
+        assertTrue(server.takeRequest().body.readUtf8().contains("second"))
+        // Only the delivery of the current state counts as delivered
+        awaitUntil("listener") { delivered.get() == 1 }
+    }
+
+    @Test
+    fun reportLeftByACrashIsDeliveredByTheNextProcess() = runBlocking {
+        server.enqueue(MockResponse().setResponseCode(503))
+        val (first, firstExecutor) = uplink()
+        first.submit(Kind.INSTALLATION_STATUS, "DEV-1", status(true))
+        awaitUntil("failed attempt") { dao.rows.values.single().attempts == 1 }
+        firstExecutor.shutdownNow()
+
+        val retryAt = dao.rows.values.single().nextAttemptAt
+        assertTrue(retryAt - now.get() >= 2_500, "Backoff after the first failure: ${retryAt - now.get()}ms")
+        now.set(retryAt)
+        server.enqueue(ok())
+        uplink()
+        awaitUntil("delivery after restart") { dao.rows.isEmpty() }
+
+        assertEquals(2, server.requestCount)
+    }
+
+    @Test
+    fun heartbeatBringsBackedOffReportsForward() = runBlocking {
+        server.enqueue(MockResponse().setResponseCode(500))
+        val (uplink, _) = uplink()
+        uplink.submit(Kind.INSTALLATION_STATUS, "DEV-1", status(true))
+        awaitUntil("failed attempt") { dao.rows.values.single().attempts == 1 }
+        // Backed off: nothing more is sent until the clock reaches the retry time...
+        Thread.sleep(200)
+        assertEquals(1, server.requestCount)
+
+        // ...or a heartbeat shows the network works
+        server.enqueue(ok())
+        uplink.onHeartbeatDelivered()
+        awaitUntil("delivery") { dao.rows.isEmpty() }
+        assertEquals(2, server.requestCount)
+    }
+
+    @Test
+    fun rejectedReportIsDroppedWithoutRetry() = runBlocking {
+        server.enqueue(MockResponse().setResponseCode(400).setBody("{\"error\":\"bad\"}"))
+        val (uplink, _) = uplink()
+        uplink.submit(Kind.INSTALLATION_STATUS, "DEV-1", status(true))
+        awaitUntil("rejection") { dao.rows.isEmpty() }
+        uplink.onHeartbeatDelivered()
+        Thread.sleep(200)
+
+        assertEquals(1, server.requestCount)
+    }
+
+    @Test
+    fun backoffDoublesWithJitterUpToTheCap() {
+        val random = Random(1)
+        for (attempts in 1..12) {
+            val ceiling = minOf(5_000L shl (attempts - 1), 30 * 60_000L)
+            val wait = StateReportUplink.backoffMs(attempts, random)
+            assertTrue(wait in ceiling / 2..ceiling, "attempt $attempts: $wait not in [${ceiling / 2}, $ceiling]")
+        }
+    }
+}
@@ -0,0 +1,135 @@
+﻿package com.microspace.payo
+
+import com.microspace.payo.data.local.database.entities.audit.SyncAuditEntity
+import com.microspace.payo.data.repository.TelemetryAppender
+import kotlinx.coroutines.asCoroutineDispatcher
+import org.junit.After
+import org.junit.Test
+import java.util.concurrent.Executors
+import java.util.concurrent.TimeUnit
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertTrue
+
+/**
+ * Group commit of heartbeat telemetry: commits (one fsync each) per simulated hour of beats, and
+ * durability of lock-affecting rows when the process dies with a partly filled buffer.
+ */
+class TelemetryAppenderTest {
+
+    private class FakeStore : TelemetryAppender.Store {
+        val committed = mutableListOf<SyncAuditEntity>()
+        var commits = 0
+        var failNext = false
+
+        override fun commit(batch: TelemetryAppender.Batch) {
+            if (failNext) {
+                failNext = false
+                throw IllegalStateException("disk I/O error")
+            }
+            commits++
+            committed += batch.audits
+        }
+    }
+
+    private val executor = Executors.newSingleThreadExecutor { r -> Thread(r, "telemetry").apply { isDaemon = true } }
+    private var now = 0L
+
+    @After
+    fun tearDown() {
+        executor.shutdownNow()
+    }
+
+    private fun appender(store: FakeStore, beatsPerCommit: Int = TelemetryAppender.BEATS_PER_COMMIT) =
+        TelemetryAppender(store, executor.asCoroutineDispatcher(), beatsPerCommit, TelemetryAppender.MAX_DELAY_MS) { now }
+
+    /** Waits for commits started by beatCompleted on the appender's dispatcher. */
+    private fun drain() {
+        executor.submit {}.get(2, TimeUnit.SECONDS)
+    }
+
+    private fun audit(action: String, before: String = "unlocked", after: String = before) =
+        SyncAuditEntity(
+            timestamp = now,
+            serverState = "UNLOCKED",
+            deviceStateBefore = before,
+            deviceStateAfter = after,
+            actionTaken = action,
+            details = ""
+        )
+
+    @Test
+    fun routineHourOfBeatsIsGroupCommitted() {
+        val store = FakeStore()
+        val appender = appender(store)
+        val beatMs = 10_000L
+
+        repeat((TimeUnit.HOURS.toMillis(1) / beatMs).toInt()) {
+            appender.append(audit("NO_CHANGE"))
+            appender.beatCompleted()
+            drain()
+            now += beatMs
+        }
+
+        // Before: an insert and a prune per beat, each its own transaction (720 commits)
+        assertEquals(12, store.commits)
+        assertEquals(360, store.committed.size)
+    }
+
+    @Test
+    fun oldBufferIsCommittedEvenWhenBeatsAreSlow() {
+        val store = FakeStore()
+        val appender = appender(store)
+
+        appender.append(audit("NO_CHANGE"))
+        appender.beatCompleted()
+        now += TelemetryAppender.MAX_DELAY_MS
+        appender.append(audit("NO_CHANGE"))
+        appender.beatCompleted()
+        drain()
+
+        assertEquals(1, store.commits)
+        assertEquals(0, appender.bufferedRows)
+    }
+
+    @Test
+    fun lockRowsSurviveSimulatedKill() {
+        val store = FakeStore()
+        val appender = appender(store, beatsPerCommit = 1_000)
+
+        val lockActions = mutableListOf<String>()
+        repeat(50) { i ->
+            appender.append(audit("NO_CHANGE"))
+            if (i % 7 == 3) {
+                val action = if (i % 2 == 0) "APPLY_HARD_LOCK" else "TRIGGER_UNLOCK"
+                appender.writeThrough(audit(action, before = "unlocked", after = "hard"))
+                lockActions += action
+            }
+            appender.beatCompleted()
+            now += 10_000L
+        }
+        // Process killed here: the appender is dropped without a flush
+        val survived = store.committed.map { it.actionTaken }.filter { it != "NO_CHANGE" }
+
+        assertEquals(lockActions, survived)
+        assertTrue(appender.bufferedRows > 0, "routine rows after the last lock row are the only loss")
+        // Each write-through also carried the routine rows buffered before it, in order
+        assertEquals(lockActions.size, store.commits)
+        assertEquals(List(4) { "NO_CHANGE" } + "TRIGGER_UNLOCK", store.committed.take(5).map { it.actionTaken })
+    }
+
+    @Test
+    fun failedWriteThroughKeepsRoutineRowsBuffered() {
+        val store = FakeStore()
+        val appender = appender(store)
+
+        appender.append(audit("NO_CHANGE"))
+        appender.append(audit("NO_CHANGE"))
+        store.failNext = true
+        assertFailsWith<IllegalStateException> { appender.writeThrough(audit("APPLY_HARD_LOCK")) }
+        assertEquals(2, appender.bufferedRows)
+
+        appender.flush()
+        assertEquals(listOf("NO_CHANGE", "NO_CHANGE"), store.committed.map { it.actionTaken })
+    }
+}
@@ -0,0 +1,106 @@
+﻿package com.microspace.payo
+
+import com.microspace.payo.ui.screens.lock.UnlockCodeState
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.asCoroutineDispatcher
+import org.junit.After
+import org.junit.Test
+import java.util.concurrent.CountDownLatch
+import java.util.concurrent.Executors
+import java.util.concurrent.TimeUnit
+import java.util.concurrent.atomic.AtomicInteger
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertNotEquals
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+/**
+ * Input handling and verification of the unlock-code state holder shared by the lock screens.
+ * The check must run on the work dispatcher, never on the caller's thread, and only once per tap.
+ */
+class UnlockCodeStateTest {
+
+    private val main = Executors.newSingleThreadExecutor { r -> Thread(r, "ui") }
+    private val io = Executors.newSingleThreadExecutor { r -> Thread(r, "io") }
+
+    @After
+    fun tearDown() {
+        main.shutdownNow()
+        io.shutdownNow()
+    }
+
+    private fun state(verifier: (String) -> Boolean) =
+        UnlockCodeState(CoroutineScope(main.asCoroutineDispatcher()), verifier, io.asCoroutineDispatcher())
+
+    /** Waits until the coroutine on the ui executor has published its result. */
+    private fun UnlockCodeState.awaitResult(): Boolean? {
+        val deadline = System.currentTimeMillis() + 2_000
+        while (isVerifying && System.currentTimeMillis() < deadline) Thread.sleep(1)
+        main.submit {}.get()
+        return result
+    }
+
+    @Test
+    fun keepsDigitsOnlyWithoutCappingTheLength() {
+        val state = state { true }
+        state.onCodeChange("12a3-4 5678")
+        assertEquals("12345678", state.code)
+
+        state.deleteLast()
+        state.appendDigit('9')
+        assertEquals("12345679", state.code)
+        "0123456789".forEach(state::appendDigit)
+        assertEquals("123456790123456789", state.code)
+    }
+
+    @Test
+    fun verifiesOffCallerThreadAndClearsResultOnEdit() {
+        var verifiedOn: String? = null
+        val state = state { code ->
+            verifiedOn = Thread.currentThread().name
+            code == "4321"
+        }
+        assertFalse(state.canSubmit)
+
+        state.onCodeChange("1234")
+        assertTrue(state.canSubmit)
+        state.verify()
+        assertEquals(false, state.awaitResult())
+        assertEquals("io", verifiedOn)
+        assertNotEquals(Thread.currentThread().name, verifiedOn)
+
+        state.onCodeChange("4321")
+        assertNull(state.result)
+        state.verify()
+        assertEquals(true, state.awaitResult())
+    }
+
+    @Test
+    fun ignoresTapsWhileVerifying() {
+        val calls = AtomicInteger()
+        val release = CountDownLatch(1)
+        val state = state {
+            calls.incrementAndGet()
+            release.await(2, TimeUnit.SECONDS)
+        }
+        state.onCodeChange("1111")
+
+        repeat(5) { state.verify() }
+        assertTrue(state.isVerifying)
+        assertFalse(state.canSubmit)
+        release.countDown()
+
+        assertEquals(true, state.awaitResult())
+        assertEquals(1, calls.get())
+    }
+
+    @Test
+    fun failingVerifierCountsAsRejected() {
+        val state = state { throw IllegalStateException("prefs unavailable") }
+        state.onCodeChange("2222")
+        state.verify()
+        assertEquals(false, state.awaitResult())
+        assertTrue(state.canSubmit)
+    }
+}
@@ -0,0 +1,157 @@
+﻿package com.microspace.payo
+
+import com.google.gson.Gson
+import com.microspace.payo.data.models.heartbeat.HeartbeatResponse
+import com.microspace.payo.security.crypto.SignedPayloadVerifier
+import com.microspace.payo.security.monitoring.violation.LockType
+import com.microspace.payo.security.monitoring.violation.SignedViolationRuleSet
+import com.microspace.payo.security.monitoring.violation.ViolationRuleSet
+import com.microspace.payo.security.monitoring.violation.ViolationRuleSpec
+import com.microspace.payo.security.monitoring.violation.ViolationRuleStore
+import com.microspace.payo.security.monitoring.violation.ViolationRuleTable
+import com.microspace.payo.security.monitoring.violation.ViolationSeverity
+import org.junit.Test
+import java.io.File
+import java.security.KeyPairGenerator
+import java.security.PrivateKey
+import java.security.Signature
+import java.security.spec.ECGenParameterSpec
+import kotlin.test.assertEquals
+import kotlin.test.assertNotNull
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+/**
+ * Parity of the compiled violation rule table with the previous per-field detector.
+ */
+class ViolationRuleTableTest {
+
+    // Previous DeviceViolationDetector classification, kept verbatim as the reference
+    private val legacyHigh = setOf(
+        "serial_number", "bootloader", "device_id", "imei", "android_id",
+        "manufacturer", "model", "is_device_rooted", "is_bootloader_unlocked", "is_custom_rom"
+    )
+    private val legacyMedium = setOf("build_id", "build_number", "security_patch_level", "fingerprint", "os_version", "build_type")
+    private val legacyLow = setOf("battery_level", "latitude", "longitude", "installed_apps_hash")
+
+    private fun legacySeverity(field: String) = when (field) {
+        in legacyHigh -> ViolationSeverity.HIGH
+        in legacyMedium -> ViolationSeverity.MEDIUM
+        in legacyLow -> ViolationSeverity.LOW
+        else -> ViolationSeverity.UNKNOWN
+    }
+
+    private fun legacyLockType(fields: List<String>): LockType {
+        val severities = fields.map { legacySeverity(it) }
+        return when {
+            severities.any { it == ViolationSeverity.HIGH } -> LockType.HARD_LOCK
+            severities.any { it == ViolationSeverity.MEDIUM } -> LockType.SOFT_LOCK
+            else -> LockType.NO_LOCK
+        }
+    }
+
+    private val recordedResponses = listOf(
+        """{"success":true,"changes_detected":true,"changed_fields":["battery_level","latitude","longitude"]}""",
+        """{"success":true,"changes_detected":true,"changed_fields":["os_version","security_patch_level","battery_level"]}""",
+        """{"success":true,"changes_detected":true,"changed_fields":["serial_number","fingerprint","installed_apps_hash"]}""",
+        """{"success":true,"changes_detected":true,"changed_fields":["is_device_rooted"]}""",
+        """{"success":true,"changes_detected":true,"changed_fields":["sim_operator","language"]}""",
+        """{"success":true,"changes_detected":false,"changed_fields":[]}"""
+    ).map { Gson().fromJson(it, HeartbeatResponse::class.java) }
+
+    private fun bundledTable(): ViolationRuleTable {
+        val json = File("src/main/res/raw/violation_rules.json").readText()
+        return assertNotNull(ViolationRuleTable.parse(json)?.let { ViolationRuleTable.compile(it) })
+    }
+
+    private fun assertParity(table: ViolationRuleTable) {
+        for (response in recordedResponses) {
+            val fields = response.changedFields.orEmpty()
+            val report = table.evaluate(fields)
+            assertEquals(legacyLockType(fields), report.lockType, "lock type for $fields")
+            assertEquals(fields.count { legacySeverity(it) == ViolationSeverity.HIGH }, report.highSeverityCount)
+            assertEquals(fields.count { legacySeverity(it) == ViolationSeverity.MEDIUM }, report.mediumSeverityCount)
+            fields.forEach { assertEquals(legacySeverity(it), table.severityOf(it), it) }
+        }
+    }
+
+    @Test
+    fun compiledDefaultMatchesLegacyDetector() = assertParity(ViolationRuleTable.DEFAULT)
+
+    @Test
+    fun bundledResourceMatchesLegacyDetector() {
+        val table = bundledTable()
+        assertEquals(ViolationRuleTable.DEFAULT.version, table.version)
+        assertEquals(ViolationRuleTable.DEFAULT.size, table.size)
+        assertParity(table)
+    }
+
+    @Test
+    fun serverRulesCanPromoteFieldAndRemapAction() {
+        val pushed = ViolationRuleSet(
+            version = 2,
+            actions = mapOf("MEDIUM" to "HARD_LOCK"),
+            rules = listOf(ViolationRuleSpec("sim_operator", "MEDIUM"), ViolationRuleSpec("battery_level", "LOW"))
+        )
+        val table = assertNotNull(ViolationRuleTable.compile(pushed))
+        assertEquals(LockType.HARD_LOCK, table.evaluate(listOf("battery_level", "sim_operator")).lockType)
+    }
+
+    @Test
+    fun malformedRuleSetsAreRejected() {
+        assertNull(ViolationRuleTable.compile(ViolationRuleSet(version = 2, rules = emptyList())))
+        assertNull(ViolationRuleTable.compile(ViolationRuleSet(version = 2, rules = listOf(ViolationRuleSpec("model", "CRITICAL")))))
+        assertNull(ViolationRuleTable.compile(ViolationRuleSet(version = 2, actions = mapOf("HIGH" to "REBOOT"), rules = listOf(ViolationRuleSpec("model", "HIGH")))))
+        assertNull(ViolationRuleTable.compile(ViolationRuleSet(version = 0, rules = listOf(ViolationRuleSpec("model", "HIGH")))))
+    }
+
+    private fun keyPair() = KeyPairGenerator.getInstance("EC")
+        .apply { initialize(ECGenParameterSpec("secp256r1")) }
+        .generateKeyPair()
+
+    private fun signed(set: ViolationRuleSet, key: PrivateKey): SignedViolationRuleSet {
+        val payload = Gson().toJson(set)
+        val signature = Signature.getInstance(SignedPayloadVerifier.ALGORITHM).run {
+            initSign(key)
+            update(payload.toByteArray())
+            sign().joinToString("") { "%02x".format(it) }
+        }
+        return SignedViolationRuleSet(payload, signature)
+    }
+
+    @Test
+    fun serverRulesAreTakenOnlyWithAValidSignature() {
+        val server = keyPair()
+        val verifier = SignedPayloadVerifier(server.public)
+        val set = ViolationRuleSet(version = 2, rules = listOf(ViolationRuleSpec("sim_operator", "HIGH")))
+        val genuine = signed(set, server.private)
+
+        assertEquals(LockType.HARD_LOCK, ViolationRuleStore.verified(genuine, verifier)?.evaluate(listOf("sim_operator"))?.lockType)
+        assertNull(ViolationRuleStore.verified(signed(set, keyPair().private), verifier))
+        assertNull(ViolationRuleStore.verified(genuine.copy(payload = genuine.payload!!.replace("HIGH", "LOW")), verifier))
+        assertNull(ViolationRuleStore.verified(SignedViolationRuleSet(genuine.payload, null), verifier))
+    }
+
+    @Test
+    fun benchmarkEvaluationAgainstLegacy() {
+        val table = ViolationRuleTable.DEFAULT
+        val fields = recordedResponses.flatMap { it.changedFields.orEmpty() }
+        val iterations = 50_000
+
+        repeat(5_000) { table.evaluate(fields); legacyLockType(fields) } // warm-up
+
+        var start = System.nanoTime()
+        repeat(iterations) { table.evaluate(fields) }
+        val tableNs = (System.nanoTime() - start) / iterations
+
+        start = System.nanoTime()
+        repeat(iterations) {
+            fields.forEach { legacySeverity(it) }
+            legacyLockType(fields)
+        }
+        val legacyNs = (System.nanoTime() - start) / iterations
+
+        // One hash lookup per field; generous bound so a loaded CI machine does not flake
+        assertTrue(tableNs < 20_000, "ViolationRuleTable: ${tableNs}ns/eval, legacy detector: ${legacyNs}ns/eval")
+    }
+}
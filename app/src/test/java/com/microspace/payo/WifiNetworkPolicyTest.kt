@@ -0,0 +1,108 @@
+﻿package com.microspace.payo
+
+import com.microspace.payo.device.SavedNetwork
+import com.microspace.payo.device.WifiConfigTarget
+import com.microspace.payo.device.WifiNetworkPolicy
+import com.microspace.payo.device.WifiNetworkPolicy.ManagedNetwork
+import org.junit.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+/**
+ * Operation counts and idempotence of the Wi-Fi network policy against a fake saved-network
+ * store that behaves like WifiManager's configured-network list.
+ */
+class WifiNetworkPolicyTest {
+
+    private class FakeWifi(vararg ssids: String) : WifiConfigTarget {
+        val saved = ssids.mapIndexed { i, ssid -> SavedNetwork(i, "\"$ssid\"") }.toMutableList()
+        val calls = mutableListOf<String>()
+        var failRemoveOf: Int? = null
+        private var nextId = ssids.size
+
+        override fun savedNetworks(): List<SavedNetwork> {
+            calls += "read"
+            return saved.map { it.copy(ssid = WifiNetworkPolicy.unquote(it.ssid)) }
+        }
+
+        override fun addNetwork(network: ManagedNetwork): Int {
+            calls += "add ${network.ssid}"
+            saved += SavedNetwork(nextId, "\"${network.ssid}\"")
+            return nextId++
+        }
+
+        override fun removeNetwork(networkId: Int): Boolean {
+            calls += "remove $networkId"
+            if (networkId == failRemoveOf) return false
+            return saved.removeAll { it.networkId == networkId }
+        }
+
+        override fun saveConfiguration() {
+            calls += "save"
+        }
+    }
+
+    @Test
+    fun forgettingOneNetworkTouchesOnlyThatNetwork() {
+        val wifi = FakeWifi("Home", "Provisioning", "Office", "Provisioning")
+
+        val report = WifiNetworkPolicy().forget("\"Provisioning\"").commit(wifi)
+
+        assertEquals(listOf("read", "remove 1", "remove 3", "save"), wifi.calls)
+        assertEquals(listOf("Home", "Office"), wifi.saved.map { WifiNetworkPolicy.unquote(it.ssid) })
+        assertEquals(2, report.removed)
+    }
+
+    @Test
+    fun secondCommitOfTheSamePolicyChangesNothing() {
+        val wifi = FakeWifi("Home", "Provisioning")
+        val policy = WifiNetworkPolicy().forget("Provisioning")
+        policy.commit(wifi)
+        wifi.calls.clear()
+
+        val report = policy.commit(wifi)
+
+        assertEquals(listOf("read"), wifi.calls)
+        assertEquals(0, report.added + report.removed)
+    }
+
+    @Test
+    fun forgetUnmanagedKeepsEnsuredNetworksAndAddsMissingOnes() {
+        val wifi = FakeWifi("Home", "Shop", "Cafe")
+        val policy = WifiNetworkPolicy()
+            .ensure(ManagedNetwork("Shop", "secret"))
+            .ensure(ManagedNetwork("Warehouse", null))
+            .forgetUnmanaged()
+
+        assertEquals(listOf("Home", "Cafe"), policy.diff(wifi.savedNetworks()).removals.map { it.ssid })
+        wifi.calls.clear()
+        policy.commit(wifi)
+
+        assertEquals(listOf("read", "remove 0", "remove 2", "add Warehouse", "save"), wifi.calls)
+        wifi.calls.clear()
+        policy.commit(wifi)
+        assertEquals(listOf("read"), wifi.calls)
+    }
+
+    @Test
+    fun failedRemovalIsReportedAndTheRestStillApplied() {
+        val wifi = FakeWifi("A", "B", "C")
+        wifi.failRemoveOf = 1
+
+        val report = WifiNetworkPolicy().forgetUnmanaged().commit(wifi)
+
+        assertEquals(listOf("read", "remove 0", "remove 1", "remove 2", "save"), wifi.calls)
+        assertEquals(2, report.removed)
+        assertEquals(listOf("B"), report.failed.map { it.ssid })
+        assertTrue(report.operations.all { it.durationNanos >= 0 })
+    }
+
+    @Test
+    fun nothingSavedMeansOneRead() {
+        val wifi = FakeWifi()
+
+        WifiNetworkPolicy().forgetUnmanaged().commit(wifi)
+
+        assertEquals(listOf("read"), wifi.calls)
+    }
+}